@@ -0,0 +1,102 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+// Own
+#include "ArchiveStoragePolicy.h"
+
+// Qt
+#include <QDir>
+#include <QStringList>
+
+// Marble
+#include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+#include "TileArchive.h"
+
+using namespace Marble;
+
+ArchiveStoragePolicy::ArchiveStoragePolicy( TileArchive *archive, const QString &dataDirectory, QObject *parent )
+    : StoragePolicy( parent ),
+      m_archive( archive ),
+      m_filePolicy( dataDirectory )
+{
+    Q_ASSERT( m_archive );
+
+    connect( &m_filePolicy, SIGNAL(cleared()), SIGNAL(cleared()) );
+    connect( &m_filePolicy, SIGNAL(sizeChanged(qint64)), SIGNAL(sizeChanged(qint64)) );
+}
+
+ArchiveStoragePolicy::~ArchiveStoragePolicy()
+{
+    m_archive->flush();
+}
+
+bool ArchiveStoragePolicy::fileExists( const QString &fileName ) const
+{
+    if ( isArchived( fileName ) ) {
+        return m_archive->contains( fileName );
+    }
+
+    return m_filePolicy.fileExists( fileName );
+}
+
+bool ArchiveStoragePolicy::updateFile( const QString &fileName, const QByteArray &data )
+{
+    if ( !isArchived( fileName ) ) {
+        return m_filePolicy.updateFile( fileName, data );
+    }
+
+    if ( !m_archive->insert( fileName, data, QDateTime::currentDateTime(), isBaseTile( fileName ) ) ) {
+        m_errorMsg = m_archive->errorString();
+        qCritical() << "TileArchive::insert" << m_errorMsg;
+        return false;
+    }
+
+    return true;
+}
+
+void ArchiveStoragePolicy::clearCache()
+{
+    m_archive->clearUnpinned();
+    m_filePolicy.clearCache();
+}
+
+QString ArchiveStoragePolicy::lastErrorMessage() const
+{
+    return m_errorMsg.isEmpty() ? m_filePolicy.lastErrorMessage() : m_errorMsg;
+}
+
+bool ArchiveStoragePolicy::isArchived( const QString &fileName )
+{
+    if ( QDir::isAbsolutePath( fileName ) || !fileName.startsWith( QLatin1String( "maps/" ) ) ) {
+        return false;
+    }
+
+    const QString lowerCase = fileName.toLower();
+    return lowerCase.endsWith( QLatin1String( ".jpg" ) )
+        || lowerCase.endsWith( QLatin1String( ".jpeg" ) )
+        || lowerCase.endsWith( QLatin1String( ".png" ) )
+        || lowerCase.endsWith( QLatin1String( ".gif" ) );
+}
+
+bool ArchiveStoragePolicy::isBaseTile( const QString &fileName )
+{
+    // maps/<planet>/<theme>/<level>/...
+    const QStringList components = fileName.split( '/' );
+    if ( components.size() < 4 ) {
+        return false;
+    }
+
+    bool ok = false;
+    const int level = components[3].toInt( &ok );
+    return ok && level <= maxBaseTileLevel;
+}
+
+#include "ArchiveStoragePolicy.moc"
@@ -0,0 +1,79 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_ARCHIVESTORAGEPOLICY_H
+#define MARBLE_ARCHIVESTORAGEPOLICY_H
+
+#include "FileStoragePolicy.h"
+#include "StoragePolicy.h"
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class TileArchive;
+
+/**
+ * @short Storage policy keeping downloaded texture tiles in a TileArchive
+ *
+ * Other downloads, e.g. vector tiles, are stored in separate files
+ * like FileStoragePolicy does. The size of the archive is limited by
+ * the archive itself, so only changes of the size of the separate
+ * files are reported by sizeChanged().
+ */
+class MARBLE_EXPORT ArchiveStoragePolicy : public StoragePolicy
+{
+    Q_OBJECT
+
+    public:
+        /**
+         * Creates a new archive storage policy.
+         *
+         * @param archive The archive texture tiles go to.
+         * @param dataDirectory The directory where other data should go to.
+         */
+        explicit ArchiveStoragePolicy( TileArchive *archive, const QString &dataDirectory = QString(), QObject *parent = 0 );
+
+        ~ArchiveStoragePolicy();
+
+        bool fileExists( const QString &fileName ) const;
+
+        bool updateFile( const QString &fileName, const QByteArray &data );
+
+        /**
+         * Clears the cache except for the base tiles.
+         */
+        void clearCache();
+
+        QString lastErrorMessage() const;
+
+        /**
+         * Returns whether @p fileName is a texture tile stored in an archive.
+         */
+        static bool isArchived( const QString &fileName );
+
+        /**
+         * Returns whether @p fileName is a tile of the base levels,
+         * which must not be evicted from the cache.
+         */
+        static bool isBaseTile( const QString &fileName );
+
+    private:
+        Q_DISABLE_COPY( ArchiveStoragePolicy )
+
+        TileArchive *const m_archive;
+        FileStoragePolicy m_filePolicy;
+        QString m_errorMsg;
+};
+
+}
+
+#endif
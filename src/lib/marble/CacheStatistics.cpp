@@ -0,0 +1,204 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "CacheStatistics.h"
+
+#include <QMutexLocker>
+
+namespace Marble
+{
+
+CacheStatistics::LevelStatistics::LevelStatistics() :
+    hits( 0 ),
+    misses( 0 ),
+    evictions( 0 ),
+    byteCount( 0 )
+{
+    for ( int timing = 0; timing < timingCount; ++timing ) {
+        for ( int bucket = 0; bucket < bucketCount; ++bucket ) {
+            histogram[timing][bucket] = 0;
+        }
+        totalTime[timing] = 0;
+    }
+}
+
+CacheStatistics::CacheStatistics()
+{
+}
+
+void CacheStatistics::addHit( Level level )
+{
+    QMutexLocker locker( &m_mutex );
+    ++m_levels[level].hits;
+}
+
+void CacheStatistics::addMiss( Level level )
+{
+    QMutexLocker locker( &m_mutex );
+    ++m_levels[level].misses;
+}
+
+void CacheStatistics::addEvictions( Level level, int count )
+{
+    if ( count <= 0 ) {
+        return;
+    }
+
+    QMutexLocker locker( &m_mutex );
+    m_levels[level].evictions += count;
+}
+
+void CacheStatistics::setByteCount( Level level, qint64 bytes )
+{
+    QMutexLocker locker( &m_mutex );
+    m_levels[level].byteCount = bytes;
+}
+
+void CacheStatistics::addTime( Level level, Timing timing, int msecs )
+{
+    int bucket = 0;
+    while ( bucket < bucketCount - 1 && msecs >= bucketLimit( bucket ) ) {
+        ++bucket;
+    }
+
+    QMutexLocker locker( &m_mutex );
+    ++m_levels[level].histogram[timing][bucket];
+    m_levels[level].totalTime[timing] += msecs;
+}
+
+quint64 CacheStatistics::hits( Level level ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_levels[level].hits;
+}
+
+quint64 CacheStatistics::misses( Level level ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_levels[level].misses;
+}
+
+quint64 CacheStatistics::evictions( Level level ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_levels[level].evictions;
+}
+
+qint64 CacheStatistics::byteCount( Level level ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_levels[level].byteCount;
+}
+
+qreal CacheStatistics::hitRatio( Level level ) const
+{
+    QMutexLocker locker( &m_mutex );
+    const quint64 lookups = m_levels[level].hits + m_levels[level].misses;
+    return lookups > 0 ? qreal( m_levels[level].hits ) / lookups : 0.0;
+}
+
+QVector<quint64> CacheStatistics::histogram( Level level, Timing timing ) const
+{
+    QMutexLocker locker( &m_mutex );
+    QVector<quint64> result( bucketCount );
+    for ( int bucket = 0; bucket < bucketCount; ++bucket ) {
+        result[bucket] = m_levels[level].histogram[timing][bucket];
+    }
+
+    return result;
+}
+
+quint64 CacheStatistics::timeCount( Level level, Timing timing ) const
+{
+    QMutexLocker locker( &m_mutex );
+    quint64 count = 0;
+    for ( int bucket = 0; bucket < bucketCount; ++bucket ) {
+        count += m_levels[level].histogram[timing][bucket];
+    }
+
+    return count;
+}
+
+qreal CacheStatistics::averageTime( Level level, Timing timing ) const
+{
+    const quint64 count = timeCount( level, timing );
+
+    QMutexLocker locker( &m_mutex );
+    return count > 0 ? qreal( m_levels[level].totalTime[timing] ) / count : 0.0;
+}
+
+int CacheStatistics::bucketLimit( int bucket )
+{
+    Q_ASSERT( 0 <= bucket && bucket < bucketCount );
+
+    if ( bucket == bucketCount - 1 ) {
+        return -1;
+    }
+
+    return 1 << bucket;
+}
+
+QString CacheStatistics::levelName( Level level )
+{
+    switch ( level ) {
+    case VolatileTileCache:
+        return "Volatile Tile Cache";
+    case DecodedTileCache:
+        return "Decoded Tile Cache";
+    case ElevationTileCache:
+        return "Elevation Tile Cache";
+    case TileStorage:
+        return "Tile Storage";
+    }
+
+    return QString();
+}
+
+void CacheStatistics::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    for ( int level = 0; level < levelCount; ++level ) {
+        const qint64 byteCount = m_levels[level].byteCount;
+        m_levels[level] = LevelStatistics();
+        m_levels[level].byteCount = byteCount;
+    }
+}
+
+QStringList CacheStatistics::runtimeTrace() const
+{
+    static const char *const timingNames[timingCount] = { "decode", "read", "download" };
+
+    QStringList result;
+    for ( int i = 0; i < levelCount; ++i ) {
+        const Level level = Level( i );
+
+        QString line = QString( "%1: %2 hits %3 misses (%4%) %5 evicted %6 kB" )
+                       .arg( levelName( level ) )
+                       .arg( hits( level ) )
+                       .arg( misses( level ) )
+                       .arg( 100.0 * hitRatio( level ), 0, 'f', 1 )
+                       .arg( evictions( level ) )
+                       .arg( byteCount( level ) / 1024 );
+
+        for ( int timing = 0; timing < timingCount; ++timing ) {
+            if ( timeCount( level, Timing( timing ) ) > 0 ) {
+                line += QString( " %1 %2 ms" )
+                        .arg( timingNames[timing] )
+                        .arg( averageTime( level, Timing( timing ) ), 0, 'f', 1 );
+            }
+        }
+
+        result << line;
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,131 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_CACHESTATISTICS_H
+#define MARBLE_CACHESTATISTICS_H
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short Hit and miss numbers and timings of the tile caches
+ *
+ * The tile caches report to the statistics of their MarbleModel, see
+ * MarbleModel::cacheStatistics(). The numbers help to choose cache limits,
+ * e.g. a low hit ratio of the volatile tile cache along with many evictions
+ * suggests to raise its limit.
+ *
+ * Timings are collected in histograms with buckets of exponentially growing
+ * size, from below 1 ms to 1 s and more.
+ *
+ * This class is thread-safe.
+ */
+class MARBLE_EXPORT CacheStatistics
+{
+ public:
+    enum Level {
+        VolatileTileCache,  ///< Blended tiles in RAM, see StackedTileLoader
+        DecodedTileCache,   ///< Blended tiles in the memory-mapped cache, see DecodedTileCache
+        ElevationTileCache, ///< Elevation tiles in RAM, see ElevationModel
+        TileStorage         ///< Downloaded tiles on disc, misses are downloaded
+    };
+
+    enum Timing {
+        DecodeTime,         ///< Creating a tile, e.g. decoding its image file
+        DiskReadTime,       ///< Reading a tile from disc
+        DownloadLatency     ///< From queuing a download until it has finished
+    };
+
+    static const int levelCount = TileStorage + 1;
+    static const int timingCount = DownloadLatency + 1;
+    static const int bucketCount = 12;
+
+    CacheStatistics();
+
+    void addHit( Level level );
+    void addMiss( Level level );
+    void addEvictions( Level level, int count = 1 );
+
+    /**
+     * Sets the memory or disc space taken by the tiles of @p level.
+     */
+    void setByteCount( Level level, qint64 bytes );
+
+    void addTime( Level level, Timing timing, int msecs );
+
+    quint64 hits( Level level ) const;
+    quint64 misses( Level level ) const;
+    quint64 evictions( Level level ) const;
+    qint64 byteCount( Level level ) const;
+
+    /**
+     * Returns the share of hits among all lookups, or 0 if there were none.
+     */
+    qreal hitRatio( Level level ) const;
+
+    /**
+     * Returns the number of times measured per bucket, see bucketLimit().
+     */
+    QVector<quint64> histogram( Level level, Timing timing ) const;
+
+    quint64 timeCount( Level level, Timing timing ) const;
+
+    /**
+     * Returns the average time in milliseconds, or 0 if nothing was measured.
+     */
+    qreal averageTime( Level level, Timing timing ) const;
+
+    /**
+     * Returns the time in milliseconds which the times counted in @p bucket
+     * are below, or -1 for the last bucket, which counts all longer times.
+     */
+    static int bucketLimit( int bucket );
+
+    static QString levelName( Level level );
+
+    /**
+     * Resets all numbers except for the byte counts.
+     */
+    void clear();
+
+    /**
+     * Returns a summary of each level for the runtime trace.
+     */
+    QStringList runtimeTrace() const;
+
+ private:
+    Q_DISABLE_COPY( CacheStatistics )
+
+    struct LevelStatistics
+    {
+        LevelStatistics();
+
+        quint64 hits;
+        quint64 misses;
+        quint64 evictions;
+        qint64 byteCount;
+        quint64 histogram[timingCount][bucketCount];
+        qint64 totalTime[timingCount];
+    };
+
+    mutable QMutex m_mutex;
+    LevelStatistics m_levels[levelCount];
+};
+
+}
+
+#endif
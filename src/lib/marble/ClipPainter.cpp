@@ -15,6 +15,9 @@
 #include <cmath>
 
 #include "MarbleDebug.h"
+#include "PolygonClipper.h"
+
+#include <QThreadStorage>
 
 // #define DEBUG_DRAW_NODES
 
@@ -31,52 +34,11 @@ class ClipPainterPrivate
     // true if clipping is on.
     bool    m_doClip;
 
-    // The limits
-    qreal  m_left;
-    qreal  m_right;
-    qreal  m_top;
-    qreal  m_bottom;
-
-    // Used in the paint process of vectors..
-    int     m_currentSector;
-    int     m_previousSector;
-
-    //	int m_debugNodeCount;
-
-    QPointF    m_currentPoint;
-    QPointF    m_previousPoint; 
-
-    inline int sector( const QPointF & point ) const;
-
-    inline QPointF clipTop( qreal m, const QPointF & point ) const;
-    inline QPointF clipLeft( qreal m, const QPointF & point ) const;
-    inline QPointF clipBottom( qreal m, const QPointF & point ) const;
-    inline QPointF clipRight( qreal m, const QPointF & point ) const;
+    PolygonClipper m_clipper;
 
     inline void initClipRect();
 
-    inline void clipPolyObject ( const QPolygonF & sourcePolygon, 
-                                 QVector<QPolygonF> & clippedPolyObjects,
-                                 bool isClosed );
-
-    inline void clipMultiple( QPolygonF & clippedPolyObject,
-                              QVector<QPolygonF> & clippedPolyObjects,
-                              bool isClosed );
-    inline void clipOnce( QPolygonF & clippedPolyObject,
-                              QVector<QPolygonF> & clippedPolyObjects,
-                              bool isClosed );
-    inline void clipOnceCorner( QPolygonF & clippedPolyObject,
-                                QVector<QPolygonF> & clippedPolyObjects,
-                                const QPointF& corner,
-                                const QPointF& point,
-                                bool isClosed ) const;
-    inline void clipOnceEdge(   QPolygonF & clippedPolyObject,
-                                QVector<QPolygonF> & clippedPolyObjects,
-                                const QPointF& point,
-                                bool isClosed ) const;
-
-
-    void labelPosition( const QPolygonF & polygon, QVector<QPointF>& labelNodes, 
+    void labelPosition( const QPointF *points, int size, QVector<QPointF>& labelNodes,
                                 LabelPositionFlags labelPositionFlags);
 
     bool pointAllowsLabel( const QPointF& point );
@@ -87,7 +49,7 @@ class ClipPainterPrivate
     static inline qreal _m( const QPointF & start, const QPointF & end );
 
 #ifdef DEBUG_DRAW_NODES
-    void debugDrawNodes( const QPolygonF & ); 
+    void debugDrawNodes( const QPointF *points, int size );
 #endif
 
     qreal m_labelAreaMargin;
@@ -139,26 +101,20 @@ void ClipPainter::drawPolygon ( const QPolygonF & polygon,
     d->initClipRect();
 
     if ( d->m_doClip ) {	
-        QVector<QPolygonF> clippedPolyObjects;
+        const QPolygonF &clippedPolygon = d->m_clipper.clipPolygon( polygon );
 
-        d->clipPolyObject( polygon, clippedPolyObjects, true );
-
-        foreach( const QPolygonF & clippedPolyObject, clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 2 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
-                QPainter::drawPolygon ( clippedPolyObject, fillRule );
-                // mDebug() << "done";
-                #ifdef DEBUG_DRAW_NODES
-                    d->debugDrawNodes( clippedPolyObject );
-                #endif
-            }
+        if ( clippedPolygon.size() > 2 ) {
+            QPainter::drawPolygon ( clippedPolygon, fillRule );
+            #ifdef DEBUG_DRAW_NODES
+                d->debugDrawNodes( clippedPolygon.constData(), clippedPolygon.size() );
+            #endif
         }
     }
     else {
         QPainter::drawPolygon ( polygon, fillRule );
 
         #ifdef DEBUG_DRAW_NODES
-            d->debugDrawNodes( polygon );
+            d->debugDrawNodes( polygon.constData(), polygon.size() );
         #endif
     }
 }
@@ -168,18 +124,16 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon )
     d->initClipRect();
 
     if ( d->m_doClip ) {
-        QVector<QPolygonF> clippedPolyObjects;
-
-        d->clipPolyObject( polygon, clippedPolyObjects, false );
+        const int pieceCount = d->m_clipper.clipPolyline( polygon );
 
-        foreach( const QPolygonF & clippedPolyObject, clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 1 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
-                QPainter::drawPolyline ( clippedPolyObject );
-                // mDebug() << "done";
+        for ( int i = 0; i < pieceCount; ++i ) {
+            const QPointF *piece = d->m_clipper.piece( i );
+            const int pieceSize = d->m_clipper.pieceSize( i );
+            if ( pieceSize > 1 ) {
+                QPainter::drawPolyline ( piece, pieceSize );
 
                 #ifdef DEBUG_DRAW_NODES
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( piece, pieceSize );
                 #endif
             }
         }
@@ -188,7 +142,7 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon )
         QPainter::drawPolyline( polygon );
 
         #ifdef DEBUG_DRAW_NODES
-            d->debugDrawNodes( polygon );
+            d->debugDrawNodes( polygon.constData(), polygon.size() );
         #endif
     }
 }
@@ -199,22 +153,19 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon, QVector<QPointF>& lab
     d->initClipRect();
 
     if ( d->m_doClip ) {
- 
-        QVector<QPolygonF> clippedPolyObjects;
+        const int pieceCount = d->m_clipper.clipPolyline( polygon );
 
-        d->clipPolyObject( polygon, clippedPolyObjects, false );
-
-        foreach( const QPolygonF & clippedPolyObject, clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 1 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
-                QPainter::drawPolyline ( clippedPolyObject );
-                // mDebug() << "done";
+        for ( int i = 0; i < pieceCount; ++i ) {
+            const QPointF *piece = d->m_clipper.piece( i );
+            const int pieceSize = d->m_clipper.pieceSize( i );
+            if ( pieceSize > 1 ) {
+                QPainter::drawPolyline ( piece, pieceSize );
 
                 #ifdef DEBUG_DRAW_NODES
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( piece, pieceSize );
                 #endif
 
-                d->labelPosition( clippedPolyObject, labelNodes, positionFlags );
+                d->labelPosition( piece, pieceSize, labelNodes, positionFlags );
             }
         }
     }
@@ -222,41 +173,61 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon, QVector<QPointF>& lab
         QPainter::drawPolyline( polygon );
 
         #ifdef DEBUG_DRAW_NODES
-            d->debugDrawNodes( polygon );
+            d->debugDrawNodes( polygon.constData(), polygon.size() );
         #endif
 
-        d->labelPosition( polygon, labelNodes, positionFlags );
+        d->labelPosition( polygon.constData(), polygon.size(), labelNodes, positionFlags );
     }
 }
 
-void ClipPainterPrivate::labelPosition( const QPolygonF & polygon, QVector<QPointF>& labelNodes, 
+void ClipPainter::clip( const QPolygonF &polygon, const QRectF &clipRect, bool isClosed,
+                        QVector<QPolygonF> &clippedPolygons )
+{
+    // one clipper per thread, so that its buffers get reused
+    static QThreadStorage<PolygonClipper *> clippers;
+    if ( !clippers.hasLocalData() ) {
+        clippers.setLocalData( new PolygonClipper );
+    }
+
+    PolygonClipper *clipper = clippers.localData();
+    clipper->setClipRect( clipRect );
+
+    // the draw methods skip the same pieces
+    if ( isClosed ) {
+        clipper->clipPolygon( polygon, clippedPolygons );
+    } else {
+        clipper->clipPolyline( polygon, clippedPolygons );
+    }
+}
+
+void ClipPainterPrivate::labelPosition( const QPointF *points, int size, QVector<QPointF>& labelNodes,
                                         LabelPositionFlags labelPositionFlags)
 {
     bool currentAllowsLabel = false;
 
     if ( labelPositionFlags.testFlag( LineCenter ) ) {
         // The Label at the center of the polyline:
-        int labelPosition = static_cast<int>( polygon.size() / 2.0 );
-        if ( polygon.size() > 0 ) {
-            if ( labelPosition >= polygon.size() ) {
-                labelPosition = polygon.size() - 1;
+        int labelPosition = static_cast<int>( size / 2.0 );
+        if ( size > 0 ) {
+            if ( labelPosition >= size ) {
+                labelPosition = size - 1;
             }
-            labelNodes << polygon.at( labelPosition );
+            labelNodes << points[labelPosition];
         }
     }
 
-    if ( polygon.size() > 0 && labelPositionFlags.testFlag( LineStart ) ) {
-        if ( pointAllowsLabel( polygon.first() ) ) {
-            labelNodes << polygon.first();
+    if ( size > 0 && labelPositionFlags.testFlag( LineStart ) ) {
+        if ( pointAllowsLabel( points[0] ) ) {
+            labelNodes << points[0];
         }
 
         // The Label at the start of the polyline:
-        for ( int it = 1; it < polygon.size(); ++it ) {
-            currentAllowsLabel = pointAllowsLabel( polygon.at( it ) );
+        for ( int it = 1; it < size; ++it ) {
+            currentAllowsLabel = pointAllowsLabel( points[it] );
 
             if ( currentAllowsLabel ) {
-                // As polygon.size() > 0 it's ensured that it-1 exists.
-                QPointF node = interpolateLabelPoint( polygon.at( it -1 ), polygon.at( it ),
+                // As size > 0 it's ensured that it-1 exists.
+                QPointF node = interpolateLabelPoint( points[it - 1], points[it],
                                                     labelPositionFlags );
                 if ( node != QPointF( -1.0, -1.0 ) ) {
                     labelNodes << node;
@@ -266,17 +237,17 @@ void ClipPainterPrivate::labelPosition( const QPolygonF & polygon, QVector<QPoin
         }
     }
 
-    if ( polygon.size() > 1 && labelPositionFlags.testFlag( LineEnd ) ) {
-        if ( pointAllowsLabel( polygon.at( polygon.size() - 1 ) ) ) {
-            labelNodes << polygon.at( polygon.size() - 1 );
+    if ( size > 1 && labelPositionFlags.testFlag( LineEnd ) ) {
+        if ( pointAllowsLabel( points[size - 1] ) ) {
+            labelNodes << points[size - 1];
         }
 
         // The Label at the end of the polyline:
-        for ( int it = polygon.size() - 2; it > 0; --it ) {
-            currentAllowsLabel = pointAllowsLabel( polygon.at( it ) );
+        for ( int it = size - 2; it > 0; --it ) {
+            currentAllowsLabel = pointAllowsLabel( points[it] );
 
             if ( currentAllowsLabel ) {
-                QPointF node = interpolateLabelPoint( polygon.at( it + 1 ), polygon.at( it ),
+                QPointF node = interpolateLabelPoint( points[it + 1], points[it],
                                                     labelPositionFlags );
                 if ( node != QPointF( -1.0, -1.0 ) ) {
                     labelNodes << node;
@@ -341,14 +312,6 @@ QPointF ClipPainterPrivate::interpolateLabelPoint( const QPointF& previousPoint,
 
 ClipPainterPrivate::ClipPainterPrivate( ClipPainter * parent )
     : m_doClip( true ),
-      m_left(0.0),
-      m_right(0.0),
-      m_top(0.0),
-      m_bottom(0.0),
-      m_currentSector(4),
-      m_previousSector(4),
-      m_currentPoint(QPointF()),
-      m_previousPoint(QPointF()), 
       m_labelAreaMargin(10.0)
 {
     q = parent;
@@ -358,10 +321,9 @@ void ClipPainterPrivate::initClipRect ()
 {
     qreal penHalfWidth = q->pen().widthF() / 2.0 + 1.0;
 
-    m_left   = -penHalfWidth; 
-    m_right  = (qreal)(q->device()->width()) + penHalfWidth;
-    m_top    = -penHalfWidth; 
-    m_bottom = (qreal)(q->device()->height()) + penHalfWidth;
+    m_clipper.setClipRect( QRectF( QPointF( -penHalfWidth, -penHalfWidth ),
+                                   QPointF( (qreal)(q->device()->width()) + penHalfWidth,
+                                            (qreal)(q->device()->height()) + penHalfWidth ) ) );
 }
 
 qreal ClipPainterPrivate::_m( const QPointF & start, const QPointF & end )
@@ -378,741 +340,9 @@ qreal ClipPainterPrivate::_m( const QPointF & start, const QPointF & end )
 }
 
 
-QPointF ClipPainterPrivate::clipTop( qreal m, const QPointF & point ) const
-{
-    return QPointF( ( m_top - point.y() ) / m + point.x(), m_top );
-}
-
-QPointF ClipPainterPrivate::clipLeft( qreal m, const QPointF & point ) const
-{
-    return QPointF( m_left, ( m_left - point.x() ) * m + point.y() );
-}
-
-QPointF ClipPainterPrivate::clipBottom( qreal m, const QPointF & point ) const
-{
-    return QPointF( ( m_bottom - point.y() ) / m + point.x(), m_bottom );
-}
-
-QPointF ClipPainterPrivate::clipRight( qreal m, const QPointF & point ) const
-{
-    return QPointF( m_right, ( m_right - point.x() ) * m + point.y() );
-}
-
-int ClipPainterPrivate::sector( const QPointF & point ) const
-{
-    // If we think of the image borders as (infinitely long) parallel
-    // lines then the plane is divided into 9 sectors.  Each of these
-    // sections is identified by a unique keynumber (currentSector):
-    //
-    //  0 | 1 | 2
-    //  --+---+--
-    //  3 | 4 | 5 <- sector number "4" represents the onscreen sector / viewport
-    //  --+---+--
-    //  6 | 7 | 8
-    //
-
-    // Figure out the section of the current point.
-    int xSector = 1;
-    if ( point.x() < m_left )
-        xSector = 0;
-    else if ( point.x() > m_right )
-        xSector = 2;
-
-    int ySector = 3;
-    if ( point.y() < m_top )
-        ySector = 0;
-    else if ( point.y() > m_bottom )
-        ySector = 6;
-
-    // By adding xSector and ySector we get a
-    // sector number of the values shown in the ASCII-art graph above.
-    return ySector + xSector;
-
-}
-
-void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon, 
-                                          QVector<QPolygonF> & clippedPolyObjects,
-                                          bool isClosed )
-{
-    //	mDebug() << "ClipPainter enabled." ;
-
-    // Only create a new polyObject as soon as we know for sure that 
-    // the current point is on the screen. 
-    QPolygonF clippedPolyObject = QPolygonF();
-
-    const QVector<QPointF>::const_iterator  itStartPoint = polygon.constBegin();
-    const QVector<QPointF>::const_iterator  itEndPoint   = polygon.constEnd();
-    QVector<QPointF>::const_iterator        itPoint      = itStartPoint;
-
-    // We use a while loop to be able to cover linestrings as well as linear rings:
-    // Linear rings require to tessellate the path from the last node to the first node
-    // which isn't really convenient to achieve with a for loop ...
-
-    bool processingLastNode = false;
-
-    while ( itPoint != itEndPoint ) {
-        m_currentPoint = (*itPoint);
-        // mDebug() << "m_currentPoint.x()" << m_currentPoint.x() << "m_currentPOint.y()" << m_currentPoint.y();
-
-        // Figure out the sector of the current point.
-        m_currentSector = sector( m_currentPoint );
-
-        // Initialize the variables related to the previous point.
-        if ( itPoint == itStartPoint && processingLastNode == false ) {
-            if ( isClosed ) {
-                m_previousPoint = polygon.last();
-
-                // Figure out the sector of the previous point.
-                m_previousSector = sector( m_previousPoint );
-            }
-            else {
-                m_previousSector = m_currentSector;
-            }
-        }
-
-        // If the current point reaches a new sector, take care of clipping.
-        if ( m_currentSector != m_previousSector ) {
-            if ( m_currentSector == 4 || m_previousSector == 4 ) {
-                // In this case the current or the previous point is visible on the
-                // screen but not both. Hence we only need to clip once and require
-                // only one interpolation for both cases.
-
-                clipOnce( clippedPolyObject, clippedPolyObjects, isClosed );
-            }
-            else {
-                // This case mostly deals with lines that reach from one
-                // sector that is located off screen to another one that
-                // is located off screen. In this situation the line 
-                // can get clipped once, twice, or not at all.
-                clipMultiple( clippedPolyObject, clippedPolyObjects, isClosed );
-            }
-
-            m_previousSector = m_currentSector;
-        }
-
-        // If the current point is onscreen, just add it to our final polygon.
-        if ( m_currentSector == 4 ) {
-
-            clippedPolyObject << m_currentPoint;
-#ifdef MARBLE_DEBUG
-            ++(m_debugNodeCount);
-#endif
-        }
-
-        m_previousPoint = m_currentPoint;
-
-        // Now let's handle the case where we have a (closed) polygon and where the
-        // last point of the polyline is outside the viewport and the start point
-        // is inside the viewport. This needs special treatment
-        if ( processingLastNode ) {
-            break;
-        }
-        ++itPoint;
-
-        if ( itPoint == itEndPoint  && isClosed ) {
-            itPoint = itStartPoint;
-            processingLastNode = true;
-        }
-    }
-
-    // Only add the pointer if there's node data available.
-    if ( !clippedPolyObject.isEmpty() ) {
-        clippedPolyObjects << clippedPolyObject;
-    }
-}
-
-
-void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
-                                       QVector<QPolygonF> & clippedPolyObjects,
-                                       bool isClosed )
-{
-    Q_UNUSED( clippedPolyObjects )
-    Q_UNUSED( isClosed )
-
-    // Take care of adding nodes in the image corners if the iterator 
-    // traverses off screen sections.
-
-    qreal  m = _m( m_previousPoint, m_currentPoint );
-
-    switch ( m_currentSector ) {
-    case 0:
-        if ( m_previousSector == 5 ) {
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_top );
-            }
-            if ( pointTop.x() >= m_left && pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
-            if ( pointLeft.y() > m_top ) 
-                clippedPolyObject << pointLeft;
-        }
-        else if ( m_previousSector == 7 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointBottom.x() > m_left ) {
-                clippedPolyObject << pointBottom;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            }
-            if ( pointLeft.y() >= m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
-        }
-        else if ( m_previousSector == 8 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
-            if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-   
-            if ( pointBottom.x() <= m_left && pointLeft.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            if ( pointTop.x() >= m_right && pointRight.y() <= m_top )
-                clippedPolyObject << QPointF( m_right, m_top );
-        }
-
-        clippedPolyObject << QPointF( m_left, m_top );
-        break;
-
-    case 1:
-        if ( m_previousSector == 3 ) {
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-
-            if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_top );
-            }
-            if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
-        }
-        else if ( m_previousSector == 5 ) {
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-
-            if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_top );
-            }
-            if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
-        }
-        else if ( m_previousSector == 6 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-
-            if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
-            if ( pointLeft.y() > m_top && pointLeft.y() <= m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointTop.x() > m_left ) {
-                clippedPolyObject << pointTop;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_top );
-            }
-        }
-        else if ( m_previousSector == 7 ) {
-            clippedPolyObject << clipBottom( m, m_previousPoint );
-            clippedPolyObject << clipTop( m, m_currentPoint );
-        }
-        else if ( m_previousSector == 8 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-
-            if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointRight.y() > m_top && pointRight.y() <= m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointTop.x() < m_right ) {
-                clippedPolyObject << pointTop;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_top );
-            }
-        }
-        break;
-
-    case 2:
-        if ( m_previousSector == 3 ) {
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_top );
-            }
-            if ( pointTop.x() > m_left && pointTop.x() <= m_right )
-                clippedPolyObject << pointTop;
-            if ( pointRight.y() > m_top ) 
-                clippedPolyObject << pointRight;
-        }
-        else if ( m_previousSector == 7 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointBottom.x() < m_right ) {
-                clippedPolyObject << pointBottom;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            }
-            if ( pointRight.y() >= m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
-        }
-        else if ( m_previousSector == 6 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointRight = clipRight( m, m_previousPoint );
-
-            if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
-            if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-   
-            if ( pointBottom.x() >= m_right && pointRight.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            if ( pointTop.x() <= m_left && pointLeft.y() <= m_top )
-                clippedPolyObject << QPointF( m_left, m_top );
-        }
-
-        clippedPolyObject << QPointF( m_right, m_top );
-        break;
-
-    case 3:
-        if ( m_previousSector == 7 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
-            if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            }
-        }
-        else if ( m_previousSector == 1 ) {
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
-            if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_top );
-            }
-        }
-        else if ( m_previousSector == 8 ) {
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointBottom.x() > m_left && pointBottom.x() <= m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            }
-        }
-        else if ( m_previousSector == 5 ) {
-            clippedPolyObject << clipRight( m, m_previousPoint );
-            clippedPolyObject << clipLeft( m, m_currentPoint );
-        }
-        else if ( m_previousSector == 2 ) {
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointRight.y() > m_top ) 
-                clippedPolyObject << pointRight;
-            if ( pointTop.x() > m_left && pointTop.x() <= m_right )
-                clippedPolyObject << pointTop;
-            if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_top );
-            }
-        }
-        break;
-
-    case 5:
-        if ( m_previousSector == 7 ) {
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            }
-        }
-        else if ( m_previousSector == 1 ) {
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
-            if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_top );
-            }
-        }
-        else if ( m_previousSector == 6 ) {
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointBottom.x() >= m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            }
-        }
-        else if ( m_previousSector == 3 ) {
-            clippedPolyObject << clipLeft( m, m_previousPoint );
-            clippedPolyObject << clipRight( m, m_currentPoint );
-        }
-        else if ( m_previousSector == 0 ) {
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointLeft.y() > m_top ) 
-                clippedPolyObject << pointLeft;
-            if ( pointTop.x() >= m_left && pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
-            if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_top );
-            }
-        }
-        break;
-
-    case 6:
-        if ( m_previousSector == 5 ) {
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            }
-            if ( pointBottom.x() >= m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-        }
-        else if ( m_previousSector == 1 ) {
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-
-            if ( pointTop.x() > m_left ) {
-                clippedPolyObject << pointTop;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_top );
-            }
-            if ( pointLeft.y() > m_top && pointLeft.y() <= m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
-        }
-        else if ( m_previousSector == 2 ) {
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-
-            if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
-            if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-   
-            if ( pointBottom.x() >= m_right && pointRight.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            if ( pointTop.x() <= m_left && pointLeft.y() <= m_top )
-                clippedPolyObject << QPointF( m_left, m_top );
-        }
-
-        clippedPolyObject << QPointF( m_left, m_bottom );
-        break;
-
-    case 7:
-        if ( m_previousSector == 3 ) {
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-
-            if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            }
-            if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
-        }
-        else if ( m_previousSector == 5 ) {
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-
-            if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            }
-            if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-        }
-        else if ( m_previousSector == 0 ) {
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-
-            if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
-            if ( pointLeft.y() >= m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointBottom.x() > m_left ) {
-                clippedPolyObject << pointBottom;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            }
-        }
-        else if ( m_previousSector == 1 ) {
-            clippedPolyObject << clipTop( m, m_previousPoint );
-            clippedPolyObject << clipBottom( m, m_currentPoint );
-        }
-        else if ( m_previousSector == 2 ) {
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-
-            if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
-            if ( pointRight.y() >= m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointBottom.x() < m_right ) {
-                clippedPolyObject << pointBottom;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
-            }
-        }
-        break;
-
-    case 8:
-        if ( m_previousSector == 3 ) {
-            QPointF pointLeft = clipLeft( m, m_previousPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-
-            if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
-            } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            }
-            if ( pointBottom.x() > m_left && pointBottom.x() <= m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-        }
-        else if ( m_previousSector == 1 ) {
-            QPointF pointTop = clipTop( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_currentPoint );
-            QPointF pointBottom = clipBottom( m, m_currentPoint );
-
-            if ( pointTop.x() < m_right ) {
-                clippedPolyObject << pointTop;
-            } else {
-                clippedPolyObject << QPointF( m_right, m_top );
-            }
-            if ( pointRight.y() > m_top && pointRight.y() <= m_bottom ) 
-                clippedPolyObject << pointRight;
-            if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-        }
-        else if ( m_previousSector == 0 ) {
-            QPointF pointTop = clipTop( m, m_currentPoint );
-            QPointF pointLeft = clipLeft( m, m_currentPoint );
-            QPointF pointBottom = clipBottom( m, m_previousPoint );
-            QPointF pointRight = clipRight( m, m_previousPoint );
-
-            if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
-            if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
-            if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
-            if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
-   
-            if ( pointBottom.x() <= m_left && pointLeft.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_left, m_bottom );
-            if ( pointTop.x() >= m_right && pointRight.y() <= m_top )
-                clippedPolyObject << QPointF( m_right, m_top );
-        }
-
-        clippedPolyObject << QPointF( m_right, m_bottom );
-        break;
-
-    default:
-        break;				
-    }
-}
-
-void ClipPainterPrivate::clipOnceCorner( QPolygonF & clippedPolyObject,
-                                         QVector<QPolygonF> & clippedPolyObjects,
-                                         const QPointF& corner,
-                                         const QPointF& point, 
-                                         bool isClosed ) const
-{
-    Q_UNUSED( clippedPolyObjects )
-    Q_UNUSED( isClosed )
-
-    if ( m_currentSector == 4) {
-        // Appearing
-        clippedPolyObject << corner;
-        clippedPolyObject << point;
-    } else {
-        // Disappearing
-        clippedPolyObject << point;
-        clippedPolyObject << corner;
-    }
-}
-
-void ClipPainterPrivate::clipOnceEdge( QPolygonF & clippedPolyObject,
-                                       QVector<QPolygonF> & clippedPolyObjects,
-                                       const QPointF& point,
-                                       bool isClosed ) const
-{
-    if ( m_currentSector == 4) {
-        // Appearing
-        if ( !isClosed ) {
-            clippedPolyObject = QPolygonF();
-        }
-        clippedPolyObject << point;
-    }
-    else {
-        // Disappearing
-        clippedPolyObject << point;
-        if ( !isClosed ) {
-            clippedPolyObjects << clippedPolyObject;           
-        }
-    }
-}
-
-void ClipPainterPrivate::clipOnce( QPolygonF & clippedPolyObject,
-                                   QVector<QPolygonF> & clippedPolyObjects,
-                                   bool isClosed )
-{
-    //	Interpolate border points (linear interpolation)
-    QPointF point;
-
-    // Calculating the slope.
-    qreal m = _m( m_previousPoint, m_currentPoint );
-
-    // Calculate in which sector the end of the line is located that is off screen 
-    int offscreenpos = ( m_currentSector == 4 ) ? m_previousSector : m_currentSector;
-
-    // "Rise over run" for all possible situations .
-    switch ( offscreenpos ) {
-    case 0: // topleft
-        point = clipTop( m, m_previousPoint );
-        if ( point.x() < m_left ) {
-            point = clipLeft( m, point );
-        }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_left, m_top ), point, isClosed );
-        break;
-    case 1: // top
-        point = clipTop( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
-        break;
-    case 2: // topright
-        point = clipTop( m, m_previousPoint );
-        if ( point.x() > m_right ) {
-            point = clipRight( m, point );
-        }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_right, m_top ), point, isClosed );
-        break;
-    case 3: // left
-        point = clipLeft( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
-        break;
-    case 5: // right
-        point = clipRight( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
-        break;
-    case 6: // bottomleft
-        point = clipBottom( m, m_previousPoint );
-        if ( point.x() < m_left ) {
-            point = clipLeft( m, point );
-        }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_left, m_bottom ), point, isClosed );
-        break;
-    case 7: // bottom
-        point = clipBottom( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
-        break;
-    case 8: // bottomright
-        point = clipBottom( m, m_previousPoint );
-        if ( point.x() > m_right ) {
-            point = clipRight( m, point );
-        }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_right, m_bottom ), point, isClosed );
-        break;
-    default:
-        break;			
-    }
-
-}
-
 #ifdef DEBUG_DRAW_NODES
 
-void ClipPainterPrivate::debugDrawNodes( const QPolygonF & polygon )
+void ClipPainterPrivate::debugDrawNodes( const QPointF *points, int size )
 {
 
     q->save();
@@ -1121,9 +351,9 @@ void ClipPainterPrivate::debugDrawNodes( const QPolygonF & polygon )
     q->setPen( Qt::red );
     q->setBrush( Qt::transparent );
 
-    const QVector<QPointF>::const_iterator  itStartPoint = polygon.constBegin();
-    const QVector<QPointF>::const_iterator  itEndPoint   = polygon.constEnd();
-    QVector<QPointF>::const_iterator        itPoint      = itStartPoint;
+    const QPointF *const itStartPoint = points;
+    const QPointF *const itEndPoint   = points + size;
+    const QPointF *      itPoint      = itStartPoint;
 
     for (; itPoint != itEndPoint; ++itPoint ) {
         
@@ -20,6 +20,7 @@
 
 class QPaintDevice;
 class QPolygonF;
+class QRectF;
 
 namespace Marble
 {
@@ -28,11 +29,9 @@ namespace Marble
  *
  * This class introduces fast polygon/polyline clipping for QPainter
  * to increase the performance.
- * Clipping is accomplished using an algorithm (by Torsten Rahn) that 
- * processes each polyline once. 
- * To keep things fast each possible scenario of two subsequent 
- * points is implemented case by case in a specialized handler which
- * creates interpolated points and helper points.
+ * Clipping is done by a PolygonClipper which keeps polygons in one
+ * piece and splits polylines where they leave the viewport. Its
+ * buffers are reused from one call to the next.
  */
 
 // The reason for this class is a terrible bug in some versions of the
@@ -66,6 +65,18 @@ class MARBLE_EXPORT ClipPainter : public QPainter
     void drawPolyline( const QPolygonF &, QVector<QPointF>& labelNodes, 
                        LabelPositionFlags labelPositionFlag = LineCenter );
 
+    /**
+     * @brief Clips @p polygon to @p clipRect without painting it
+     *
+     * Uses the same algorithm as the draw methods, so polygons can be clipped
+     * ahead of painting, e.g. on other threads, and be drawn with screen clip
+     * disabled afterwards. Pieces which would not get drawn are dropped.
+     *
+     * @param isClosed whether @p polygon is a polygon rather than a polyline
+     */
+    static void clip( const QPolygonF &polygon, const QRectF &clipRect, bool isClosed,
+                      QVector<QPolygonF> &clippedPolygons );
+
     //	void clearNodeCount(){ m_debugNodeCount = 0; }
     //	int nodeCount(){ return m_debugNodeCount; }
 
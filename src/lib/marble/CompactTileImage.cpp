@@ -0,0 +1,169 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "CompactTileImage.h"
+
+#include <QHash>
+
+#include <cstring>
+
+namespace Marble
+{
+
+CompactTileImage::CompactTileImage() :
+    m_encoding( UncompressedTiles ),
+    m_format( QImage::Format_Invalid )
+{
+}
+
+CompactTileImage::CompactTileImage( const QImage &image, TileCacheEncoding encoding ) :
+    m_encoding( encoding ),
+    m_format( image.format() ),
+    m_size( image.size() )
+{
+    if ( image.isNull() ) {
+        m_encoding = UncompressedTiles;
+        return;
+    }
+
+    // 16 bit and palettized images can't hold an alpha channel
+    if ( ( m_encoding == Rgb565Tiles || m_encoding == PalettizedTiles )
+         && ( image.depth() != 32 || !isOpaque( image ) ) ) {
+        m_encoding = CompressedTiles;
+    }
+
+    switch ( m_encoding ) {
+    case UncompressedTiles:
+        m_image = image;
+        break;
+    case Rgb565Tiles:
+        m_image = image.convertToFormat( QImage::Format_RGB16 );
+        break;
+    case PalettizedTiles:
+        if ( !palettize( image ) ) {
+            m_encoding = CompressedTiles;
+            compress( image );
+        }
+        break;
+    case CompressedTiles:
+        compress( image );
+        break;
+    }
+}
+
+bool CompactTileImage::isNull() const
+{
+    return m_format == QImage::Format_Invalid;
+}
+
+TileCacheEncoding CompactTileImage::encoding() const
+{
+    return m_encoding;
+}
+
+int CompactTileImage::byteCount() const
+{
+    return m_image.byteCount() + m_data.size() + ( m_colorTable.size() + m_image.colorCount() ) * sizeof( QRgb );
+}
+
+QImage CompactTileImage::toImage() const
+{
+    switch ( m_encoding ) {
+    case UncompressedTiles:
+        return m_image;
+    case Rgb565Tiles:
+        return m_image.convertToFormat( m_format );
+    case PalettizedTiles: {
+        // QImage::convertToFormat() would premultiply the colors of the palette
+        // once more, so look up the original pixels ourselves
+        QImage result( m_size, m_format );
+        const QVector<QRgb> colorTable = m_image.colorTable();
+        for ( int y = 0; y < m_size.height(); ++y ) {
+            const uchar *source = m_image.constScanLine( y );
+            QRgb *destination = reinterpret_cast<QRgb *>( result.scanLine( y ) );
+            for ( int x = 0; x < m_size.width(); ++x ) {
+                destination[x] = colorTable[source[x]];
+            }
+        }
+        return result;
+    }
+    case CompressedTiles: {
+        if ( isNull() ) {
+            return QImage();
+        }
+
+        const QByteArray pixels = qUncompress( m_data );
+        QImage result( m_size, m_format );
+        Q_ASSERT( pixels.size() == result.byteCount() );
+        memcpy( result.bits(), pixels.constData(), qMin( pixels.size(), result.byteCount() ) );
+        if ( !m_colorTable.isEmpty() ) {
+            result.setColorTable( m_colorTable );
+        }
+        return result;
+    }
+    }
+
+    return QImage();
+}
+
+bool CompactTileImage::isOpaque( const QImage &image )
+{
+    if ( !image.hasAlphaChannel() ) {
+        return true;
+    }
+
+    for ( int y = 0; y < image.height(); ++y ) {
+        const QRgb *line = reinterpret_cast<const QRgb *>( image.constScanLine( y ) );
+        for ( int x = 0; x < image.width(); ++x ) {
+            if ( qAlpha( line[x] ) != 255 ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool CompactTileImage::palettize( const QImage &image )
+{
+    QImage indexed( m_size, QImage::Format_Indexed8 );
+    QHash<QRgb, int> indexes;
+    QVector<QRgb> colorTable;
+
+    for ( int y = 0; y < m_size.height(); ++y ) {
+        const QRgb *source = reinterpret_cast<const QRgb *>( image.constScanLine( y ) );
+        uchar *destination = indexed.scanLine( y );
+        for ( int x = 0; x < m_size.width(); ++x ) {
+            QHash<QRgb, int>::const_iterator it = indexes.constFind( source[x] );
+            if ( it == indexes.constEnd() ) {
+                if ( colorTable.size() == 256 ) {
+                    return false;
+                }
+                it = indexes.insert( source[x], colorTable.size() );
+                colorTable.append( source[x] );
+            }
+            destination[x] = it.value();
+        }
+    }
+
+    indexed.setColorTable( colorTable );
+    m_image = indexed;
+
+    return true;
+}
+
+void CompactTileImage::compress( const QImage &image )
+{
+    // favor speed over size, tiles are compressed whenever they disappear from the screen
+    m_data = qCompress( image.constBits(), image.byteCount(), 1 );
+    m_colorTable = image.colorTable();
+}
+
+}
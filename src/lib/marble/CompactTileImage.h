@@ -0,0 +1,80 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_COMPACTTILEIMAGE_H
+#define MARBLE_COMPACTTILEIMAGE_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QVector>
+
+#include "MarbleGlobal.h"
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short A tile image encoded to save memory
+ *
+ * Tiles in the volatile tile cache are not displayed, so they don't need
+ * to be kept in the 32 bit formats the texture mappers read. A compact tile
+ * image stores such a tile in a smaller encoding and restores an image of the
+ * original format and size by toImage().
+ *
+ * Rgb565Tiles and PalettizedTiles only apply to opaque 32 bit images. For
+ * other images, and for images with more than 256 colors in case of
+ * PalettizedTiles, the image is compressed instead.
+ */
+class MARBLE_EXPORT CompactTileImage
+{
+ public:
+    /**
+     * Constructs a null image.
+     */
+    CompactTileImage();
+
+    CompactTileImage( const QImage &image, TileCacheEncoding encoding );
+
+    bool isNull() const;
+
+    /**
+     * Returns the encoding actually used, which may differ from the one
+     * requested if the image does not qualify for it.
+     */
+    TileCacheEncoding encoding() const;
+
+    /**
+     * Returns the memory needed by the encoded image.
+     */
+    int byteCount() const;
+
+    QImage toImage() const;
+
+ private:
+    static bool isOpaque( const QImage &image );
+    bool palettize( const QImage &image );
+    void compress( const QImage &image );
+
+    TileCacheEncoding m_encoding;
+    QImage::Format m_format;
+    QSize m_size;
+
+    // the image in the 16 bit or 8 bit format, or the uncompressed image
+    QImage m_image;
+
+    // the pixels of a compressed image
+    QByteArray m_data;
+    QVector<QRgb> m_colorTable;
+};
+
+}
+
+#endif
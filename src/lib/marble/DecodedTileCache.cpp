@@ -0,0 +1,245 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "DecodedTileCache.h"
+
+#include <QDir>
+#include <QMutexLocker>
+#include <QTime>
+
+#include <cstring>
+
+#include "CacheStatistics.h"
+#include "MarbleDebug.h"
+
+namespace Marble
+{
+
+// Slots start at page boundaries, so restoring a tile touches as few pages as possible.
+static const qint64 pageSize = 4096;
+
+DecodedTileCache::Slot::Slot()
+    : format( QImage::Format_Invalid ),
+      isUsed( false )
+{
+}
+
+DecodedTileCache::DecodedTileCache()
+    : m_maximumSize( 0 ),
+      m_file( QDir::tempPath() + "/marble-tiles-XXXXXX.cache" ),
+      m_data( 0 ),
+      m_bytesPerLine( 0 ),
+      m_slotSize( 0 ),
+      m_nextSlot( 0 ),
+      m_statistics( 0 )
+{
+}
+
+DecodedTileCache::~DecodedTileCache()
+{
+    unmap();
+}
+
+void DecodedTileCache::setMaximumSize( quint64 bytes )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( bytes == m_maximumSize ) {
+        return;
+    }
+
+    // the slots are laid out again on the next insertion
+    m_maximumSize = bytes;
+    unmap();
+}
+
+quint64 DecodedTileCache::maximumSize() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_maximumSize;
+}
+
+bool DecodedTileCache::isEnabled() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_maximumSize > 0;
+}
+
+QImage DecodedTileCache::find( const TileId &tileId, const QString &key ) const
+{
+    QMutexLocker locker( &m_mutex );
+
+    const int index = m_slotIndex.value( tileId, -1 );
+    if ( index < 0 || m_slots[index].key != key ) {
+        if ( m_statistics && m_maximumSize > 0 ) {
+            m_statistics->addMiss( CacheStatistics::DecodedTileCache );
+        }
+        return QImage();
+    }
+
+    const Slot &slot = m_slots[index];
+    QImage image( m_imageSize, slot.format );
+    if ( image.isNull() ) {
+        return QImage();
+    }
+
+    QTime timer;
+    timer.start();
+
+    Q_ASSERT( image.bytesPerLine() == m_bytesPerLine );
+    memcpy( image.bits(), m_data + index * m_slotSize, m_bytesPerLine * m_imageSize.height() );
+
+    if ( m_statistics ) {
+        // pages which are not in memory anymore are read from the file
+        m_statistics->addHit( CacheStatistics::DecodedTileCache );
+        m_statistics->addTime( CacheStatistics::DecodedTileCache, CacheStatistics::DiskReadTime, timer.elapsed() );
+    }
+
+    return image;
+}
+
+void DecodedTileCache::insert( const TileId &tileId, const QString &key, const QImage &image )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( m_maximumSize == 0 || image.isNull() || image.depth() != 32 ) {
+        return;
+    }
+
+    if ( !m_data || image.size() != m_imageSize || image.bytesPerLine() != m_bytesPerLine ) {
+        // the map theme changed, or this is the first tile
+        unmap();
+        if ( !layoutSlots( image ) ) {
+            return;
+        }
+    }
+
+    int index = m_slotIndex.value( tileId, -1 );
+    if ( index < 0 ) {
+        index = m_nextSlot;
+        m_nextSlot = ( m_nextSlot + 1 ) % m_slots.size();
+
+        if ( m_slots[index].isUsed ) {
+            m_slotIndex.remove( m_slots[index].tileId );
+            if ( m_statistics ) {
+                m_statistics->addEvictions( CacheStatistics::DecodedTileCache );
+            }
+        }
+        m_slotIndex.insert( tileId, index );
+        updateByteCount();
+    }
+
+    Slot &slot = m_slots[index];
+    slot.tileId = tileId;
+    slot.key = key;
+    slot.format = image.format();
+    slot.isUsed = true;
+
+    memcpy( m_data + index * m_slotSize, image.constBits(), m_bytesPerLine * m_imageSize.height() );
+}
+
+void DecodedTileCache::remove( const TileId &tileId )
+{
+    QMutexLocker locker( &m_mutex );
+
+    const int index = m_slotIndex.value( tileId, -1 );
+    if ( index < 0 ) {
+        return;
+    }
+
+    m_slotIndex.remove( tileId );
+    m_slots[index] = Slot();
+    updateByteCount();
+}
+
+void DecodedTileCache::clear()
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_slotIndex.clear();
+    m_slots.fill( Slot() );
+    m_nextSlot = 0;
+    updateByteCount();
+}
+
+void DecodedTileCache::setCacheStatistics( CacheStatistics *statistics )
+{
+    QMutexLocker locker( &m_mutex );
+    m_statistics = statistics;
+}
+
+int DecodedTileCache::count() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_slotIndex.size();
+}
+
+bool DecodedTileCache::layoutSlots( const QImage &image )
+{
+    // m_mutex is locked, nothing is mapped
+    const qint64 imageBytes = qint64( image.bytesPerLine() ) * image.height();
+    const qint64 slotSize = ( imageBytes + pageSize - 1 ) / pageSize * pageSize;
+    const qint64 slotCount = qint64( m_maximumSize ) / slotSize;
+
+    if ( slotCount == 0 ) {
+        return false;
+    }
+
+    if ( !m_file.isOpen() && !m_file.open() ) {
+        mDebug() << Q_FUNC_INFO << "could not create" << m_file.fileTemplate();
+        return false;
+    }
+
+    if ( !m_file.resize( slotCount * slotSize ) ) {
+        mDebug() << Q_FUNC_INFO << "could not resize" << m_file.fileName() << "to" << slotCount * slotSize << "bytes";
+        return false;
+    }
+
+    m_data = m_file.map( 0, slotCount * slotSize );
+    if ( !m_data ) {
+        mDebug() << Q_FUNC_INFO << "could not map" << m_file.fileName();
+        return false;
+    }
+
+    m_imageSize = image.size();
+    m_bytesPerLine = image.bytesPerLine();
+    m_slotSize = slotSize;
+    m_slots.fill( Slot(), int( slotCount ) );
+    m_nextSlot = 0;
+
+    return true;
+}
+
+void DecodedTileCache::unmap()
+{
+    // m_mutex is locked
+    if ( m_data ) {
+        m_file.unmap( m_data );
+        m_data = 0;
+    }
+
+    m_imageSize = QSize();
+    m_bytesPerLine = 0;
+    m_slotSize = 0;
+    m_slots.clear();
+    m_slotIndex.clear();
+    m_nextSlot = 0;
+    updateByteCount();
+}
+
+void DecodedTileCache::updateByteCount()
+{
+    // m_mutex is locked
+    if ( m_statistics ) {
+        m_statistics->setByteCount( CacheStatistics::DecodedTileCache, m_slotIndex.size() * m_slotSize );
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_DECODEDTILECACHE_H
+#define MARBLE_DECODEDTILECACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include "marble_export.h"
+#include "TileId.h"
+
+namespace Marble
+{
+
+class CacheStatistics;
+
+/**
+ * @short Second level cache for decoded and blended tile images
+ *
+ * Tiles which are dropped from the cache in RAM have to be decoded and
+ * blended again when they are needed another time. This cache keeps
+ * their pixels in a memory-mapped temporary file instead, so that a tile
+ * can be restored by copying its pixels from the page cache.
+ *
+ * The file is divided into page-aligned slots of the size of one tile.
+ * If all slots are taken, the tile stored first gets replaced.
+ * Only 32 bit images are cached.
+ *
+ * Each tile is stored together with a key describing how the tile was
+ * created, e.g. which texture layers were blended. Tiles are only found
+ * if the key matches.
+ *
+ * This class is thread-safe.
+ */
+class MARBLE_EXPORT DecodedTileCache
+{
+ public:
+    DecodedTileCache();
+    ~DecodedTileCache();
+
+    /**
+     * Sets the maximum size of the cache file. A size of 0 disables the cache,
+     * which is the default.
+     */
+    void setMaximumSize( quint64 bytes );
+    quint64 maximumSize() const;
+
+    bool isEnabled() const;
+
+    /**
+     * Returns a copy of the cached image of the given tile, or a null image
+     * if the tile is not cached for the given @p key.
+     */
+    QImage find( const TileId &tileId, const QString &key ) const;
+
+    void insert( const TileId &tileId, const QString &key, const QImage &image );
+
+    void remove( const TileId &tileId );
+
+    void clear();
+
+    /**
+     * Returns the number of tiles in the cache.
+     */
+    int count() const;
+
+    /**
+     * Sets the statistics which hits, misses and evictions are reported to.
+     */
+    void setCacheStatistics( CacheStatistics *statistics );
+
+ private:
+    Q_DISABLE_COPY( DecodedTileCache )
+
+    struct Slot
+    {
+        Slot();
+
+        TileId tileId;
+        QString key;
+        QImage::Format format;
+        bool isUsed;
+    };
+
+    bool layoutSlots( const QImage &image );
+    void unmap();
+    void updateByteCount();
+
+    mutable QMutex m_mutex;
+    quint64 m_maximumSize;
+
+    QTemporaryFile m_file;
+    uchar *m_data;
+
+    // geometry of the images in the slots
+    QSize m_imageSize;
+    int m_bytesPerLine;
+    qint64 m_slotSize;
+
+    QVector<Slot> m_slots;
+    QHash<TileId, int> m_slotIndex;
+    int m_nextSlot;
+
+    CacheStatistics *m_statistics;
+};
+
+}
+
+#endif
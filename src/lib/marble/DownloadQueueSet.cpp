@@ -17,19 +17,22 @@
 
 #include "MarbleDebug.h"
 
+#include "CacheStatistics.h"
 #include "HttpJob.h"
 
 namespace Marble
 {
 
 DownloadQueueSet::DownloadQueueSet( QObject * const parent )
-    : QObject( parent )
+    : QObject( parent ),
+      m_statistics( 0 )
 {
 }
 
 DownloadQueueSet::DownloadQueueSet( DownloadPolicy const & policy, QObject * const parent )
     : QObject( parent ),
-      m_downloadPolicy( policy )
+      m_downloadPolicy( policy ),
+      m_statistics( 0 )
 {
 }
 
@@ -73,8 +76,21 @@ bool DownloadQueueSet::canAcceptJob( const QUrl& sourceUrl,
     return true;
 }
 
+bool DownloadQueueSet::canAcceptPrefetchJob( const QUrl& sourceUrl,
+                                             const QString& destinationFileName ) const
+{
+    return !m_prefetchJobs.contains( destinationFileName )
+        && canAcceptJob( sourceUrl, destinationFileName );
+}
+
 void DownloadQueueSet::addJob( HttpJob * const job )
 {
+    // the file is needed now rather than soon
+    HttpJob * const prefetchJob = m_prefetchJobs.take( job->destinationFileName() );
+    if ( prefetchJob ) {
+        prefetchJob->deleteLater();
+    }
+
     m_jobs.push( job );
     mDebug() << "addJob: new job queue size:" << m_jobs.count();
     emit jobAdded();
@@ -82,6 +98,21 @@ void DownloadQueueSet::addJob( HttpJob * const job )
     activateJobs();
 }
 
+void DownloadQueueSet::addPrefetchJob( HttpJob * const job )
+{
+    m_prefetchJobs.push( job );
+    mDebug() << "addPrefetchJob: new prefetch queue size:" << m_prefetchJobs.count();
+    activateJobs();
+}
+
+void DownloadQueueSet::cancelPrefetchJobs()
+{
+    while ( !m_prefetchJobs.isEmpty() ) {
+        HttpJob * const job = m_prefetchJobs.pop();
+        job->deleteLater();
+    }
+}
+
 void DownloadQueueSet::activateJobs()
 {
     while ( !m_jobs.isEmpty()
@@ -90,6 +121,15 @@ void DownloadQueueSet::activateJobs()
         HttpJob * const job = m_jobs.pop();
         activateJob( job );
     }
+
+    // leave connections for jobs which are added while the prefetch jobs are active
+    const int maximumPrefetchConnections = qMax( 1, m_downloadPolicy.maximumConnections() / 2 );
+    while ( m_jobs.isEmpty() && !m_prefetchJobs.isEmpty()
+            && m_activeJobs.count() < maximumPrefetchConnections )
+    {
+        HttpJob * const job = m_prefetchJobs.pop();
+        activateJob( job );
+    }
 }
 
 void DownloadQueueSet::retryJobs()
@@ -109,6 +149,7 @@ void DownloadQueueSet::purgeJobs()
         HttpJob * const job = m_jobs.pop();
         job->deleteLater();
     }
+    cancelPrefetchJobs();
 
     // purge all retry jobs
     qDeleteAll( m_retryQueue );
@@ -122,10 +163,19 @@ void DownloadQueueSet::purgeJobs()
     emit progressChanged( m_activeJobs.size(), m_jobs.count() );
 }
 
+void DownloadQueueSet::setCacheStatistics( CacheStatistics *statistics )
+{
+    m_statistics = statistics;
+}
+
 void DownloadQueueSet::finishJob( HttpJob * job, const QByteArray& data )
 {
     mDebug() << "finishJob: " << job->sourceUrl() << job->destinationFileName();
 
+    if ( m_statistics ) {
+        m_statistics->addTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency, job->elapsed() );
+    }
+
     deactivateJob( job );
     emit jobRemoved();
     emit jobFinished( data, job->destinationFileName(), job->initiatorId() );
@@ -273,6 +323,24 @@ inline void DownloadQueueSet::JobStack::push( HttpJob * const job )
     m_jobsContent.insert( job->destinationFileName() );
 }
 
+HttpJob * DownloadQueueSet::JobStack::take( const QString& destinationFileName )
+{
+    if ( !m_jobsContent.remove( destinationFileName ) ) {
+        return 0;
+    }
+
+    for ( int i = 0; i < m_jobs.count(); ++i ) {
+        if ( m_jobs.at( i )->destinationFileName() == destinationFileName ) {
+            HttpJob * const job = m_jobs.at( i );
+            m_jobs.remove( i );
+            return job;
+        }
+    }
+
+    Q_ASSERT_X( false, "JobStack::take", "job not found" ); // not reached
+    return 0;
+}
+
 
 }
 
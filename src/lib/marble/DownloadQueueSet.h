@@ -28,6 +28,7 @@
 namespace Marble
 {
 
+class CacheStatistics;
 class HttpJob;
 
 /**
@@ -85,10 +86,29 @@ class DownloadQueueSet: public QObject
                        const QString& destinationFileName ) const;
     void addJob( HttpJob * const job );
 
+    /**
+     * Prefetch jobs are only activated if no other jobs are waiting, and they
+     * use at most half of the connections. If a regular job is added for the
+     * same file, it replaces the prefetch job.
+     */
+    bool canAcceptPrefetchJob( const QUrl& sourceUrl,
+                               const QString& destinationFileName ) const;
+    void addPrefetchJob( HttpJob * const job );
+
+    /**
+     * Removes all prefetch jobs which are still waiting for activation.
+     */
+    void cancelPrefetchJobs();
+
     void activateJobs();
     void retryJobs();
     void purgeJobs();
 
+    /**
+     * Sets the statistics which the latency of finished jobs is reported to.
+     */
+    void setCacheStatistics( CacheStatistics *statistics );
+
  Q_SIGNALS:
     void jobAdded();
     void jobRemoved();
@@ -125,12 +145,16 @@ class DownloadQueueSet: public QObject
         bool isEmpty() const;
         HttpJob * pop();
         void push( HttpJob * const );
+        HttpJob * take( const QString& destinationFileName );
     private:
         QStack<HttpJob*> m_jobs;
         QSet<QString> m_jobsContent;
     };
     JobStack m_jobs;
 
+    /// Contains the jobs of tiles which are expected to be needed soon.
+    JobStack m_prefetchJobs;
+
     /// Contains the jobs which are currently being downloaded.
     QList<HttpJob*> m_activeJobs;
 
@@ -141,6 +165,8 @@ class DownloadQueueSet: public QObject
 
     /// Contains the blacklisted source urls
     QSet<QString> m_jobBlackList;
+
+    CacheStatistics *m_statistics;
 };
 
 }
@@ -9,6 +9,7 @@
 //
 
 #include "ElevationModel.h"
+#include "CacheStatistics.h"
 #include "GeoSceneHead.h"
 #include "GeoSceneLayer.h"
 #include "GeoSceneMap.h"
@@ -34,7 +35,8 @@ public:
     ElevationModelPrivate( ElevationModel *_q, HttpDownloadManager *downloadManager )
         : q( _q ),
           m_tileLoader( downloadManager, 0 ),
-          m_textureLayer( 0 )
+          m_textureLayer( 0 ),
+          m_statistics( 0 )
     {
         m_cache.setMaxCost( 10 ); //keep 10 tiles in memory (~17MB)
 
@@ -59,16 +61,32 @@ public:
 
     void tileCompleted( const TileId & tileId, const QImage &image )
     {
-        m_cache.insert( tileId, new QImage( image ) );
+        insertTile( tileId, new QImage( image ) );
         emit q->updateAvailable();
     }
 
+    void insertTile( const TileId &tileId, const QImage *image )
+    {
+        const int count = m_cache.count();
+        const bool replaced = m_cache.contains( tileId );
+        const qint64 byteCount = image->byteCount();
+
+        m_cache.insert( tileId, image );
+
+        if ( m_statistics ) {
+            // all tiles have the same size, and QCache silently deletes the least recently used ones
+            m_statistics->addEvictions( CacheStatistics::ElevationTileCache, count + ( replaced ? 0 : 1 ) - m_cache.count() );
+            m_statistics->setByteCount( CacheStatistics::ElevationTileCache, m_cache.count() * byteCount );
+        }
+    }
+
 public:
     ElevationModel *q;
 
     TileLoader m_tileLoader;
     const GeoSceneTextureTile *m_textureLayer;
     QCache<TileId, const QImage> m_cache;
+    CacheStatistics *m_statistics;
 };
 
 ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, QObject *parent ) :
@@ -118,9 +136,16 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         //mDebug() << "LAT" << lat << "LON" << lon << "tile" << ( x % ( numTilesX * width ) ) / width << ( y % ( numTilesY * height ) ) / height;
 
         const QImage *image = d->m_cache[id];
+        if ( d->m_statistics ) {
+            if ( image ) {
+                d->m_statistics->addHit( CacheStatistics::ElevationTileCache );
+            } else {
+                d->m_statistics->addMiss( CacheStatistics::ElevationTileCache );
+            }
+        }
         if ( image == 0 ) {
             image = new QImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) );
-            d->m_cache.insert( id, image );
+            d->insertTile( id, image );
         }
         Q_ASSERT( image );
         Q_ASSERT( !image->isNull() );
@@ -159,6 +184,12 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
     return ret;
 }
 
+void ElevationModel::setCacheStatistics( CacheStatistics *statistics )
+{
+    d->m_statistics = statistics;
+    d->m_tileLoader.setCacheStatistics( statistics );
+}
+
 QList<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const
 {
     if ( !d->m_textureLayer ) {
@@ -26,6 +26,7 @@ namespace {
     unsigned int const invalidElevationData = 32768;
 }
 
+class CacheStatistics;
 class TileId;
 class ElevationModelPrivate;
 class HttpDownloadManager;
@@ -39,6 +40,11 @@ public:
     qreal height( qreal lon, qreal lat ) const;
     QList<GeoDataCoordinates> heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const;
 
+    /**
+     * Sets the statistics which the tile cache of this model reports to.
+     */
+    void setCacheStatistics( CacheStatistics *statistics );
+
 Q_SIGNALS:
     /**
      * Elevation tiles loaded. You will get more accurate results when querying height
@@ -17,7 +17,7 @@
 #include <cmath>
 
 // Qt
-#include <QRunnable>
+#include <QRegion>
 
 // Marble
 #include "GeoPainter.h"
@@ -29,12 +29,12 @@
 
 using namespace Marble;
 
-class EquirectScanlineTextureMapper::RenderJob : public QRunnable
+class EquirectScanlineTextureMapper::RenderJob : public TextureMapperScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewportParams, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewportParams, MapQuality mapQuality, int xLeft, int xRight );
 
-    virtual void run();
+    virtual void renderLines( int yPaintedTop, int yPaintedBottom );
 
 private:
     StackedTileLoader *const m_tileLoader;
@@ -42,27 +42,34 @@ private:
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yPaintedTop;
-    const int m_yPaintedBottom;
+    const int m_xPaintedLeft;
+    const int m_xPaintedRight;
 };
 
-EquirectScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+EquirectScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int xLeft, int xRight )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
       m_mapQuality( mapQuality ),
-      m_yPaintedTop( yTop ),
-      m_yPaintedBottom( yBottom )
+      m_xPaintedLeft( xLeft ),
+      m_xPaintedRight( xRight )
 {
 }
 
+// Maximum deviation of a center movement from a whole number of pixels
+// for which the previous result may still be shifted instead of repainted
+static const qreal maxTranslationError = 0.01;
 
 EquirectScanlineTextureMapper::EquirectScanlineTextureMapper( StackedTileLoader *tileLoader )
     : TextureMapperInterface(),
       m_tileLoader( tileLoader ),
       m_radius( 0 ),
-      m_oldYPaintedTop( 0 )
+      m_oldYPaintedTop( 0 ),
+      m_paintedCenterLon( 0.0 ),
+      m_paintedYCenterOffset( 0 ),
+      m_paintedTileLevel( -1 ),
+      m_paintedMapQuality( NormalQuality )
 {
 }
 
@@ -87,6 +94,11 @@ void EquirectScanlineTextureMapper::mapTexture( GeoPainter *painter,
         m_repaintNeeded = true;
     }
 
+    if ( !m_repaintNeeded ) {
+        // At most the center changed, which is a pure translation in this projection.
+        m_repaintNeeded = !mapTranslatedTexture( viewport, tileZoomLevel, painter->mapQuality(), texColorizer );
+    }
+
     if ( m_repaintNeeded ) {
         mapTexture( viewport, tileZoomLevel, painter->mapQuality() );
 
@@ -100,6 +112,16 @@ void EquirectScanlineTextureMapper::mapTexture( GeoPainter *painter,
     painter->drawImage( dirtyRect, m_canvasImage, dirtyRect );
 }
 
+QString EquirectScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.runtimeTrace();
+}
+
+void EquirectScanlineTextureMapper::setCenterChanged()
+{
+    // mapTexture() takes care of center changes by translating the previous result
+}
+
 void EquirectScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
 {
     // Reset backend
@@ -128,14 +150,8 @@ void EquirectScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     if (yPaintedBottom < 0)             yPaintedBottom = 0;
     if (yPaintedBottom > imageHeight) yPaintedBottom = imageHeight;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = ( yPaintedBottom - yPaintedTop ) / numThreads;
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yPaintedTop +  i      * yStep;
-        const int yEnd   = yPaintedTop + (i + 1) * yStep;
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
+    m_scheduler.schedule( new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, 0, m_canvasImage.width() ),
+                          yPaintedTop, yPaintedBottom );
 
     // Remove unused lines
     const int clearStart = ( yPaintedTop - m_oldYPaintedTop <= 0 ) ? yPaintedBottom : 0;
@@ -148,14 +164,119 @@ void EquirectScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
         *(it) = 0;
     }
 
-    m_threadPool.waitForDone();
+    m_scheduler.run();
+
+    m_oldYPaintedTop = yPaintedTop;
+
+    m_paintedCenterLon = viewport->centerLongitude();
+    m_paintedYCenterOffset = (int)( centerLat * ( (qreal)( 2 * radius ) / M_PI ) );
+    m_paintedTileLevel = tileZoomLevel;
+    m_paintedMapQuality = mapQuality;
+
+    m_tileLoader->cleanupTilehash();
+}
+
+bool EquirectScanlineTextureMapper::mapTranslatedTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality,
+                                                          const TextureColorizer *texColorizer )
+{
+    const int imageHeight = m_canvasImage.height();
+    const int imageWidth  = m_canvasImage.width();
+    const qint64  radius  = viewport->radius();
+    // Same precision as used by RenderJob
+    const qreal rad2Pixel = (qreal)( 2 * radius ) / M_PI;
+    const float pixel2Rad = 1.0/rad2Pixel;
+
+    const int yCenterOffset = (int)( viewport->centerLatitude() * rad2Pixel );
+
+    qreal deltaLon = viewport->centerLongitude() - m_paintedCenterLon;
+    if ( deltaLon > M_PI ) deltaLon -= 2 * M_PI;
+    if ( deltaLon < -M_PI ) deltaLon += 2 * M_PI;
+
+    // Movement of the map on the screen
+    const qreal exactDx = -deltaLon / pixel2Rad;
+    const int dx = qRound( exactDx );
+    const int dy = yCenterOffset - m_paintedYCenterOffset;
+
+    if ( qAbs( exactDx - dx ) > maxTranslationError ) {
+        return false;
+    }
+
+    if ( dx == 0 && dy == 0 ) {
+        return true;
+    }
+
+    // The colorizer works on the whole canvas and can't be applied twice.
+    if ( texColorizer
+         || tileZoomLevel != m_paintedTileLevel
+         || mapQuality != m_paintedMapQuality
+         || qAbs( dx ) >= imageWidth
+         || qAbs( dy ) >= imageHeight ) {
+        return false;
+    }
+
+    ScanlineTextureMapperContext::translateCanvasImage( &m_canvasImage, dx, dy );
+
+    // Keep track of the center the canvas actually shows, so that
+    // deviations from whole pixels don't add up over several moves.
+    m_paintedCenterLon -= dx * pixel2Rad;
+    if ( m_paintedCenterLon > M_PI ) m_paintedCenterLon -= 2 * M_PI;
+    if ( m_paintedCenterLon < -M_PI ) m_paintedCenterLon += 2 * M_PI;
+    m_paintedYCenterOffset = yCenterOffset;
 
+    const int yTop = imageHeight / 2 - radius + yCenterOffset;
+    const int yPaintedTop    = qBound( 0, yTop, imageHeight );
+    const int yPaintedBottom = qBound( 0, yTop + 2 * (int)radius, imageHeight );
     m_oldYPaintedTop = yPaintedTop;
 
+    QRegion exposed;
+    if ( dy > 0 ) {
+        exposed += QRect( 0, 0, imageWidth, dy );
+    }
+    else if ( dy < 0 ) {
+        exposed += QRect( 0, imageHeight + dy, imageWidth, -dy );
+    }
+    if ( dx > 0 ) {
+        exposed += QRect( 0, 0, dx, imageHeight );
+    }
+    else if ( dx < 0 ) {
+        exposed += QRect( imageWidth + dx, 0, -dx, imageHeight );
+    }
+
+    // Lines at the border of the map might round differently after the move
+    exposed += QRect( 0, yPaintedTop - 1, imageWidth, 2 );
+    exposed += QRect( 0, yPaintedBottom - 1, imageWidth, 2 );
+    exposed &= QRect( 0, 0, imageWidth, imageHeight );
+
+    // Reset backend
+    m_tileLoader->resetTilehash();
+
+    foreach ( const QRect &rect, exposed.rects() ) {
+        const int top    = qMax( rect.top(), yPaintedTop );
+        const int bottom = qMin( rect.bottom() + 1, yPaintedBottom );
+        if ( top < bottom ) {
+            m_scheduler.schedule( new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality,
+                                                 rect.left(), rect.right() + 1 ),
+                                  top, bottom );
+        }
+
+        // Remove exposed lines outside of the map
+        const int pixelByteSize = m_canvasImage.bytesPerLine() / imageWidth;
+        for ( int y = rect.top(); y <= rect.bottom(); ++y ) {
+            if ( y < yPaintedTop || y >= yPaintedBottom ) {
+                memset( m_canvasImage.scanLine( y ) + rect.left() * pixelByteSize, 0,
+                        rect.width() * pixelByteSize );
+            }
+        }
+    }
+
+    m_scheduler.run();
+
     m_tileLoader->cleanupTilehash();
+
+    return true;
 }
 
-void EquirectScanlineTextureMapper::RenderJob::run()
+void EquirectScanlineTextureMapper::RenderJob::renderLines( int yPaintedTop, int yPaintedBottom )
 {
     // Scanline based algorithm to do texture mapping
 
@@ -186,7 +307,7 @@ void EquirectScanlineTextureMapper::RenderJob::run()
     while ( leftLon < -M_PI ) leftLon += 2 * M_PI;
     while ( leftLon >  M_PI ) leftLon -= 2 * M_PI;
 
-    const int maxInterpolationPointX = n * (int)( imageWidth / n - 1 ) + 1;
+    const int maxInterpolationPointX = m_xPaintedLeft + n * (int)( ( m_xPaintedRight - m_xPaintedLeft ) / n - 1 ) + 1;
 
 
     // initialize needed variables that are modified during texture mapping:
@@ -196,18 +317,18 @@ void EquirectScanlineTextureMapper::RenderJob::run()
 
     // Scanline based algorithm to do texture mapping
 
-    for ( int y = m_yPaintedTop; y < m_yPaintedBottom; ++y ) {
+    for ( int y = yPaintedTop; y < yPaintedBottom; ++y ) {
 
-        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) );
+        QRgb * scanLine = (QRgb*)( m_canvasImage->scanLine( y ) ) + m_xPaintedLeft;
 
-        qreal lon = leftLon;
+        qreal lon = leftLon + m_xPaintedLeft * pixel2Rad;
         const qreal lat = M_PI/2 - (y - yTop )* pixel2Rad;
 
-        for ( int x = 0; x < imageWidth; ++x ) {
+        for ( int x = m_xPaintedLeft; x < m_xPaintedRight; ++x ) {
 
             // Prepare for interpolation
             bool interpolate = false;
-            if ( x > 0 && x <= maxInterpolationPointX ) {
+            if ( x > m_xPaintedLeft && x <= maxInterpolationPointX ) {
                 x += n - 1;
                 lon += (n - 1) * pixel2Rad;
                 interpolate = !printQuality;
@@ -228,7 +349,7 @@ void EquirectScanlineTextureMapper::RenderJob::run()
                 scanLine += ( n - 1 );
             }
 
-            if ( x < imageWidth ) {
+            if ( x < m_xPaintedRight ) {
                 if ( highQuality )
                     context.pixelValueF( lon, lat, scanLine );
                 else
@@ -240,13 +361,13 @@ void EquirectScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yPaintedBottom ) { 
+        if ( interlaced && y + 1 < yPaintedBottom ) { 
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
-            memcpy( m_canvasImage->scanLine( y + 1 ),
-                    m_canvasImage->scanLine( y     ),
-                    imageWidth * pixelByteSize );
+            memcpy( m_canvasImage->scanLine( y + 1 ) + m_xPaintedLeft * pixelByteSize,
+                    m_canvasImage->scanLine( y     ) + m_xPaintedLeft * pixelByteSize,
+                    ( m_xPaintedRight - m_xPaintedLeft ) * pixelByteSize );
             ++y;
         }
     }
@@ -10,10 +10,13 @@
 
 #include "FileLoader.h"
 
+#include <QAtomicInt>
 #include <QBuffer>
 #include <QDataStream>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QMutex>
 #include <QThread>
 
 #include "GeoDataParser.h"
@@ -35,6 +38,24 @@
 namespace Marble
 {
 
+class FileLoaderPrivate;
+
+/**
+ * Reads a KML file and passes each completed placemark on to the loader,
+ * which shows it before the rest of the file has been read.
+ */
+class StreamingKmlParser : public GeoDataParser
+{
+public:
+    explicit StreamingKmlParser( FileLoaderPrivate *loader );
+
+private:
+    virtual GeoDocument* createDocument() const;
+    virtual void nodeParsed( GeoNode* node );
+
+    FileLoaderPrivate *const m_loader;
+};
+
 class FileLoaderPrivate
 {
 public:
@@ -48,7 +69,10 @@ public:
           m_style( style ),
           m_documentRole ( role ),
           m_styleMap( new GeoDataStyleMap ),
-          m_document( 0 )
+          m_document( 0 ),
+          m_discardedDocument( 0 ),
+          m_cancelled( false ),
+          m_progress( 0 )
     {
         if( m_style ) {
             m_styleMap->setId("default-map");
@@ -66,23 +90,39 @@ public:
           m_style( 0 ),
           m_documentRole ( role ),
           m_styleMap( 0 ),
-          m_document( 0 )
+          m_document( 0 ),
+          m_discardedDocument( 0 ),
+          m_cancelled( false ),
+          m_progress( 0 )
     {
     }
 
     ~FileLoaderPrivate()
     {
+        qDeleteAll( m_batch );
+        qDeleteAll( m_parsedPlacemarks );
+        delete m_discardedDocument;
         delete m_style;
         delete m_styleMap;
     }
 
     void createFilterProperties( GeoDataContainer *container );
+    void createFilterProperties( GeoDataPlacemark *placemark );
     static int cityPopIdx( qint64 population );
     static int spacePopIdx( qint64 population );
     static int areaPopIdx( qreal area );
 
     void documentParsed( GeoDataDocument *doc, const QString& error);
 
+    void parseKml( const QString &fileName );
+    bool placemarkParsed( GeoDataPlacemark *placemark, const QIODevice *device );
+    bool isCancelled();
+
+    // Placemarks are handed out when this many got parsed or when the
+    // interval in milliseconds has passed, whatever happens first
+    static const int batchSize = 1000;
+    static const int batchInterval = 100;
+
     FileLoader *q;
     ParsingRunnerManager m_runner;
     bool m_recenter;
@@ -93,9 +133,50 @@ public:
     DocumentRole m_documentRole;
     GeoDataStyleMap* m_styleMap;
     GeoDataDocument *m_document;
+    GeoDataDocument *m_discardedDocument;
     QString m_error;
+
+    // used by the loading thread only
+    QVector<GeoDataPlacemark*> m_batch;
+    QElapsedTimer m_batchTimer;
+
+    // shared with the thread of the file manager
+    QMutex m_parsedMutex;
+    QVector<GeoDataPlacemark*> m_parsedPlacemarks;
+    // set under the mutex, but read without it for every parsed placemark
+    QAtomicInt m_cancelled;
+    int m_progress;
 };
 
+StreamingKmlParser::StreamingKmlParser( FileLoaderPrivate *loader )
+    : GeoDataParser( GeoData_KML ),
+      m_loader( loader )
+{
+}
+
+GeoDocument* StreamingKmlParser::createDocument() const
+{
+    GeoDataDocument *document = new GeoDataDocument;
+
+    // The placemarks look up their style when they get handed out, so the
+    // style given to the loader has to be known from the start
+    if ( m_loader->m_style ) {
+        document->addStyleMap( *m_loader->m_styleMap );
+        document->addStyle( *m_loader->m_style );
+    }
+
+    return document;
+}
+
+void StreamingKmlParser::nodeParsed( GeoNode* node )
+{
+    if ( node->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+        if ( !m_loader->placemarkParsed( static_cast<GeoDataPlacemark*>( node ), device() ) ) {
+            raiseError( QObject::tr( "Loading was cancelled" ) );
+        }
+    }
+}
+
 FileLoader::FileLoader( QObject* parent, const PluginManager *pluginManager, bool recenter,
                        const QString& file, const QString& property, const GeoDataStyle* style, DocumentRole role )
     : QThread( parent ),
@@ -130,6 +211,31 @@ QString FileLoader::error() const
     return d->m_error;
 }
 
+DocumentRole FileLoader::documentRole() const
+{
+    return d->m_documentRole;
+}
+
+void FileLoader::cancel()
+{
+    QMutexLocker locker( &d->m_parsedMutex );
+    d->m_cancelled.fetchAndStoreRelease( 1 );
+}
+
+int FileLoader::progress() const
+{
+    QMutexLocker locker( &d->m_parsedMutex );
+    return d->m_progress;
+}
+
+QVector<GeoDataPlacemark*> FileLoader::takeParsedPlacemarks()
+{
+    QMutexLocker locker( &d->m_parsedMutex );
+    QVector<GeoDataPlacemark*> result;
+    result.swap( d->m_parsedPlacemarks );
+    return result;
+}
+
 void FileLoader::run()
 {
     if ( d->m_contents.isEmpty() ) {
@@ -163,7 +269,11 @@ void FileLoader::run()
             }
         }
 
-        if ( QFile::exists( defaultSourceName ) ) {
+        if ( QFile::exists( defaultSourceName ) && QFileInfo( defaultSourceName ).suffix().toLower() == "kml" ) {
+            // parsed here rather than by the runner to show it while loading
+            d->parseKml( defaultSourceName );
+        }
+        else if ( QFile::exists( defaultSourceName ) ) {
             mDebug() << "No recent Default Placemark Cache File available!";
 
             // use runners: pnt, gpx, osm
@@ -228,6 +338,101 @@ void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& err
     emit q->loaderFinished( q );
 }
 
+void FileLoaderPrivate::parseKml( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        qWarning() << "Could not open" << fileName;
+        emit q->loaderFinished( q );
+        return;
+    }
+
+    StreamingKmlParser parser( this );
+    m_batchTimer.start();
+    const bool success = parser.read( &file );
+
+    GeoDataDocument *document = static_cast<GeoDataDocument*>( parser.releaseDocument() );
+    Q_ASSERT( document );
+
+    // The placemarks handed out so far share their data with the document,
+    // it has to stay around until they are gone.
+    QMutexLocker locker( &m_parsedMutex );
+    const bool cancelled = isCancelled();
+    if ( cancelled ) {
+        m_document = document;
+    }
+    else if ( !success ) {
+        m_discardedDocument = document;
+        m_error = parser.errorString();
+    }
+    else {
+        document->setDocumentRole( m_documentRole );
+        document->setFileName( fileName );
+        document->setBaseUri( fileName );
+        document->setProperty( m_property );
+        m_document = document;
+    }
+    locker.unlock();
+
+    if ( m_document && !cancelled ) {
+        mDebug() << "newGeoDataDocumentAdded" << m_filepath;
+        emit q->newGeoDataDocumentAdded( m_document );
+    }
+    emit q->loaderFinished( q );
+}
+
+bool FileLoaderPrivate::placemarkParsed( GeoDataPlacemark *placemark, const QIODevice *device )
+{
+    // checked for every placemark, as a batch may take a while to fill
+    if ( isCancelled() ) {
+        return false;
+    }
+
+    // only the placemarks createFilterProperties( GeoDataContainer* ) would visit
+    const GeoDataObject *parent = placemark->parent();
+    if ( parent && ( parent->nodeType() == GeoDataTypes::GeoDataFolderType
+                     || parent->nodeType() == GeoDataTypes::GeoDataDocumentType ) ) {
+        createFilterProperties( placemark );
+
+        // Computes the cached bounding box before the data gets shared with
+        // the thread of the file manager
+        placemark->geometry()->latLonAltBox();
+
+        // A shallow copy, the placemark in the document is not changed
+        // anymore and the data gets detached on the first change of either
+        m_batch.append( new GeoDataPlacemark( *placemark ) );
+    }
+
+    if ( m_batch.size() < batchSize && m_batchTimer.elapsed() < batchInterval ) {
+        return true;
+    }
+
+    QMutexLocker locker( &m_parsedMutex );
+    const bool notify = m_parsedPlacemarks.isEmpty() && !m_batch.isEmpty();
+    m_parsedPlacemarks += m_batch;
+    m_batch.clear();
+    if ( device->size() > 0 ) {
+        m_progress = int( 100 * device->pos() / device->size() );
+    }
+    locker.unlock();
+
+    m_batchTimer.restart();
+    if ( notify ) {
+        emit q->placemarksParsed( q );
+    }
+
+    return true;
+}
+
+bool FileLoaderPrivate::isCancelled()
+{
+#if QT_VERSION < 0x050000
+    return m_cancelled.fetchAndAddAcquire( 0 ) != 0;
+#else
+    return m_cancelled.loadAcquire() != 0;
+#endif
+}
+
 void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
 {
     QVector<GeoDataFeature*>::Iterator i = container->begin();
@@ -244,181 +449,184 @@ void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
             /** @todo: How to handle this ? */
         } else if ( (*i)->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
             Q_ASSERT( dynamic_cast<GeoDataPlacemark*>( *i ) );
+            createFilterProperties( static_cast<GeoDataPlacemark*>( *i ) );
+        } else {
+            qWarning() << Q_FUNC_INFO << "Unknown feature" << (*i)->nodeType() << ". Skipping.";
+        }
+    }
+}
 
-            GeoDataPlacemark* placemark = static_cast<GeoDataPlacemark*>( *i );
-            Q_ASSERT( placemark->geometry() );
+void FileLoaderPrivate::createFilterProperties( GeoDataPlacemark *placemark )
+{
+    Q_ASSERT( placemark->geometry() );
 
-            bool hasPopularity = false;
+    bool hasPopularity = false;
 
-            if ( placemark->geometry()->nodeType() != GeoDataTypes::GeoDataTrackType &&
-                placemark->geometry()->nodeType() != GeoDataTypes::GeoDataPointType
-                 && m_documentRole == MapDocument
-                 && m_style ) {
-                placemark->setStyleUrl( QString("#").append( m_styleMap->id() ) );
-            }
+    if ( placemark->geometry()->nodeType() != GeoDataTypes::GeoDataTrackType &&
+        placemark->geometry()->nodeType() != GeoDataTypes::GeoDataPointType
+         && m_documentRole == MapDocument
+         && m_style ) {
+        placemark->setStyleUrl( QString("#").append( m_styleMap->id() ) );
+    }
 
-            // Mountain (H), Volcano (V), Shipwreck (W)
-            if ( placemark->role() == "H" || placemark->role() == "V" || placemark->role() == "W" )
-            {
-                qreal altitude = placemark->coordinate().altitude();
-                if ( altitude != 0.0 )
-                {
-                    hasPopularity = true;
-                    placemark->setPopularity( (qint64)(altitude * 1000.0) );
-                    placemark->setZoomLevel( cityPopIdx( qAbs( (qint64)(altitude * 1000.0) ) ) );
-                }
-            }
-            // Continent (K), Ocean (O), Nation (S)
-            else if ( placemark->role() == "K" || placemark->role() == "O" || placemark->role() == "S" )
-            {
-                qreal area = placemark->area();
-                if ( area >= 0.0 )
-                {
-                    hasPopularity = true;
-                    //                mDebug() << placemark->name() << " " << (qint64)(area);
-                    placemark->setPopularity( (qint64)(area * 100) );
-                    placemark->setZoomLevel( areaPopIdx( area ) );
+    // Mountain (H), Volcano (V), Shipwreck (W)
+    if ( placemark->role() == "H" || placemark->role() == "V" || placemark->role() == "W" )
+    {
+        qreal altitude = placemark->coordinate().altitude();
+        if ( altitude != 0.0 )
+        {
+            hasPopularity = true;
+            placemark->setPopularity( (qint64)(altitude * 1000.0) );
+            placemark->setZoomLevel( cityPopIdx( qAbs( (qint64)(altitude * 1000.0) ) ) );
+        }
+    }
+    // Continent (K), Ocean (O), Nation (S)
+    else if ( placemark->role() == "K" || placemark->role() == "O" || placemark->role() == "S" )
+    {
+        qreal area = placemark->area();
+        if ( area >= 0.0 )
+        {
+            hasPopularity = true;
+            //                mDebug() << placemark->name() << " " << (qint64)(area);
+            placemark->setPopularity( (qint64)(area * 100) );
+            placemark->setZoomLevel( areaPopIdx( area ) );
+        }
+    }
+    // Pole (P)
+    else if ( placemark->role() == "P" )
+    {
+        placemark->setPopularity( 1000000000 );
+        placemark->setZoomLevel( 1 );
+    }
+    // Magnetic Pole (M)
+    else if ( placemark->role() == "M" )
+    {
+        placemark->setPopularity( 10000000 );
+        placemark->setZoomLevel( 3 );
+    }
+    // MannedLandingSite (h)
+    else if ( placemark->role() == "h" )
+    {
+        placemark->setPopularity( 1000000000 );
+        placemark->setZoomLevel( 1 );
+    }
+    // RoboticRover (r)
+    else if ( placemark->role() == "r" )
+    {
+        placemark->setPopularity( 10000000 );
+        placemark->setZoomLevel( 2 );
+    }
+    // UnmannedSoftLandingSite (u)
+    else if ( placemark->role() == "u" )
+    {
+        placemark->setPopularity( 1000000 );
+        placemark->setZoomLevel( 3 );
+    }
+    // UnmannedSoftLandingSite (i)
+    else if ( placemark->role() == "i" )
+    {
+        placemark->setPopularity( 1000000 );
+        placemark->setZoomLevel( 3 );
+    }
+    // Space Terrain: Craters, Maria, Montes, Valleys, etc.
+    else if (    placemark->role() == "m" || placemark->role() == "v"
+                 || placemark->role() == "o" || placemark->role() == "c"
+                 || placemark->role() == "a" )
+    {
+        qint64 diameter = placemark->population();
+        if ( diameter >= 0 )
+        {
+            hasPopularity = true;
+            placemark->setPopularity( diameter );
+            if ( placemark->role() == "c" ) {
+                placemark->setZoomLevel( spacePopIdx( diameter ) );
+                if ( placemark->name() == "Tycho" || placemark->name() == "Copernicus" ) {
+                    placemark->setZoomLevel( 1 );
                 }
             }
-            // Pole (P)
-            else if ( placemark->role() == "P" )
-            {
-                placemark->setPopularity( 1000000000 );
-                placemark->setZoomLevel( 1 );
+            else {
+                placemark->setZoomLevel( spacePopIdx( diameter ) );
             }
-            // Magnetic Pole (M)
-            else if ( placemark->role() == "M" )
-            {
-                placemark->setPopularity( 10000000 );
-                placemark->setZoomLevel( 3 );
-            }
-            // MannedLandingSite (h)
-            else if ( placemark->role() == "h" )
-            {
+
+            if ( placemark->role() == "a" && diameter == 0 ) {
                 placemark->setPopularity( 1000000000 );
                 placemark->setZoomLevel( 1 );
             }
-            // RoboticRover (r)
-            else if ( placemark->role() == "r" )
-            {
-                placemark->setPopularity( 10000000 );
-                placemark->setZoomLevel( 2 );
-            }
-            // UnmannedSoftLandingSite (u)
-            else if ( placemark->role() == "u" )
-            {
-                placemark->setPopularity( 1000000 );
-                placemark->setZoomLevel( 3 );
-            }
-            // UnmannedSoftLandingSite (i)
-            else if ( placemark->role() == "i" )
-            {
-                placemark->setPopularity( 1000000 );
-                placemark->setZoomLevel( 3 );
-            }
-            // Space Terrain: Craters, Maria, Montes, Valleys, etc.
-            else if (    placemark->role() == "m" || placemark->role() == "v"
-                         || placemark->role() == "o" || placemark->role() == "c"
-                         || placemark->role() == "a" )
-            {
-                qint64 diameter = placemark->population();
-                if ( diameter >= 0 )
-                {
-                    hasPopularity = true;
-                    placemark->setPopularity( diameter );
-                    if ( placemark->role() == "c" ) {
-                        placemark->setZoomLevel( spacePopIdx( diameter ) );
-                        if ( placemark->name() == "Tycho" || placemark->name() == "Copernicus" ) {
-                            placemark->setZoomLevel( 1 );
-                        }
-                    }
-                    else {
-                        placemark->setZoomLevel( spacePopIdx( diameter ) );
-                    }
-
-                    if ( placemark->role() == "a" && diameter == 0 ) {
-                        placemark->setPopularity( 1000000000 );
-                        placemark->setZoomLevel( 1 );
-                    }
-                }
-            }
-            else
-            {
-                qint64 population = placemark->population();
-                if ( population >= 0 )
-                {
-                    hasPopularity = true;
-                    placemark->setPopularity( population );
-                    placemark->setZoomLevel( cityPopIdx( population ) );
-                }
-            }
-
-            //  Then we set the visual category:
-
-            if ( placemark->role() == "H" )      placemark->setVisualCategory( GeoDataPlacemark::Mountain );
-            else if ( placemark->role() == "V" ) placemark->setVisualCategory( GeoDataPlacemark::Volcano );
-
-            else if ( placemark->role() == "m" ) placemark->setVisualCategory( GeoDataPlacemark::Mons );
-            else if ( placemark->role() == "v" ) placemark->setVisualCategory( GeoDataPlacemark::Valley );
-            else if ( placemark->role() == "o" ) placemark->setVisualCategory( GeoDataPlacemark::OtherTerrain );
-            else if ( placemark->role() == "c" ) placemark->setVisualCategory( GeoDataPlacemark::Crater );
-            else if ( placemark->role() == "a" ) placemark->setVisualCategory( GeoDataPlacemark::Mare );
-
-            else if ( placemark->role() == "P" ) placemark->setVisualCategory( GeoDataPlacemark::GeographicPole );
-            else if ( placemark->role() == "M" ) placemark->setVisualCategory( GeoDataPlacemark::MagneticPole );
-            else if ( placemark->role() == "W" ) placemark->setVisualCategory( GeoDataPlacemark::ShipWreck );
-            else if ( placemark->role() == "F" ) placemark->setVisualCategory( GeoDataPlacemark::AirPort );
-            else if ( placemark->role() == "A" ) placemark->setVisualCategory( GeoDataPlacemark::Observatory );
-            else if ( placemark->role() == "K" ) placemark->setVisualCategory( GeoDataPlacemark::Continent );
-            else if ( placemark->role() == "O" ) placemark->setVisualCategory( GeoDataPlacemark::Ocean );
-            else if ( placemark->role() == "S" ) placemark->setVisualCategory( GeoDataPlacemark::Nation );
-            else
-                if (  placemark->role()=="PPL"
-                   || placemark->role()=="PPLF"
-                   || placemark->role()=="PPLG"
-                   || placemark->role()=="PPLL"
-                   || placemark->role()=="PPLQ"
-                   || placemark->role()=="PPLR"
-                   || placemark->role()=="PPLS"
-                   || placemark->role()=="PPLW" ) placemark->setVisualCategory(
-                        ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCity
-                                                                       + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role() == "PPLA" ) placemark->setVisualCategory(
-                    ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallStateCapital
-                                                                   + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role()=="PPLC" ) placemark->setVisualCategory(
-                    ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallNationCapital
-                                                                   + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role()=="PPLA2" || placemark->role()=="PPLA3" ) placemark->setVisualCategory(
-                    ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCountyCapital
-                                                                   + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
-            else if ( placemark->role()==" " && !hasPopularity && placemark->visualCategory() == GeoDataPlacemark::Unknown ) {
-                placemark->setVisualCategory( GeoDataPlacemark::Unknown ); // default location
-                placemark->setZoomLevel(0);
-            }
-            else if ( placemark->role() == "h" ) placemark->setVisualCategory( GeoDataPlacemark::MannedLandingSite );
-            else if ( placemark->role() == "r" ) placemark->setVisualCategory( GeoDataPlacemark::RoboticRover );
-            else if ( placemark->role() == "u" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedSoftLandingSite );
-            else if ( placemark->role() == "i" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedHardLandingSite );
-
-            if ( placemark->role() == "W" && placemark->zoomLevel() < 4 )
-                placemark->setZoomLevel( 4 );
-            if ( placemark->role() == "O" )
-                placemark->setZoomLevel( 2 );
-            if ( placemark->role() == "K" )
-                placemark->setZoomLevel( 0 );
-            if ( !placemark->isVisible() ) {
-                placemark->setZoomLevel( 18 );
-            }
-            // Workaround: Emulate missing "setVisible" serialization by allowing for population
-            // values smaller than -1 which are considered invisible.
-            if ( placemark->population() < -1 ) {
-                placemark->setZoomLevel( 18 );
-            }
-        } else {
-            qWarning() << Q_FUNC_INFO << "Unknown feature" << (*i)->nodeType() << ". Skipping.";
         }
     }
+    else
+    {
+        qint64 population = placemark->population();
+        if ( population >= 0 )
+        {
+            hasPopularity = true;
+            placemark->setPopularity( population );
+            placemark->setZoomLevel( cityPopIdx( population ) );
+        }
+    }
+
+    //  Then we set the visual category:
+
+    if ( placemark->role() == "H" )      placemark->setVisualCategory( GeoDataPlacemark::Mountain );
+    else if ( placemark->role() == "V" ) placemark->setVisualCategory( GeoDataPlacemark::Volcano );
+
+    else if ( placemark->role() == "m" ) placemark->setVisualCategory( GeoDataPlacemark::Mons );
+    else if ( placemark->role() == "v" ) placemark->setVisualCategory( GeoDataPlacemark::Valley );
+    else if ( placemark->role() == "o" ) placemark->setVisualCategory( GeoDataPlacemark::OtherTerrain );
+    else if ( placemark->role() == "c" ) placemark->setVisualCategory( GeoDataPlacemark::Crater );
+    else if ( placemark->role() == "a" ) placemark->setVisualCategory( GeoDataPlacemark::Mare );
+
+    else if ( placemark->role() == "P" ) placemark->setVisualCategory( GeoDataPlacemark::GeographicPole );
+    else if ( placemark->role() == "M" ) placemark->setVisualCategory( GeoDataPlacemark::MagneticPole );
+    else if ( placemark->role() == "W" ) placemark->setVisualCategory( GeoDataPlacemark::ShipWreck );
+    else if ( placemark->role() == "F" ) placemark->setVisualCategory( GeoDataPlacemark::AirPort );
+    else if ( placemark->role() == "A" ) placemark->setVisualCategory( GeoDataPlacemark::Observatory );
+    else if ( placemark->role() == "K" ) placemark->setVisualCategory( GeoDataPlacemark::Continent );
+    else if ( placemark->role() == "O" ) placemark->setVisualCategory( GeoDataPlacemark::Ocean );
+    else if ( placemark->role() == "S" ) placemark->setVisualCategory( GeoDataPlacemark::Nation );
+    else
+        if (  placemark->role()=="PPL"
+           || placemark->role()=="PPLF"
+           || placemark->role()=="PPLG"
+           || placemark->role()=="PPLL"
+           || placemark->role()=="PPLQ"
+           || placemark->role()=="PPLR"
+           || placemark->role()=="PPLS"
+           || placemark->role()=="PPLW" ) placemark->setVisualCategory(
+                ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCity
+                                                               + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role() == "PPLA" ) placemark->setVisualCategory(
+            ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallStateCapital
+                                                           + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role()=="PPLC" ) placemark->setVisualCategory(
+            ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallNationCapital
+                                                           + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role()=="PPLA2" || placemark->role()=="PPLA3" ) placemark->setVisualCategory(
+            ( GeoDataPlacemark::GeoDataVisualCategory )( GeoDataPlacemark::SmallCountyCapital
+                                                           + (( 20- ( 2*placemark->zoomLevel()) ) / 4 * 4 ) ) );
+    else if ( placemark->role()==" " && !hasPopularity && placemark->visualCategory() == GeoDataPlacemark::Unknown ) {
+        placemark->setVisualCategory( GeoDataPlacemark::Unknown ); // default location
+        placemark->setZoomLevel(0);
+    }
+    else if ( placemark->role() == "h" ) placemark->setVisualCategory( GeoDataPlacemark::MannedLandingSite );
+    else if ( placemark->role() == "r" ) placemark->setVisualCategory( GeoDataPlacemark::RoboticRover );
+    else if ( placemark->role() == "u" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedSoftLandingSite );
+    else if ( placemark->role() == "i" ) placemark->setVisualCategory( GeoDataPlacemark::UnmannedHardLandingSite );
+
+    if ( placemark->role() == "W" && placemark->zoomLevel() < 4 )
+        placemark->setZoomLevel( 4 );
+    if ( placemark->role() == "O" )
+        placemark->setZoomLevel( 2 );
+    if ( placemark->role() == "K" )
+        placemark->setZoomLevel( 0 );
+    if ( !placemark->isVisible() ) {
+        placemark->setZoomLevel( 18 );
+    }
+    // Workaround: Emulate missing "setVisible" serialization by allowing for population
+    // values smaller than -1 which are considered invisible.
+    if ( placemark->population() < -1 ) {
+        placemark->setZoomLevel( 18 );
+    }
 }
 
 int FileLoaderPrivate::cityPopIdx( qint64 population )
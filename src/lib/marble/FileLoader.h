@@ -15,10 +15,12 @@
 
 #include <QThread>
 #include <QString>
+#include <QVector>
 
 namespace Marble
 {
 class GeoDataContainer;
+class GeoDataPlacemark;
 class FileLoaderPrivate;
 class PluginManager;
 
@@ -35,13 +37,43 @@ class FileLoader : public QThread
         void run();
         bool recenter() const;
         QString path() const;
+        /**
+         * The loaded document, or after cancel() the part loaded so far.
+         * The caller takes ownership.
+         */
         GeoDataDocument *document();
         QString error() const;
+        DocumentRole documentRole() const;
+
+        /**
+         * Stops loading a KML file as soon as possible. Other files are
+         * loaded completely.
+         */
+        void cancel();
+
+        /**
+         * Returns the percentage of the KML file read so far
+         */
+        int progress() const;
+
+        /**
+         * Returns the placemarks of a KML file parsed since the last call and
+         * passes their ownership to the caller. They share their data with
+         * the document which is still being loaded, so they have to be
+         * deleted before it.
+         */
+        QVector<GeoDataPlacemark*> takeParsedPlacemarks();
 
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
 
+        /**
+         * Emitted by the loading thread when placemarks can be taken by
+         * takeParsedPlacemarks(). It is not emitted again before they are.
+         */
+        void placemarksParsed( FileLoader* );
+
 private:
         Q_PRIVATE_SLOT ( d, void documentParsed( GeoDataDocument *, QString) )
 
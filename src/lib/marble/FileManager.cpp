@@ -22,7 +22,9 @@
 #include "GeoDataTreeModel.h"
 
 #include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
 #include "GeoDataStyle.h"
 #include "GeoWriter.h"
 #include <KmlElementDictionary.h>
@@ -46,7 +48,9 @@ public:
     {
         foreach ( FileLoader *loader, m_loaderList ) {
             if ( loader ) {
+                loader->cancel();
                 loader->wait();
+                removePreview( loader );
             }
         }
     }
@@ -54,6 +58,8 @@ public:
     void appendLoader( FileLoader *loader );
     void closeFile( const QString &key );
     void cleanupLoader( FileLoader *loader );
+    void addParsedPlacemarks( FileLoader *loader );
+    void removePreview( FileLoader *loader );
 
     FileManager *const q;
     GeoDataTreeModel *const m_treeModel;
@@ -61,6 +67,8 @@ public:
 
     QList<FileLoader*> m_loaderList;
     QHash < QString, GeoDataDocument* > m_fileItemHash;
+    // the placemarks of files still being loaded
+    QHash < FileLoader*, GeoDataDocument* > m_previewHash;
     GeoDataLatLonBox m_latLonBox;
     QTime m_timer;
 };
@@ -106,6 +114,8 @@ void FileManagerPrivate::appendLoader( FileLoader *loader )
 {
     QObject::connect( loader, SIGNAL(loaderFinished(FileLoader*)),
              q, SLOT(cleanupLoader(FileLoader*)) );
+    QObject::connect( loader, SIGNAL(placemarksParsed(FileLoader*)),
+             q, SLOT(addParsedPlacemarks(FileLoader*)) );
 
     m_loaderList.append( loader );
     loader->start();
@@ -116,8 +126,10 @@ void FileManager::removeFile( const QString& key )
     foreach ( FileLoader *loader, d->m_loaderList ) {
         if ( loader->path() == key ) {
             disconnect( loader, 0, this, 0 );
+            loader->cancel();
             loader->wait();
             d->m_loaderList.removeAll( loader );
+            d->removePreview( loader );
             delete loader->document();
             return;
         }
@@ -186,10 +198,52 @@ int FileManager::pendingFiles() const
     return d->m_loaderList.size();
 }
 
+void FileManagerPrivate::addParsedPlacemarks( FileLoader *loader )
+{
+    if ( !m_loaderList.contains( loader ) ) {
+        // removed in the meantime
+        return;
+    }
+
+    const QVector<GeoDataPlacemark*> placemarks = loader->takeParsedPlacemarks();
+    if ( !placemarks.isEmpty() ) {
+        GeoDataDocument *preview = m_previewHash.value( loader );
+        if ( !preview ) {
+            preview = new GeoDataDocument;
+            preview->setName( QFileInfo( loader->path() ).baseName() );
+            preview->setDocumentRole( loader->documentRole() );
+            m_treeModel->addDocument( preview );
+            m_previewHash.insert( loader, preview );
+        }
+
+        // one folder per batch, which gets added to the model in one go
+        GeoDataFolder *batch = new GeoDataFolder;
+        foreach ( GeoDataPlacemark *placemark, placemarks ) {
+            batch->append( placemark );
+        }
+        m_treeModel->addFeature( preview, batch );
+    }
+
+    emit q->loadingProgress( loader->path(), loader->progress() );
+}
+
+void FileManagerPrivate::removePreview( FileLoader *loader )
+{
+    GeoDataDocument *preview = m_previewHash.take( loader );
+    if ( preview ) {
+        m_treeModel->removeDocument( preview );
+        delete preview;
+    }
+
+    // placemarks which were not taken yet
+    qDeleteAll( loader->takeParsedPlacemarks() );
+}
+
 void FileManagerPrivate::cleanupLoader( FileLoader* loader )
 {
     GeoDataDocument *doc = loader->document();
     m_loaderList.removeAll( loader );
+    removePreview( loader );
     if ( loader->isFinished() ) {
         if ( doc ) {
             if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
@@ -13,6 +13,7 @@
 #define MARBLE_FILEMANAGER_H
 
 #include "GeoDataDocument.h"
+#include "marble_export.h"
 
 #include <QObject>
 #include <QString>
@@ -34,7 +35,7 @@ class PluginManager;
  * The loaded data are accessible via
  * various models in MarbleModel.
  */
-class FileManager : public QObject
+class MARBLE_EXPORT FileManager : public QObject
 {
     Q_OBJECT
 
@@ -58,7 +59,8 @@ class FileManager : public QObject
 
 
     /**
-    * removes an existing file from the manager
+    * removes an existing file from the manager, a file still being loaded
+    * is cancelled
     */
     void removeFile( const QString &fileName );
 
@@ -81,9 +83,17 @@ class FileManager : public QObject
     void fileRemoved( const QString &key );
     void centeredDocument( const GeoDataLatLonBox& );
 
+    /**
+     * Reports the percentage of a KML file loaded so far. Its placemarks are
+     * shown while it is loaded and replaced by the document once fileAdded()
+     * is emitted.
+     */
+    void loadingProgress( const QString &key, int percent );
+
  private:
 
     Q_PRIVATE_SLOT( d, void cleanupLoader( FileLoader *loader ) )
+    Q_PRIVATE_SLOT( d, void addParsedPlacemarks( FileLoader *loader ) )
 
     Q_DISABLE_COPY( FileManager )
 
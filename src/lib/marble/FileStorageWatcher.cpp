@@ -18,6 +18,7 @@
 #include <QTimer>
 
 // Marble
+#include "CacheStatistics.h"
 #include "MarbleGlobal.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
@@ -35,7 +36,8 @@ FileStorageWatcherThread::FileStorageWatcherThread( const QString &dataDirectory
     : QObject( parent ),
       m_dataDirectory( dataDirectory ),
       m_deleting( false ),
-      m_willQuit( false )
+      m_willQuit( false ),
+      m_statistics( 0 )
 {
     // For now setting cache limit to 0. This won't delete anything
     setCacheLimit( 0 );
@@ -55,6 +57,11 @@ quint64 FileStorageWatcherThread::cacheLimit()
     return m_cacheLimit;
 }
 
+void FileStorageWatcherThread::setCacheStatistics( CacheStatistics *statistics )
+{
+    m_statistics = statistics;
+}
+
 void FileStorageWatcherThread::setCacheLimit( quint64 bytes )
 {
     m_limitMutex.lock();
@@ -72,12 +79,14 @@ void FileStorageWatcherThread::addToCurrentSize( qint64 bytes )
 	m_currentCacheSize = changedSize;
     else
 	m_currentCacheSize = 0;
+    updateStatistics();
     emit variableChanged();
 }
 
 void FileStorageWatcherThread::resetCurrentSize()
 {
     m_currentCacheSize = 0;
+    updateStatistics();
     emit variableChanged();
 }
 
@@ -117,6 +126,7 @@ void FileStorageWatcherThread::getCurrentCacheSize()
         }
     }
     m_currentCacheSize = dataSize;
+    updateStatistics();
 }
 
 void FileStorageWatcherThread::ensureCacheSize()
@@ -150,6 +160,11 @@ void FileStorageWatcherThread::ensureCacheSize()
             QFile::remove( filePath );
         }
 
+        if ( m_statistics ) {
+            m_statistics->addEvictions( CacheStatistics::TileStorage, m_filesDeleted );
+        }
+        updateStatistics();
+
         // We have deleted enough files.
         // Perhaps there are changes.
         if( m_filesDeleted > maxFilesDelete ) {
@@ -177,6 +192,13 @@ bool FileStorageWatcherThread::keepDeleting() const
 	     ( m_filesDeleted <= maxFilesDelete ) &&
               !m_willQuit );
 }
+
+void FileStorageWatcherThread::updateStatistics()
+{
+    if ( m_statistics ) {
+        m_statistics->setByteCount( CacheStatistics::TileStorage, m_currentCacheSize );
+    }
+}
 // End of methods of our Thread
 
 
@@ -196,6 +218,7 @@ FileStorageWatcher::FileStorageWatcher( const QString &dataDirectory, QObject *
     
     m_thread = 0;
     m_quitting = false;
+    m_statistics = 0;
 }
 
 FileStorageWatcher::~FileStorageWatcher()
@@ -237,6 +260,11 @@ quint64 FileStorageWatcher::cacheLimit()
 	return m_limit;
 }
 
+void FileStorageWatcher::setCacheStatistics( CacheStatistics *statistics )
+{
+    m_statistics = statistics;
+}
+
 void FileStorageWatcher::addToCurrentSize( qint64 bytes )
 {
     emit sizeChanged( bytes );
@@ -253,6 +281,7 @@ void FileStorageWatcher::run()
     if( !m_quitting ) {
         m_limitMutex->lock();
         m_thread->setCacheLimit( m_limit );
+        m_thread->setCacheStatistics( m_statistics );
         m_started = true;
         m_limitMutex->unlock();
 
@@ -18,6 +18,8 @@
 
 namespace Marble
 {
+
+class CacheStatistics;
     
 // Lives inside the new Thread
 class FileStorageWatcherThread : public QObject
@@ -30,6 +32,11 @@ class FileStorageWatcherThread : public QObject
 	~FileStorageWatcherThread();
     
 	quint64 cacheLimit();
+
+	/**
+	 * Sets the statistics which deleted files and the cache size are reported to.
+	 */
+	void setCacheStatistics( CacheStatistics *statistics );
 	
     Q_SIGNALS:
 	/**
@@ -77,6 +84,8 @@ class FileStorageWatcherThread : public QObject
 	 * Returns true if it is necessary to delete files.
 	 */
 	bool keepDeleting() const;
+
+	void updateStatistics();
 	
 	QString m_dataDirectory;
     QMultiMap<QDateTime,QString> m_filesCache;
@@ -87,6 +96,7 @@ class FileStorageWatcherThread : public QObject
 	bool 	m_deleting;
 	QMutex	m_limitMutex;
 	bool	m_willQuit;
+	CacheStatistics *m_statistics;
 };
 
 
@@ -111,6 +121,12 @@ class FileStorageWatcher : public QThread
 	 * Returns the limit of the cache in bytes.
 	 */
 	quint64 cacheLimit();
+
+	/**
+	 * Sets the statistics which deleted files and the cache size are reported to.
+	 * Has to be called before the thread is started.
+	 */
+	void setCacheStatistics( CacheStatistics *statistics );
 	
     public Q_SLOTS:
 	/**
@@ -150,6 +166,7 @@ class FileStorageWatcher : public QThread
 	quint64 m_limit;
 	bool m_started;
 	bool m_quitting;
+	CacheStatistics *m_statistics;
 };
 
 }
@@ -16,7 +16,6 @@
 
 // Qt
 #include <QtCore/qmath.h>
-#include <QtCore/QRunnable>
 #include <QtGui/QImage>
 
 // Marble
@@ -33,12 +32,12 @@
 
 using namespace Marble;
 
-class GenericScanlineTextureMapper::RenderJob : public QRunnable
+class GenericScanlineTextureMapper::RenderJob : public TextureMapperScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality );
 
-    virtual void run();
+    virtual void renderLines( int yTop, int yBottom );
 
 private:
     StackedTileLoader *const m_tileLoader;
@@ -46,18 +45,14 @@ private:
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    const int m_yTop;
-    const int m_yBottom;
 };
 
-GenericScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+GenericScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
-      m_mapQuality( mapQuality ),
-      m_yTop( yTop ),
-      m_yBottom( yBottom )
+      m_mapQuality( mapQuality )
 {
 }
 
@@ -66,7 +61,7 @@ GenericScanlineTextureMapper::GenericScanlineTextureMapper( StackedTileLoader *t
     : TextureMapperInterface()
     , m_tileLoader( tileLoader )
     , m_radius( 0 )
-    , m_threadPool()
+    , m_scheduler()
 {
 }
 
@@ -113,6 +108,11 @@ void GenericScanlineTextureMapper::mapTexture( GeoPainter *painter,
     painter->drawImage( rect, m_canvasImage, rect );
 }
 
+QString GenericScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.runtimeTrace();
+}
+
 void GenericScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
 {
     // Reset backend
@@ -129,21 +129,13 @@ void GenericScanlineTextureMapper::mapTexture( const ViewportParams *viewport, i
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
-
-    m_threadPool.waitForDone();
+    m_scheduler.schedule( new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality ), yTop, yBottom );
+    m_scheduler.run();
 
     m_tileLoader->cleanupTilehash();
 }
 
-void GenericScanlineTextureMapper::RenderJob::run()
+void GenericScanlineTextureMapper::RenderJob::renderLines( int yTop, int yBottom )
 {
     const int imageWidth  = m_canvasImage->width();
     const int imageHeight  = m_canvasImage->height();
@@ -171,7 +163,7 @@ void GenericScanlineTextureMapper::RenderJob::run()
 
 
     // Paint the map.
-    for ( int y = m_yTop; y < m_yBottom; ++y ) {
+    for ( int y = yTop; y < yBottom; ++y ) {
 
         // rx is the radius component in x direction
         const int rx = (int)sqrt( (qreal)( clipRadius * clipRadius
@@ -264,7 +256,7 @@ void GenericScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yBottom ) {
+        if ( interlaced && y + 1 < yBottom ) {
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
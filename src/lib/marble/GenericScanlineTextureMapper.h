@@ -13,8 +13,8 @@
 
 
 #include "TextureMapperInterface.h"
+#include "TextureMapperScheduler.h"
 
-#include <QtCore/QThreadPool>
 #include <QtGui/QImage>
 
 #include <MarbleGlobal.h>
@@ -36,6 +36,8 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer );
 
+    virtual QString runtimeTrace() const;
+
  private:
     class RenderJob;
 
@@ -44,7 +46,7 @@ class GenericScanlineTextureMapper : public TextureMapperInterface
     StackedTileLoader *const m_tileLoader;
     int m_radius;
     QImage m_canvasImage;
-    QThreadPool m_threadPool;
+    TextureMapperScheduler m_scheduler;
 };
 
 }
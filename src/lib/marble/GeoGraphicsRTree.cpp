@@ -0,0 +1,509 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoGraphicsRTree.h"
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoGraphicsItem.h"
+
+#include <QHash>
+#include <QVector>
+#include <QtAlgorithms>
+
+#include <cmath>
+
+namespace Marble
+{
+
+namespace
+{
+
+struct Box
+{
+    qreal west;
+    qreal south;
+    qreal east;
+    qreal north;
+
+    bool intersects( const Box &other ) const
+    {
+        return west <= other.east && other.west <= east
+            && south <= other.north && other.south <= north;
+    }
+
+    bool contains( const Box &other ) const
+    {
+        return west <= other.west && other.east <= east
+            && south <= other.south && other.north <= north;
+    }
+
+    Box united( const Box &other ) const
+    {
+        const Box result = { qMin( west, other.west ), qMin( south, other.south ),
+                             qMax( east, other.east ), qMax( north, other.north ) };
+        return result;
+    }
+
+    bool operator==( const Box &other ) const
+    {
+        return west == other.west && south == other.south
+            && east == other.east && north == other.north;
+    }
+
+    qreal area() const
+    {
+        return ( east - west ) * ( north - south );
+    }
+
+    qreal center( int axis ) const
+    {
+        return axis == 0 ? ( west + east ) / 2 : ( south + north ) / 2;
+    }
+};
+
+struct Node;
+
+struct Entry
+{
+    Box box;
+    int minZoomLevel;      // the smallest one below
+    Node *child;           // 0 in leaves
+    GeoGraphicsItem *item; // 0 in inner nodes
+    int sequence;          // order of insertion
+};
+
+struct Node
+{
+    explicit Node( bool leaf ) : isLeaf( leaf ) {}
+
+    bool isLeaf;
+    QVector<Entry> entries;
+};
+
+struct Record
+{
+    Box box;
+    int minZoomLevel;
+    int sequence;
+};
+
+class CenterLessThan
+{
+ public:
+    explicit CenterLessThan( int axis ) : m_axis( axis ) {}
+
+    bool operator()( const Entry &one, const Entry &other ) const
+    {
+        return one.box.center( m_axis ) < other.box.center( m_axis );
+    }
+
+ private:
+    int m_axis;
+};
+
+bool zValueLessThan( const Entry *one, const Entry *other )
+{
+    if ( one->item->zValue() != other->item->zValue() ) {
+        return one->item->zValue() < other->item->zValue();
+    }
+
+    return one->sequence < other->sequence;
+}
+
+}
+
+class GeoGraphicsRTreePrivate
+{
+ public:
+    GeoGraphicsRTreePrivate();
+
+    static const int maximumEntries = 16;
+    static const int minimumEntries = 4;
+
+    static QVector<Box> splitAtDateLine( const Box &box );
+    static Entry nodeEntry( Node *node );
+    static int chooseSubtree( const Node *node, const Box &box );
+    static Node *split( Node *node );
+    static void deleteNode( Node *node );
+    static void collectLeafEntries( const Node *node, QVector<Entry> &entries );
+    static QVector<Node *> pack( QVector<Entry> &entries, bool leaves );
+
+    void insert( const Entry &entry );
+    Node *insert( Node *node, const Entry &entry );
+    bool remove( Node *node, const GeoGraphicsItem *item, const Box &box, QVector<Entry> &orphans );
+    void search( const Node *node, const Box &box, int maxZoomLevel, QVector<const Entry *> &result ) const;
+
+    Node *m_root;
+    QHash<GeoGraphicsItem *, Record> m_records;
+    int m_nextSequence;
+};
+
+const int GeoGraphicsRTreePrivate::maximumEntries;
+const int GeoGraphicsRTreePrivate::minimumEntries;
+
+GeoGraphicsRTreePrivate::GeoGraphicsRTreePrivate() :
+    m_root( new Node( true ) ),
+    m_nextSequence( 0 )
+{
+}
+
+QVector<Box> GeoGraphicsRTreePrivate::splitAtDateLine( const Box &box )
+{
+    QVector<Box> result;
+    if ( box.west > box.east ) {
+        // crosses the date line
+        const Box west = { box.west, box.south, M_PI, box.north };
+        const Box east = { -M_PI, box.south, box.east, box.north };
+        result << west << east;
+    } else {
+        result << box;
+    }
+
+    return result;
+}
+
+Entry GeoGraphicsRTreePrivate::nodeEntry( Node *node )
+{
+    Q_ASSERT( !node->entries.isEmpty() );
+
+    Entry result = node->entries.first();
+    for ( int i = 1; i < node->entries.size(); ++i ) {
+        result.box = result.box.united( node->entries.at( i ).box );
+        result.minZoomLevel = qMin( result.minZoomLevel, node->entries.at( i ).minZoomLevel );
+    }
+    result.child = node;
+    result.item = 0;
+    result.sequence = -1;
+
+    return result;
+}
+
+int GeoGraphicsRTreePrivate::chooseSubtree( const Node *node, const Box &box )
+{
+    // least enlargement, then least area
+    int result = 0;
+    qreal bestEnlargement = 0.0;
+    qreal bestArea = 0.0;
+    for ( int i = 0; i < node->entries.size(); ++i ) {
+        const Box &childBox = node->entries.at( i ).box;
+        const qreal area = childBox.area();
+        const qreal enlargement = childBox.united( box ).area() - area;
+        if ( i == 0 || enlargement < bestEnlargement
+             || ( enlargement == bestEnlargement && area < bestArea ) ) {
+            result = i;
+            bestEnlargement = enlargement;
+            bestArea = area;
+        }
+    }
+
+    return result;
+}
+
+Node *GeoGraphicsRTreePrivate::split( Node *node )
+{
+    // sort along the axis the entries spread most and cut in half
+    qreal minimum[2] = { node->entries.first().box.center( 0 ), node->entries.first().box.center( 1 ) };
+    qreal maximum[2] = { minimum[0], minimum[1] };
+    foreach ( const Entry &entry, node->entries ) {
+        for ( int axis = 0; axis < 2; ++axis ) {
+            minimum[axis] = qMin( minimum[axis], entry.box.center( axis ) );
+            maximum[axis] = qMax( maximum[axis], entry.box.center( axis ) );
+        }
+    }
+    const int axis = ( maximum[0] - minimum[0] >= maximum[1] - minimum[1] ) ? 0 : 1;
+    qSort( node->entries.begin(), node->entries.end(), CenterLessThan( axis ) );
+
+    Node *sibling = new Node( node->isLeaf );
+    const int half = node->entries.size() / 2;
+    sibling->entries = node->entries.mid( half );
+    node->entries.resize( half );
+
+    return sibling;
+}
+
+void GeoGraphicsRTreePrivate::deleteNode( Node *node )
+{
+    if ( !node->isLeaf ) {
+        foreach ( const Entry &entry, node->entries ) {
+            deleteNode( entry.child );
+        }
+    }
+    delete node;
+}
+
+void GeoGraphicsRTreePrivate::collectLeafEntries( const Node *node, QVector<Entry> &entries )
+{
+    if ( node->isLeaf ) {
+        entries += node->entries;
+        return;
+    }
+
+    foreach ( const Entry &entry, node->entries ) {
+        collectLeafEntries( entry.child, entries );
+    }
+}
+
+QVector<Node *> GeoGraphicsRTreePrivate::pack( QVector<Entry> &entries, bool leaves )
+{
+    // Sort-Tile-Recursive: cut the entries sorted by longitude into vertical
+    // slices, and each slice sorted by latitude into nodes
+    const int nodeCount = ( entries.size() + maximumEntries - 1 ) / maximumEntries;
+    const int sliceCount = qMax( 1, int( ceil( sqrt( qreal( nodeCount ) ) ) ) );
+    const int sliceSize = sliceCount * maximumEntries;
+
+    qSort( entries.begin(), entries.end(), CenterLessThan( 0 ) );
+
+    QVector<Node *> result;
+    for ( int slice = 0; slice < entries.size(); slice += sliceSize ) {
+        const int sliceEnd = qMin( slice + sliceSize, entries.size() );
+        qSort( entries.begin() + slice, entries.begin() + sliceEnd, CenterLessThan( 1 ) );
+
+        for ( int first = slice; first < sliceEnd; first += maximumEntries ) {
+            Node *node = new Node( leaves );
+            node->entries = entries.mid( first, qMin( maximumEntries, sliceEnd - first ) );
+            result.append( node );
+        }
+    }
+
+    return result;
+}
+
+void GeoGraphicsRTreePrivate::insert( const Entry &entry )
+{
+    Node *sibling = insert( m_root, entry );
+    if ( sibling ) {
+        Node *root = new Node( false );
+        root->entries << nodeEntry( m_root ) << nodeEntry( sibling );
+        m_root = root;
+    }
+}
+
+Node *GeoGraphicsRTreePrivate::insert( Node *node, const Entry &entry )
+{
+    if ( node->isLeaf ) {
+        node->entries.append( entry );
+    } else {
+        const int i = chooseSubtree( node, entry.box );
+        Node *child = node->entries.at( i ).child;
+        Node *sibling = insert( child, entry );
+        node->entries[i] = nodeEntry( child );
+        if ( sibling ) {
+            node->entries.append( nodeEntry( sibling ) );
+        }
+    }
+
+    return node->entries.size() > maximumEntries ? split( node ) : 0;
+}
+
+bool GeoGraphicsRTreePrivate::remove( Node *node, const GeoGraphicsItem *item, const Box &box, QVector<Entry> &orphans )
+{
+    if ( node->isLeaf ) {
+        for ( int i = 0; i < node->entries.size(); ++i ) {
+            if ( node->entries.at( i ).item == item && node->entries.at( i ).box == box ) {
+                node->entries.remove( i );
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for ( int i = 0; i < node->entries.size(); ++i ) {
+        if ( !node->entries.at( i ).box.contains( box ) ) {
+            continue;
+        }
+
+        Node *child = node->entries.at( i ).child;
+        if ( remove( child, item, box, orphans ) ) {
+            if ( child->entries.size() < minimumEntries ) {
+                // dissolve the child, its items get inserted again
+                collectLeafEntries( child, orphans );
+                deleteNode( child );
+                node->entries.remove( i );
+            } else {
+                node->entries[i] = nodeEntry( child );
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GeoGraphicsRTreePrivate::search( const Node *node, const Box &box, int maxZoomLevel,
+                                      QVector<const Entry *> &result ) const
+{
+    for ( int i = 0; i < node->entries.size(); ++i ) {
+        const Entry &entry = node->entries.at( i );
+        if ( entry.minZoomLevel > maxZoomLevel || !entry.box.intersects( box ) ) {
+            continue;
+        }
+
+        if ( node->isLeaf ) {
+            if ( entry.item->minZoomLevel() <= maxZoomLevel && entry.item->visible() ) {
+                result.append( &entry );
+            }
+        } else {
+            search( entry.child, box, maxZoomLevel, result );
+        }
+    }
+}
+
+GeoGraphicsRTree::GeoGraphicsRTree() :
+    d( new GeoGraphicsRTreePrivate )
+{
+}
+
+GeoGraphicsRTree::~GeoGraphicsRTree()
+{
+    GeoGraphicsRTreePrivate::deleteNode( d->m_root );
+    delete d;
+}
+
+void GeoGraphicsRTree::load( const QList<GeoGraphicsItem *> &items )
+{
+    clear();
+
+    QVector<Entry> entries;
+    foreach ( GeoGraphicsItem *item, items ) {
+        if ( d->m_records.contains( item ) ) {
+            continue;
+        }
+
+        qreal north, south, east, west;
+        item->latLonAltBox().boundaries( north, south, east, west );
+        const Record record = { { west, south, east, north }, item->minZoomLevel(), d->m_nextSequence++ };
+        d->m_records.insert( item, record );
+
+        foreach ( const Box &box, GeoGraphicsRTreePrivate::splitAtDateLine( record.box ) ) {
+            const Entry entry = { box, record.minZoomLevel, 0, item, record.sequence };
+            entries.append( entry );
+        }
+    }
+
+    if ( entries.isEmpty() ) {
+        return;
+    }
+
+    bool leaves = true;
+    forever {
+        const QVector<Node *> nodes = GeoGraphicsRTreePrivate::pack( entries, leaves );
+        if ( nodes.size() == 1 ) {
+            GeoGraphicsRTreePrivate::deleteNode( d->m_root );
+            d->m_root = nodes.first();
+            break;
+        }
+
+        entries.clear();
+        foreach ( Node *node, nodes ) {
+            entries.append( GeoGraphicsRTreePrivate::nodeEntry( node ) );
+        }
+        leaves = false;
+    }
+}
+
+void GeoGraphicsRTree::insert( GeoGraphicsItem *item )
+{
+    if ( d->m_records.contains( item ) ) {
+        return;
+    }
+
+    qreal north, south, east, west;
+    item->latLonAltBox().boundaries( north, south, east, west );
+    const Record record = { { west, south, east, north }, item->minZoomLevel(), d->m_nextSequence++ };
+    d->m_records.insert( item, record );
+
+    foreach ( const Box &box, GeoGraphicsRTreePrivate::splitAtDateLine( record.box ) ) {
+        const Entry entry = { box, record.minZoomLevel, 0, item, record.sequence };
+        d->insert( entry );
+    }
+}
+
+bool GeoGraphicsRTree::remove( GeoGraphicsItem *item )
+{
+    if ( !d->m_records.contains( item ) ) {
+        return false;
+    }
+
+    const Record record = d->m_records.take( item );
+
+    QVector<Entry> orphans;
+    foreach ( const Box &box, GeoGraphicsRTreePrivate::splitAtDateLine( record.box ) ) {
+        d->remove( d->m_root, item, box, orphans );
+    }
+
+    // the other half of an item crossing the date line may have been orphaned
+    for ( int i = orphans.size() - 1; i >= 0; --i ) {
+        if ( orphans.at( i ).item == item ) {
+            orphans.remove( i );
+        }
+    }
+
+    // shorten the tree while the root has a single child
+    while ( !d->m_root->isLeaf && d->m_root->entries.size() == 1 ) {
+        Node *root = d->m_root->entries.first().child;
+        delete d->m_root;
+        d->m_root = root;
+    }
+
+    if ( !d->m_root->isLeaf && d->m_root->entries.isEmpty() ) {
+        delete d->m_root;
+        d->m_root = new Node( true );
+    }
+
+    foreach ( const Entry &orphan, orphans ) {
+        d->insert( orphan );
+    }
+
+    return true;
+}
+
+void GeoGraphicsRTree::clear()
+{
+    GeoGraphicsRTreePrivate::deleteNode( d->m_root );
+    d->m_root = new Node( true );
+    d->m_records.clear();
+}
+
+bool GeoGraphicsRTree::isEmpty() const
+{
+    return d->m_records.isEmpty();
+}
+
+int GeoGraphicsRTree::size() const
+{
+    return d->m_records.size();
+}
+
+QList<GeoGraphicsItem *> GeoGraphicsRTree::items( const GeoDataLatLonBox &box, int maxZoomLevel ) const
+{
+    qreal north, south, east, west;
+    box.boundaries( north, south, east, west );
+    const Box queryBox = { west, south, east, north };
+
+    QVector<const Entry *> entries;
+    foreach ( const Box &part, GeoGraphicsRTreePrivate::splitAtDateLine( queryBox ) ) {
+        d->search( d->m_root, part, maxZoomLevel, entries );
+    }
+
+    qSort( entries.begin(), entries.end(), zValueLessThan );
+
+    // items crossing the date line may have been found twice, next to each other
+    QList<GeoGraphicsItem *> result;
+    result.reserve( entries.size() );
+    foreach ( const Entry *entry, entries ) {
+        if ( result.isEmpty() || result.last() != entry->item ) {
+            result.append( entry->item );
+        }
+    }
+
+    return result;
+}
+
+}
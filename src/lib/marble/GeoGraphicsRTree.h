@@ -0,0 +1,84 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_GEOGRAPHICSRTREE_H
+#define MARBLE_GEOGRAPHICSRTREE_H
+
+#include <QList>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+class GeoGraphicsItem;
+class GeoGraphicsRTreePrivate;
+
+/**
+ * @short A spatial index of GeoGraphicsItems
+ *
+ * An R-tree over the bounding boxes of the items. Items whose box crosses
+ * the date line are indexed by both of its halves, and query boxes crossing
+ * the date line are split the same way. Each node remembers the smallest
+ * minimum zoom level below it, so a query for a low zoom level does not
+ * descend into nodes which only hold detailed items.
+ *
+ * The index does not own the items. It keeps the bounding box and minimum
+ * zoom level an item had when it was inserted, so these have to be set up
+ * before.
+ */
+class MARBLE_EXPORT GeoGraphicsRTree
+{
+ public:
+    GeoGraphicsRTree();
+    ~GeoGraphicsRTree();
+
+    /**
+     * @brief Replaces the contents of the index by @p items
+     *
+     * Builds the tree in one go (Sort-Tile-Recursive packing), which is
+     * faster and gives a better tree than inserting the items one by one.
+     */
+    void load( const QList<GeoGraphicsItem *> &items );
+
+    void insert( GeoGraphicsItem *item );
+
+    /**
+     * @brief Removes @p item from the index
+     * @return false if the item was not in the index
+     */
+    bool remove( GeoGraphicsItem *item );
+
+    /**
+     * @brief Removes all items from the index without deleting them
+     */
+    void clear();
+
+    bool isEmpty() const;
+    int size() const;
+
+    /**
+     * @brief Returns the visible items in @p box
+     *
+     * Only items with a minimum zoom level up to @p maxZoomLevel are returned,
+     * ordered by z value and by the order of insertion for equal z values.
+     */
+    QList<GeoGraphicsItem *> items( const GeoDataLatLonBox &box, int maxZoomLevel ) const;
+
+ private:
+    Q_DISABLE_COPY( GeoGraphicsRTree )
+
+    GeoGraphicsRTreePrivate * const d;
+};
+
+}
+
+#endif
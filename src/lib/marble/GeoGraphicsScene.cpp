@@ -10,6 +10,7 @@
 
 #include "GeoGraphicsScene.h"
 
+#include "GeoDataContainer.h"
 #include "GeoDataFeature.h"
 #include "GeoDataGroundOverlay.h"
 #include "GeoDataLatLonBox.h"
@@ -20,17 +21,53 @@
 #include "GeoDataDocument.h"
 #include "GeoDataTypes.h"
 #include "GeoGraphicsItem.h"
-#include "TileId.h"
-#include "TileCoordsPyramid.h"
+#include "GeoGraphicsRTree.h"
 #include "MarbleDebug.h"
-#include <QMap>
+
+#include <QtAlgorithms>
 
 namespace Marble
 {
 
-bool zValueLessThan( GeoGraphicsItem* i1, GeoGraphicsItem* i2 )
+/**
+ * The items of the placemarks of one document of the tree, indexed on their
+ * own. Whole documents which are hidden or far from the queried box are
+ * skipped by the cached bounding box of the document, without looking at
+ * their index.
+ */
+class GeoGraphicsScenePartition
+{
+public:
+    explicit GeoGraphicsScenePartition( const GeoDataContainer *document ) :
+        m_document( document )
+    {
+    }
+
+    bool mayIntersect( const GeoDataLatLonBox &box ) const;
+
+    // 0 for the items which are not culled by a document, see partitionOf()
+    const GeoDataContainer *const m_document;
+    GeoGraphicsRTree m_items;
+};
+
+bool GeoGraphicsScenePartition::mayIntersect( const GeoDataLatLonBox &box ) const
+{
+    if ( !m_document ) {
+        return true;
+    }
+
+    if ( !m_document->isVisible() ) {
+        return false;
+    }
+
+    // Altitudes don't matter here. An empty box can't tell anything.
+    const GeoDataLatLonBox documentBox = m_document->latLonAltBox();
+    return documentBox.isEmpty() || box.isEmpty() || documentBox.intersects( box );
+}
+
+static bool zValueLessThan( const GeoGraphicsItem *one, const GeoGraphicsItem *other )
 {
-    return i1->zValue() < i2->zValue();
+    return one->zValue() < other->zValue();
 }
 
 class GeoGraphicsScenePrivate
@@ -47,16 +84,20 @@ public:
         q->clear();
     }
 
-    static void mergeItems( QList<GeoGraphicsItem *> &result, const QList<GeoGraphicsItem *> &objects, int maxZoomLevel );
-
-    QMap<TileId, QList<GeoGraphicsItem*> > m_items;
-    QMultiHash<const GeoDataFeature*, TileId> m_features;
+    // in the order of their creation, which keeps the order of insertion
+    // for items with equal z values
+    QList<GeoGraphicsScenePartition*> m_partitions;
+    QHash<const GeoDataContainer*, GeoGraphicsScenePartition*> m_documentPartitions;
+    QHash<const GeoDataFeature*, GeoGraphicsScenePartition*> m_featurePartitions;
+    QMultiHash<const GeoDataFeature*, GeoGraphicsItem*> m_features;
 
     // Stores the items which have been clicked;
     QList<GeoGraphicsItem*> m_selectedItems;
 
     GeoDataStyle *highlightStyle(const GeoDataDocument *document, const GeoDataStyleMap &styleMap);
 
+    GeoGraphicsScenePartition *partitionOf( const GeoDataFeature *feature );
+
     void selectItem( GeoGraphicsItem *item );
     void applyHighlightStyle( GeoGraphicsItem *item, GeoDataStyle *style );
 };
@@ -76,6 +117,36 @@ GeoDataStyle *GeoGraphicsScenePrivate::highlightStyle( const GeoDataDocument *do
     }
 }
 
+GeoGraphicsScenePartition *GeoGraphicsScenePrivate::partitionOf( const GeoDataFeature *feature )
+{
+    GeoGraphicsScenePartition *partition = m_featurePartitions.value( feature );
+    if ( partition ) {
+        return partition;
+    }
+
+    // The box of a container only covers the geometries of its placemarks,
+    // so the items of other features, like overlays, are never culled. The
+    // documents of the tree model all hang below its root document.
+    const GeoDataContainer *document = 0;
+    if ( feature && feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+        const GeoDataObject *object = feature->parent();
+        while ( object && object->parent() ) {
+            document = dynamic_cast<const GeoDataContainer*>( object );
+            object = object->parent();
+        }
+    }
+
+    partition = m_documentPartitions.value( document );
+    if ( !partition ) {
+        partition = new GeoGraphicsScenePartition( document );
+        m_partitions.append( partition );
+        m_documentPartitions.insert( document, partition );
+    }
+    m_featurePartitions.insert( feature, partition );
+
+    return partition;
+}
+
 void GeoGraphicsScenePrivate::selectItem( GeoGraphicsItem* item )
 {
     m_selectedItems.append( item );
@@ -101,57 +172,20 @@ GeoGraphicsScene::~GeoGraphicsScene()
 
 QList< GeoGraphicsItem* > GeoGraphicsScene::items( const GeoDataLatLonBox &box, int zoomLevel ) const
 {
-    if ( box.west() > box.east() ) {
-        // Handle boxes crossing the IDL by splitting it into two separate boxes
-        GeoDataLatLonBox left;
-        left.setWest( -M_PI );
-        left.setEast( box.east() );
-        left.setNorth( box.north() );
-        left.setSouth( box.south() );
-
-        GeoDataLatLonBox right;
-        right.setWest( box.west() );
-        right.setEast( M_PI );
-        right.setNorth( box.north() );
-        right.setSouth( box.south() );
-
-        QList< GeoGraphicsItem* > allItems = items( left, zoomLevel );
-        foreach( GeoGraphicsItem* item, items( right, zoomLevel ) ) {
-            if ( !allItems.contains( item ) ) {
-                allItems << item;
-            }
+    QList<GeoGraphicsItem*> result;
+    int partitionCount = 0;
+    foreach ( const GeoGraphicsScenePartition *partition, d->m_partitions ) {
+        if ( partition->mayIntersect( box ) ) {
+            result << partition->m_items.items( box, zoomLevel );
+            ++partitionCount;
         }
-        return allItems;
     }
 
-    QList< GeoGraphicsItem* > result;
-    QRect rect;
-    qreal north, south, east, west;
-    box.boundaries( north, south, east, west );
-    TileId key;
-
-    key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel );
-    rect.setLeft( key.x() );
-    rect.setTop( key.y() );
-
-    key = TileId::fromCoordinates( GeoDataCoordinates(east, south, 0), zoomLevel );
-    rect.setRight( key.x() );
-    rect.setBottom( key.y() );
-    
-    TileCoordsPyramid pyramid( 0, zoomLevel );
-    pyramid.setBottomLevelCoords( rect );
-
-    for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
-        QRect const coords = pyramid.coords( level );
-        int x1, y1, x2, y2;
-        coords.getCoords( &x1, &y1, &x2, &y2 );
-        for ( int x = x1; x <= x2; ++x ) {
-            for ( int y = y1; y <= y2; ++y ) {
-                const TileId tileId = TileId( 0, level, x, y );
-                GeoGraphicsScenePrivate::mergeItems( result, d->m_items.value( tileId ), zoomLevel );
-            }
-        }
+    // each index orders its own items already
+    if ( partitionCount > 1 ) {
+        qStableSort( result.begin(), result.end(), zValueLessThan );
     }
+
     return result;
 }
 
@@ -179,41 +213,35 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
      * items to use highlight style
      */
     foreach( const GeoDataPlacemark *placemark, selectedPlacemarks ) {
-        QList<TileId> tiles = d->m_features.values( placemark );
-        foreach( const TileId &tileId, tiles ) {
-            QList<GeoGraphicsItem*> clickedItems = d->m_items[tileId];
-            foreach ( GeoGraphicsItem *item, clickedItems ) {
-                if ( item->feature() == placemark ) {
-                    GeoDataObject *parent = placemark->parent();
-                    if ( parent ) {
-                        if ( parent->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
-                            GeoDataDocument *doc = static_cast<GeoDataDocument*>( parent );
-                            QString styleUrl = placemark->styleUrl();
-                            styleUrl.remove('#');
-                            if ( !styleUrl.isEmpty() ) {
-                                GeoDataStyleMap const &styleMap = doc->styleMap( styleUrl );
-                                GeoDataStyle *style = d->highlightStyle( doc, styleMap );
-                                if ( style ) {
-                                    d->selectItem( item );
-                                    d->applyHighlightStyle( item, style );
-                                }
-                            }
+        foreach ( GeoGraphicsItem *item, d->m_features.values( placemark ) ) {
+            GeoDataObject *parent = placemark->parent();
+            if ( parent ) {
+                if ( parent->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
+                    GeoDataDocument *doc = static_cast<GeoDataDocument*>( parent );
+                    QString styleUrl = placemark->styleUrl();
+                    styleUrl.remove('#');
+                    if ( !styleUrl.isEmpty() ) {
+                        GeoDataStyleMap const &styleMap = doc->styleMap( styleUrl );
+                        GeoDataStyle *style = d->highlightStyle( doc, styleMap );
+                        if ( style ) {
+                            d->selectItem( item );
+                            d->applyHighlightStyle( item, style );
+                        }
+                    }
 
-                            /**
-                            * If a placemark is using an inline style instead of a shared
-                            * style ( e.g in case when theme file specifies the colorMap
-                            * attribute ) then highlight it if any of the style maps have a
-                            * highlight styleId
-                            */
-                            else {
-                                foreach ( const GeoDataStyleMap &styleMap, doc->styleMaps() ) {
-                                    GeoDataStyle *style = d->highlightStyle( doc, styleMap );
-                                    if ( style ) {
-                                        d->selectItem( item );
-                                        d->applyHighlightStyle( item, style );
-                                        break;
-                                    }
-                                }
+                    /**
+                    * If a placemark is using an inline style instead of a shared
+                    * style ( e.g in case when theme file specifies the colorMap
+                    * attribute ) then highlight it if any of the style maps have a
+                    * highlight styleId
+                    */
+                    else {
+                        foreach ( const GeoDataStyleMap &styleMap, doc->styleMaps() ) {
+                            GeoDataStyle *style = d->highlightStyle( doc, styleMap );
+                            if ( style ) {
+                                d->selectItem( item );
+                                d->applyHighlightStyle( item, style );
+                                break;
                             }
                         }
                     }
@@ -226,64 +254,56 @@ void GeoGraphicsScene::applyHighlight( const QVector< GeoDataPlacemark* > &selec
 
 void GeoGraphicsScene::removeItem( const GeoDataFeature* feature )
 {
-    QList<TileId> keys = d->m_features.values( feature );
-    foreach( TileId key, keys ) {
-        QList< GeoGraphicsItem* >& tileList = d->m_items[key];
-        foreach( GeoGraphicsItem* item, tileList ) {
-            if( item->feature() == feature ) {
-                d->m_features.remove( feature );
-                tileList.removeAll( item );
-                delete item;
-                break;
-            }
-        }
+    GeoGraphicsScenePartition *partition = d->m_featurePartitions.take( feature );
+    foreach( GeoGraphicsItem* item, d->m_features.values( feature ) ) {
+        partition->m_items.remove( item );
+        d->m_selectedItems.removeAll( item );
+        delete item;
+    }
+    d->m_features.remove( feature );
+
+    if ( partition && partition->m_items.isEmpty() ) {
+        d->m_partitions.removeAll( partition );
+        d->m_documentPartitions.remove( partition->m_document );
+        delete partition;
     }
 }
 
 void GeoGraphicsScene::clear()
 {
-    foreach(const QList<GeoGraphicsItem*> &list, d->m_items.values()) {
-        qDeleteAll(list);
-    }
-    d->m_items.clear();
+    qDeleteAll( d->m_features );
+    qDeleteAll( d->m_partitions );
+    d->m_partitions.clear();
+    d->m_documentPartitions.clear();
+    d->m_featurePartitions.clear();
     d->m_features.clear();
+    d->m_selectedItems.clear();
 }
 
 void GeoGraphicsScene::addItem( GeoGraphicsItem* item )
 {
-    // Select zoom level so that the object fit in single tile
-    int zoomLevel;
-    qreal north, south, east, west;
-    item->latLonAltBox().boundaries( north, south, east, west );
-    for(zoomLevel = item->minZoomLevel(); zoomLevel >= 0; zoomLevel--)
-    {
-        if( TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel ) ==
-            TileId::fromCoordinates( GeoDataCoordinates(east, south, 0), zoomLevel ) )
-            break;
-    }
-
-    const TileId key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel ); // same as GeoDataCoordinates(east, south, 0), see above
-
-    QList< GeoGraphicsItem* >& tileList = d->m_items[key];
-    QList< GeoGraphicsItem* >::iterator position = qLowerBound( tileList.begin(), tileList.end(), item, zValueLessThan );
-    tileList.insert( position, item );
-    d->m_features.insert( item->feature(), key );
+    d->partitionOf( item->feature() )->m_items.insert( item );
+    d->m_features.insert( item->feature(), item );
 }
 
-void GeoGraphicsScenePrivate::mergeItems( QList<GeoGraphicsItem *> &result, const QList<GeoGraphicsItem *> &objects, int maxZoomLevel )
+void GeoGraphicsScene::addItems( const QList<GeoGraphicsItem*> &items )
 {
-    QList< GeoGraphicsItem* >::iterator before = result.begin();
-    QList< GeoGraphicsItem* >::const_iterator currentItem = objects.constBegin();
-    while( currentItem != objects.end() ) {
-        while( ( currentItem != objects.end() )
-          && ( ( before == result.end() ) || ( (*currentItem)->zValue() < (*before)->zValue() ) ) ) {
-            if( (*currentItem)->minZoomLevel() <= maxZoomLevel && (*currentItem)->visible() ) {
-                before = result.insert( before, *currentItem );
+    QHash<GeoGraphicsScenePartition*, QList<GeoGraphicsItem*> > partitionItems;
+    foreach( GeoGraphicsItem* item, items ) {
+        partitionItems[d->partitionOf( item->feature() )].append( item );
+        d->m_features.insert( item->feature(), item );
+    }
+
+    QHash<GeoGraphicsScenePartition*, QList<GeoGraphicsItem*> >::const_iterator it = partitionItems.constBegin();
+    for ( ; it != partitionItems.constEnd(); ++it ) {
+        GeoGraphicsRTree &index = it.key()->m_items;
+        if ( index.isEmpty() ) {
+            // building the index at once is faster and gives a better index
+            index.load( it.value() );
+        } else {
+            foreach( GeoGraphicsItem* item, it.value() ) {
+                index.insert( item );
             }
-            ++currentItem;
-        }
-        if ( before != result.end() ) {
-            ++before;
         }
     }
 }
@@ -51,6 +51,13 @@ public:
      */
     void addItem( GeoGraphicsItem *item );
 
+    /**
+     * @brief Add several items to the GeoGraphicsScene
+     * Adding many items at once is faster than adding them one by one,
+     * especially to an empty scene.
+     */
+    void addItems( const QList<GeoGraphicsItem *> &items );
+
     /**
      * @brief Remove all concerned items from the GeoGraphicsScene
      * Removes all items which are associated with @p object from the GeoGraphicsScene
@@ -67,7 +74,7 @@ public:
      *
      * @param box The box around the items.
      * @param maxZoomLevel The max zoom level of tiling
-     * @return The list of items in the specified box in no specific order.
+     * @return The list of items in the specified box ordered by their z value.
      */
     QList<GeoGraphicsItem *> items( const GeoDataLatLonBox &box, int maxZoomLevel ) const;
 
@@ -26,6 +26,7 @@
 #include "MarbleGlobal.h"
 #include "ViewportParams.h"
 #include "AbstractProjection.h"
+#include "ScreenPolygonCache.h"
 
 // #define MARBLE_DEBUG
 
@@ -498,12 +499,20 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
         return;
     }
 
-    QVector<QPolygonF*> polygons;
-    d->m_viewport->screenCoordinates( lineString, polygons );
+    QVector<QPolygonF> polygons;
+    ScreenPolygonCache::project( d->m_viewport, lineString, polygons );
+
+    drawScreenPolylines( polygons, labelText, labelPositionFlags );
+}
+
 
+void GeoPainter::drawScreenPolylines ( const QVector<QPolygonF> & polygons,
+                                       const QString& labelText,
+                                       LabelPositionFlags labelPositionFlags )
+{
     if ( labelText.isEmpty() || labelPositionFlags.testFlag( NoLabel ) ) {
-        foreach( QPolygonF* itPolygon, polygons ) {
-            ClipPainter::drawPolyline( *itPolygon );
+        foreach( const QPolygonF& itPolygon, polygons ) {
+            ClipPainter::drawPolyline( itPolygon );
         }
     }
     else {
@@ -511,9 +520,9 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
         int labelAscent = fontMetrics().ascent();
 
         QVector<QPointF> labelNodes;
-        foreach( QPolygonF* itPolygon, polygons ) {
+        foreach( const QPolygonF& itPolygon, polygons ) {
             labelNodes.clear();
-            ClipPainter::drawPolyline( *itPolygon, labelNodes, labelPositionFlags );
+            ClipPainter::drawPolyline( itPolygon, labelNodes, labelPositionFlags );
             if ( !labelNodes.isEmpty() ) {
                 foreach ( const QPointF& labelNode, labelNodes ) {
                     QPointF labelPosition = labelNode + QPointF( 3.0, -2.0 );
@@ -531,7 +540,6 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
             }
         }
     }
-    qDeleteAll( polygons );
 }
 
 
@@ -651,61 +659,33 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
     }
     // mDebug() << "Drawing Polygon";
 
-    // Creating the outer screen polygons first
-    QVector<QPolygonF*> outerPolygons;
-    d->m_viewport->screenCoordinates( polygon.outerBoundary(), outerPolygons );
+    QVector<QPolygonF> polygons;
+    QVector<QPolygonF> outlines;
+    ScreenPolygonCache::project( d->m_viewport, polygon, polygons, outlines );
 
-    // Now creating the "holes" by cutting away the inner boundaries:
+    drawScreenPolygons( polygons, outlines, fillRule );
+}
 
-    // In QPathClipper We Trust ...
-    // ... and in the speed of a threesome of nested foreachs!
 
-    QVector<QPolygonF> outline;
+void GeoPainter::drawScreenPolygons ( const QVector<QPolygonF> & polygons,
+                                      const QVector<QPolygonF> & outlines,
+                                      Qt::FillRule fillRule )
+{
     QPen const oldPen = pen();
-    // When inner boundaries exist, the outline of the polygon must be painted
-    // separately to avoid connections between the outer and inner boundaries
-    // To avoid performance penalties the separate painting is only done when
-    // it's really needed. See review 105019 for details.
-    bool const needOutlineWorkaround = !polygon.innerBoundaries().isEmpty();
-    if ( needOutlineWorkaround ) {
-        foreach( QPolygonF* polygon, outerPolygons ) {
-            outline << *polygon;
-        }
+    if ( !outlines.isEmpty() ) {
         setPen( QPen( Qt::NoPen ) );
     }
 
-
-    QVector<GeoDataLinearRing> innerBoundaries = polygon.innerBoundaries(); 
-    foreach( const GeoDataLinearRing& itInnerBoundary, innerBoundaries ) {
-        QVector<QPolygonF*> innerPolygons;
-        d->m_viewport->screenCoordinates( itInnerBoundary, innerPolygons );
-
-        if ( needOutlineWorkaround ) {
-            foreach( QPolygonF* polygon, innerPolygons ) {
-                outline << *polygon;
-            }
-        }
-
-        foreach( QPolygonF* itOuterPolygon, outerPolygons ) {
-            foreach( QPolygonF* itInnerPolygon, innerPolygons ) {
-                *itOuterPolygon = itOuterPolygon->subtracted( *itInnerPolygon );
-            }
-        }
-        qDeleteAll( innerPolygons );    
+    foreach( const QPolygonF& itPolygon, polygons ) {
+        ClipPainter::drawPolygon( itPolygon, fillRule );
     }
 
-    foreach( QPolygonF* itOuterPolygon, outerPolygons ) {
-        ClipPainter::drawPolygon( *itOuterPolygon, fillRule );
-    }
-
-    if ( needOutlineWorkaround ) {
+    if ( !outlines.isEmpty() ) {
         setPen( oldPen );
-        foreach( const QPolygonF &polygon, outline ) {
+        foreach( const QPolygonF &polygon, outlines ) {
             ClipPainter::drawPolyline( polygon );
         }
     }
-
-    qDeleteAll( outerPolygons );    
 }
 
 
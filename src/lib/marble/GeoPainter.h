@@ -380,6 +380,34 @@ class MARBLE_EXPORT GeoPainter : public ClipPainter
     void drawPolygon ( const GeoDataPolygon & polygon,
                        Qt::FillRule fillRule = Qt::OddEvenFill );
 
+
+/*!
+    \brief Draws line strings which have been projected to the screen already.
+
+    Like drawPolyline( GeoDataLineString ), but for the screen \a polygons
+    a line string has been projected to, e.g. by ScreenPolygonCache.
+
+    \see ScreenPolygonCache
+*/
+    void drawScreenPolylines ( const QVector<QPolygonF> & polygons,
+                               const QString& labelText = QString(),
+                               LabelPositionFlags labelPositionFlags = LineCenter );
+
+
+/*!
+    \brief Draws polygons which have been projected to the screen already.
+
+    Like drawPolygon( GeoDataPolygon ), but for the screen \a polygons a
+    polygon has been projected to, e.g. by ScreenPolygonCache. If there are
+    any \a outlines they are drawn using the current pen instead of the
+    outlines of the \a polygons.
+
+    \see ScreenPolygonCache
+*/
+    void drawScreenPolygons ( const QVector<QPolygonF> & polygons,
+                              const QVector<QPolygonF> & outlines = QVector<QPolygonF>(),
+                              Qt::FillRule fillRule = Qt::OddEvenFill );
+
     
 /*!
     \brief Draws a rectangle at the given position.
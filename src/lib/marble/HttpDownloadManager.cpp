@@ -47,6 +47,7 @@ class HttpDownloadManager::Private
     StoragePolicy *const m_storagePolicy;
     QNetworkAccessManager m_networkAccessManager;
     bool m_acceptJobs;
+    CacheStatistics *m_statistics;
 
 };
 
@@ -54,7 +55,8 @@ HttpDownloadManager::Private::Private( StoragePolicy *policy )
     : m_requeueTimer(),
       m_storagePolicy( policy ),
       m_networkAccessManager(),
-      m_acceptJobs( true )
+      m_acceptJobs( true ),
+      m_statistics( 0 )
 {
     // setup default download policy and associated queue set
     DownloadPolicy defaultBrowsePolicy;
@@ -124,11 +126,29 @@ void HttpDownloadManager::addDownloadPolicy( const DownloadPolicy& policy )
     if ( hasDownloadPolicy( policy ))
         return;
     DownloadQueueSet * const queueSet = new DownloadQueueSet( policy, this );
+    queueSet->setCacheStatistics( d->m_statistics );
     connectQueueSet( queueSet );
     d->m_queueSets.append( QPair<DownloadPolicyKey, DownloadQueueSet *>
                            ( queueSet->downloadPolicy().key(), queueSet ));
 }
 
+void HttpDownloadManager::setCacheStatistics( CacheStatistics *statistics )
+{
+    d->m_statistics = statistics;
+
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator pos = d->m_queueSets.begin();
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator const end = d->m_queueSets.end();
+    for (; pos != end; ++pos ) {
+        pos->second->setCacheStatistics( statistics );
+    }
+
+    QMap<DownloadUsage, DownloadQueueSet *>::iterator defaultPos = d->m_defaultQueueSets.begin();
+    QMap<DownloadUsage, DownloadQueueSet *>::iterator const defaultEnd = d->m_defaultQueueSets.end();
+    for (; defaultPos != defaultEnd; ++defaultPos ) {
+        defaultPos.value()->setCacheStatistics( statistics );
+    }
+}
+
 void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFileName,
                                   const QString &id, const DownloadUsage usage )
 {
@@ -147,6 +167,37 @@ void HttpDownloadManager::addJob( const QUrl& sourceUrl, const QString& destFile
     }
 }
 
+void HttpDownloadManager::addPrefetchJob( const QUrl& sourceUrl, const QString& destFileName,
+                                          const QString &id )
+{
+    if ( !d->m_acceptJobs ) {
+        return;
+    }
+
+    DownloadQueueSet * const queueSet = d->findQueues( sourceUrl.host(), DownloadBrowse );
+    if ( queueSet->canAcceptPrefetchJob( sourceUrl, destFileName )) {
+        HttpJob * const job = new HttpJob( sourceUrl, destFileName, id, &d->m_networkAccessManager );
+        job->setUserAgentPluginId( "QNamNetworkPlugin" );
+        job->setDownloadUsage( DownloadBrowse );
+        queueSet->addPrefetchJob( job );
+    }
+}
+
+void HttpDownloadManager::cancelPrefetchJobs()
+{
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator pos = d->m_queueSets.begin();
+    QList<QPair<DownloadPolicyKey, DownloadQueueSet *> >::iterator const end = d->m_queueSets.end();
+    for (; pos != end; ++pos ) {
+        pos->second->cancelPrefetchJobs();
+    }
+
+    QMap<DownloadUsage, DownloadQueueSet *>::iterator defaultPos = d->m_defaultQueueSets.begin();
+    QMap<DownloadUsage, DownloadQueueSet *>::iterator const defaultEnd = d->m_defaultQueueSets.end();
+    for (; defaultPos != defaultEnd; ++defaultPos ) {
+        defaultPos.value()->cancelPrefetchJobs();
+    }
+}
+
 void HttpDownloadManager::finishJob( const QByteArray& data, const QString& destinationFileName,
                                      const QString& id )
 {
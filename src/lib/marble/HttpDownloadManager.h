@@ -28,6 +28,7 @@ namespace Marble
 {
 
 class DownloadPolicy;
+class CacheStatistics;
 class DownloadQueueSet;
 class StoragePolicy;
 
@@ -66,6 +67,11 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void setDownloadEnabled( const bool enable );
     void addDownloadPolicy( const DownloadPolicy& );
 
+    /**
+     * Sets the statistics which the latency of downloads is reported to.
+     */
+    void setCacheStatistics( CacheStatistics *statistics );
+
  public Q_SLOTS:
 
     /**
@@ -74,6 +80,17 @@ class MARBLE_EXPORT HttpDownloadManager : public QObject
     void addJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id,
                  const DownloadUsage usage );
 
+    /**
+     * Adds a new low priority browse job for a file which is expected to be
+     * needed soon, e.g. a tile which is going to become visible.
+     */
+    void addPrefetchJob( const QUrl& sourceUrl, const QString& destFilename, const QString &id );
+
+    /**
+     * Removes all prefetch jobs which have not been started yet.
+     */
+    void cancelPrefetchJobs();
+
 
  Q_SIGNALS:
     void downloadComplete( QString, QString );
@@ -18,6 +18,7 @@
 
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QTime>
 
 using namespace Marble;
 
@@ -35,6 +36,7 @@ class Marble::HttpJobPrivate
     QString m_userAgent;
     QNetworkAccessManager *const m_networkAccessManager;
     QNetworkReply *m_networkReply;
+    QTime          m_creationTime;
 };
 
 HttpJobPrivate::HttpJobPrivate( const QUrl & sourceUrl, const QString & destFileName,
@@ -50,6 +52,7 @@ HttpJobPrivate::HttpJobPrivate( const QUrl & sourceUrl, const QString & destFile
       m_networkAccessManager( networkAccessManager ),
       m_networkReply( 0 )
 {
+    m_creationTime.start();
 }
 
 
@@ -119,6 +122,11 @@ void HttpJob::setUserAgentPluginId( const QString & pluginId ) const
     d->m_userAgent = pluginId;
 }
 
+int HttpJob::elapsed() const
+{
+    return d->m_creationTime.elapsed();
+}
+
 QByteArray HttpJob::userAgent() const
 {
     switch ( d->m_downloadUsage ) {
@@ -56,6 +56,11 @@ class MARBLE_EXPORT HttpJob: public QObject
 
     QByteArray userAgent() const;
 
+    /**
+     * Returns the time in milliseconds since the job was created.
+     */
+    int elapsed() const;
+
  Q_SIGNALS:
     /**
      * errorCode contains 0, if there was no error and 1 otherwise
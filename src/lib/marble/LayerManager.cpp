@@ -20,6 +20,7 @@
 #include "AbstractDataPluginItem.h"
 #include "AbstractFloatItem.h"
 #include "GeoPainter.h"
+#include "CacheStatistics.h"
 #include "MarbleModel.h"
 #include "PluginManager.h"
 #include "RenderPlugin.h"
@@ -181,6 +182,7 @@ void LayerManager::renderLayers( GeoPainter *painter, ViewportParams *viewport )
         const int totalElapsed = totalTime.elapsed();
         const int fps = 1000.0/totalElapsed;
         traceList.append( QString( "Total: %1 ms (%2 fps)" ).arg( totalElapsed, 3 ).arg( fps ) );
+        traceList << d->m_model->cacheStatistics()->runtimeTrace();
 
         painter->save();
         painter->setBackgroundMode( Qt::OpaqueMode );
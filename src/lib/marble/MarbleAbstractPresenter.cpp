@@ -96,6 +96,11 @@ namespace Marble
         }
         else
         {
+            // the destination is known, so prepare its tiles while flying there
+            const GeoDataCoordinates::Unit deg = GeoDataCoordinates::Degree;
+            const int radius = qRound(radiusFromDistance(newLookAt.range() * METER2KM));
+            map()->prefetch(newLookAt.longitude(deg), newLookAt.latitude(deg), radius);
+
             m_physics.flyTo(newLookAt, mode);
         }
     }
@@ -171,6 +171,17 @@ enum DownloadUsage {
     DownloadBrowse      ///< Browsing mode, normal operation of Marble, like a web browser
 };
 
+/**
+ * @brief This enum is used to choose how tiles which are not displayed are kept
+ *        in the volatile tile cache
+ */
+enum TileCacheEncoding {
+    UncompressedTiles,  ///< Tiles are kept as they are displayed
+    Rgb565Tiles,        ///< 16 bits per pixel, lossy
+    PalettizedTiles,    ///< 8 bits per pixel for tiles with at most 256 colors, compressed otherwise
+    CompressedTiles     ///< Lossless compression
+};
+
 /** 
  * @brief Describes possible flight mode (interpolation between source
  *        and target camera positions)
@@ -370,7 +370,7 @@ void MarbleDefaultInputHandler::checkReleasedMove(QMouseEvent *event)
 
             if (MarbleInputHandler::d->m_inertialEarthRotation)
             {
-                d->m_kineticSpinning.start();
+                startKineticSpinning();
             }
             else
             {
@@ -432,6 +432,9 @@ void MarbleDefaultInputHandler::handleLeftMouseButtonPress(QMouseEvent *event)
         d->m_kineticSpinning.setPosition(d->m_leftPressedLon, d->m_leftPressedLat);
     }
 
+    // the map is going to move somewhere else than predicted before
+    MarbleInputHandler::d->m_marblePresenter->map()->cancelPrefetch();
+
     // Choose spin direction by taking into account whether we
     // drag above or below the visible pole.
     if (MarbleInputHandler::d->m_marblePresenter->map()->projection() == Spherical)
@@ -477,7 +480,7 @@ void MarbleDefaultInputHandler::handleMiddleMouseButtonPress(QMouseEvent *event)
 
     if (MarbleInputHandler::d->m_inertialEarthRotation)
     {
-        d->m_kineticSpinning.start();
+        startKineticSpinning();
     }
 
     selectionRubber()->hide();
@@ -500,7 +503,7 @@ void MarbleDefaultInputHandler::handleMouseButtonRelease(QMouseEvent *event)
         d->m_leftPressed = false;
         if (MarbleInputHandler::d->m_inertialEarthRotation)
         {
-            d->m_kineticSpinning.start();
+            startKineticSpinning();
         }
         else
         {
@@ -616,6 +619,21 @@ void MarbleDefaultInputHandler::adjustCursorShape(const QPoint &mousePosition, c
 #endif
 }
 
+void MarbleDefaultInputHandler::startKineticSpinning()
+{
+    d->m_kineticSpinning.start();
+
+    // prepare the tiles where the spinning is going to stop
+    const QPointF restingPosition = d->m_kineticSpinning.restingPosition();
+    if (restingPosition != d->m_kineticSpinning.position())
+    {
+        MarbleAbstractPresenter *marblePresenter = MarbleInputHandler::d->m_marblePresenter;
+        const qreal lon = GeoDataCoordinates::normalizeLon(restingPosition.x(), GeoDataCoordinates::Degree);
+        const qreal lat = qBound<qreal>(-90.0, restingPosition.y(), 90.0);
+        marblePresenter->map()->prefetch(lon, lat, marblePresenter->radius());
+    }
+}
+
 QPoint MarbleDefaultInputHandler::mouseMovedOutside(QMouseEvent *event)
 {   //Returns a 2d vector representing the direction in which the mouse left
     int dirX = 0;
@@ -626,7 +644,7 @@ QPoint MarbleDefaultInputHandler::mouseMovedOutside(QMouseEvent *event)
 
     if (MarbleInputHandler::d->m_inertialEarthRotation)
     {
-        d->m_kineticSpinning.start();
+        startKineticSpinning();
     }
 
     QRect boundingRect = MarbleInputHandler::d->m_marblePresenter->viewport()->mapRegion().boundingRect();
@@ -167,6 +167,8 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model ) :
     m_isLockedToSubSolarPoint( false ),
     m_isSubSolarPointIconVisible( false )
 {
+    m_textureLayer.setCacheStatistics( model->cacheStatistics() );
+
     m_layerManager.addLayer( &m_fogLayer );
     m_layerManager.addLayer( &m_groundLayer );
     m_layerManager.addLayer( &m_geometryLayer );
@@ -461,6 +463,18 @@ void MarbleMap::reload()
     d->m_textureLayer.reload();
 }
 
+void MarbleMap::prefetch( qreal lon, qreal lat, int radius )
+{
+    const ViewportParams viewport( d->m_viewport.projection(), lon * DEG2RAD, lat * DEG2RAD,
+                                   radius, d->m_viewport.size() );
+    d->m_textureLayer.prefetchTiles( &viewport );
+}
+
+void MarbleMap::cancelPrefetch()
+{
+    d->m_textureLayer.cancelPrefetch();
+}
+
 void MarbleMap::downloadRegion( QVector<TileCoordsPyramid> const & pyramid )
 {
     Q_ASSERT( textureLayer() );
@@ -648,6 +662,16 @@ quint64 MarbleMap::volatileTileCacheLimit() const
     return d->m_textureLayer.volatileCacheLimit();
 }
 
+quint64 MarbleMap::decodedTileCacheLimit() const
+{
+    return d->m_textureLayer.decodedTileCacheLimit();
+}
+
+TileCacheEncoding MarbleMap::volatileTileCacheEncoding() const
+{
+    return d->m_textureLayer.volatileCacheEncoding();
+}
+
 
 void MarbleMap::rotateBy( const qreal& deltaLon, const qreal& deltaLat )
 {
@@ -1184,6 +1208,16 @@ void MarbleMap::setVolatileTileCacheLimit( quint64 kilobytes )
     d->m_textureLayer.setVolatileCacheLimit( kilobytes );
 }
 
+void MarbleMap::setDecodedTileCacheLimit( quint64 kilobytes )
+{
+    d->m_textureLayer.setDecodedTileCacheLimit( kilobytes );
+}
+
+void MarbleMap::setVolatileTileCacheEncoding( TileCacheEncoding encoding )
+{
+    d->m_textureLayer.setVolatileCacheEncoding( encoding );
+}
+
 AngleUnit MarbleMap::defaultAngleUnit() const
 {
     if ( GeoDataCoordinates::defaultNotation() == GeoDataCoordinates::Decimal ) {
@@ -362,6 +362,17 @@ class MARBLE_EXPORT MarbleMap : public QObject
      */
     quint64 volatileTileCacheLimit() const;
 
+    /**
+     * @brief  Returns the limit in kilobytes of the memory-mapped cache of blended tiles.
+     * @return the limit of the decoded tile cache in kilobytes, 0 if disabled.
+     */
+    quint64 decodedTileCacheLimit() const;
+
+    /**
+     * @brief  Returns how tiles which are not displayed are kept in the volatile tile cache.
+     */
+    TileCacheEncoding volatileTileCacheEncoding() const;
+
     /**
      * @brief Returns a list of all RenderPlugins in the model, this includes float items
      * @return the list of RenderPlugins
@@ -631,6 +642,20 @@ class MARBLE_EXPORT MarbleMap : public QObject
      */
     void setVolatileTileCacheLimit( quint64 kiloBytes );
 
+    /**
+     * @brief  Set the limit of the memory-mapped cache of blended tiles,
+     *         which backs up the volatile tile cache. 0 disables it.
+     * @param  kiloBytes The limit in kilobytes.
+     */
+    void setDecodedTileCacheLimit( quint64 kiloBytes );
+
+    /**
+     * @brief  Set how tiles which are not displayed are kept in the volatile tile cache.
+     *         A compact encoding lets more tiles fit into the volatile tile cache limit.
+     * @param  encoding The encoding, UncompressedTiles by default.
+     */
+    void setVolatileTileCacheEncoding( TileCacheEncoding encoding );
+
     void setDefaultAngleUnit( AngleUnit angleUnit );
 
     void setDefaultFont( const QFont& font );
@@ -642,6 +667,20 @@ class MARBLE_EXPORT MarbleMap : public QObject
      */
     void reload();
 
+    /**
+     * @brief Prepares the texture tiles for showing the map at the given
+     *        position soon, e.g. at the end of a kinetic spin or a flight.
+     * @param  lon     the expected center longitude in degree
+     * @param  lat     the expected center latitude in degree
+     * @param  radius  the expected radius of the globe
+     */
+    void prefetch( qreal lon, qreal lat, int radius );
+
+    /**
+     * @brief Cancels the pending downloads and loads started by prefetch().
+     */
+    void cancelPrefetch();
+
     void downloadRegion( QVector<TileCoordsPyramid> const & );
 
  Q_SIGNALS:
@@ -19,6 +19,7 @@
 
 #include <QAtomicInt>
 #include <QPointer>
+#include <QScopedPointer>
 #include <QTime>
 #include <QTimer>
 #include <QAbstractItemModel>
@@ -56,6 +57,7 @@
 
 #include "DgmlAuxillaryDictionary.h"
 #include "MarbleClock.h"
+#include "ArchiveStoragePolicy.h"
 #include "FileStoragePolicy.h"
 #include "FileStorageWatcher.h"
 #include "PositionTracking.h"
@@ -69,6 +71,7 @@
 #include "PluginManager.h"
 #include "StoragePolicy.h"
 #include "SunLocator.h"
+#include "TileArchive.h"
 #include "TileCreator.h"
 #include "TileCreatorDialog.h"
 #include "TileLoader.h"
@@ -76,6 +79,7 @@
 #include "RouteSimulationPositionProviderPlugin.h"
 #include "BookmarkManager.h"
 #include "ElevationModel.h"
+#include "CacheStatistics.h"
 
 namespace Marble
 {
@@ -91,8 +95,8 @@ class MarbleModelPrivate
           m_homePoint( -9.4, 54.8, 0.0, GeoDataCoordinates::Degree ),  // Some point that tackat defined. :-)
           m_homeZoom( 1050 ),
           m_mapTheme( 0 ),
-          m_storagePolicy( MarbleDirs::localPath() ),
-          m_downloadManager( &m_storagePolicy ),
+          m_storagePolicy( createStoragePolicy() ),
+          m_downloadManager( m_storagePolicy.data() ),
           m_storageWatcher( MarbleDirs::localPath() ),
           m_treeModel(),
           m_descendantProxy(),
@@ -124,6 +128,13 @@ class MarbleModelPrivate
         delete m_legend;
     }
 
+    /**
+     * @brief Returns a storage policy for the tile cache, which keeps
+     * texture tiles in a TileArchive if the user converted the cache
+     * to one, and in separate files otherwise.
+     */
+    static StoragePolicy *createStoragePolicy();
+
     /**
      * @brief When applying a new theme, if the old theme
      * contains any data whose source file is same
@@ -165,7 +176,11 @@ class MarbleModelPrivate
     // View and paint stuff
     GeoSceneDocument        *m_mapTheme;
 
-    FileStoragePolicy        m_storagePolicy;
+    // declared before the caches, which report to it until destruction
+    CacheStatistics          m_cacheStatistics;
+
+    // declared before m_downloadManager, which uses it until destruction
+    QScopedPointer<StoragePolicy> const m_storagePolicy;
     HttpDownloadManager      m_downloadManager;
 
     // Cache related
@@ -211,10 +226,14 @@ MarbleModel::MarbleModel( QObject *parent )
     new QNetworkConfigurationManager( this );
 #endif
 
+    d->m_downloadManager.setCacheStatistics( &d->m_cacheStatistics );
+    d->m_storageWatcher.setCacheStatistics( &d->m_cacheStatistics );
+    d->m_elevationModel.setCacheStatistics( &d->m_cacheStatistics );
+
     // connect the StoragePolicy used by the download manager to the FileStorageWatcher
-    connect( &d->m_storagePolicy, SIGNAL(cleared()),
+    connect( d->m_storagePolicy.data(), SIGNAL(cleared()),
              &d->m_storageWatcher, SLOT(resetCurrentSize()) );
-    connect( &d->m_storagePolicy, SIGNAL(sizeChanged(qint64)),
+    connect( d->m_storagePolicy.data(), SIGNAL(sizeChanged(qint64)),
              &d->m_storageWatcher, SLOT(addToCurrentSize(qint64)) );
 
     connect( &d->m_fileManager, SIGNAL(fileAdded( QString)),
@@ -450,6 +469,17 @@ void MarbleModel::setMapTheme( GeoSceneDocument *document )
     emit themeChanged( mapTheme->head()->mapThemeId() );
 }
 
+StoragePolicy *MarbleModelPrivate::createStoragePolicy()
+{
+    TileArchive *const archive = TileArchive::cacheArchive();
+    if ( archive && archive->isOpen() ) {
+        mDebug() << "Storing texture tiles in" << archive->fileName();
+        return new ArchiveStoragePolicy( archive, MarbleDirs::localPath() );
+    }
+
+    return new FileStoragePolicy( MarbleDirs::localPath() );
+}
+
 void MarbleModelPrivate::addHighlightStyle(GeoDataDocument* doc)
 {
     if ( doc ) {
@@ -543,6 +573,16 @@ const HttpDownloadManager *MarbleModel::downloadManager() const
     return &d->m_downloadManager;
 }
 
+CacheStatistics *MarbleModel::cacheStatistics()
+{
+    return &d->m_cacheStatistics;
+}
+
+const CacheStatistics *MarbleModel::cacheStatistics() const
+{
+    return &d->m_cacheStatistics;
+}
+
 
 GeoDataTreeModel *MarbleModel::treeModel()
 {
@@ -631,7 +671,7 @@ quint64 MarbleModel::persistentTileCacheLimit() const
 
 void MarbleModel::clearPersistentTileCache()
 {
-    d->m_storagePolicy.clearCache();
+    d->m_storagePolicy->clearCache();
 
     // Now create base tiles again if needed
     if ( d->m_mapTheme->map()->hasTextureLayers() || d->m_mapTheme->map()->hasVectorLayers() ) {
@@ -678,6 +718,11 @@ void MarbleModel::setPersistentTileCacheLimit(quint64 kiloBytes)
 {
     d->m_storageWatcher.setCacheLimit( kiloBytes * 1024 );
 
+    TileArchive *const archive = TileArchive::cacheArchive();
+    if ( archive ) {
+        archive->setCacheLimit( kiloBytes * 1024 );
+    }
+
     if( kiloBytes != 0 )
     {
         if( !d->m_storageWatcher.isRunning() )
@@ -67,6 +67,7 @@ class RoutingManager;
 class BookmarkManager;
 class FileManager;
 class ElevationModel;
+class CacheStatistics;
 
 /**
  * @short The data model (not based on QAbstractModel) for a MarbleWidget.
@@ -189,6 +190,13 @@ class MARBLE_EXPORT MarbleModel : public QObject
     HttpDownloadManager *downloadManager();
     const HttpDownloadManager *downloadManager() const;
 
+    /**
+     * @brief Return the hit and miss numbers and timings of the tile caches
+     *        of this model and of the maps displaying it
+     */
+    CacheStatistics *cacheStatistics();
+    const CacheStatistics *cacheStatistics() const;
+
 
     /**
      * @brief Handle file loading into the treeModel
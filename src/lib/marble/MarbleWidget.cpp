@@ -530,6 +530,16 @@ quint64 MarbleWidget::volatileTileCacheLimit() const
     return d->map()->volatileTileCacheLimit();
 }
 
+quint64 MarbleWidget::decodedTileCacheLimit() const
+{
+    return d->map()->decodedTileCacheLimit();
+}
+
+TileCacheEncoding MarbleWidget::volatileTileCacheEncoding() const
+{
+    return d->map()->volatileTileCacheEncoding();
+}
+
 
 void MarbleWidget::setZoom( int newZoom, FlyToMode mode )
 {
@@ -1007,6 +1017,16 @@ void MarbleWidget::setVolatileTileCacheLimit( quint64 kiloBytes )
     d->map()->setVolatileTileCacheLimit( kiloBytes );
 }
 
+void MarbleWidget::setDecodedTileCacheLimit( quint64 kiloBytes )
+{
+    d->map()->setDecodedTileCacheLimit( kiloBytes );
+}
+
+void MarbleWidget::setVolatileTileCacheEncoding( TileCacheEncoding encoding )
+{
+    d->map()->setVolatileTileCacheEncoding( encoding );
+}
+
 // This slot will called when the Globe starts to create the tiles.
 
 void MarbleWidget::creatingTilesStart( TileCreator *creator,
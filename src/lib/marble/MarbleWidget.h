@@ -143,6 +143,7 @@ class MARBLE_EXPORT MarbleWidget : public QWidget
     Q_PROPERTY( RenderStatus renderStatus READ renderStatus NOTIFY renderStatusChanged )
 
     Q_PROPERTY(quint64 volatileTileCacheLimit    READ volatileTileCacheLimit    WRITE setVolatileTileCacheLimit)
+    Q_PROPERTY(quint64 decodedTileCacheLimit     READ decodedTileCacheLimit     WRITE setDecodedTileCacheLimit)
 
  public:
 
@@ -570,6 +571,17 @@ class MARBLE_EXPORT MarbleWidget : public QWidget
      */
     quint64 volatileTileCacheLimit() const;
 
+    /**
+     * @brief  Returns the limit in kilobytes of the memory-mapped cache of blended tiles.
+     * @return the limit of the decoded tile cache, 0 if disabled
+     */
+    quint64 decodedTileCacheLimit() const;
+
+    /**
+     * @brief  Returns how tiles which are not displayed are kept in the volatile tile cache.
+     */
+    TileCacheEncoding volatileTileCacheEncoding() const;
+
     //@}
 
     /// @name Miscellaneous
@@ -960,6 +972,20 @@ class MARBLE_EXPORT MarbleWidget : public QWidget
      */
     void setVolatileTileCacheLimit( quint64 kiloBytes );
 
+    /**
+     * @brief  Set the limit of the memory-mapped cache of blended tiles,
+     *         which backs up the volatile tile cache. 0 disables it.
+     * @param  kilobytes The limit in kilobytes.
+     */
+    void setDecodedTileCacheLimit( quint64 kiloBytes );
+
+    /**
+     * @brief  Set how tiles which are not displayed are kept in the volatile tile cache.
+     *         A compact encoding lets more tiles fit into the volatile tile cache limit.
+     * @param  encoding The encoding, UncompressedTiles by default.
+     */
+    void setVolatileTileCacheEncoding( TileCacheEncoding encoding );
+
     /**
      * @brief A slot that is called when the model starts to create new tiles.
      * @param creator the tile creator object.
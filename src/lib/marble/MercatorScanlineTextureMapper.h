@@ -17,8 +17,8 @@
 #include "TextureMapperInterface.h"
 
 #include "MarbleGlobal.h"
+#include "TextureMapperScheduler.h"
 
-#include <QThreadPool>
 #include <QImage>
 
 
@@ -36,9 +36,23 @@ class MercatorScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer );
 
+    virtual QString runtimeTrace() const;
+
+    virtual void setCenterChanged();
+
  private:
     void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
 
+    /**
+     * Shifts the previous result by the movement of the center and maps
+     * the exposed areas only. Returns false if a full repaint is needed instead.
+     */
+    bool mapTranslatedTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality,
+                               const TextureColorizer *texColorizer );
+
+    static void paintedRange( const ViewportParams *viewport, int imageHeight,
+                              int &yTop, int &yPaintedTop, int &yPaintedBottom );
+
  private:
     class RenderJob;
 
@@ -46,7 +60,13 @@ class MercatorScanlineTextureMapper : public TextureMapperInterface
     int m_radius;
     QImage m_canvasImage;
     int    m_oldYPaintedTop;
-    QThreadPool m_threadPool;
+    TextureMapperScheduler m_scheduler;
+
+    // view the canvas image has been mapped for
+    qreal      m_paintedCenterLon;
+    int        m_paintedYCenterOffset;
+    int        m_paintedTileLevel;
+    MapQuality m_paintedMapQuality;
 };
 
 }
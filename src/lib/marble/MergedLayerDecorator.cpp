@@ -20,6 +20,7 @@
 
 #include "blendings/Blending.h"
 #include "blendings/BlendingFactory.h"
+#include "DecodedTileCache.h"
 #include "SunLocator.h"
 #include "MarbleMath.h"
 #include "MarbleDebug.h"
@@ -48,6 +49,13 @@ public:
     static int maxDivisor( int maximum, int fullLength );
 
     StackedTile *createTile( const QVector<QSharedPointer<TextureTile> > &tiles ) const;
+    QVector<QSharedPointer<TextureTile> > loadTextureTiles( const TileId &stackedTileId, DownloadUsage usage ) const;
+
+    /**
+     * Returns whether tiles created now may be taken from or put into
+     * the decoded tile cache, and the key describing how they are created.
+     */
+    bool decodedTileCacheKey( const TileId &stackedTileId, QString &key ) const;
 
     void renderGroundOverlays( QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles ) const;
     void paintSunShading( QImage *tileImage, const TileId &id ) const;
@@ -68,6 +76,7 @@ public:
     bool m_showSunShading;
     bool m_showCityLights;
     bool m_showTileId;
+    DecodedTileCache m_decodedTileCache;
 };
 
 MergedLayerDecorator::Private::Private( TileLoader *tileLoader, const SunLocator *sunLocator ) :
@@ -109,6 +118,7 @@ void MergedLayerDecorator::setTextureLayers( const QVector<const GeoSceneTexture
     }
 
     d->m_textureLayers = textureLayers;
+    d->m_decodedTileCache.clear();
 
     d->detectMaxTileLevel();
 }
@@ -301,7 +311,34 @@ void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, con
 
 StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId )
 {
-    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( stackedTileId );
+    QString key;
+    const bool useDecodedTileCache = d->decodedTileCacheKey( stackedTileId, key );
+
+    if ( useDecodedTileCache ) {
+        const QImage resultImage = d->m_decodedTileCache.find( stackedTileId, key );
+        if ( !resultImage.isNull() ) {
+            mDebug() << Q_FUNC_INFO << stackedTileId << "found in decoded tile cache";
+            // the texture tiles are loaded on demand by updateTile()
+            return new StackedTile( stackedTileId, resultImage );
+        }
+    }
+
+    const QVector<QSharedPointer<TextureTile> > tiles = d->loadTextureTiles( stackedTileId, DownloadBrowse );
+
+    Q_ASSERT( !tiles.isEmpty() );
+
+    StackedTile *const stackedTile = d->createTile( tiles );
+
+    if ( useDecodedTileCache ) {
+        d->m_decodedTileCache.insert( stackedTileId, key, *stackedTile->resultImage() );
+    }
+
+    return stackedTile;
+}
+
+QVector<QSharedPointer<TextureTile> > MergedLayerDecorator::Private::loadTextureTiles( const TileId &stackedTileId, DownloadUsage usage ) const
+{
+    const QVector<const GeoSceneTextureTile *> textureLayers = findRelevantTextureLayers( stackedTileId );
     QVector<QSharedPointer<TextureTile> > tiles;
 
     foreach ( const GeoSceneTextureTile *layer, textureLayers ) {
@@ -311,21 +348,69 @@ StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId )
         mDebug() << Q_FUNC_INFO << layer->sourceDir() << tileId << layer->tileSize() << layer->fileFormat();
 
         // Blending (how to merge the images into an only image)
-        const Blending *blending = d->m_blendingFactory.findBlending( layer->blending() );
+        const Blending *blending = m_blendingFactory.findBlending( layer->blending() );
         if ( blending == 0 && !layer->blending().isEmpty() ) {
             mDebug() << Q_FUNC_INFO << "could not find blending" << layer->blending();
         }
 
         const GeoSceneTextureTile *const textureLayer = static_cast<const GeoSceneTextureTile *>( layer );
-        const QImage tileImage = d->m_tileLoader->loadTileImage( textureLayer, tileId, DownloadBrowse );
+        const QImage tileImage = m_tileLoader->loadTileImage( textureLayer, tileId, usage );
 
         QSharedPointer<TextureTile> tile( new TextureTile( tileId, tileImage, blending ) );
         tiles.append( tile );
     }
 
-    Q_ASSERT( !tiles.isEmpty() );
+    return tiles;
+}
 
-    return d->createTile( tiles );
+bool MergedLayerDecorator::Private::decodedTileCacheKey( const TileId &stackedTileId, QString &key ) const
+{
+    // ground overlays can change at any time
+    if ( !m_decodedTileCache.isEnabled() || !m_groundOverlays.isEmpty() ) {
+        return false;
+    }
+
+    // the full description is the key, as a hash of it could collide
+    QString description = QString( "%1 %2 %3" ).arg( m_showSunShading ).arg( m_showCityLights ).arg( m_showTileId );
+    if ( m_sunLocator && ( m_showSunShading || m_showCityLights ) ) {
+        description += QString( " %1 %2" ).arg( m_sunLocator->getLon(), 0, 'g', 17 ).arg( m_sunLocator->getLat(), 0, 'g', 17 );
+    }
+
+    foreach ( const GeoSceneTextureTile *layer, findRelevantTextureLayers( stackedTileId ) ) {
+        const TileId tileId( layer->sourceDir(), stackedTileId.zoomLevel(),
+                             stackedTileId.x(), stackedTileId.y() );
+
+        // don't cache scaled replacements for missing tiles, nor tiles to be updated
+        if ( TileLoader::tileStatus( layer, tileId ) != TileLoader::Available ) {
+            return false;
+        }
+
+        description += ' ' + layer->sourceDir() + ' ' + layer->blending();
+    }
+
+    key = description;
+
+    return true;
+}
+
+void MergedLayerDecorator::setDecodedTileCacheLimit( quint64 kiloBytes )
+{
+    d->m_decodedTileCache.setMaximumSize( kiloBytes * 1024 );
+}
+
+quint64 MergedLayerDecorator::decodedTileCacheLimit() const
+{
+    return d->m_decodedTileCache.maximumSize() / 1024;
+}
+
+void MergedLayerDecorator::setCacheStatistics( CacheStatistics *statistics )
+{
+    d->m_decodedTileCache.setCacheStatistics( statistics );
+}
+
+void MergedLayerDecorator::removeDecodedTile( const TileId &stackedTileId )
+{
+    d->m_decodedTileCache.remove( stackedTileId );
 }
 
 RenderState MergedLayerDecorator::renderState( const TileId &stackedTileId ) const
@@ -364,6 +449,10 @@ StackedTile *MergedLayerDecorator::updateTile( const StackedTile &stackedTile, c
     d->detectMaxTileLevel();
 
     QVector<QSharedPointer<TextureTile> > tiles = stackedTile.tiles();
+    if ( tiles.isEmpty() ) {
+        // the stacked tile was restored from the decoded tile cache
+        tiles = d->loadTextureTiles( stackedTile.id(), DownloadBrowse );
+    }
 
     for ( int i = 0; i < tiles.count(); ++ i) {
         if ( tiles[i]->id() == tileId ) {
@@ -387,6 +476,21 @@ void MergedLayerDecorator::downloadStackedTile( const TileId &id, DownloadUsage
     }
 }
 
+bool MergedLayerDecorator::prefetchStackedTile( const TileId &id )
+{
+    const QVector<const GeoSceneTextureTile *> textureLayers = d->findRelevantTextureLayers( id );
+
+    bool available = true;
+    foreach ( const GeoSceneTextureTile *textureLayer, textureLayers ) {
+        if ( TileLoader::tileStatus( textureLayer, id ) != TileLoader::Available ) {
+            d->m_tileLoader->queuePrefetch( textureLayer, id );
+            available = false;
+        }
+    }
+
+    return available;
+}
+
 void MergedLayerDecorator::setShowSunShading( bool show )
 {
     d->m_showSunShading = show;
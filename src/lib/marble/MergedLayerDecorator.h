@@ -29,6 +29,7 @@ class QString;
 namespace Marble
 {
 
+class CacheStatistics;
 class GeoDataGroundOverlay;
 class SunLocator;
 class StackedTile;
@@ -65,8 +66,31 @@ class MergedLayerDecorator
 
     StackedTile *updateTile( const StackedTile &stackedTile, const TileId &tileId, const QImage &tileImage );
 
+    /**
+     * Sets the size of the cache for blended tiles in a memory-mapped file.
+     * Stacked tiles found in this cache don't need to be decoded and blended
+     * again. A size of 0 disables the cache, which is the default.
+     */
+    void setDecodedTileCacheLimit( quint64 kiloBytes );
+    quint64 decodedTileCacheLimit() const;
+
+    void setCacheStatistics( CacheStatistics *statistics );
+
+    /**
+     * Removes the given stacked tile from the decoded tile cache, e.g. because
+     * one of its texture tiles was downloaded again.
+     */
+    void removeDecodedTile( const TileId &stackedTileId );
+
     void downloadStackedTile( const TileId &id, DownloadUsage usage );
 
+    /**
+     * Queues low priority downloads of the texture tiles of the given stacked
+     * tile which are missing or expired. Returns true if all of them are
+     * available on disk, so the stacked tile can be loaded without downloads.
+     */
+    bool prefetchStackedTile( const TileId &id );
+
     void setShowSunShading( bool show );
     bool showSunShading() const;
 
@@ -9,6 +9,10 @@
 
 #include "ParsingRunner.h"
 
+#include <QDir>
+#include <QFileInfo>
+#include <QTemporaryFile>
+
 namespace Marble
 {
 
@@ -18,6 +22,19 @@ ParsingRunner::ParsingRunner( QObject *parent )
     // nothing to do
 }
 
+void ParsingRunner::parseData( const QByteArray &data, const QString &fileName, DocumentRole role )
+{
+    // keep the suffix, some runners look at it
+    QTemporaryFile file( QDir::tempPath() + "/marble-XXXXXX." + QFileInfo( fileName ).suffix() );
+    if ( !file.open() || file.write( data ) != data.size() ) {
+        emit parsingFinished( 0, tr( "Could not write temporary file %1" ).arg( file.fileName() ) );
+        return;
+    }
+    file.close();
+
+    parseFile( file.fileName(), role );
+}
+
 }
 
 #include "ParsingRunner.moc"
@@ -35,6 +35,15 @@ public:
       */
     virtual void parseFile( const QString &fileName, DocumentRole role ) = 0;
 
+    /**
+      * Parse @p data, the contents of a file called @p fileName which need not
+      * exist. The result is returned via the parsingFinished signal like for
+      * parseFile(). The default implementation writes the data to a temporary
+      * file and parses that one, runners reading from a QIODevice should
+      * reimplement it.
+      */
+    virtual void parseData( const QByteArray &data, const QString &fileName, DocumentRole role );
+
 Q_SIGNALS:
     /**
      * File parsing is finished, result in the given document object.
@@ -17,6 +17,7 @@
 #include "GeoDataPlacemark.h"
 #include "PluginManager.h"
 #include "ParseRunnerPlugin.h"
+#include "ParsingRunner.h"
 #include "RunnerTask.h"
 
 #include <QFileInfo>
@@ -29,6 +30,33 @@ namespace Marble
 
 class MarbleModel;
 
+/**
+ * Receives the result of a runner which parses on the calling thread
+ */
+class ParsingResult : public QObject
+{
+    Q_OBJECT
+
+public:
+    ParsingResult() : m_document( 0 ) {}
+
+    GeoDataDocument *m_document;
+    QString m_error;
+
+public Q_SLOTS:
+    void setResult( GeoDataDocument *document, const QString &error )
+    {
+        // a runner which reports more than once must not leak the first result
+        if ( document && m_document ) {
+            delete m_document;
+        }
+        if ( document ) {
+            m_document = document;
+        }
+        m_error = error;
+    }
+};
+
 class ParsingRunnerManager::Private
 {
 public:
@@ -36,6 +64,9 @@ public:
 
     ~Private();
 
+    QList<const ParseRunnerPlugin*> plugins( const QString &fileName ) const;
+    GeoDataDocument *read( const QString &fileName, const QByteArray *data, DocumentRole role, QString *error ) const;
+
     void addParsingResult( GeoDataDocument *document, const QString &error = QString() );
     void cleanupParsingTask( ParsingTask *task );
 
@@ -58,6 +89,54 @@ ParsingRunnerManager::Private::~Private()
     // nothing to do
 }
 
+QList<const ParseRunnerPlugin*> ParsingRunnerManager::Private::plugins( const QString &fileName ) const
+{
+    const QFileInfo fileInfo( fileName );
+    const QString suffix = fileInfo.suffix().toLower();
+    const QString completeSuffix = fileInfo.completeSuffix().toLower();
+
+    // runners for the format first, those for any format last
+    QList<const ParseRunnerPlugin*> result;
+    QList<const ParseRunnerPlugin*> fallbacks;
+    foreach( const ParseRunnerPlugin *plugin, m_pluginManager->parsingRunnerPlugins() ) {
+        QStringList const extensions = plugin->fileExtensions();
+        if ( extensions.isEmpty() ) {
+            fallbacks << plugin;
+        } else if ( extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
+            result << plugin;
+        }
+    }
+
+    return result + fallbacks;
+}
+
+GeoDataDocument *ParsingRunnerManager::Private::read( const QString &fileName, const QByteArray *data,
+                                                      DocumentRole role, QString *error ) const
+{
+    foreach( const ParseRunnerPlugin *plugin, plugins( fileName ) ) {
+        ParsingRunner *const runner = plugin->newRunner();
+        ParsingResult result;
+        QObject::connect( runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)),
+                          &result, SLOT(setResult(GeoDataDocument*,QString)), Qt::DirectConnection );
+
+        if ( data ) {
+            runner->parseData( *data, fileName, role );
+        } else {
+            runner->parseFile( fileName, role );
+        }
+        delete runner;
+
+        if ( result.m_document ) {
+            return result.m_document;
+        }
+        if ( error && !result.m_error.isEmpty() ) {
+            *error = result.m_error;
+        }
+    }
+
+    return 0;
+}
+
 void ParsingRunnerManager::Private::addParsingResult( GeoDataDocument *document, const QString &error )
 {
     if ( document || !error.isEmpty() ) {
@@ -94,19 +173,11 @@ ParsingRunnerManager::~ParsingRunnerManager()
 
 void ParsingRunnerManager::parseFile( const QString &fileName, DocumentRole role )
 {
-    QList<const ParseRunnerPlugin*> plugins = d->m_pluginManager->parsingRunnerPlugins();
-    const QFileInfo fileInfo( fileName );
-    const QString suffix = fileInfo.suffix().toLower();
-    const QString completeSuffix = fileInfo.completeSuffix().toLower();
-
-    foreach( const ParseRunnerPlugin *plugin, plugins ) {
-        QStringList const extensions = plugin->fileExtensions();
-        if ( extensions.isEmpty() || extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
-            ParsingTask *task = new ParsingTask( plugin->newRunner(), this, fileName, role );
-            connect( task, SIGNAL(finished(ParsingTask*)), this, SLOT(cleanupParsingTask(ParsingTask*)) );
-            mDebug() << "parse task " << plugin->nameId() << " " << (quintptr)task;
-            d->m_parsingTasks << task;
-        }
+    foreach( const ParseRunnerPlugin *plugin, d->plugins( fileName ) ) {
+        ParsingTask *task = new ParsingTask( plugin->newRunner(), this, fileName, role );
+        connect( task, SIGNAL(finished(ParsingTask*)), this, SLOT(cleanupParsingTask(ParsingTask*)) );
+        mDebug() << "parse task " << plugin->nameId() << " " << (quintptr)task;
+        d->m_parsingTasks << task;
     }
 
     foreach ( ParsingTask *task, d->m_parsingTasks ) {
@@ -133,6 +204,17 @@ GeoDataDocument *ParsingRunnerManager::openFile( const QString &fileName, Docume
     return d->m_fileResult;
 }
 
+GeoDataDocument *ParsingRunnerManager::readFile( const QString &fileName, DocumentRole role, QString *error ) const
+{
+    return d->read( fileName, 0, role, error );
+}
+
+GeoDataDocument *ParsingRunnerManager::readData( const QByteArray &data, const QString &fileName,
+                                                 DocumentRole role, QString *error ) const
+{
+    return d->read( fileName, &data, role, error );
+}
+
 }
 
 #include "ParsingRunnerManager.moc"
@@ -52,6 +52,24 @@ public:
     void parseFile( const QString &fileName, DocumentRole role = UserDocument );
     GeoDataDocument *openFile( const QString &fileName, DocumentRole role = UserDocument, int timeout = 30000 );
 
+    /**
+     * Parse the file on the calling thread and return the document, or 0 if
+     * none of the runners for its format could parse it. The runners are
+     * tried one after another until one succeeds. Neither an event loop nor
+     * another thread is involved, and no signals are emitted, so worker
+     * threads can share a manager once the plugins have been loaded.
+     * The caller takes ownership of the document.
+     * @param error set to the error message of the last runner that failed
+     */
+    GeoDataDocument *readFile( const QString &fileName, DocumentRole role = UserDocument, QString *error = 0 ) const;
+
+    /**
+     * Like readFile(), but parse @p data, the contents of a file called
+     * @p fileName, which is used to pick the runners and need not exist.
+     */
+    GeoDataDocument *readData( const QByteArray &data, const QString &fileName,
+                               DocumentRole role = UserDocument, QString *error = 0 ) const;
+
 Q_SIGNALS:
     /**
      * The file was parsed and potential error message
@@ -0,0 +1,309 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "PlacemarkCacheFile.h"
+
+#include <QHash>
+#include <QtEndian>
+
+#include <cstring>
+
+#include "GeoDataData.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDebug.h"
+
+namespace Marble
+{
+
+const quint32 PlacemarkCacheFile::magicNumber;
+const quint32 PlacemarkCacheFile::version;
+
+namespace
+{
+
+// magic number, version, record count, string count and the offsets of the
+// records, the string index and the string data
+const int headerSize = 28;
+
+// longitude, latitude, altitude and area as doubles, the population as
+// qint64, the string indexes of name, role, description, country code and
+// state, the gmt offset as qint16, the dst offset as qint8 and a padding byte
+const int recordSize = 64;
+
+template<typename T>
+inline T read( const uchar *data )
+{
+    return qFromLittleEndian<T>( data );
+}
+
+inline double readDouble( const uchar *data )
+{
+    const quint64 bits = qFromLittleEndian<quint64>( data );
+    double result;
+    std::memcpy( &result, &bits, sizeof( result ) );
+    return result;
+}
+
+template<typename T>
+inline void append( QByteArray &out, T value )
+{
+    uchar buffer[sizeof( T )];
+    qToLittleEndian<T>( value, buffer );
+    out.append( reinterpret_cast<const char*>( buffer ), sizeof( T ) );
+}
+
+inline void appendDouble( QByteArray &out, double value )
+{
+    quint64 bits;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    append<quint64>( out, bits );
+}
+
+}
+
+PlacemarkCacheFile::PlacemarkCacheFile( const QString &fileName )
+    : m_file( fileName ),
+      m_data( 0 ),
+      m_size( 0 ),
+      m_recordCount( 0 ),
+      m_stringCount( 0 ),
+      m_records( 0 ),
+      m_stringIndex( 0 ),
+      m_stringData( 0 )
+{
+    if ( !open() ) {
+        mDebug() << "Could not open placemark cache" << fileName << m_errorString;
+    }
+}
+
+PlacemarkCacheFile::~PlacemarkCacheFile()
+{
+    if ( m_data ) {
+        m_file.unmap( const_cast<uchar*>( m_data ) );
+    }
+}
+
+bool PlacemarkCacheFile::open()
+{
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if ( m_size < headerSize ) {
+        m_errorString = "File too small";
+        return false;
+    }
+
+    uchar *const data = m_file.map( 0, m_size );
+    if ( !data ) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_data = data;
+
+    if ( read<quint32>( m_data ) != magicNumber ) {
+        m_errorString = "Not a placemark cache file";
+        return false;
+    }
+    if ( read<quint32>( m_data + 4 ) != version ) {
+        m_errorString = QString( "Unsupported version %1" ).arg( read<quint32>( m_data + 4 ) );
+        return false;
+    }
+
+    m_recordCount = read<quint32>( m_data + 8 );
+    m_stringCount = read<quint32>( m_data + 12 );
+    const qint64 recordsOffset = read<quint32>( m_data + 16 );
+    const qint64 stringIndexOffset = read<quint32>( m_data + 20 );
+    const qint64 stringDataOffset = read<quint32>( m_data + 24 );
+
+    // make sure that no table reaches beyond the end of the file
+    if ( m_stringCount == 0
+         || recordsOffset + qint64( m_recordCount ) * recordSize > m_size
+         || stringIndexOffset + ( qint64( m_stringCount ) + 1 ) * 4 > m_size
+         || stringDataOffset > m_size ) {
+        m_errorString = "Corrupt header";
+        return false;
+    }
+
+    m_stringIndex = m_data + stringIndexOffset;
+    const qint64 stringDataSize = 2 * qint64( read<quint32>( m_stringIndex + 4 * m_stringCount ) );
+    if ( stringDataOffset + stringDataSize > m_size ) {
+        m_errorString = "Corrupt string table";
+        return false;
+    }
+
+    m_stringData = m_data + stringDataOffset;
+    m_strings.resize( m_stringCount );
+    m_records = m_data + recordsOffset;
+
+    return true;
+}
+
+bool PlacemarkCacheFile::isOpen() const
+{
+    return m_records != 0;
+}
+
+QString PlacemarkCacheFile::errorString() const
+{
+    return m_errorString;
+}
+
+bool PlacemarkCacheFile::isCacheFile( const QString &fileName )
+{
+    QFile file( fileName );
+    uchar magic[4];
+    return file.open( QIODevice::ReadOnly )
+        && file.read( reinterpret_cast<char*>( magic ), 4 ) == 4
+        && read<quint32>( magic ) == magicNumber;
+}
+
+int PlacemarkCacheFile::size() const
+{
+    return isOpen() ? int( m_recordCount ) : 0;
+}
+
+QString PlacemarkCacheFile::string( quint32 index ) const
+{
+    if ( index >= m_stringCount ) {
+        return QString();
+    }
+
+    if ( m_strings.at( index ).isNull() ) {
+        const quint32 begin = read<quint32>( m_stringIndex + 4 * index );
+        const quint32 end = read<quint32>( m_stringIndex + 4 * ( index + 1 ) );
+        const quint32 last = read<quint32>( m_stringIndex + 4 * m_stringCount );
+        if ( begin >= end || end > last ) {
+            return QString();
+        }
+
+        QString result( end - begin, Qt::Uninitialized );
+        const uchar *source = m_stringData + 2 * begin;
+        QChar *target = result.data();
+        for ( quint32 i = begin; i < end; ++i, source += 2 ) {
+            *target++ = QChar( read<quint16>( source ) );
+        }
+        m_strings[index] = result;
+    }
+
+    return m_strings.at( index );
+}
+
+GeoDataPlacemark *PlacemarkCacheFile::placemark( int index ) const
+{
+    if ( index < 0 || index >= size() ) {
+        return 0;
+    }
+
+    const uchar *const record = m_records + qint64( index ) * recordSize;
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setName( string( read<quint32>( record + 40 ) ) );
+    placemark->setCoordinate( readDouble( record ), readDouble( record + 8 ), readDouble( record + 16 ) );
+    placemark->setRole( string( read<quint32>( record + 44 ) ) );
+    placemark->setDescription( string( read<quint32>( record + 48 ) ) );
+    placemark->setCountryCode( string( read<quint32>( record + 52 ) ) );
+    placemark->setState( string( read<quint32>( record + 56 ) ) );
+    placemark->setArea( readDouble( record + 24 ) );
+    placemark->setPopulation( read<qint64>( record + 32 ) );
+    placemark->extendedData().addValue( GeoDataData( "gmt", int( read<qint16>( record + 60 ) ) ) );
+    placemark->extendedData().addValue( GeoDataData( "dst", int( qint8( record[62] ) ) ) );
+
+    return placemark;
+}
+
+bool PlacemarkCacheFile::write( const QString &fileName, const QVector<const GeoDataPlacemark*> &placemarks,
+                                QString *errorString )
+{
+    // string 0 is the empty string
+    QHash<QString, quint32> stringIds;
+    QVector<QString> strings;
+    strings << QString();
+
+    QByteArray records;
+    records.reserve( placemarks.size() * recordSize );
+
+    foreach ( const GeoDataPlacemark *placemark, placemarks ) {
+        const QString values[] = { placemark->name(), placemark->role(), placemark->description(),
+                                   placemark->countryCode(), placemark->state() };
+        quint32 ids[5];
+        for ( int j = 0; j < 5; ++j ) {
+            if ( values[j].isEmpty() ) {
+                ids[j] = 0;
+            } else {
+                QHash<QString, quint32>::const_iterator it = stringIds.constFind( values[j] );
+                if ( it == stringIds.constEnd() ) {
+                    it = stringIds.insert( values[j], strings.size() );
+                    strings << values[j];
+                }
+                ids[j] = it.value();
+            }
+        }
+
+        qreal lon, lat, alt;
+        placemark->coordinate().geoCoordinates( lon, lat, alt );
+        appendDouble( records, lon );
+        appendDouble( records, lat );
+        appendDouble( records, alt );
+        appendDouble( records, placemark->area() );
+        append<qint64>( records, placemark->population() );
+        for ( int j = 0; j < 5; ++j ) {
+            append<quint32>( records, ids[j] );
+        }
+        append<qint16>( records, placemark->extendedData().value( "gmt" ).value().toInt() );
+        records.append( char( qint8( placemark->extendedData().value( "dst" ).value().toInt() ) ) );
+        records.append( char( 0 ) );
+    }
+
+    QByteArray stringIndex;
+    QByteArray stringData;
+    quint32 offset = 0;
+    append<quint32>( stringIndex, offset );
+    foreach ( const QString &string, strings ) {
+        for ( int i = 0; i < string.size(); ++i ) {
+            append<quint16>( stringData, string.at( i ).unicode() );
+        }
+        offset += string.size();
+        append<quint32>( stringIndex, offset );
+    }
+
+    const quint32 recordsOffset = headerSize;
+    const quint32 stringIndexOffset = recordsOffset + records.size();
+    const quint32 stringDataOffset = stringIndexOffset + stringIndex.size();
+
+    QByteArray header;
+    append<quint32>( header, magicNumber );
+    append<quint32>( header, version );
+    append<quint32>( header, placemarks.size() );
+    append<quint32>( header, strings.size() );
+    append<quint32>( header, recordsOffset );
+    append<quint32>( header, stringIndexOffset );
+    append<quint32>( header, stringDataOffset );
+    Q_ASSERT( header.size() == headerSize );
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate )
+         || file.write( header ) != header.size()
+         || file.write( records ) != records.size()
+         || file.write( stringIndex ) != stringIndex.size()
+         || file.write( stringData ) != stringData.size() ) {
+        if ( errorString ) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+
+    return true;
+}
+
+}
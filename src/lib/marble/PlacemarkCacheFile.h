@@ -0,0 +1,103 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_PLACEMARKCACHEFILE_H
+#define MARBLE_PLACEMARKCACHEFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataPlacemark;
+
+/**
+ * @short Placemark cache file which is read through a memory mapping
+ *
+ * The format replaces the QDataStream based .cache files, which have to be
+ * read field by field. A file consists of
+ *
+ * @li a header with a magic number, the version and the offsets of the tables,
+ * @li fixed-width records, one per placemark, which refer to the string table,
+ * @li a string table, which stores every distinct string once in UTF-16.
+ *
+ * All numbers are stored in little endian byte order. Opening a file only
+ * maps it and checks the header. Placemarks are created on request, and a
+ * string is decoded once when it is needed first and then shared by all
+ * placemarks referring to it.
+ *
+ * There is no spatial index. The cache runner creates all placemarks of a
+ * file at once, because documents, the tree model and the placemark layout
+ * only work on GeoDataPlacemark objects.
+ *
+ * A file must not be used by several threads at once.
+ */
+class MARBLE_EXPORT PlacemarkCacheFile
+{
+ public:
+    static const quint32 magicNumber = 0x4350424d; // "MBPC"
+    static const quint32 version = 2;
+
+    explicit PlacemarkCacheFile( const QString &fileName );
+    ~PlacemarkCacheFile();
+
+    bool isOpen() const;
+
+    QString errorString() const;
+
+    /**
+     * Returns whether @p fileName starts with the magic number of this
+     * format, i.e. is not a file of the old format.
+     */
+    static bool isCacheFile( const QString &fileName );
+
+    /** Returns the number of placemarks */
+    int size() const;
+
+    /**
+     * Creates the placemark stored in record @p index. The caller takes
+     * ownership.
+     */
+    GeoDataPlacemark *placemark( int index ) const;
+
+    /**
+     * Writes @p placemarks to the cache file @p fileName.
+     */
+    static bool write( const QString &fileName, const QVector<const GeoDataPlacemark*> &placemarks,
+                       QString *errorString = 0 );
+
+ private:
+    Q_DISABLE_COPY( PlacemarkCacheFile )
+
+    bool open();
+    QString string( quint32 index ) const;
+
+    QFile m_file;
+    QString m_errorString;
+    const uchar *m_data;
+    qint64 m_size;
+
+    quint32 m_recordCount;
+    quint32 m_stringCount;
+    const uchar *m_records;
+    const uchar *m_stringIndex;
+    const uchar *m_stringData;
+
+    // the strings decoded so far, null if not decoded yet
+    mutable QVector<QString> m_strings;
+};
+
+}
+
+#endif
@@ -41,6 +41,10 @@
 namespace Marble
 {
 
+// The width of a cell of the label grid. The cells are as high as the
+// highest label, so most labels overlap two to four cells.
+static const int labelGridCellWidth = 64;
+
 QVector<GeoDataFeature::GeoDataVisualCategory> sortedVisualCategories()
 {
     QVector<GeoDataFeature::GeoDataVisualCategory> visualCategories;
@@ -140,6 +144,8 @@ PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
     : QObject( parent ),
       m_selectionModel( selectionModel ),
       m_clock( clock ),
+      m_labelGridColumns( 0 ),
+      m_labelGridRows( 0 ),
       m_acceptedVisualCategories( sortedVisualCategories() ),
       m_showPlaces( false ),
       m_showCities( false ),
@@ -312,7 +318,9 @@ void PlacemarkLayout::resetCacheData()
 
     m_placemarkCache.clear();
     requestStyleReset();
-    addPlacemarks( m_placemarkModel.index( 0, 0 ), 0, rowCount );
+    if ( rowCount > 0 ) {
+        addPlacemarks( QModelIndex(), 0, rowCount - 1 );
+    }
     emit repaintNeeded();
 }
 
@@ -382,9 +390,10 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
         return QVector<VisiblePlacemark *>();
     }
 
-    const int secnumber = viewport->height() / m_maxLabelHeight + 1;
-    m_rowsection.clear();
-    m_rowsection.resize(secnumber);
+    m_labelGridColumns = viewport->width() / labelGridCellWidth + 1;
+    m_labelGridRows = viewport->height() / m_maxLabelHeight + 1;
+    m_labelGrid.clear();
+    m_labelGrid.resize( m_labelGridColumns * m_labelGridRows );
 
     m_paintOrder.clear();
     m_labelArea = 0;
@@ -393,10 +402,18 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
     const QModelIndexList selectedIndexes = m_selectionModel->selection().indexes();
 
+    // Other placemarks are looked up in here, so it needs to be complete
+    // before the selected placemarks get laid out
+    QSet<const GeoDataPlacemark*> selectedPlacemarks;
+    foreach ( const QModelIndex &index, selectedIndexes ) {
+        const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
+        Q_ASSERT(placemark);
+        selectedPlacemarks.insert( placemark );
+    }
+
     for ( int i = 0; i < selectedIndexes.count(); ++i ) {
         const QModelIndex index = selectedIndexes.at( i );
         const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
-        Q_ASSERT(placemark);
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
 
         if ( !coordinates.isValid() ) {
@@ -424,8 +441,6 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
     // Now handle all other placemarks...
 
-    const QItemSelection selection = m_selectionModel->selection();
-
     QList<TileId> tileIdList = visibleTiles( viewport ).toList();
     qSort( tileIdList );
     QList<const GeoDataPlacemark*> placemarkList;
@@ -499,20 +514,10 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
             continue;
 
         // We handled selected placemarks already, so we skip them here...
-        // Assuming that only a small amount of places is selected
-        // we check for the selected state after all other filters
-        bool isSelected = false;
-        foreach ( const QModelIndex &index, selection.indexes() ) {
-            const GeoDataPlacemark *mark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
-            if (mark == placemark ) {
-                isSelected = true;
-                break;
-            }
-        }
-        if ( isSelected )
+        if ( selectedPlacemarks.contains( placemark ) )
             continue;
 
-        if( layoutPlacemark( placemark, x, y, isSelected ) ) {
+        if( layoutPlacemark( placemark, x, y, false ) ) {
             // Make sure not to draw more placemarks on the screen than
             // specified by placemarksOnScreenLimit().
             if ( placemarksOnScreenLimit( viewport->size() ) )
@@ -566,14 +571,7 @@ bool PlacemarkLayout::layoutPlacemark( const GeoDataPlacemark *placemark, qreal
     mark->setLabelRect( labelRect );
 
     if ( !labelRect.isEmpty() ) {
-        // Add the current placemark to the matching row and its
-        // direct neighbors.
-        int idx = y / m_maxLabelHeight;
-        if ( idx - 1 >= 0 )
-            m_rowsection[ idx - 1 ].append( mark );
-        m_rowsection[ idx ].append( mark );
-        if ( idx + 1 < m_rowsection.size() )
-            m_rowsection[ idx + 1 ].append( mark );
+        addLabelRect( labelRect );
     }
 
     m_paintOrder.append( mark );
@@ -613,8 +611,6 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
         textWidth = ( QFontMetrics( labelFont ).width( labelText ) );
     }
 
-    const QVector<VisiblePlacemark*> currentsec = m_rowsection.at( y / m_maxLabelHeight );
-
     if ( style->labelStyle().alignment() == GeoDataLabelStyle::Corner ) {
         const int symbolWidth = style->iconStyle().icon().width();
 
@@ -627,40 +623,18 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
             const QRectF labelRect = QRectF( xPos, yPos, textWidth, textHeight );
 
             // Check if there is another label or symbol that overlaps.
-            bool isRoom = true;
-            QVector<VisiblePlacemark*>::const_iterator beforeItEnd = currentsec.constEnd();
-            for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = currentsec.constBegin();
-                  beforeIt != beforeItEnd;
-                  ++beforeIt ) {
-                if ( labelRect.intersects( (*beforeIt)->labelRect()) ) {
-                    isRoom = false;
-                    break;
-                }
-            }
-
-            if ( isRoom ) {
+            if ( isRoomFor( labelRect ) ) {
                 // claim the place immediately if it hasn't been used yet
                 return labelRect;
             }
         }
     }
     else if ( style->labelStyle().alignment() == GeoDataLabelStyle::Center ) {
-        bool isRoom = true;
         QRectF  labelRect( x - textWidth / 2, y - textHeight / 2,
                           textWidth, textHeight );
 
         // Check if there is another label or symbol that overlaps.
-        QVector<VisiblePlacemark*>::const_iterator beforeItEnd = currentsec.constEnd();
-        for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = currentsec.constBegin();
-              beforeIt != beforeItEnd; ++beforeIt )
-        {
-            if ( labelRect.intersects( (*beforeIt)->labelRect() ) ) {
-                isRoom = false;
-                break;
-            }
-        }
-
-        if ( isRoom ) {
+        if ( isRoomFor( labelRect ) ) {
             // claim the place immediately if it hasn't been used yet 
             return labelRect;
         }
@@ -670,6 +644,46 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
                      // for the rectangle anymore.
 }
 
+QRect PlacemarkLayout::labelGridCells( const QRectF &labelRect ) const
+{
+    // Labels may stick out of the screen, their parts outside belong to the
+    // cells at the border. Overlapping labels still share a cell then.
+    const int left = qBound( 0, qFloor( labelRect.left() / labelGridCellWidth ), m_labelGridColumns - 1 );
+    const int right = qBound( 0, qFloor( labelRect.right() / labelGridCellWidth ), m_labelGridColumns - 1 );
+    const int top = qBound( 0, qFloor( labelRect.top() / m_maxLabelHeight ), m_labelGridRows - 1 );
+    const int bottom = qBound( 0, qFloor( labelRect.bottom() / m_maxLabelHeight ), m_labelGridRows - 1 );
+
+    return QRect( QPoint( left, top ), QPoint( right, bottom ) );
+}
+
+bool PlacemarkLayout::isRoomFor( const QRectF &labelRect ) const
+{
+    const QRect cells = labelGridCells( labelRect );
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            const QVector<QRectF> &cell = m_labelGrid.at( row * m_labelGridColumns + column );
+            QVector<QRectF>::const_iterator const end = cell.constEnd();
+            for ( QVector<QRectF>::const_iterator it = cell.constBegin(); it != end; ++it ) {
+                if ( labelRect.intersects( *it ) ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void PlacemarkLayout::addLabelRect( const QRectF &labelRect )
+{
+    const QRect cells = labelGridCells( labelRect );
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            m_labelGrid[row * m_labelGridColumns + column].append( labelRect );
+        }
+    }
+}
+
 bool PlacemarkLayout::placemarksOnScreenLimit( const QSize &screenSize ) const
 {
     int ratio = ( m_labelArea * 100 ) / ( screenSize.width() * screenSize.height() );
@@ -26,6 +26,7 @@
 #include <QSortFilterProxyModel>
 
 #include "GeoDataFeature.h"
+#include "marble_export.h"
 
 class QAbstractItemModel;
 class QItemSelectionModel;
@@ -51,7 +52,7 @@ class ViewportParams;
 
 
 
-class PlacemarkLayout : public QObject
+class MARBLE_EXPORT PlacemarkLayout : public QObject
 {
     Q_OBJECT
 
@@ -127,6 +128,13 @@ class PlacemarkLayout : public QObject
                          const qreal x, const qreal y,
                          const QString &labelText ) const;
 
+    /**
+     * Returns whether @p labelRect does not overlap any label laid out so far.
+     */
+    bool    isRoomFor( const QRectF &labelRect ) const;
+    void    addLabelRect( const QRectF &labelRect );
+    QRect   labelGridCells( const QRectF &labelRect ) const;
+
     bool    placemarksOnScreenLimit( const QSize &screenSize ) const;
 
  private:
@@ -139,7 +147,15 @@ class PlacemarkLayout : public QObject
     QString m_runtimeTrace;
     int m_labelArea;
     QHash<const GeoDataPlacemark*, VisiblePlacemark*> m_visiblePlacemarks;
-    QVector< QVector< VisiblePlacemark* > >  m_rowsection;
+
+    /**
+     * The labels laid out so far, binned into the cells of a uniform grid
+     * over the screen they overlap. New labels only get checked against the
+     * labels in the cells they overlap themselves.
+     */
+    QVector< QVector<QRectF> > m_labelGrid;
+    int m_labelGridColumns;
+    int m_labelGridRows;
 
     /// map providing the list of placemark belonging in TileId as key
     QMap<TileId, QList<const GeoDataPlacemark*> > m_placemarkCache;
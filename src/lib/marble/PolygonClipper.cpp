@@ -0,0 +1,339 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "PolygonClipper.h"
+
+#include <algorithm>
+
+namespace Marble
+{
+
+namespace
+{
+
+enum OutCode {
+    OutLeft   = 1,
+    OutRight  = 2,
+    OutTop    = 4,
+    OutBottom = 8
+};
+
+}
+
+PolygonClipper::PolygonClipper() :
+    m_left( 0.0 ),
+    m_right( 0.0 ),
+    m_top( 0.0 ),
+    m_bottom( 0.0 ),
+    m_pieceData( 0 )
+{
+    // Reserving marks the capacity as reserved, so resizing the buffers to
+    // zero keeps their memory
+    m_buffers[0].reserve( 64 );
+    m_buffers[1].reserve( 64 );
+    m_pieceOffsets.reserve( 16 );
+}
+
+PolygonClipper::PolygonClipper( const QRectF &clipRect ) :
+    m_left( clipRect.left() ),
+    m_right( clipRect.right() ),
+    m_top( clipRect.top() ),
+    m_bottom( clipRect.bottom() ),
+    m_pieceData( 0 )
+{
+    m_buffers[0].reserve( 64 );
+    m_buffers[1].reserve( 64 );
+    m_pieceOffsets.reserve( 16 );
+}
+
+void PolygonClipper::setClipRect( const QRectF &clipRect )
+{
+    m_left   = clipRect.left();
+    m_right  = clipRect.right();
+    m_top    = clipRect.top();
+    m_bottom = clipRect.bottom();
+}
+
+QRectF PolygonClipper::clipRect() const
+{
+    return QRectF( QPointF( m_left, m_top ), QPointF( m_right, m_bottom ) );
+}
+
+template<int edge>
+bool PolygonClipper::isInside( const QPointF &point ) const
+{
+    switch ( edge ) {
+    case LeftEdge:
+        return point.x() >= m_left;
+    case RightEdge:
+        return point.x() <= m_right;
+    case TopEdge:
+        return point.y() >= m_top;
+    default:
+        return point.y() <= m_bottom;
+    }
+}
+
+template<int edge>
+QPointF PolygonClipper::intersection( const QPointF &reference, const QPointF &outside ) const
+{
+    // The points are on different sides of the edge, so the divisor is not
+    // zero. The intersection is put exactly onto the edge.
+    if ( edge == LeftEdge || edge == RightEdge ) {
+        const qreal x = edge == LeftEdge ? m_left : m_right;
+        const qreal t = ( x - reference.x() ) / ( outside.x() - reference.x() );
+        return QPointF( x, reference.y() + t * ( outside.y() - reference.y() ) );
+    }
+
+    const qreal y = edge == TopEdge ? m_top : m_bottom;
+    const qreal t = ( y - reference.y() ) / ( outside.y() - reference.y() );
+    return QPointF( reference.x() + t * ( outside.x() - reference.x() ), y );
+}
+
+template<int edge>
+void PolygonClipper::clipEdge( const QPolygonF &input, QPolygonF &output ) const
+{
+    output.resize( 0 );
+    if ( input.isEmpty() ) {
+        return;
+    }
+
+    // each edge of the input adds two nodes at most
+    output.reserve( 2 * input.size() );
+
+    const QPointF *current = input.constData();
+    const QPointF *const end = current + input.size();
+    const QPointF *previous = end - 1;
+    bool previousInside = isInside<edge>( *previous );
+
+    for ( ; current != end; previous = current, ++current ) {
+        const bool currentInside = isInside<edge>( *current );
+        if ( currentInside ) {
+            if ( !previousInside ) {
+                output << intersection<edge>( *current, *previous );
+            }
+            output << *current;
+        } else if ( previousInside ) {
+            output << intersection<edge>( *previous, *current );
+        }
+        previousInside = currentInside;
+    }
+}
+
+int PolygonClipper::outCode( const QPointF &point ) const
+{
+    int code = 0;
+    if ( point.x() < m_left ) {
+        code |= OutLeft;
+    } else if ( point.x() > m_right ) {
+        code |= OutRight;
+    }
+    if ( point.y() < m_top ) {
+        code |= OutTop;
+    } else if ( point.y() > m_bottom ) {
+        code |= OutBottom;
+    }
+
+    return code;
+}
+
+bool PolygonClipper::clipSegment( QPointF &start, QPointF &end ) const
+{
+    // Cohen-Sutherland: move the end points onto the edges they are outside of
+    // until both are inside or on the same outer side. Each step puts one
+    // coordinate onto an edge, so a few steps are enough even if rounding
+    // leaves a point slightly outside.
+    int startCode = outCode( start );
+    int endCode = outCode( end );
+    for ( int i = 0; i < 4 && ( startCode | endCode ) != 0; ++i ) {
+        if ( ( startCode & endCode ) != 0 ) {
+            return false;
+        }
+
+        if ( startCode != 0 ) {
+            start = intersection( startCode, end, start );
+            startCode = outCode( start );
+        } else {
+            end = intersection( endCode, start, end );
+            endCode = outCode( end );
+        }
+    }
+
+    return ( startCode & endCode ) == 0;
+}
+
+QPointF PolygonClipper::intersection( int code, const QPointF &reference, const QPointF &outside ) const
+{
+    if ( code & OutLeft ) {
+        return intersection<LeftEdge>( reference, outside );
+    }
+    if ( code & OutRight ) {
+        return intersection<RightEdge>( reference, outside );
+    }
+    if ( code & OutTop ) {
+        return intersection<TopEdge>( reference, outside );
+    }
+
+    return intersection<BottomEdge>( reference, outside );
+}
+
+const QPolygonF &PolygonClipper::clipPolygon( const QPolygonF &polygon )
+{
+    if ( polygon.isEmpty() ) {
+        return polygon;
+    }
+
+    const QRectF bounds = polygon.boundingRect();
+    if ( bounds.left() > m_right || bounds.right() < m_left
+         || bounds.top() > m_bottom || bounds.bottom() < m_top ) {
+        m_buffers[0].resize( 0 );
+        return m_buffers[0];
+    }
+
+    // only clip against the edges the polygon actually crosses
+    const QPolygonF *input = &polygon;
+    int next = 0;
+    if ( bounds.left() < m_left ) {
+        clipEdge<LeftEdge>( *input, m_buffers[next] );
+        input = &m_buffers[next];
+        next = 1 - next;
+    }
+    if ( bounds.right() > m_right ) {
+        clipEdge<RightEdge>( *input, m_buffers[next] );
+        input = &m_buffers[next];
+        next = 1 - next;
+    }
+    if ( bounds.top() < m_top ) {
+        clipEdge<TopEdge>( *input, m_buffers[next] );
+        input = &m_buffers[next];
+        next = 1 - next;
+    }
+    if ( bounds.bottom() > m_bottom ) {
+        clipEdge<BottomEdge>( *input, m_buffers[next] );
+        input = &m_buffers[next];
+    }
+
+    return *input;
+}
+
+void PolygonClipper::clipPolygon( const QPolygonF &polygon, QVector<QPolygonF> &clippedPolygons )
+{
+    const QPolygonF &clipped = clipPolygon( polygon );
+    if ( clipped.size() < 3 ) {
+        return;
+    }
+
+    if ( &clipped == &polygon ) {
+        clippedPolygons << polygon;
+    } else {
+        clippedPolygons << copy( clipped.constData(), clipped.size() );
+    }
+}
+
+int PolygonClipper::clipPolyline( const QPolygonF &polyline )
+{
+    m_pieceOffsets.resize( 0 );
+    m_pieceData = 0;
+
+    if ( polyline.isEmpty() ) {
+        return 0;
+    }
+
+    const QRectF bounds = polyline.boundingRect();
+    if ( bounds.left() > m_right || bounds.right() < m_left
+         || bounds.top() > m_bottom || bounds.bottom() < m_top ) {
+        return 0;
+    }
+
+    if ( bounds.left() >= m_left && bounds.right() <= m_right
+         && bounds.top() >= m_top && bounds.bottom() <= m_bottom ) {
+        m_pieceData = polyline.constData();
+        m_pieceOffsets << 0 << polyline.size();
+        return 1;
+    }
+
+    QPolygonF &points = m_buffers[0];
+    points.resize( 0 );
+    // each segment adds two nodes at most
+    points.reserve( 2 * polyline.size() );
+
+    const QPointF *const nodes = polyline.constData();
+    int previousCode = outCode( nodes[0] );
+    if ( previousCode == 0 ) {
+        m_pieceOffsets << 0;
+        points << nodes[0];
+    }
+
+    for ( int i = 1; i < polyline.size(); ++i ) {
+        const int code = outCode( nodes[i] );
+        if ( ( code | previousCode ) == 0 ) {
+            points << nodes[i];
+        } else if ( ( code & previousCode ) == 0 ) {
+            // the segment may cross the rectangle
+            QPointF start = nodes[i - 1];
+            QPointF end = nodes[i];
+            if ( clipSegment( start, end ) ) {
+                if ( previousCode != 0 ) {
+                    m_pieceOffsets << points.size();
+                    points << start;
+                }
+                points << end;
+            }
+        }
+        previousCode = code;
+    }
+
+    if ( m_pieceOffsets.isEmpty() ) {
+        return 0;
+    }
+
+    m_pieceOffsets << points.size();
+    m_pieceData = points.constData();
+
+    return m_pieceOffsets.size() - 1;
+}
+
+void PolygonClipper::clipPolyline( const QPolygonF &polyline, QVector<QPolygonF> &clippedPolylines )
+{
+    const int pieceCount = clipPolyline( polyline );
+    if ( pieceCount == 1 && m_pieceData == polyline.constData() ) {
+        if ( polyline.size() > 1 ) {
+            clippedPolylines << polyline;
+        }
+        return;
+    }
+
+    for ( int i = 0; i < pieceCount; ++i ) {
+        if ( pieceSize( i ) > 1 ) {
+            clippedPolylines << copy( piece( i ), pieceSize( i ) );
+        }
+    }
+}
+
+const QPointF *PolygonClipper::piece( int index ) const
+{
+    return m_pieceData + m_pieceOffsets.at( index );
+}
+
+int PolygonClipper::pieceSize( int index ) const
+{
+    return m_pieceOffsets.at( index + 1 ) - m_pieceOffsets.at( index );
+}
+
+QPolygonF PolygonClipper::copy( const QPointF *points, int size )
+{
+    // a deep copy, the buffers get reused
+    QPolygonF result( size );
+    std::copy( points, points + size, result.begin() );
+
+    return result;
+}
+
+}
@@ -0,0 +1,121 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_POLYGONCLIPPER_H
+#define MARBLE_POLYGONCLIPPER_H
+
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short Clips screen polygons and polylines to a rectangle
+ *
+ * Polygons are clipped with the Sutherland-Hodgman algorithm, which keeps
+ * them in one piece, polylines are split into pieces with the
+ * Cohen-Sutherland algorithm. Intersections are put exactly onto the border
+ * of the rectangle, so nodes far off the screen do not cost precision.
+ *
+ * The results are kept in scratch buffers which are reused by the next
+ * call, so once the buffers have grown clipping does not allocate memory.
+ * Polygons and polylines inside the rectangle are passed through as they
+ * are. A clipper must not be used by several threads at once.
+ */
+class MARBLE_EXPORT PolygonClipper
+{
+ public:
+    PolygonClipper();
+    explicit PolygonClipper( const QRectF &clipRect );
+
+    void setClipRect( const QRectF &clipRect );
+    QRectF clipRect() const;
+
+    /**
+     * @brief Clips the closed @p polygon
+     *
+     * Parts of the boundary outside the rectangle get replaced by edges along
+     * the border of the rectangle.
+     *
+     * @return @p polygon itself if it is inside the rectangle, otherwise a
+     * buffer of the clipper which is valid until the next call. The result has
+     * less than three nodes if nothing remains to be filled.
+     */
+    const QPolygonF &clipPolygon( const QPolygonF &polygon );
+
+    /**
+     * @brief Clips @p polygon and appends the result to @p clippedPolygons
+     * unless nothing remains to be filled
+     */
+    void clipPolygon( const QPolygonF &polygon, QVector<QPolygonF> &clippedPolygons );
+
+    /**
+     * @brief Clips the open @p polyline
+     *
+     * Each part of the polyline inside the rectangle becomes a piece of its
+     * own, see piece() and pieceSize(). The pieces are valid until the next
+     * call.
+     *
+     * @return the number of pieces
+     */
+    int clipPolyline( const QPolygonF &polyline );
+
+    /**
+     * @brief Clips @p polyline and appends the pieces of at least two nodes
+     * to @p clippedPolylines
+     */
+    void clipPolyline( const QPolygonF &polyline, QVector<QPolygonF> &clippedPolylines );
+
+    const QPointF *piece( int index ) const;
+    int pieceSize( int index ) const;
+
+ private:
+    enum Edge {
+        LeftEdge,
+        RightEdge,
+        TopEdge,
+        BottomEdge
+    };
+
+    template<int edge>
+    inline bool isInside( const QPointF &point ) const;
+
+    template<int edge>
+    inline QPointF intersection( const QPointF &reference, const QPointF &outside ) const;
+    QPointF intersection( int code, const QPointF &reference, const QPointF &outside ) const;
+
+    template<int edge>
+    void clipEdge( const QPolygonF &input, QPolygonF &output ) const;
+
+    inline int outCode( const QPointF &point ) const;
+    inline bool clipSegment( QPointF &start, QPointF &end ) const;
+
+    static QPolygonF copy( const QPointF *points, int size );
+
+    qreal m_left;
+    qreal m_right;
+    qreal m_top;
+    qreal m_bottom;
+
+    QPolygonF m_buffers[2];
+
+    // the pieces of the last polyline, piece i is made of the nodes
+    // m_pieceOffsets[i] to m_pieceOffsets[i + 1] - 1
+    const QPointF *m_pieceData;
+    QVector<int> m_pieceOffsets;
+};
+
+}
+
+#endif
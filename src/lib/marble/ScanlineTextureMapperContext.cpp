@@ -438,6 +438,38 @@ QImage::Format ScanlineTextureMapperContext::optimalCanvasImageFormat( const Vie
 }
 
 
+void ScanlineTextureMapperContext::translateCanvasImage( QImage *canvasImage, int dx, int dy )
+{
+    const int imageWidth = canvasImage->width();
+    const int imageHeight = canvasImage->height();
+
+    if ( qAbs( dx ) >= imageWidth || qAbs( dy ) >= imageHeight ) {
+        return;
+    }
+
+    const int pixelByteSize = canvasImage->bytesPerLine() / imageWidth;
+    const int sourceX = qMax( 0, -dx ) * pixelByteSize;
+    const int targetX = qMax( 0,  dx ) * pixelByteSize;
+    const int byteCount = ( imageWidth - qAbs( dx ) ) * pixelByteSize;
+
+    // Walk against the direction of the move so that no line gets
+    // overwritten before it got copied.
+    if ( dy > 0 ) {
+        for ( int y = imageHeight - 1; y >= dy; --y ) {
+            memmove( canvasImage->scanLine( y ) + targetX,
+                     canvasImage->scanLine( y - dy ) + sourceX,
+                     byteCount );
+        }
+    }
+    else {
+        for ( int y = 0; y < imageHeight + dy; ++y ) {
+            memmove( canvasImage->scanLine( y ) + targetX,
+                     canvasImage->scanLine( y - dy ) + sourceX,
+                     byteCount );
+        }
+    }
+}
+
 void ScanlineTextureMapperContext::nextTile( int &posX, int &posY )
 {
     // Move from tile coordinates to global texture coordinates 
@@ -461,8 +493,9 @@ void ScanlineTextureMapperContext::nextTile( int &posX, int &posY )
     const int tileCol = lon / m_tileSize.width();
     const int tileRow = lat / m_tileSize.height();
 
-    m_deltaLevel = 0;
-    m_tile = m_tileLoader->loadTile( TileId( 0, m_tileLevel - m_deltaLevel, tileCol >> m_deltaLevel, tileRow >> m_deltaLevel ) );
+    // If the tile is still being loaded by another render thread, a lower
+    // level tile is used in the meantime and m_deltaLevel is set accordingly.
+    m_tile = m_tileLoader->loadTileOrParent( TileId( 0, m_tileLevel, tileCol, tileRow ), m_deltaLevel );
 
     // Update position variables:
     // m_tilePosX/Y stores the position of the tiles in 
@@ -503,8 +536,9 @@ void ScanlineTextureMapperContext::nextTile( qreal &posX, qreal &posY )
     const int tileCol = lon / m_tileSize.width();
     const int tileRow = lat / m_tileSize.height();
 
-    m_deltaLevel = 0;
-    m_tile = m_tileLoader->loadTile( TileId( 0, m_tileLevel - m_deltaLevel, tileCol >> m_deltaLevel, tileRow >> m_deltaLevel ) );
+    // If the tile is still being loaded by another render thread, a lower
+    // level tile is used in the meantime and m_deltaLevel is set accordingly.
+    m_tile = m_tileLoader->loadTileOrParent( TileId( 0, m_tileLevel, tileCol, tileRow ), m_deltaLevel );
 
     // Update position variables:
     // m_tilePosX/Y stores the position of the tiles in 
@@ -46,6 +46,12 @@ public:
 
     static QImage::Format optimalCanvasImageFormat( const ViewportParams *viewport );
 
+    /**
+     * Moves the content of @p canvasImage by @p dx pixels to the right and by
+     * @p dy pixels down. The exposed areas keep their previous content.
+     */
+    static void translateCanvasImage( QImage *canvasImage, int dx, int dy );
+
     int globalWidth() const;
     int globalHeight() const;
 
@@ -0,0 +1,373 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "ScreenPolygonCache.h"
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPolygon.h"
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
+#include "ViewportParams.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QSize>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+class ScreenPolygonCachePrivate
+{
+ public:
+    ScreenPolygonCachePrivate();
+
+    void setViewport( const ViewportParams *viewport, bool translatable );
+    quint64 freePolygons();
+    void touch();
+
+    bool m_valid;
+    bool m_translatable;
+    Projection m_projection;
+    int m_radius;
+    Quaternion m_planetAxis;
+    QSize m_viewportSize;
+    QPointF m_anchor;
+
+    quint64 m_lastUse;
+    quint64 m_byteSize;
+
+    QVector<QPolygonF> m_polygons;
+    QVector<QPolygonF> m_outlines;
+};
+
+namespace
+{
+
+struct CacheRegistry
+{
+    CacheRegistry() :
+        size( 0 ),
+        limit( 32 * 1024 * 1024 ),
+        clock( 0 )
+    {
+    }
+
+    QMutex mutex;
+    QSet<ScreenPolygonCachePrivate *> caches;
+    quint64 size;  // in bytes
+    quint64 limit; // in bytes
+    quint64 clock;
+};
+
+CacheRegistry &registry()
+{
+    static CacheRegistry instance;
+    return instance;
+}
+
+quint64 byteSize( const QVector<QPolygonF> &polygons )
+{
+    quint64 result = 0;
+    foreach ( const QPolygonF &polygon, polygons ) {
+        result += polygon.size() * sizeof( QPointF );
+    }
+
+    return result;
+}
+
+bool lessRecentlyUsed( const ScreenPolygonCachePrivate *a, const ScreenPolygonCachePrivate *b )
+{
+    return a->m_lastUse < b->m_lastUse;
+}
+
+/*
+ * Whether the map covers the whole width of the viewport without being
+ * repeated, see CylindricalProjectionPrivate::repeatPolygons(). Only then a
+ * pan does not change which copies of the projected polygons are needed.
+ */
+bool coversWidth( const ViewportParams *viewport )
+{
+    const qreal centerLatitude = viewport->viewLatLonAltBox().center().latitude();
+
+    qreal xWest = 0;
+    qreal xEast = 0;
+    qreal y = 0;
+    viewport->screenCoordinates( GeoDataCoordinates( -M_PI, centerLatitude ), xWest, y );
+    viewport->screenCoordinates( GeoDataCoordinates( +M_PI, centerLatitude ), xEast, y );
+
+    return xWest <= 0 && xEast >= viewport->width() - 1;
+}
+
+/*
+ * A point whose screen position tells how far the map moved on a pan.
+ */
+QPointF anchor( const ViewportParams *viewport )
+{
+    qreal x = 0;
+    qreal y = 0;
+    viewport->screenCoordinates( GeoDataCoordinates( 0.0, 0.0 ), x, y );
+
+    return QPointF( x, y );
+}
+
+}
+
+ScreenPolygonCachePrivate::ScreenPolygonCachePrivate() :
+    m_valid( false ),
+    m_translatable( false ),
+    m_projection( Spherical ),
+    m_radius( 0 ),
+    m_lastUse( 0 ),
+    m_byteSize( 0 )
+{
+}
+
+void ScreenPolygonCachePrivate::setViewport( const ViewportParams *viewport, bool translatable )
+{
+    m_valid = true;
+    m_projection = viewport->projection();
+    m_radius = viewport->radius();
+    m_planetAxis = viewport->planetAxis();
+    m_viewportSize = viewport->size();
+
+    // Flat projections only shift the map on pans. Polygons closed along the
+    // viewport border around a pole and repeated copies of the map do not
+    // follow that shift, though.
+    m_translatable = translatable
+                     && ( m_projection == Mercator || m_projection == Equirectangular )
+                     && coversWidth( viewport );
+    if ( m_translatable ) {
+        m_anchor = anchor( viewport );
+    }
+
+    const quint64 size = byteSize( m_polygons ) + byteSize( m_outlines );
+
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    cacheRegistry.size = cacheRegistry.size - m_byteSize + size;
+    m_byteSize = size;
+    m_lastUse = ++cacheRegistry.clock;
+}
+
+quint64 ScreenPolygonCachePrivate::freePolygons()
+{
+    m_valid = false;
+    m_polygons.clear();
+    m_outlines.clear();
+
+    const quint64 freed = m_byteSize;
+    m_byteSize = 0;
+
+    return freed;
+}
+
+void ScreenPolygonCachePrivate::touch()
+{
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    m_lastUse = ++cacheRegistry.clock;
+}
+
+ScreenPolygonCache::ScreenPolygonCache() :
+    d( new ScreenPolygonCachePrivate )
+{
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    cacheRegistry.caches.insert( d );
+}
+
+ScreenPolygonCache::~ScreenPolygonCache()
+{
+    {
+        CacheRegistry &cacheRegistry = registry();
+        QMutexLocker locker( &cacheRegistry.mutex );
+        cacheRegistry.size -= d->freePolygons();
+        cacheRegistry.caches.remove( d );
+    }
+
+    delete d;
+}
+
+bool ScreenPolygonCache::isValid( const ViewportParams *viewport )
+{
+    if ( !d->m_valid
+         || d->m_projection != viewport->projection()
+         || d->m_radius != viewport->radius()
+         || d->m_viewportSize != viewport->size() ) {
+        return false;
+    }
+
+    if ( !( d->m_planetAxis == viewport->planetAxis() ) ) {
+        if ( !d->m_translatable || !coversWidth( viewport ) ) {
+            return false;
+        }
+
+        const QPointF offset = anchor( viewport ) - d->m_anchor;
+        for ( int i = 0; i < d->m_polygons.size(); ++i ) {
+            d->m_polygons[i].translate( offset );
+        }
+        for ( int i = 0; i < d->m_outlines.size(); ++i ) {
+            d->m_outlines[i].translate( offset );
+        }
+        d->m_anchor += offset;
+        d->m_planetAxis = viewport->planetAxis();
+    }
+
+    d->touch();
+    return true;
+}
+
+void ScreenPolygonCache::setLineString( const ViewportParams *viewport, const GeoDataLineString &lineString )
+{
+    d->m_polygons.clear();
+    d->m_outlines.clear();
+    project( viewport, lineString, d->m_polygons );
+
+    const bool closedAroundPole = lineString.isClosed() && lineString.latLonAltBox().width() == 2 * M_PI;
+    d->setViewport( viewport, !closedAroundPole );
+}
+
+void ScreenPolygonCache::setPolygon( const ViewportParams *viewport, const GeoDataPolygon &polygon )
+{
+    d->m_polygons.clear();
+    d->m_outlines.clear();
+    project( viewport, polygon, d->m_polygons, d->m_outlines );
+
+    bool closedAroundPole = polygon.outerBoundary().latLonAltBox().width() == 2 * M_PI;
+    foreach ( const GeoDataLinearRing &innerBoundary, polygon.innerBoundaries() ) {
+        closedAroundPole |= innerBoundary.latLonAltBox().width() == 2 * M_PI;
+    }
+    d->setViewport( viewport, !closedAroundPole );
+}
+
+const QVector<QPolygonF> &ScreenPolygonCache::polygons() const
+{
+    return d->m_polygons;
+}
+
+const QVector<QPolygonF> &ScreenPolygonCache::outlines() const
+{
+    return d->m_outlines;
+}
+
+void ScreenPolygonCache::clear()
+{
+    const quint64 freed = d->freePolygons();
+
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    cacheRegistry.size -= freed;
+}
+
+void ScreenPolygonCache::project( const ViewportParams *viewport, const GeoDataLineString &lineString,
+                                  QVector<QPolygonF> &polygons )
+{
+    QVector<QPolygonF*> screenPolygons;
+    viewport->screenCoordinates( lineString, screenPolygons );
+
+    polygons.reserve( polygons.size() + screenPolygons.size() );
+    foreach( QPolygonF* itPolygon, screenPolygons ) {
+        polygons << *itPolygon;
+    }
+
+    qDeleteAll( screenPolygons );
+}
+
+void ScreenPolygonCache::project( const ViewportParams *viewport, const GeoDataPolygon &polygon,
+                                  QVector<QPolygonF> &polygons, QVector<QPolygonF> &outlines )
+{
+    // Creating the outer screen polygons first
+    QVector<QPolygonF> outerPolygons;
+    project( viewport, polygon.outerBoundary(), outerPolygons );
+
+    // When inner boundaries exist, the outline of the polygon must be painted
+    // separately to avoid connections between the outer and inner boundaries
+    // To avoid performance penalties the separate painting is only done when
+    // it's really needed. See review 105019 for details.
+    const bool needOutlineWorkaround = !polygon.innerBoundaries().isEmpty();
+    if ( needOutlineWorkaround ) {
+        outlines << outerPolygons;
+    }
+
+    // Now creating the "holes" by cutting away the inner boundaries:
+
+    // In QPathClipper We Trust ...
+    // ... and in the speed of a threesome of nested foreachs!
+
+    foreach( const GeoDataLinearRing& itInnerBoundary, polygon.innerBoundaries() ) {
+        QVector<QPolygonF> innerPolygons;
+        project( viewport, itInnerBoundary, innerPolygons );
+
+        if ( needOutlineWorkaround ) {
+            outlines << innerPolygons;
+        }
+
+        for ( int i = 0; i < outerPolygons.size(); ++i ) {
+            foreach( const QPolygonF &itInnerPolygon, innerPolygons ) {
+                outerPolygons[i] = outerPolygons[i].subtracted( itInnerPolygon );
+            }
+        }
+    }
+
+    polygons << outerPolygons;
+}
+
+void ScreenPolygonCache::setCacheLimit( quint64 kiloBytes )
+{
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    cacheRegistry.limit = kiloBytes * 1024;
+}
+
+quint64 ScreenPolygonCache::cacheLimit()
+{
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    return cacheRegistry.limit / 1024;
+}
+
+quint64 ScreenPolygonCache::cacheSize()
+{
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    return cacheRegistry.size / 1024;
+}
+
+void ScreenPolygonCache::trim()
+{
+    CacheRegistry &cacheRegistry = registry();
+    QMutexLocker locker( &cacheRegistry.mutex );
+    if ( cacheRegistry.size <= cacheRegistry.limit ) {
+        return;
+    }
+
+    // Free a bit more than needed, so that the caches are not trimmed again
+    // right in the next frame
+    const quint64 target = cacheRegistry.limit / 4 * 3;
+
+    QVector<ScreenPolygonCachePrivate *> caches;
+    caches.reserve( cacheRegistry.caches.size() );
+    foreach ( ScreenPolygonCachePrivate *cache, cacheRegistry.caches ) {
+        if ( cache->m_byteSize > 0 ) {
+            caches << cache;
+        }
+    }
+    std::sort( caches.begin(), caches.end(), lessRecentlyUsed );
+
+    for ( int i = 0; i < caches.size() && cacheRegistry.size > target; ++i ) {
+        cacheRegistry.size -= caches[i]->freePolygons();
+    }
+}
+
+}
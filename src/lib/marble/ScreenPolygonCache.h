@@ -0,0 +1,120 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_SCREENPOLYGONCACHE_H
+#define MARBLE_SCREENPOLYGONCACHE_H
+
+#include <QPolygonF>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataLineString;
+class GeoDataPolygon;
+class ScreenPolygonCachePrivate;
+class ViewportParams;
+
+/**
+ * @short The screen polygons a geometry got projected to in a viewport
+ *
+ * Graphics items keep one of these to avoid projecting their geometry anew
+ * in each frame. The polygons stay valid as long as the projection, the
+ * radius, the planet axis and the size of the viewport do not change. Pans
+ * in flat projections (Mercator, Equirectangular) only move the map on the
+ * screen, so the polygons are translated instead of being projected again.
+ *
+ * All caches share a size limit. Once it is exceeded trim() frees the
+ * polygons of the caches which have not been painted for the longest time.
+ */
+class MARBLE_EXPORT ScreenPolygonCache
+{
+ public:
+    ScreenPolygonCache();
+    ~ScreenPolygonCache();
+
+    /**
+     * @brief Returns whether the cached polygons can be painted in @p viewport
+     *
+     * If the viewport was only panned in a flat projection since the polygons
+     * were projected, they get translated accordingly.
+     */
+    bool isValid( const ViewportParams *viewport );
+
+    /**
+     * @brief Projects @p lineString and caches the resulting polylines
+     */
+    void setLineString( const ViewportParams *viewport, const GeoDataLineString &lineString );
+
+    /**
+     * @brief Projects @p polygon and caches the resulting polygons and outlines
+     */
+    void setPolygon( const ViewportParams *viewport, const GeoDataPolygon &polygon );
+
+    /**
+     * @brief The polylines of a line string or the filled polygons of a polygon
+     */
+    const QVector<QPolygonF> &polygons() const;
+
+    /**
+     * @brief The outlines of a polygon with holes, empty otherwise
+     * @see GeoPainter::drawScreenPolygons()
+     */
+    const QVector<QPolygonF> &outlines() const;
+
+    void clear();
+
+    /**
+     * @brief Projects @p lineString to screen polylines in @p viewport
+     */
+    static void project( const ViewportParams *viewport, const GeoDataLineString &lineString,
+                         QVector<QPolygonF> &polygons );
+
+    /**
+     * @brief Projects @p polygon to screen polygons in @p viewport
+     *
+     * The inner boundaries are cut out of the outer boundary. If there are any,
+     * @p outlines receives the boundaries separately, as the outline of the cut
+     * polygons would connect the outer and the inner boundaries.
+     */
+    static void project( const ViewportParams *viewport, const GeoDataPolygon &polygon,
+                         QVector<QPolygonF> &polygons, QVector<QPolygonF> &outlines );
+
+    /**
+     * @brief Sets the limit of the memory used by all caches together
+     */
+    static void setCacheLimit( quint64 kiloBytes );
+    static quint64 cacheLimit();
+
+    /**
+     * @brief Returns the memory currently used by all caches together, in kilobytes
+     */
+    static quint64 cacheSize();
+
+    /**
+     * @brief Frees the least recently painted caches if the limit is exceeded
+     *
+     * Frees caches until they use no more than three quarters of the limit.
+     *
+     * Must not be called while caches are in use.
+     */
+    static void trim();
+
+ private:
+    Q_DISABLE_COPY( ScreenPolygonCache )
+
+    ScreenPolygonCachePrivate * const d;
+};
+
+}
+
+#endif
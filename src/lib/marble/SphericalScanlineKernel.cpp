@@ -0,0 +1,349 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "SphericalScanlineKernel.h"
+
+#include <cmath>
+#include <cfloat>
+
+// The vectorized code paths require qreal to be double, which is the case
+// on all x86 platforms unless Qt is configured otherwise.
+#if !defined(QT_COORD_TYPE)
+#  if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#    define MARBLE_HAVE_SSE2
+#    include <emmintrin.h>
+#  endif
+#  if defined(MARBLE_HAVE_SSE2) && ( defined(__x86_64__) || defined(__i386__) ) \
+      && ( defined(__clang__) || ( defined(__GNUC__) && __GNUC__ >= 5 ) )
+     // AVX2 code is compiled per function and only called if the CPU supports it
+#    define MARBLE_HAVE_AVX2
+#    define MARBLE_TARGET_AVX2 __attribute__((target("avx2")))
+#    include <immintrin.h>
+#  endif
+#endif
+
+namespace Marble
+{
+
+namespace
+{
+
+// Coefficients of the rational approximation of atan() on [0, 0.66],
+// taken from the Cephes Math Library.
+const double P0 = -8.750608600031904122785E-1;
+const double P1 = -1.615753718733365076637E1;
+const double P2 = -7.500855792314704667340E1;
+const double P3 = -1.228866684490136173410E2;
+const double P4 = -6.485021904942025371773E1;
+const double Q0 = 2.485846490142306297962E1;
+const double Q1 = 1.650270098316988542046E2;
+const double Q2 = 4.328810604912902668951E2;
+const double Q3 = 4.853903996359136964868E2;
+const double Q4 = 1.945506571482613964425E2;
+
+const double PiOver4 = 0.78539816339744830962;
+const double PiOver2 = 1.57079632679489661923;
+const double Pi = 3.14159265358979323846;
+
+// below this squared distance from the y axis, the longitude is set to 0
+// (see Quaternion::getSpherical())
+const double PoleThreshold = 0.00005;
+
+// atan( x ) for 0 <= x <= 1
+inline double atanUnit( double x )
+{
+    double offset = 0.0;
+    if ( x > 0.66 ) {
+        offset = PiOver4;
+        x = ( x - 1.0 ) / ( x + 1.0 );
+    }
+
+    const double z = x * x;
+    const double p = ( ( ( ( P0 * z + P1 ) * z + P2 ) * z + P3 ) * z + P4 );
+    const double q = ( ( ( ( ( z + Q0 ) * z + Q1 ) * z + Q2 ) * z + Q3 ) * z + Q4 );
+
+    return offset + x + x * z * p / q;
+}
+
+inline double atan2Approx( double y, double x )
+{
+    const double absY = fabs( y );
+    const double absX = fabs( x );
+    const double maximum = absY > absX ? absY : absX;
+    const double minimum = absY > absX ? absX : absY;
+
+    double result = maximum > 0.0 ? atanUnit( minimum / maximum ) : 0.0;
+    if ( absY > absX )
+        result = PiOver2 - result;
+    if ( x < 0.0 )
+        result = Pi - result;
+
+    return y < 0.0 ? -result : result;
+}
+
+void lonLatScalar( const matrix &m, qreal qy, const qreal *qx, int count, qreal *lon, qreal *lat )
+{
+    const double qr = 1.0 - qy * qy;
+
+    for ( int i = 0; i < count; ++i ) {
+        const double qr2z = qr - qx[i] * qx[i];
+        const double qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+
+        const double x = m[0][0] * qx[i] + m[1][0] * qy + m[2][0] * qz;
+        double       y = m[0][1] * qx[i] + m[1][1] * qy + m[2][1] * qz;
+        const double z = m[0][2] * qx[i] + m[1][2] * qy + m[2][2] * qz;
+
+        if ( y > 1.0 )
+            y = 1.0;
+        else if ( y < -1.0 )
+            y = -1.0;
+
+        // asin( y ) == atan2( y, sqrt( 1 - y * y ) ), factorized for precision near the poles
+        lat[i] = atan2Approx( y, sqrt( ( 1.0 - y ) * ( 1.0 + y ) ) );
+        lon[i] = ( x * x + z * z > PoleThreshold ) ? atan2Approx( x, z ) : 0.0;
+    }
+}
+
+#ifdef MARBLE_HAVE_SSE2
+
+inline __m128d selectSse2( __m128d mask, __m128d a, __m128d b )
+{
+    return _mm_or_pd( _mm_and_pd( mask, a ), _mm_andnot_pd( mask, b ) );
+}
+
+inline __m128d atan2Sse2( __m128d y, __m128d x )
+{
+    const __m128d signMask = _mm_set1_pd( -0.0 );
+    const __m128d one = _mm_set1_pd( 1.0 );
+
+    const __m128d absY = _mm_andnot_pd( signMask, y );
+    const __m128d absX = _mm_andnot_pd( signMask, x );
+    const __m128d swap = _mm_cmpgt_pd( absY, absX );
+    const __m128d maximum = _mm_max_pd( absY, absX );
+    const __m128d minimum = _mm_min_pd( absY, absX );
+
+    // minimum is 0 whenever maximum is, so the quotient is 0 then
+    __m128d t = _mm_div_pd( minimum, _mm_max_pd( maximum, _mm_set1_pd( DBL_MIN ) ) );
+
+    const __m128d reduce = _mm_cmpgt_pd( t, _mm_set1_pd( 0.66 ) );
+    t = selectSse2( reduce, _mm_div_pd( _mm_sub_pd( t, one ), _mm_add_pd( t, one ) ), t );
+    const __m128d offset = _mm_and_pd( reduce, _mm_set1_pd( PiOver4 ) );
+
+    const __m128d z = _mm_mul_pd( t, t );
+    __m128d p = _mm_set1_pd( P0 );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( P1 ) );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( P2 ) );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( P3 ) );
+    p = _mm_add_pd( _mm_mul_pd( p, z ), _mm_set1_pd( P4 ) );
+    __m128d q = _mm_add_pd( z, _mm_set1_pd( Q0 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( Q1 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( Q2 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( Q3 ) );
+    q = _mm_add_pd( _mm_mul_pd( q, z ), _mm_set1_pd( Q4 ) );
+
+    __m128d result = _mm_add_pd( _mm_add_pd( offset, t ),
+                                 _mm_div_pd( _mm_mul_pd( _mm_mul_pd( t, z ), p ), q ) );
+
+    result = selectSse2( swap, _mm_sub_pd( _mm_set1_pd( PiOver2 ), result ), result );
+    result = selectSse2( _mm_cmplt_pd( x, _mm_setzero_pd() ), _mm_sub_pd( _mm_set1_pd( Pi ), result ), result );
+
+    // result is not negative, so this yields the sign of y
+    return selectSse2( _mm_cmplt_pd( y, _mm_setzero_pd() ), _mm_or_pd( result, signMask ), result );
+}
+
+void lonLatSse2( const matrix &m, qreal qy, const qreal *qx, int count, qreal *lon, qreal *lat )
+{
+    const __m128d one = _mm_set1_pd( 1.0 );
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d qr = _mm_set1_pd( 1.0 - qy * qy );
+
+    // the contribution of qy is the same for all pixels of the scanline
+    const __m128d yx = _mm_set1_pd( m[1][0] * qy );
+    const __m128d yy = _mm_set1_pd( m[1][1] * qy );
+    const __m128d yz = _mm_set1_pd( m[1][2] * qy );
+
+    int i = 0;
+    for ( ; i + 2 <= count; i += 2 ) {
+        const __m128d x = _mm_loadu_pd( qx + i );
+        const __m128d z = _mm_sqrt_pd( _mm_max_pd( _mm_sub_pd( qr, _mm_mul_pd( x, x ) ), zero ) );
+
+        const __m128d rx = _mm_add_pd( _mm_add_pd( _mm_mul_pd( _mm_set1_pd( m[0][0] ), x ), yx ),
+                                       _mm_mul_pd( _mm_set1_pd( m[2][0] ), z ) );
+        __m128d       ry = _mm_add_pd( _mm_add_pd( _mm_mul_pd( _mm_set1_pd( m[0][1] ), x ), yy ),
+                                       _mm_mul_pd( _mm_set1_pd( m[2][1] ), z ) );
+        const __m128d rz = _mm_add_pd( _mm_add_pd( _mm_mul_pd( _mm_set1_pd( m[0][2] ), x ), yz ),
+                                       _mm_mul_pd( _mm_set1_pd( m[2][2] ), z ) );
+
+        ry = _mm_min_pd( _mm_max_pd( ry, _mm_set1_pd( -1.0 ) ), one );
+        const __m128d cosLat = _mm_sqrt_pd( _mm_mul_pd( _mm_sub_pd( one, ry ), _mm_add_pd( one, ry ) ) );
+        _mm_storeu_pd( lat + i, atan2Sse2( ry, cosLat ) );
+
+        const __m128d distance = _mm_add_pd( _mm_mul_pd( rx, rx ), _mm_mul_pd( rz, rz ) );
+        const __m128d offPole = _mm_cmpgt_pd( distance, _mm_set1_pd( PoleThreshold ) );
+        _mm_storeu_pd( lon + i, _mm_and_pd( offPole, atan2Sse2( rx, rz ) ) );
+    }
+
+    lonLatScalar( m, qy, qx + i, count - i, lon + i, lat + i );
+}
+
+#endif
+
+#ifdef MARBLE_HAVE_AVX2
+
+MARBLE_TARGET_AVX2
+inline __m256d atan2Avx2( __m256d y, __m256d x )
+{
+    const __m256d signMask = _mm256_set1_pd( -0.0 );
+    const __m256d one = _mm256_set1_pd( 1.0 );
+
+    const __m256d absY = _mm256_andnot_pd( signMask, y );
+    const __m256d absX = _mm256_andnot_pd( signMask, x );
+    const __m256d swap = _mm256_cmp_pd( absY, absX, _CMP_GT_OQ );
+    const __m256d maximum = _mm256_max_pd( absY, absX );
+    const __m256d minimum = _mm256_min_pd( absY, absX );
+
+    // minimum is 0 whenever maximum is, so the quotient is 0 then
+    __m256d t = _mm256_div_pd( minimum, _mm256_max_pd( maximum, _mm256_set1_pd( DBL_MIN ) ) );
+
+    const __m256d reduce = _mm256_cmp_pd( t, _mm256_set1_pd( 0.66 ), _CMP_GT_OQ );
+    t = _mm256_blendv_pd( t, _mm256_div_pd( _mm256_sub_pd( t, one ), _mm256_add_pd( t, one ) ), reduce );
+    const __m256d offset = _mm256_and_pd( reduce, _mm256_set1_pd( PiOver4 ) );
+
+    const __m256d z = _mm256_mul_pd( t, t );
+    __m256d p = _mm256_set1_pd( P0 );
+    p = _mm256_add_pd( _mm256_mul_pd( p, z ), _mm256_set1_pd( P1 ) );
+    p = _mm256_add_pd( _mm256_mul_pd( p, z ), _mm256_set1_pd( P2 ) );
+    p = _mm256_add_pd( _mm256_mul_pd( p, z ), _mm256_set1_pd( P3 ) );
+    p = _mm256_add_pd( _mm256_mul_pd( p, z ), _mm256_set1_pd( P4 ) );
+    __m256d q = _mm256_add_pd( z, _mm256_set1_pd( Q0 ) );
+    q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( Q1 ) );
+    q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( Q2 ) );
+    q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( Q3 ) );
+    q = _mm256_add_pd( _mm256_mul_pd( q, z ), _mm256_set1_pd( Q4 ) );
+
+    __m256d result = _mm256_add_pd( _mm256_add_pd( offset, t ),
+                                    _mm256_div_pd( _mm256_mul_pd( _mm256_mul_pd( t, z ), p ), q ) );
+
+    result = _mm256_blendv_pd( result, _mm256_sub_pd( _mm256_set1_pd( PiOver2 ), result ), swap );
+    result = _mm256_blendv_pd( result, _mm256_sub_pd( _mm256_set1_pd( Pi ), result ),
+                               _mm256_cmp_pd( x, _mm256_setzero_pd(), _CMP_LT_OQ ) );
+
+    // result is not negative, so this yields the sign of y
+    return _mm256_blendv_pd( result, _mm256_or_pd( result, signMask ),
+                             _mm256_cmp_pd( y, _mm256_setzero_pd(), _CMP_LT_OQ ) );
+}
+
+MARBLE_TARGET_AVX2
+void lonLatAvx2( const matrix &m, qreal qy, const qreal *qx, int count, qreal *lon, qreal *lat )
+{
+    const __m256d one = _mm256_set1_pd( 1.0 );
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d qr = _mm256_set1_pd( 1.0 - qy * qy );
+
+    // the contribution of qy is the same for all pixels of the scanline
+    const __m256d yx = _mm256_set1_pd( m[1][0] * qy );
+    const __m256d yy = _mm256_set1_pd( m[1][1] * qy );
+    const __m256d yz = _mm256_set1_pd( m[1][2] * qy );
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m256d x = _mm256_loadu_pd( qx + i );
+        const __m256d z = _mm256_sqrt_pd( _mm256_max_pd( _mm256_sub_pd( qr, _mm256_mul_pd( x, x ) ), zero ) );
+
+        const __m256d rx = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( m[0][0] ), x ), yx ),
+                                          _mm256_mul_pd( _mm256_set1_pd( m[2][0] ), z ) );
+        __m256d       ry = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( m[0][1] ), x ), yy ),
+                                          _mm256_mul_pd( _mm256_set1_pd( m[2][1] ), z ) );
+        const __m256d rz = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( m[0][2] ), x ), yz ),
+                                          _mm256_mul_pd( _mm256_set1_pd( m[2][2] ), z ) );
+
+        ry = _mm256_min_pd( _mm256_max_pd( ry, _mm256_set1_pd( -1.0 ) ), one );
+        const __m256d cosLat = _mm256_sqrt_pd( _mm256_mul_pd( _mm256_sub_pd( one, ry ), _mm256_add_pd( one, ry ) ) );
+        _mm256_storeu_pd( lat + i, atan2Avx2( ry, cosLat ) );
+
+        const __m256d distance = _mm256_add_pd( _mm256_mul_pd( rx, rx ), _mm256_mul_pd( rz, rz ) );
+        const __m256d offPole = _mm256_cmp_pd( distance, _mm256_set1_pd( PoleThreshold ), _CMP_GT_OQ );
+        _mm256_storeu_pd( lon + i, _mm256_and_pd( offPole, atan2Avx2( rx, rz ) ) );
+    }
+
+    lonLatScalar( m, qy, qx + i, count - i, lon + i, lat + i );
+}
+
+#endif
+
+}
+
+SphericalScanlineKernel::SphericalScanlineKernel( const matrix &planetAxisMatrix )
+    : m_instructionSet( bestInstructionSet() )
+{
+    for ( int i = 0; i < 3; ++i ) {
+        for ( int j = 0; j < 4; ++j ) {
+            m_planetAxisMatrix[i][j] = planetAxisMatrix[i][j];
+        }
+    }
+}
+
+SphericalScanlineKernel::SphericalScanlineKernel( const matrix &planetAxisMatrix, InstructionSet instructionSet )
+    : m_instructionSet( qMin( instructionSet, bestInstructionSet() ) )
+{
+    for ( int i = 0; i < 3; ++i ) {
+        for ( int j = 0; j < 4; ++j ) {
+            m_planetAxisMatrix[i][j] = planetAxisMatrix[i][j];
+        }
+    }
+}
+
+SphericalScanlineKernel::InstructionSet SphericalScanlineKernel::instructionSet() const
+{
+    return m_instructionSet;
+}
+
+SphericalScanlineKernel::InstructionSet SphericalScanlineKernel::bestInstructionSet()
+{
+#if defined(MARBLE_HAVE_AVX2)
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) ) {
+        return Avx2;
+    }
+#endif
+
+#if defined(MARBLE_HAVE_SSE2)
+    return Sse2;
+#else
+    return Scalar;
+#endif
+}
+
+qreal SphericalScanlineKernel::maximumError()
+{
+    // The rational approximation of atan() is accurate to a few ulp,
+    // which leaves a lot of headroom even for the highest tile levels.
+    return 1e-12;
+}
+
+void SphericalScanlineKernel::lonLat( qreal qy, const qreal *qx, int count, qreal *lon, qreal *lat ) const
+{
+    switch ( m_instructionSet ) {
+#if defined(MARBLE_HAVE_AVX2)
+    case Avx2:
+        lonLatAvx2( m_planetAxisMatrix, qy, qx, count, lon, lat );
+        return;
+#endif
+#if defined(MARBLE_HAVE_SSE2)
+    case Sse2:
+        lonLatSse2( m_planetAxisMatrix, qy, qx, count, lon, lat );
+        return;
+#endif
+    default:
+        lonLatScalar( m_planetAxisMatrix, qy, qx, count, lon, lat );
+    }
+}
+
+}
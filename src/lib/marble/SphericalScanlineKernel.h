@@ -0,0 +1,83 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_SPHERICALSCANLINEKERNEL_H
+#define MARBLE_SPHERICALSCANLINEKERNEL_H
+
+#include "marble_export.h"
+#include "Quaternion.h"
+
+namespace Marble
+{
+
+/**
+ * @short Batch evaluation of longitude and latitude for the pixels of a scanline
+ *
+ * For each pixel of the globe disk, SphericalScanlineTextureMapper creates the
+ * 3D position vector, rotates it around the planet axis and converts it to
+ * longitude and latitude. This class does that for many pixels of a scanline
+ * at once, using SSE2 or AVX2 instructions if the CPU supports them.
+ *
+ * The results match Quaternion::rotateAroundAxis() followed by
+ * Quaternion::getSpherical() within maximumError().
+ */
+class MARBLE_EXPORT SphericalScanlineKernel
+{
+ public:
+    enum InstructionSet {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    /**
+     * Creates a kernel using the best instruction set supported by the CPU.
+     */
+    explicit SphericalScanlineKernel( const matrix &planetAxisMatrix );
+
+    /**
+     * Creates a kernel using the given instruction set, or the best supported
+     * one if @p instructionSet is not supported by the CPU.
+     */
+    SphericalScanlineKernel( const matrix &planetAxisMatrix, InstructionSet instructionSet );
+
+    InstructionSet instructionSet() const;
+
+    /**
+     * Returns the best instruction set which is both compiled in and
+     * supported by the CPU at runtime.
+     */
+    static InstructionSet bestInstructionSet();
+
+    /**
+     * Returns the maximum absolute error of the calculated coordinates in radian.
+     */
+    static qreal maximumError();
+
+    /**
+     * Calculates the coordinates of @p count pixels of a scanline.
+     *
+     * @param qy  the y component of the position vector of the scanline,
+     *            normalized to the globe radius
+     * @param qx  the x components of the position vectors of the pixels,
+     *            normalized to the globe radius
+     * @param lon receives the longitudes in radian
+     * @param lat receives the latitudes in radian
+     */
+    void lonLat( qreal qy, const qreal *qx, int count, qreal *lon, qreal *lat ) const;
+
+ private:
+    matrix m_planetAxisMatrix;
+    InstructionSet m_instructionSet;
+};
+
+}
+
+#endif
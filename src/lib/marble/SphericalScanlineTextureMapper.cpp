@@ -15,7 +15,7 @@
 #include <cmath>
 
 #include <QtCore/qmath.h>
-#include <QRunnable>
+#include <QVector>
 
 #include "MarbleGlobal.h"
 #include "GeoPainter.h"
@@ -24,6 +24,7 @@
 #include "MarbleDebug.h"
 #include "Quaternion.h"
 #include "ScanlineTextureMapperContext.h"
+#include "SphericalScanlineKernel.h"
 #include "StackedTileLoader.h"
 #include "StackedTile.h"
 #include "TextureColorizer.h"
@@ -33,12 +34,12 @@
 
 using namespace Marble;
 
-class SphericalScanlineTextureMapper::RenderJob : public QRunnable
+class SphericalScanlineTextureMapper::RenderJob : public TextureMapperScheduler::Job
 {
 public:
-    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom );
+    RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality );
 
-    virtual void run();
+    virtual void renderLines( int yTop, int yBottom );
 
 private:
     StackedTileLoader *const m_tileLoader;
@@ -46,18 +47,14 @@ private:
     QImage *const m_canvasImage;
     const ViewportParams *const m_viewport;
     const MapQuality m_mapQuality;
-    int const m_yTop;
-    int const m_yBottom;
 };
 
-SphericalScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality, int yTop, int yBottom )
+SphericalScanlineTextureMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, QImage *canvasImage, const ViewportParams *viewport, MapQuality mapQuality )
     : m_tileLoader( tileLoader ),
       m_tileLevel( tileLevel ),
       m_canvasImage( canvasImage ),
       m_viewport( viewport ),
-      m_mapQuality( mapQuality ),
-      m_yTop( yTop ),
-      m_yBottom( yBottom )
+      m_mapQuality( mapQuality )
 {
 }
 
@@ -65,7 +62,7 @@ SphericalScanlineTextureMapper::SphericalScanlineTextureMapper( StackedTileLoade
     : TextureMapperInterface()
     , m_tileLoader( tileLoader )
     , m_radius( 0 )
-    , m_threadPool()
+    , m_scheduler()
 {
 }
 
@@ -112,6 +109,11 @@ void SphericalScanlineTextureMapper::mapTexture( GeoPainter *painter,
     painter->drawImage( rect, m_canvasImage, rect );
 }
 
+QString SphericalScanlineTextureMapper::runtimeTrace() const
+{
+    return m_scheduler.runtimeTrace();
+}
+
 void SphericalScanlineTextureMapper::mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality )
 {
     // Reset backend
@@ -130,21 +132,13 @@ void SphericalScanlineTextureMapper::mapTexture( const ViewportParams *viewport,
     const int yBottom = ( yTop == 0 ) ? imageHeight - skip
                                       : yTop + radius + radius - skip;
 
-    const int numThreads = m_threadPool.maxThreadCount();
-    const int yStep = qCeil(qreal( yBottom - yTop ) / qreal(numThreads));
-    for ( int i = 0; i < numThreads; ++i ) {
-        const int yStart = yTop +  i      * yStep;
-        const int yEnd   = qMin(yBottom, yTop + (i + 1) * yStep);
-        QRunnable *const job = new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality, yStart, yEnd );
-        m_threadPool.start( job );
-    }
-
-    m_threadPool.waitForDone();
+    m_scheduler.schedule( new RenderJob( m_tileLoader, tileZoomLevel, &m_canvasImage, viewport, mapQuality ), yTop, yBottom );
+    m_scheduler.run();
 
     m_tileLoader->cleanupTilehash();
 }
 
-void SphericalScanlineTextureMapper::RenderJob::run()
+void SphericalScanlineTextureMapper::RenderJob::renderLines( int yTop, int yBottom )
 {
     const int imageHeight = m_canvasImage->height();
     const int imageWidth  = m_canvasImage->width();
@@ -169,18 +163,25 @@ void SphericalScanlineTextureMapper::RenderJob::run()
     matrix  planetAxisMatrix;
     m_viewport->planetAxis().toMatrix( planetAxisMatrix );
 
+    // Evaluates the coordinates of all exactly mapped pixels of a scanline at once
+    const SphericalScanlineKernel kernel( planetAxisMatrix );
+
     // initialize needed variables that are modified during texture mapping:
 
     ScanlineTextureMapperContext context( m_tileLoader, m_tileLevel );
-    qreal  lon = 0.0;
-    qreal  lat = 0.0;
+
+    // Pixels of the current scanline whose coordinates get evaluated exactly
+    QVector<int>  sampleX( imageWidth + 1 );
+    QVector<bool> sampleInterpolate( imageWidth + 1 );
+    QVector<qreal> sampleQx( imageWidth + 1 );
+    QVector<qreal> sampleLon( imageWidth + 1 );
+    QVector<qreal> sampleLat( imageWidth + 1 );
 
     // Scanline based algorithm to texture map a sphere
-    for ( int y = m_yTop; y < m_yBottom ; ++y ) {
+    for ( int y = yTop; y < yBottom ; ++y ) {
 
         // Evaluate coordinates for the 3D position vector of the current pixel
         const qreal qy = inverseRadius * (qreal)( imageHeight / 2 - y );
-        const qreal qr = 1.0 - qy * qy;
 
         // rx is the radius component in x direction
         const int rx = (int)sqrt( (qreal)( radius * radius
@@ -220,6 +221,8 @@ void SphericalScanlineTextureMapper::RenderJob::run()
             crossingPoleArea = true;
         }
 
+        // First pass: find the pixels whose coordinates get evaluated exactly.
+        int sampleCount = 0;
         int ncount = 0;
 
         for ( int x = xLeft; x < xRight; ++x ) {
@@ -250,21 +253,25 @@ void SphericalScanlineTextureMapper::RenderJob::run()
 
             // Evaluate more coordinates for the 3D position vector of
             // the current pixel.
-            const qreal qx = (qreal)( x - imageWidth / 2 ) * inverseRadius;
-            const qreal qr2z = qr - qx * qx;
-            const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+            sampleX[sampleCount] = x;
+            sampleInterpolate[sampleCount] = interpolate;
+            sampleQx[sampleCount] = (qreal)( x - imageWidth / 2 ) * inverseRadius;
+            ++sampleCount;
+        }
 
-            // Create Quaternion from vector coordinates and rotate it
-            // around globe axis
-            Quaternion qpos( 0.0, qx, qy, qz );
-            qpos.rotateAroundAxis( planetAxisMatrix );
+        // Second pass: rotate the position vectors around the globe axis
+        // and convert them to longitude and latitude, many pixels at once.
+        kernel.lonLat( qy, sampleQx.constData(), sampleCount, sampleLon.data(), sampleLat.data() );
 
-            qpos.getSpherical( lon, lat );
+        // Third pass: look up the texture.
+        for ( int i = 0; i < sampleCount; ++i ) {
+            const qreal lon = sampleLon[i];
+            const qreal lat = sampleLat[i];
 //            mDebug() << QString("lon: %1 lat: %2").arg(lon).arg(lat);
             // Approx for n-1 out of n pixels within the boundary of
             // xIpLeft to xIpRight
 
-            if ( interpolate ) {
+            if ( sampleInterpolate[i] ) {
                 if (highQuality)
                     context.pixelValueApproxF( lon, lat, scanLine, n );
                 else
@@ -280,7 +287,7 @@ void SphericalScanlineTextureMapper::RenderJob::run()
 //          rendering around north pole:
 
 //            if ( !crossingPoleArea )
-            if ( x < imageWidth ) {
+            if ( sampleX[i] < imageWidth ) {
                 if ( highQuality )
                     context.pixelValueF( lon, lat, scanLine );
                 else
@@ -291,7 +298,7 @@ void SphericalScanlineTextureMapper::RenderJob::run()
         }
 
         // copy scanline to improve performance
-        if ( interlaced && y + 1 < m_yBottom ) { 
+        if ( interlaced && y + 1 < yBottom ) { 
 
             const int pixelByteSize = m_canvasImage->bytesPerLine() / imageWidth;
 
@@ -16,8 +16,8 @@
 #include "TextureMapperInterface.h"
 
 #include "MarbleGlobal.h"
+#include "TextureMapperScheduler.h"
 
-#include <QThreadPool>
 #include <QImage>
 
 
@@ -47,6 +47,8 @@ class SphericalScanlineTextureMapper : public TextureMapperInterface
                              const QRect &dirtyRect,
                              TextureColorizer *texColorizer );
 
+    virtual QString runtimeTrace() const;
+
  private:
     void mapTexture( const ViewportParams *viewport, int tileZoomLevel, MapQuality mapQuality );
 
@@ -55,7 +57,7 @@ class SphericalScanlineTextureMapper : public TextureMapperInterface
     StackedTileLoader *const m_tileLoader;
     int m_radius;
     QImage m_canvasImage;
-    QThreadPool m_threadPool;
+    TextureMapperScheduler m_scheduler;
 };
 
 }
@@ -74,6 +74,21 @@ StackedTile::StackedTile( const TileId &id, const QImage &resultImage, QVector<Q
     }
 }
 
+StackedTile::StackedTile( const TileId &id, const QImage &resultImage ) :
+      Tile( id ),
+      m_resultImage( resultImage ),
+      m_depth( resultImage.depth() ),
+      m_isGrayscale( resultImage.isGrayscale() ),
+      jumpTable8( jumpTableFromQImage8( m_resultImage ) ),
+      jumpTable32( jumpTableFromQImage32( m_resultImage ) ),
+      m_byteCount( calcByteCount( resultImage, QVector<QSharedPointer<TextureTile> >() ) ),
+      m_isUsed( false )
+{
+    if ( jumpTable32 == 0 && jumpTable8 == 0 ) {
+        qWarning() << "Color depth" << m_depth << " is not supported.";
+    }
+}
+
 StackedTile::~StackedTile()
 {
       delete [] jumpTable32;
@@ -254,6 +269,45 @@ int StackedTile::byteCount() const
     return m_byteCount;
 }
 
+void StackedTile::compact( TileCacheEncoding encoding )
+{
+    if ( encoding == UncompressedTiles || isCompact() )
+        return;
+
+    m_compactImage = CompactTileImage( m_resultImage, encoding );
+    m_resultImage = QImage();
+
+    // the texture tiles are only needed for updating a displayed tile,
+    // MergedLayerDecorator::updateTile() loads them again if needed
+    m_tiles.clear();
+
+    delete [] jumpTable32;
+    jumpTable32 = 0;
+    delete [] jumpTable8;
+    jumpTable8 = 0;
+
+    m_byteCount = m_compactImage.byteCount();
+}
+
+void StackedTile::expand()
+{
+    if ( !isCompact() )
+        return;
+
+    m_resultImage = m_compactImage.toImage();
+    m_compactImage = CompactTileImage();
+
+    jumpTable8 = jumpTableFromQImage8( m_resultImage );
+    jumpTable32 = jumpTableFromQImage32( m_resultImage );
+
+    m_byteCount = calcByteCount( m_resultImage, m_tiles );
+}
+
+bool StackedTile::isCompact() const
+{
+    return !m_compactImage.isNull();
+}
+
 QVector<QSharedPointer<TextureTile> > StackedTile::tiles() const
 {
     return m_tiles;
@@ -261,6 +315,8 @@ QVector<QSharedPointer<TextureTile> > StackedTile::tiles() const
 
 QImage const * StackedTile::resultImage() const
 {
+    Q_ASSERT( !isCompact() );
+
     return &m_resultImage;
 }
 
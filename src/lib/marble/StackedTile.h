@@ -19,6 +19,8 @@
 #include <QColor>
 #include <QImage>
 
+#include "CompactTileImage.h"
+#include "MarbleGlobal.h"
 #include "Tile.h"
 
 namespace Marble
@@ -57,6 +59,13 @@ class StackedTile : public Tile
 {
  public:
     explicit StackedTile( TileId const &id, QImage const &resultImage, QVector<QSharedPointer<TextureTile> > const &tiles );
+
+/*!
+    \brief Creates a tile without its stack of Tiles, e.g. one restored from
+    the decoded tile cache. MergedLayerDecorator::updateTile() loads them
+    when they are needed.
+*/
+    explicit StackedTile( TileId const &id, QImage const &resultImage );
     virtual ~StackedTile();
 
     void setUsed( bool used );
@@ -99,16 +108,33 @@ class StackedTile : public Tile
     // This method passes the top left pixel (if known already) for better performance
     uint pixelF( qreal x, qreal y, const QRgb& pixel ) const; 
 
+/*!
+    \brief Replaces the result image by a compact encoding and drops the stack of Tiles
+    
+    This reduces the memory needed by a tile which is not displayed. The tile
+    can't be displayed again until expand() is called. Does nothing for
+    UncompressedTiles.
+*/
+    void compact( TileCacheEncoding encoding );
+
+/*!
+    \brief Restores the result image of a compacted tile
+*/
+    void expand();
+
+    bool isCompact() const;
+
  private:
     Q_DISABLE_COPY( StackedTile )
 
-    const QImage m_resultImage;
+    QImage m_resultImage;
+    CompactTileImage m_compactImage;
     const int m_depth;
     const bool m_isGrayscale;
-    const QVector<QSharedPointer<TextureTile> > m_tiles;
-    const uchar **const jumpTable8;
-    const uint **const jumpTable32;
-    const int m_byteCount;
+    QVector<QSharedPointer<TextureTile> > m_tiles;
+    const uchar **jumpTable8;
+    const uint **jumpTable32;
+    int m_byteCount;
     bool m_isUsed;
 
     static int calcByteCount( const QImage &resultImage, const QVector<QSharedPointer<TextureTile> > &tiles );
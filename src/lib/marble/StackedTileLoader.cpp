@@ -24,6 +24,7 @@
 
 #include "StackedTileLoader.h"
 
+#include "CacheStatistics.h"
 #include "MarbleDebug.h"
 #include "MergedLayerDecorator.h"
 #include "StackedTile.h"
@@ -33,7 +34,13 @@
 
 #include <QCache>
 #include <QHash>
+#include <QMutex>
 #include <QReadWriteLock>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QTime>
+#include <QWaitCondition>
 #include <QImage>
 
 
@@ -44,17 +51,210 @@ class StackedTileLoaderPrivate
 {
 public:
     StackedTileLoaderPrivate( MergedLayerDecorator *mergedLayerDecorator )
-        : m_layerDecorator( mergedLayerDecorator )
+        : m_layerDecorator( mergedLayerDecorator ),
+          m_cacheEncoding( UncompressedTiles ),
+          m_statistics( 0 ),
+          m_parentTilesUsed( false ),
+          m_prefetchRunning( false ),
+          m_prefetchGeneration( 0 )
     {
         m_tileCache.setMaxCost( 20000 * 1024 ); // Cache size measured in bytes
+        m_prefetchPool.setMaxThreadCount( 1 );
     }
 
+    /**
+     * Returns the tile if it is in memory, moving it from the cache to the
+     * tiles on display if necessary. Must be called with m_cacheLock locked for write,
+     * which is released while a compact tile is expanded.
+     */
+    StackedTile *takeLoadedTile( TileId const &stackedTileId );
+
+    /**
+     * Loads the tile from disk without holding m_cacheLock during the I/O.
+     * Must be called with m_cacheLock locked for write, returns with it unlocked.
+     */
+    StackedTile *loadTileUnlocked( TileId const &stackedTileId );
+
+    /**
+     * Loads the tiles of m_prefetchQueue into the cache until the queue is empty.
+     * Runs in m_prefetchPool.
+     */
+    void prefetchQueuedTiles();
+
+    /**
+     * Moves the tile into m_tileCache, which may evict other tiles.
+     * Must be called with m_cacheLock locked for write.
+     */
+    void insertIntoCache( TileId const &stackedTileId, StackedTile *stackedTile );
+
     MergedLayerDecorator *const m_layerDecorator;
     QHash <TileId, StackedTile*>  m_tilesOnDisplay;
     QCache <TileId, StackedTile>  m_tileCache;
     QReadWriteLock m_cacheLock;
+    TileCacheEncoding m_cacheEncoding;
+    CacheStatistics *m_statistics;
+
+    // tiles which are currently being read from disk by some render thread
+    QSet<TileId> m_tilesLoading;
+    QWaitCondition m_tileLoadingFinished;
+    bool m_parentTilesUsed;
+
+    // tiles which are expected to be needed soon, guarded by m_cacheLock
+    QList<TileId> m_prefetchQueue;
+    bool m_prefetchRunning;
+    // incremented by cancelPrefetch(), tiles loaded meanwhile are discarded
+    int m_prefetchGeneration;
+    QThreadPool m_prefetchPool;
+
+    // held by the prefetching thread while it reads from m_layerDecorator
+    QMutex m_decoratorMutex;
 };
 
+class PrefetchJob : public QRunnable
+{
+public:
+    explicit PrefetchJob( StackedTileLoaderPrivate *loader )
+        : m_loader( loader )
+    {
+    }
+
+    virtual void run()
+    {
+        m_loader->prefetchQueuedTiles();
+    }
+
+private:
+    StackedTileLoaderPrivate *const m_loader;
+};
+
+StackedTile *StackedTileLoaderPrivate::takeLoadedTile( TileId const &stackedTileId )
+{
+    StackedTile *stackedTile = m_tilesOnDisplay.value( stackedTileId, 0 );
+    if ( stackedTile ) {
+        Q_ASSERT( stackedTile->used() && "other thread should have marked tile as used" );
+        return stackedTile;
+    }
+
+    stackedTile = m_tileCache.take( stackedTileId );
+    if ( stackedTile ) {
+        Q_ASSERT( !stackedTile->used() && "tiles in m_tileCache are invisible and should thus be marked as unused" );
+
+        if ( m_statistics ) {
+            m_statistics->addHit( CacheStatistics::VolatileTileCache );
+            m_statistics->setByteCount( CacheStatistics::VolatileTileCache, m_tileCache.totalCost() );
+        }
+
+        if ( stackedTile->isCompact() ) {
+            // decoding takes a while, so other threads wait for the tile
+            // like for one which is read from disk
+            m_tilesLoading.insert( stackedTileId );
+            m_cacheLock.unlock();
+            stackedTile->expand();
+            m_cacheLock.lockForWrite();
+            m_tilesLoading.remove( stackedTileId );
+            m_tileLoadingFinished.wakeAll();
+        }
+
+        stackedTile->setUsed( true );
+        m_tilesOnDisplay[ stackedTileId ] = stackedTile;
+    }
+
+    return stackedTile;
+}
+
+StackedTile *StackedTileLoaderPrivate::loadTileUnlocked( TileId const &stackedTileId )
+{
+    Q_ASSERT( !m_tilesLoading.contains( stackedTileId ) );
+
+    // Announce that we are loading this tile, so concurrent requests for it
+    // wait for us instead of reading the same files again.
+    m_tilesLoading.insert( stackedTileId );
+    m_cacheLock.unlock();
+
+    mDebug() << "load tile from disk:" << stackedTileId;
+
+    QTime timer;
+    timer.start();
+
+    StackedTile *const stackedTile = m_layerDecorator->loadTile( stackedTileId );
+    Q_ASSERT( stackedTile );
+    stackedTile->setUsed( true );
+
+    if ( m_statistics ) {
+        m_statistics->addMiss( CacheStatistics::VolatileTileCache );
+        m_statistics->addTime( CacheStatistics::VolatileTileCache, CacheStatistics::DecodeTime, timer.elapsed() );
+    }
+
+    m_cacheLock.lockForWrite();
+    m_tilesLoading.remove( stackedTileId );
+    m_tilesOnDisplay[ stackedTileId ] = stackedTile;
+    m_tileLoadingFinished.wakeAll();
+    m_cacheLock.unlock();
+
+    return stackedTile;
+}
+
+void StackedTileLoaderPrivate::prefetchQueuedTiles()
+{
+    forever {
+        m_cacheLock.lockForWrite();
+        if ( m_prefetchQueue.isEmpty() ) {
+            m_prefetchRunning = false;
+            m_cacheLock.unlock();
+            return;
+        }
+
+        const TileId stackedTileId = m_prefetchQueue.takeFirst();
+        if ( m_tilesOnDisplay.contains( stackedTileId )
+             || m_tileCache.contains( stackedTileId )
+             || m_tilesLoading.contains( stackedTileId ) ) {
+            m_cacheLock.unlock();
+            continue;
+        }
+
+        m_tilesLoading.insert( stackedTileId );
+        const TileCacheEncoding cacheEncoding = m_cacheEncoding;
+        const int generation = m_prefetchGeneration;
+        m_cacheLock.unlock();
+
+        mDebug() << "prefetch tile from disk:" << stackedTileId;
+
+        m_decoratorMutex.lock();
+        StackedTile *const stackedTile = m_layerDecorator->loadTile( stackedTileId );
+        m_decoratorMutex.unlock();
+        Q_ASSERT( stackedTile );
+        stackedTile->compact( cacheEncoding );
+
+        // render threads waiting for the tile take it from the cache,
+        // or load it themselves if prefetching was canceled meanwhile
+        m_cacheLock.lockForWrite();
+        m_tilesLoading.remove( stackedTileId );
+        if ( generation == m_prefetchGeneration ) {
+            insertIntoCache( stackedTileId, stackedTile );
+        } else {
+            delete stackedTile;
+        }
+        m_tileLoadingFinished.wakeAll();
+        m_cacheLock.unlock();
+    }
+}
+
+void StackedTileLoaderPrivate::insertIntoCache( TileId const &stackedTileId, StackedTile *stackedTile )
+{
+    const int count = m_tileCache.count();
+
+    // If insert call result is false then the cache is too small to store the tile
+    // but the item will get deleted nevertheless and the pointer we have
+    // doesn't get set to zero (so don't delete it in this case or it will crash!)
+    m_tileCache.insert( stackedTileId, stackedTile, stackedTile->byteCount() );
+
+    if ( m_statistics ) {
+        // QCache silently deletes the least recently used tiles, or the new one
+        m_statistics->addEvictions( CacheStatistics::VolatileTileCache, count + 1 - m_tileCache.count() );
+        m_statistics->setByteCount( CacheStatistics::VolatileTileCache, m_tileCache.totalCost() );
+    }
+}
+
 StackedTileLoader::StackedTileLoader( MergedLayerDecorator *mergedLayerDecorator, QObject *parent )
     : QObject( parent ),
       d( new StackedTileLoaderPrivate( mergedLayerDecorator ) )
@@ -63,6 +263,8 @@ StackedTileLoader::StackedTileLoader( MergedLayerDecorator *mergedLayerDecorator
 
 StackedTileLoader::~StackedTileLoader()
 {
+    cancelPrefetch();
+    d->m_prefetchPool.waitForDone();
     qDeleteAll( d->m_tilesOnDisplay );
     delete d;
 }
@@ -89,6 +291,8 @@ QSize StackedTileLoader::tileSize() const
 
 void StackedTileLoader::resetTilehash()
 {
+    d->m_parentTilesUsed = false;
+
     QHash<TileId, StackedTile*>::const_iterator it = d->m_tilesOnDisplay.constBegin();
     QHash<TileId, StackedTile*>::const_iterator const end = d->m_tilesOnDisplay.constEnd();
     for (; it != end; ++it ) {
@@ -102,14 +306,14 @@ void StackedTileLoader::cleanupTilehash()
     // Make sure that tiles which haven't been used during the last
     // rendering of the map at all get removed from the tile hash.
 
+    QWriteLocker locker( &d->m_cacheLock );
+
     QHashIterator<TileId, StackedTile*> it( d->m_tilesOnDisplay );
     while ( it.hasNext() ) {
         it.next();
         if ( !it.value()->used() ) {
-            // If insert call result is false then the cache is too small to store the tile
-            // but the item will get deleted nevertheless and the pointer we have
-            // doesn't get set to zero (so don't delete it in this case or it will crash!)
-            d->m_tileCache.insert( it.key(), it.value(), it.value()->byteCount() );
+            it.value()->compact( d->m_cacheEncoding );
+            d->insertIntoCache( it.key(), it.value() );
             d->m_tilesOnDisplay.remove( it.key() );
         }
     }
@@ -129,20 +333,16 @@ const StackedTile* StackedTileLoader::loadTile( TileId const & stackedTileId )
 
     d->m_cacheLock.lockForWrite();
 
-    // has another thread loaded our tile due to a race condition?
-    stackedTile = d->m_tilesOnDisplay.value( stackedTileId, 0 );
-    if ( stackedTile ) {
-        Q_ASSERT( stackedTile->used() && "other thread should have marked tile as used" );
-        d->m_cacheLock.unlock();
-        return stackedTile;
+    // has another thread loaded our tile due to a race condition,
+    // or is the tile still in the cache?
+    stackedTile = d->takeLoadedTile( stackedTileId );
+    while ( !stackedTile && d->m_tilesLoading.contains( stackedTileId ) ) {
+        // another thread is reading the tile from disk, so share its result
+        d->m_tileLoadingFinished.wait( &d->m_cacheLock );
+        stackedTile = d->takeLoadedTile( stackedTileId );
     }
 
-    // the tile was not in the hash so check if it is in the cache
-    stackedTile = d->m_tileCache.take( stackedTileId );
     if ( stackedTile ) {
-        Q_ASSERT( !stackedTile->used() && "tiles in m_tileCache are invisible and should thus be marked as unused" );
-        stackedTile->setUsed( true );
-        d->m_tilesOnDisplay[ stackedTileId ] = stackedTile;
         d->m_cacheLock.unlock();
         return stackedTile;
     }
@@ -150,52 +350,130 @@ const StackedTile* StackedTileLoader::loadTile( TileId const & stackedTileId )
     // tile (valid) has not been found in hash or cache, so load it from disk
     // and place it in the hash from where it will get transferred to the cache
 
-    mDebug() << "load tile from disk:" << stackedTileId;
+    stackedTile = d->loadTileUnlocked( stackedTileId );
 
-    stackedTile = d->m_layerDecorator->loadTile( stackedTileId );
-    Q_ASSERT( stackedTile );
-    stackedTile->setUsed( true );
+    emit tileLoaded( stackedTileId );
 
-    d->m_tilesOnDisplay[ stackedTileId ] = stackedTile;
+    return stackedTile;
+}
+
+const StackedTile* StackedTileLoader::loadTileOrParent( TileId const &stackedTileId, int &deltaLevel )
+{
+    deltaLevel = 0;
+
+    // check if the tile is in the hash
+    d->m_cacheLock.lockForRead();
+    StackedTile * stackedTile = d->m_tilesOnDisplay.value( stackedTileId, 0 );
     d->m_cacheLock.unlock();
+    if ( stackedTile ) {
+        stackedTile->setUsed( true );
+        return stackedTile;
+    }
+
+    d->m_cacheLock.lockForWrite();
+
+    stackedTile = d->takeLoadedTile( stackedTileId );
+    while ( !stackedTile && d->m_tilesLoading.contains( stackedTileId ) ) {
+        // Another thread is reading the tile from disk. Rather than waiting
+        // for it, continue with the closest lower level tile held in memory.
+        for ( int level = stackedTileId.zoomLevel() - 1; level >= 0; --level ) {
+            const int delta = stackedTileId.zoomLevel() - level;
+            const TileId parentId( 0, level, stackedTileId.x() >> delta, stackedTileId.y() >> delta );
+            StackedTile *const parentTile = d->takeLoadedTile( parentId );
+            if ( parentTile ) {
+                d->m_parentTilesUsed = true;
+                d->m_cacheLock.unlock();
+                deltaLevel = delta;
+                return parentTile;
+            }
+        }
+
+        // no parent tile in memory either, so wait for the other thread
+        d->m_tileLoadingFinished.wait( &d->m_cacheLock );
+        stackedTile = d->takeLoadedTile( stackedTileId );
+    }
+
+    if ( stackedTile ) {
+        d->m_cacheLock.unlock();
+        return stackedTile;
+    }
+
+    stackedTile = d->loadTileUnlocked( stackedTileId );
 
     emit tileLoaded( stackedTileId );
 
     return stackedTile;
 }
 
+bool StackedTileLoader::parentTilesUsed() const
+{
+    QReadLocker locker( &d->m_cacheLock );
+    return d->m_parentTilesUsed;
+}
+
 quint64 StackedTileLoader::volatileCacheLimit() const
 {
+    QReadLocker locker( &d->m_cacheLock );
     return d->m_tileCache.maxCost() / 1024;
 }
 
 QList<TileId> StackedTileLoader::visibleTiles() const
 {
+    QReadLocker locker( &d->m_cacheLock );
     return d->m_tilesOnDisplay.keys();
 }
 
 int StackedTileLoader::tileCount() const
 {
+    QReadLocker locker( &d->m_cacheLock );
     return d->m_tileCache.count() + d->m_tilesOnDisplay.count();
 }
 
 void StackedTileLoader::setVolatileCacheLimit( quint64 kiloBytes )
 {
     mDebug() << QString("Setting tile cache to %1 kilobytes.").arg( kiloBytes );
+    QWriteLocker locker( &d->m_cacheLock );
     d->m_tileCache.setMaxCost( kiloBytes * 1024 );
 }
 
+void StackedTileLoader::setCacheStatistics( CacheStatistics *statistics )
+{
+    QWriteLocker locker( &d->m_cacheLock );
+    d->m_statistics = statistics;
+}
+
+TileCacheEncoding StackedTileLoader::volatileCacheEncoding() const
+{
+    QReadLocker locker( &d->m_cacheLock );
+    return d->m_cacheEncoding;
+}
+
+void StackedTileLoader::setVolatileCacheEncoding( TileCacheEncoding encoding )
+{
+    QWriteLocker locker( &d->m_cacheLock );
+    // tiles already in the cache keep their encoding until they are displayed again
+    d->m_cacheEncoding = encoding;
+}
+
 void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImage )
 {
     const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
 
+    d->m_layerDecorator->removeDecodedTile( stackedTileId );
+
+    // keep the prefetching thread from loading the tile meanwhile
+    d->m_cacheLock.lockForWrite();
+
     StackedTile * displayedTile = d->m_tilesOnDisplay.take( stackedTileId );
     if ( displayedTile ) {
         Q_ASSERT( !d->m_tileCache.contains( stackedTileId ) );
 
+        d->m_decoratorMutex.lock();
         StackedTile *const stackedTile = d->m_layerDecorator->updateTile( *displayedTile, tileId, tileImage );
+        d->m_decoratorMutex.unlock();
         stackedTile->setUsed( true );
         d->m_tilesOnDisplay.insert( stackedTileId, stackedTile );
+        d->m_cacheLock.unlock();
 
         delete displayedTile;
         displayedTile = 0;
@@ -203,11 +481,16 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
         emit tileLoaded( stackedTileId );
     } else {
         d->m_tileCache.remove( stackedTileId );
+        if ( d->m_statistics ) {
+            d->m_statistics->setByteCount( CacheStatistics::VolatileTileCache, d->m_tileCache.totalCost() );
+        }
+        d->m_cacheLock.unlock();
     }
 }
 
 RenderState StackedTileLoader::renderState() const
 {
+    QReadLocker locker( &d->m_cacheLock );
     RenderState renderState( "Stacked Tiles" );
     QHash<TileId, StackedTile*>::const_iterator it = d->m_tilesOnDisplay.constBegin();
     QHash<TileId, StackedTile*>::const_iterator const end = d->m_tilesOnDisplay.constEnd();
@@ -217,13 +500,44 @@ RenderState StackedTileLoader::renderState() const
     return renderState;
 }
 
+void StackedTileLoader::prefetchTiles( const QList<TileId> &stackedTileIds )
+{
+    QWriteLocker locker( &d->m_cacheLock );
+
+    d->m_prefetchQueue = stackedTileIds;
+    if ( !d->m_prefetchRunning && !d->m_prefetchQueue.isEmpty() ) {
+        d->m_prefetchRunning = true;
+        d->m_prefetchPool.start( new PrefetchJob( d ) );
+    }
+}
+
+void StackedTileLoader::cancelPrefetch()
+{
+    QWriteLocker locker( &d->m_cacheLock );
+
+    d->m_prefetchQueue.clear();
+    ++d->m_prefetchGeneration;
+}
+
+QMutex *StackedTileLoader::decoratorMutex()
+{
+    return &d->m_decoratorMutex;
+}
+
 void StackedTileLoader::clear()
 {
     mDebug() << Q_FUNC_INFO;
 
+    cancelPrefetch();
+
+    d->m_cacheLock.lockForWrite();
     qDeleteAll( d->m_tilesOnDisplay );
     d->m_tilesOnDisplay.clear();
     d->m_tileCache.clear(); // clear the tile cache in physical memory
+    if ( d->m_statistics ) {
+        d->m_statistics->setByteCount( CacheStatistics::VolatileTileCache, 0 );
+    }
+    d->m_cacheLock.unlock();
 
     emit cleared();
 }
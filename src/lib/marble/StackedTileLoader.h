@@ -29,15 +29,18 @@
 #include <QSize>
 
 #include "GeoSceneTiled.h"
+#include "MarbleGlobal.h"
 #include "TileId.h"
 #include "RenderState.h"
 
 class QImage;
+class QMutex;
 class QString;
 
 namespace Marble
 {
 
+class CacheStatistics;
 class MergedLayerDecorator;
 class StackedTile;
 
@@ -86,6 +89,26 @@ class StackedTileLoader : public QObject
          */
         const StackedTile* loadTile( TileId const &stackedTileId );
 
+        /**
+         * Loads a tile and returns it, unless the tile is currently being
+         * loaded from disk by another thread. In that case, rather than
+         * blocking, the closest lower level tile which is held in memory
+         * is returned and @p deltaLevel is set to the level difference.
+         *
+         * @param stackedTileId The Id of the requested tile, containing the x and y coordinate
+         *                      and the zoom level.
+         * @param deltaLevel    Set to 0 if the requested tile is returned, or to the number
+         *                      of levels the returned parent tile is below the requested one.
+         */
+        const StackedTile* loadTileOrParent( TileId const &stackedTileId, int &deltaLevel );
+
+        /**
+         * Returns whether loadTileOrParent() had to hand out parent tiles
+         * since the last call of resetTilehash(). In that case, another
+         * repaint is needed in order to display the real tiles.
+         */
+        bool parentTilesUsed() const;
+
         /**
          * Resets the internal tile hash.
          */
@@ -121,6 +144,49 @@ class StackedTileLoader : public QObject
          */
         void setVolatileCacheLimit( quint64 kiloBytes );
 
+        /**
+         * @brief Returns how tiles which are not displayed are kept in the volatile cache.
+         */
+        TileCacheEncoding volatileCacheEncoding() const;
+
+        /**
+         * @brief Set how tiles which are not displayed are kept in the volatile cache.
+         *
+         * A compact encoding lets more tiles fit into the volatile cache limit,
+         * at the cost of encoding tiles which disappear from the screen and
+         * decoding them when they are displayed again. The default is
+         * UncompressedTiles.
+         */
+        void setVolatileCacheEncoding( TileCacheEncoding encoding );
+
+        /**
+         * @brief Set the statistics which hits, misses and evictions are reported to.
+         */
+        void setCacheStatistics( CacheStatistics *statistics );
+
+        /**
+         * Loads the given tiles into the cache in a background thread, unless
+         * they are in memory already. Replaces the tiles of the previous call
+         * which have not been loaded yet.
+         *
+         * Only tiles whose texture tiles are available on disk should be
+         * prefetched, since missing ones would trigger regular downloads.
+         */
+        void prefetchTiles( const QList<TileId> &stackedTileIds );
+
+        /**
+         * Drops the tiles queued by prefetchTiles(). Does not wait for the tile
+         * which is currently being prefetched, it is discarded once loaded.
+         */
+        void cancelPrefetch();
+
+        /**
+         * Returns the mutex the prefetching thread holds while it loads a tile
+         * from the MergedLayerDecorator. It must be locked while changing the
+         * MergedLayerDecorator.
+         */
+        QMutex *decoratorMutex();
+
         /**
          * Effectively triggers a reload of all tiles that are currently in use
          * and clears the tile cache in physical memory.
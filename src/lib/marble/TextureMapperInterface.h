@@ -12,6 +12,8 @@
 #ifndef MARBLE_TEXTUREMAPPERINTERFACE_H
 #define MARBLE_TEXTUREMAPPERINTERFACE_H
 
+#include <QString>
+
 class QRect;
 
 namespace Marble
@@ -38,6 +40,18 @@ public:
 
     void setRepaintNeeded();
 
+    /**
+     * Notifies the texture mapper that the center of the viewport changed
+     * since the last call of mapTexture(). By default, this requests a full repaint.
+     */
+    virtual void setCenterChanged();
+
+    /**
+     * Returns statistics about the last call of mapTexture() for display
+     * in the runtime trace, or an empty string.
+     */
+    virtual QString runtimeTrace() const;
+
 protected:
     bool m_repaintNeeded;
 };
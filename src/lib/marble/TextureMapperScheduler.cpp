@@ -0,0 +1,175 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "TextureMapperScheduler.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QRunnable>
+
+namespace Marble
+{
+
+// Number of scanlines rendered at once. Kept even so that interlaced
+// rendering in low quality mode copies the same lines as without bands.
+static const int bandHeight = 16;
+
+class TextureMapperScheduler::Worker : public QRunnable
+{
+ public:
+    Worker( TextureMapperScheduler *scheduler, int index );
+
+    virtual void run();
+
+ private:
+    TextureMapperScheduler *const m_scheduler;
+    const int m_index;
+};
+
+TextureMapperScheduler::Worker::Worker( TextureMapperScheduler *scheduler, int index )
+    : m_scheduler( scheduler ),
+      m_index( index )
+{
+}
+
+void TextureMapperScheduler::Worker::run()
+{
+    QElapsedTimer timer;
+    qint64 busyTime = 0;
+
+    Band band;
+    while ( m_scheduler->takeBand( m_index, band ) ) {
+        timer.start();
+        band.job->renderLines( band.yTop, band.yBottom );
+        busyTime += timer.nsecsElapsed();
+    }
+
+    // only written by this worker, read after all workers are done
+    m_scheduler->m_busyTime[m_index] = busyTime;
+}
+
+TextureMapperScheduler::Job::~Job()
+{
+}
+
+TextureMapperScheduler::TextureMapperScheduler()
+    : m_stolenBandCount( 0 ),
+      m_utilization( 1.0 ),
+      m_workerCount( 0 ),
+      m_lastStolenBandCount( 0 )
+{
+}
+
+TextureMapperScheduler::~TextureMapperScheduler()
+{
+    m_threadPool.waitForDone();
+    qDeleteAll( m_jobs );
+}
+
+void TextureMapperScheduler::schedule( Job *job, int yTop, int yBottom )
+{
+    m_jobs << job;
+
+    for ( int y = yTop; y < yBottom; y += bandHeight ) {
+        const Band band = { job, y, qMin( y + bandHeight, yBottom ) };
+        m_bands << band;
+    }
+}
+
+void TextureMapperScheduler::run()
+{
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    const int bandCount = m_bands.size();
+    const int workerCount = qMin( m_threadPool.maxThreadCount(), bandCount );
+
+    m_bandBegin.resize( workerCount );
+    m_bandEnd.resize( workerCount );
+    m_busyTime.fill( 0, workerCount );
+    m_stolenBandCount = 0;
+
+    // Start with contiguous shares, neighboring bands likely use the same tiles.
+    for ( int i = 0; i < workerCount; ++i ) {
+        m_bandBegin[i] = i * bandCount / workerCount;
+        m_bandEnd[i] = ( i + 1 ) * bandCount / workerCount;
+    }
+
+    for ( int i = 0; i < workerCount; ++i ) {
+        m_threadPool.start( new Worker( this, i ) );
+    }
+
+    m_threadPool.waitForDone();
+
+    const qint64 frameTime = frameTimer.nsecsElapsed();
+    qint64 busyTime = 0;
+    for ( int i = 0; i < workerCount; ++i ) {
+        busyTime += m_busyTime[i];
+    }
+
+    m_workerCount = workerCount;
+    m_utilization = ( workerCount > 0 && frameTime > 0 ) ? qMin<qreal>( 1.0, qreal( busyTime ) / ( workerCount * frameTime ) )
+                                                         : 1.0;
+    m_lastStolenBandCount = m_stolenBandCount;
+
+    qDeleteAll( m_jobs );
+    m_jobs.clear();
+    m_bands.clear();
+}
+
+qreal TextureMapperScheduler::utilization() const
+{
+    return m_utilization;
+}
+
+int TextureMapperScheduler::stolenBandCount() const
+{
+    return m_lastStolenBandCount;
+}
+
+QString TextureMapperScheduler::runtimeTrace() const
+{
+    return QString( "Mapping Threads: %1 Utilization: %2% Stolen: %3" )
+            .arg( m_workerCount )
+            .arg( qRound( 100 * m_utilization ) )
+            .arg( m_lastStolenBandCount );
+}
+
+bool TextureMapperScheduler::takeBand( int workerIndex, Band &band )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( m_bandBegin[workerIndex] < m_bandEnd[workerIndex] ) {
+        band = m_bands[m_bandBegin[workerIndex]++];
+        return true;
+    }
+
+    // Steal from the end of the largest remaining share, away from where its owner works.
+    int victim = -1;
+    int victimRemaining = 0;
+    for ( int i = 0; i < m_bandBegin.size(); ++i ) {
+        const int remaining = m_bandEnd[i] - m_bandBegin[i];
+        if ( remaining > victimRemaining ) {
+            victim = i;
+            victimRemaining = remaining;
+        }
+    }
+
+    if ( victim < 0 ) {
+        return false;
+    }
+
+    band = m_bands[--m_bandEnd[victim]];
+    ++m_stolenBandCount;
+
+    return true;
+}
+
+}
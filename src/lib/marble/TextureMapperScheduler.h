@@ -0,0 +1,112 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_TEXTUREMAPPERSCHEDULER_H
+#define MARBLE_TEXTUREMAPPERSCHEDULER_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short Distributes the scanlines of a frame among the threads of a texture mapper
+ *
+ * The scanlines to be rendered are split into small bands. Each thread starts
+ * with an equal, contiguous share of the bands. A thread which has finished
+ * its share steals bands from the end of the share of the thread with the
+ * most remaining work, so that threads rendering expensive parts of the
+ * map (e.g. tiles which need to be loaded first) don't delay the frame.
+ */
+class MARBLE_EXPORT TextureMapperScheduler
+{
+ public:
+    /**
+     * A part of the frame, rendered band by band.
+     */
+    class MARBLE_EXPORT Job
+    {
+     public:
+        virtual ~Job();
+
+        /**
+         * Renders the scanlines from @p yTop to @p yBottom (exclusive).
+         * This method is called concurrently for disjoint bands.
+         */
+        virtual void renderLines( int yTop, int yBottom ) = 0;
+    };
+
+    TextureMapperScheduler();
+    ~TextureMapperScheduler();
+
+    /**
+     * Schedules the scanlines from @p yTop to @p yBottom (exclusive) of @p job
+     * for rendering by the next call of run(). Takes ownership of @p job.
+     */
+    void schedule( Job *job, int yTop, int yBottom );
+
+    /**
+     * Renders all scheduled jobs and returns when they are finished.
+     */
+    void run();
+
+    /**
+     * Returns the fraction of the time the threads were busy rendering
+     * during the last call of run(), between 0 and 1.
+     */
+    qreal utilization() const;
+
+    /**
+     * Returns the number of bands which were stolen from other threads
+     * during the last call of run().
+     */
+    int stolenBandCount() const;
+
+    QString runtimeTrace() const;
+
+ private:
+    Q_DISABLE_COPY( TextureMapperScheduler )
+
+    class Worker;
+
+    struct Band
+    {
+        Job *job;
+        int yTop;
+        int yBottom;
+    };
+
+    bool takeBand( int workerIndex, Band &band );
+
+    QThreadPool m_threadPool;
+    QList<Job *> m_jobs;
+    QVector<Band> m_bands;
+
+    QMutex m_mutex;
+    // remaining bands of each worker: [begin, end) in m_bands
+    QVector<int> m_bandBegin;
+    QVector<int> m_bandEnd;
+    int m_stolenBandCount;
+
+    QVector<qint64> m_busyTime;
+    qreal m_utilization;
+    int m_workerCount;
+    int m_lastStolenBandCount;
+};
+
+}
+
+#endif
@@ -0,0 +1,719 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "TileArchive.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+
+namespace Marble
+{
+
+// The archive starts with a header, followed by the records of the tiles:
+//
+//   quint32 recordMagic
+//   quint8  flags
+//   quint32 size of name, name in UTF-8
+//   qint64  last modification in msecs since epoch
+//   quint32 size of data, data
+//
+// Removing a tile only sets the Removed flag of its record.
+static const quint32 archiveMagic = 0x4d415243;
+static const quint32 indexMagic = 0x4d415249;
+static const quint32 recordMagic = 0x54494c45;
+static const quint32 archiveVersion = 1;
+static const qint64 archiveHeaderSize = 8;
+
+// size of a record without name and data
+static const qint64 recordHeaderSize = 4 + 1 + 4 + 8 + 4;
+
+// upper limit of name sizes, anything larger indicates a corrupt record
+static const quint32 maximumNameSize = 4096;
+
+// compacting smaller archives is not worth the effort
+static const qint64 minimumCompactionSize = 4 * 1024 * 1024;
+
+enum RecordFlag {
+    Removed = 0x1,
+    Pinned = 0x2
+};
+
+static bool writeRecord( QIODevice *device, const QByteArray &name, const QByteArray &data,
+                         qint64 lastModified, quint8 flags )
+{
+    QDataStream stream( device );
+    stream.setVersion( QDataStream::Qt_4_7 );
+    stream << recordMagic << flags;
+    stream << quint32( name.size() );
+    stream.writeRawData( name.constData(), name.size() );
+    stream << lastModified;
+    stream << quint32( data.size() );
+    stream.writeRawData( data.constData(), data.size() );
+
+    return stream.status() == QDataStream::Ok;
+}
+
+// Copies a record from @p source to the end of @p target and returns the
+// offset of the copy, or -1 on failure.
+static qint64 copyRecord( QIODevice *source, QIODevice *target, const QString &name,
+                          qint64 dataOffset, quint32 dataSize, qint64 lastModified, bool pinned )
+{
+    if ( !source->seek( dataOffset ) ) {
+        return -1;
+    }
+
+    const QByteArray data = source->read( dataSize );
+    const qint64 offset = target->pos();
+    if ( data.size() != int( dataSize ) || !writeRecord( target, name.toUtf8(), data, lastModified, pinned ? Pinned : 0 ) ) {
+        return -1;
+    }
+
+    return offset;
+}
+
+class TileArchive::CompactJob : public QRunnable
+{
+ public:
+    explicit CompactJob( TileArchive *archive )
+        : m_archive( archive )
+    {
+    }
+
+    virtual void run()
+    {
+        m_archive->compact();
+
+        QMutexLocker locker( &m_archive->m_mutex );
+        m_archive->m_compactionPending = false;
+    }
+
+ private:
+    TileArchive *const m_archive;
+};
+
+namespace {
+
+class CacheArchiveHolder
+{
+ public:
+    CacheArchiveHolder()
+        : archive( QFile::exists( TileArchive::defaultFileName() ) ? new TileArchive( TileArchive::defaultFileName() ) : 0 )
+    {
+    }
+
+    ~CacheArchiveHolder()
+    {
+        delete archive;
+    }
+
+    TileArchive *const archive;
+};
+
+}
+
+TileArchive::Entry::Entry()
+    : recordOffset( 0 ),
+      dataOffset( 0 ),
+      dataSize( 0 ),
+      lastModified( 0 ),
+      pinned( false ),
+      accessStamp( 0 )
+{
+}
+
+qint64 TileArchive::Entry::recordSize() const
+{
+    return dataOffset - recordOffset + dataSize;
+}
+
+TileArchive::TileArchive( const QString &fileName )
+    : m_file( fileName ),
+      m_accessCounter( 0 ),
+      m_liveBytes( 0 ),
+      m_deadBytes( 0 ),
+      m_cacheLimit( 0 ),
+      m_compactionPending( false )
+{
+    m_compactionPool.setMaxThreadCount( 1 );
+    open();
+}
+
+TileArchive::~TileArchive()
+{
+    m_compactionPool.waitForDone();
+
+    if ( m_file.isOpen() ) {
+        m_file.flush();
+        writeIndex();
+        m_file.close();
+    }
+}
+
+bool TileArchive::isOpen() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_file.isOpen();
+}
+
+QString TileArchive::fileName() const
+{
+    return m_file.fileName();
+}
+
+QString TileArchive::errorString() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_errorString;
+}
+
+QString TileArchive::defaultFileName()
+{
+    return MarbleDirs::localPath() + "/cache/tiles.archive";
+}
+
+TileArchive *TileArchive::cacheArchive()
+{
+    static CacheArchiveHolder holder;
+    return holder.archive;
+}
+
+bool TileArchive::contains( const QString &name ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_entries.contains( name );
+}
+
+QDateTime TileArchive::lastModified( const QString &name ) const
+{
+    QMutexLocker locker( &m_mutex );
+
+    QHash<QString, Entry>::const_iterator const it = m_entries.constFind( name );
+    if ( it == m_entries.constEnd() ) {
+        return QDateTime();
+    }
+
+    return QDateTime::fromMSecsSinceEpoch( it->lastModified );
+}
+
+QByteArray TileArchive::data( const QString &name )
+{
+    QMutexLocker locker( &m_mutex );
+
+    QHash<QString, Entry>::iterator const it = m_entries.find( name );
+    if ( it == m_entries.end() ) {
+        return QByteArray();
+    }
+
+    if ( !m_file.seek( it->dataOffset ) ) {
+        m_errorString = m_file.errorString();
+        return QByteArray();
+    }
+
+    const QByteArray data = m_file.read( it->dataSize );
+    if ( data.size() != int( it->dataSize ) ) {
+        mDebug() << Q_FUNC_INFO << "truncated record of" << name << "in" << m_file.fileName();
+        return QByteArray();
+    }
+
+    touch( name, *it );
+
+    return data;
+}
+
+bool TileArchive::insert( const QString &name, const QByteArray &data, const QDateTime &lastModified, bool pinned )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( !m_file.isOpen() ) {
+        return false;
+    }
+
+    if ( m_entries.contains( name ) ) {
+        removeEntry( name );
+    }
+
+    Entry entry;
+    if ( !appendRecord( name, data, lastModified.toMSecsSinceEpoch(), pinned, entry ) ) {
+        return false;
+    }
+
+    m_liveBytes += entry.recordSize();
+    QHash<QString, Entry>::iterator const it = m_entries.insert( name, entry );
+    touch( name, *it );
+
+    evict();
+
+    if ( m_deadBytes > m_liveBytes && m_deadBytes > minimumCompactionSize && !m_compactionPending ) {
+        // rewriting the archive takes long, so it is not done by the threads storing tiles
+        m_compactionPending = true;
+        m_compactionPool.start( new CompactJob( this ) );
+    }
+
+    return true;
+}
+
+bool TileArchive::remove( const QString &name )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( !m_entries.contains( name ) ) {
+        return false;
+    }
+
+    removeEntry( name );
+    return true;
+}
+
+void TileArchive::clearUnpinned()
+{
+    {
+        QMutexLocker locker( &m_mutex );
+
+        while ( !m_usage.isEmpty() ) {
+            removeEntry( m_usage.begin().value() );
+        }
+    }
+
+    compact();
+}
+
+QStringList TileArchive::names() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_entries.keys();
+}
+
+int TileArchive::count() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_entries.count();
+}
+
+qint64 TileArchive::size() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_liveBytes;
+}
+
+void TileArchive::setCacheLimit( quint64 bytes )
+{
+    QMutexLocker locker( &m_mutex );
+    m_cacheLimit = bytes;
+    evict();
+}
+
+quint64 TileArchive::cacheLimit() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_cacheLimit;
+}
+
+bool TileArchive::compact()
+{
+    QMutexLocker compactionLocker( &m_compactionMutex );
+
+    const QString fileName = m_file.fileName();
+    QHash<QString, Entry> snapshot;
+
+    {
+        QMutexLocker locker( &m_mutex );
+
+        if ( !m_file.isOpen() ) {
+            return false;
+        }
+
+        if ( m_deadBytes == 0 ) {
+            return true;
+        }
+
+        mDebug() << Q_FUNC_INFO << "reclaiming" << m_deadBytes << "bytes of" << fileName;
+        m_file.flush();
+        snapshot = m_entries;
+    }
+
+    QFile source( fileName );
+    QFile compacted( fileName + ".compact" );
+    if ( !source.open( QIODevice::ReadOnly ) || !compacted.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        QMutexLocker locker( &m_mutex );
+        m_errorString = source.isOpen() ? compacted.errorString() : source.errorString();
+        return false;
+    }
+
+    QDataStream stream( &compacted );
+    stream.setVersion( QDataStream::Qt_4_7 );
+    stream << archiveMagic << archiveVersion;
+    bool ok = stream.status() == QDataStream::Ok;
+
+    // Records are never changed once written except for their flags, so the
+    // tiles of the snapshot are copied while the archive is in use. The copies
+    // are keyed by the offsets of the original records.
+    QHash<qint64, Entry> copies;
+    QHash<QString, Entry>::const_iterator it = snapshot.constBegin();
+    QHash<QString, Entry>::const_iterator end = snapshot.constEnd();
+    for (; ok && it != end; ++it ) {
+        Entry copy = *it;
+        copy.recordOffset = copyRecord( &source, &compacted, it.key(), it->dataOffset, it->dataSize, it->lastModified, it->pinned );
+        copy.dataOffset = copy.recordOffset + ( it->dataOffset - it->recordOffset );
+        ok = copy.recordOffset >= 0;
+        copies.insert( it->recordOffset, copy );
+    }
+    source.close();
+
+    QMutexLocker locker( &m_mutex );
+
+    // catch up with the tiles inserted and removed since the snapshot
+    QHash<QString, Entry> entries;
+    it = m_entries.constBegin();
+    end = m_entries.constEnd();
+    for (; ok && it != end; ++it ) {
+        Entry entry = *it;
+        if ( copies.contains( it->recordOffset ) ) {
+            const Entry copy = copies.take( it->recordOffset );
+            entry.recordOffset = copy.recordOffset;
+        }
+        else {
+            entry.recordOffset = copyRecord( &m_file, &compacted, it.key(), it->dataOffset, it->dataSize, it->lastModified, it->pinned );
+            ok = entry.recordOffset >= 0;
+        }
+        entry.dataOffset = entry.recordOffset + ( it->dataOffset - it->recordOffset );
+        entries.insert( it.key(), entry );
+    }
+
+    qint64 deadBytes = 0;
+    const char removedFlags = Removed;
+    foreach ( const Entry &copy, copies ) {
+        ok = ok && compacted.seek( copy.recordOffset + 4 ) && compacted.write( &removedFlags, 1 ) == 1;
+        deadBytes += copy.recordSize();
+    }
+
+    compacted.close();
+
+    if ( !ok ) {
+        m_errorString = QString( "%1: %2" ).arg( compacted.fileName() ).arg( compacted.errorString() );
+        mDebug() << Q_FUNC_INFO << m_errorString;
+        compacted.remove();
+        return false;
+    }
+
+    // The archive is only removed once the compacted one replaced it, a
+    // crash in between leaves it under the backup name, see open().
+    const QString backupName = fileName + ".old";
+    m_file.close();
+    QFile::remove( backupName );
+    if ( !QFile::rename( fileName, backupName ) ) {
+        m_errorString = QString( "%1: cannot replace the archive" ).arg( fileName );
+        mDebug() << Q_FUNC_INFO << m_errorString;
+        compacted.remove();
+        m_file.open( QIODevice::ReadWrite );
+        return false;
+    }
+
+    if ( !compacted.rename( fileName ) || !m_file.open( QIODevice::ReadWrite ) ) {
+        m_errorString = QString( "%1: %2" ).arg( fileName ).arg( compacted.errorString() );
+        mDebug() << Q_FUNC_INFO << m_errorString;
+        compacted.remove();
+        QFile::rename( backupName, fileName );
+        m_file.open( QIODevice::ReadWrite );
+        return false;
+    }
+
+    QFile::remove( backupName );
+
+    m_entries = entries;
+    m_deadBytes = deadBytes;
+
+    return true;
+}
+
+bool TileArchive::flush()
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( !m_file.isOpen() ) {
+        return false;
+    }
+
+    m_file.flush();
+    return writeIndex();
+}
+
+bool TileArchive::open()
+{
+    const QFileInfo info( m_file.fileName() );
+    if ( !info.dir().exists() ) {
+        QDir::root().mkpath( info.absolutePath() );
+    }
+
+    // compact() was interrupted while replacing the archive
+    const QString backupName = m_file.fileName() + ".old";
+    if ( !info.exists() && QFile::exists( backupName ) ) {
+        QFile::rename( backupName, m_file.fileName() );
+    }
+
+    if ( !m_file.open( QIODevice::ReadWrite ) ) {
+        m_errorString = m_file.errorString();
+        mDebug() << Q_FUNC_INFO << m_file.fileName() << m_errorString;
+        return false;
+    }
+
+    QDataStream stream( &m_file );
+    stream.setVersion( QDataStream::Qt_4_7 );
+
+    if ( m_file.size() == 0 ) {
+        stream << archiveMagic << archiveVersion;
+        return stream.status() == QDataStream::Ok;
+    }
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if ( magic != archiveMagic || version != archiveVersion ) {
+        m_errorString = QString( "%1: not a tile archive" ).arg( m_file.fileName() );
+        mDebug() << Q_FUNC_INFO << m_errorString;
+        m_file.close();
+        return false;
+    }
+
+    if ( !loadIndex() ) {
+        mDebug() << Q_FUNC_INFO << "rebuilding the index of" << m_file.fileName();
+        scanRecords();
+    }
+
+    // A crash leaves no outdated index behind, it is saved again on exit.
+    QFile::remove( indexFileName() );
+
+    return true;
+}
+
+bool TileArchive::loadIndex()
+{
+    QFile indexFile( indexFileName() );
+    if ( !indexFile.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &indexFile );
+    stream.setVersion( QDataStream::Qt_4_7 );
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 archiveSize = 0;
+    qint64 deadBytes = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> archiveSize >> deadBytes >> count;
+    if ( magic != indexMagic || version != archiveVersion || archiveSize != m_file.size() ) {
+        return false;
+    }
+
+    // the entries are stored least recently used first
+    for ( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+        QByteArray name;
+        Entry entry;
+        stream >> name >> entry.recordOffset >> entry.dataSize >> entry.lastModified >> entry.pinned;
+        entry.dataOffset = entry.recordOffset + recordHeaderSize + name.size();
+
+        if ( entry.recordOffset < archiveHeaderSize || entry.dataOffset + entry.dataSize > archiveSize ) {
+            break;
+        }
+
+        const QString key = QString::fromUtf8( name );
+        m_liveBytes += entry.recordSize();
+        QHash<QString, Entry>::iterator const it = m_entries.insert( key, entry );
+        touch( key, *it );
+    }
+
+    if ( stream.status() != QDataStream::Ok || m_entries.count() != int( count ) ) {
+        m_entries.clear();
+        m_usage.clear();
+        m_liveBytes = 0;
+        return false;
+    }
+
+    m_deadBytes = deadBytes;
+
+    return true;
+}
+
+bool TileArchive::scanRecords()
+{
+    m_entries.clear();
+    m_usage.clear();
+    m_liveBytes = 0;
+    m_deadBytes = 0;
+
+    const qint64 archiveSize = m_file.size();
+    qint64 offset = archiveHeaderSize;
+
+    QDataStream stream( &m_file );
+    stream.setVersion( QDataStream::Qt_4_7 );
+
+    while ( offset < archiveSize ) {
+        if ( !m_file.seek( offset ) ) {
+            break;
+        }
+
+        quint32 magic = 0;
+        quint8 flags = 0;
+        quint32 nameSize = 0;
+        stream >> magic >> flags >> nameSize;
+        if ( stream.status() != QDataStream::Ok || magic != recordMagic || nameSize > maximumNameSize ) {
+            break;
+        }
+
+        QByteArray name( nameSize, 0 );
+        stream.readRawData( name.data(), nameSize );
+
+        Entry entry;
+        stream >> entry.lastModified >> entry.dataSize;
+        if ( stream.status() != QDataStream::Ok ) {
+            break;
+        }
+
+        entry.recordOffset = offset;
+        entry.dataOffset = offset + recordHeaderSize + nameSize;
+        entry.pinned = flags & Pinned;
+        if ( entry.dataOffset + entry.dataSize > archiveSize ) {
+            break;
+        }
+
+        offset = entry.dataOffset + entry.dataSize;
+
+        const QString key = QString::fromUtf8( name );
+        if ( flags & Removed ) {
+            m_deadBytes += entry.recordSize();
+            continue;
+        }
+
+        if ( m_entries.contains( key ) ) {
+            // the record was written again before the old one was marked as removed
+            removeEntry( key );
+        }
+
+        m_liveBytes += entry.recordSize();
+        QHash<QString, Entry>::iterator const it = m_entries.insert( key, entry );
+        touch( key, *it );
+    }
+
+    if ( offset < archiveSize ) {
+        mDebug() << Q_FUNC_INFO << "discarding a corrupt record at" << offset << "of" << m_file.fileName();
+        m_file.resize( offset );
+        return false;
+    }
+
+    return true;
+}
+
+bool TileArchive::writeIndex()
+{
+    QFile indexFile( indexFileName() );
+    if ( !indexFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        m_errorString = indexFile.errorString();
+        return false;
+    }
+
+    QDataStream stream( &indexFile );
+    stream.setVersion( QDataStream::Qt_4_7 );
+    stream << indexMagic << archiveVersion << m_file.size() << m_deadBytes << quint32( m_entries.count() );
+
+    // pinned tiles are never used least recently
+    QHash<QString, Entry>::const_iterator it = m_entries.constBegin();
+    QHash<QString, Entry>::const_iterator const end = m_entries.constEnd();
+    for (; it != end; ++it ) {
+        if ( it->pinned ) {
+            stream << it.key().toUtf8() << it->recordOffset << it->dataSize << it->lastModified << it->pinned;
+        }
+    }
+
+    foreach ( const QString &name, m_usage ) {
+        const Entry &entry = m_entries[name];
+        stream << name.toUtf8() << entry.recordOffset << entry.dataSize << entry.lastModified << entry.pinned;
+    }
+
+    if ( stream.status() != QDataStream::Ok ) {
+        indexFile.remove();
+        return false;
+    }
+
+    return true;
+}
+
+bool TileArchive::appendRecord( const QString &name, const QByteArray &data, qint64 lastModified, bool pinned, Entry &entry )
+{
+    const QByteArray utf8Name = name.toUtf8();
+    const qint64 offset = m_file.size();
+
+    if ( !m_file.seek( offset ) || !writeRecord( &m_file, utf8Name, data, lastModified, pinned ? Pinned : 0 ) ) {
+        m_errorString = QString( "%1: %2" ).arg( m_file.fileName() ).arg( m_file.errorString() );
+        mDebug() << Q_FUNC_INFO << m_errorString;
+        m_file.resize( offset );
+        return false;
+    }
+
+    entry.recordOffset = offset;
+    entry.dataOffset = offset + recordHeaderSize + utf8Name.size();
+    entry.dataSize = data.size();
+    entry.lastModified = lastModified;
+    entry.pinned = pinned;
+
+    return true;
+}
+
+void TileArchive::removeEntry( const QString &name )
+{
+    const Entry entry = m_entries.take( name );
+    if ( !entry.pinned ) {
+        m_usage.remove( entry.accessStamp );
+    }
+
+    m_liveBytes -= entry.recordSize();
+    m_deadBytes += entry.recordSize();
+
+    // the flags follow the magic of the record
+    const char flags = Removed | ( entry.pinned ? Pinned : 0 );
+    if ( !m_file.seek( entry.recordOffset + 4 ) || m_file.write( &flags, 1 ) != 1 ) {
+        m_errorString = m_file.errorString();
+        mDebug() << Q_FUNC_INFO << name << m_errorString;
+    }
+}
+
+void TileArchive::touch( const QString &name, Entry &entry )
+{
+    if ( entry.pinned ) {
+        return;
+    }
+
+    m_usage.remove( entry.accessStamp );
+    entry.accessStamp = ++m_accessCounter;
+    m_usage.insert( entry.accessStamp, name );
+}
+
+void TileArchive::evict()
+{
+    if ( m_cacheLimit == 0 ) {
+        return;
+    }
+
+    while ( m_liveBytes > qint64( m_cacheLimit ) && !m_usage.isEmpty() ) {
+        removeEntry( m_usage.begin().value() );
+    }
+}
+
+QString TileArchive::indexFileName() const
+{
+    return m_file.fileName() + ".index";
+}
+
+}
@@ -0,0 +1,187 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_TILEARCHIVE_H
+#define MARBLE_TILEARCHIVE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @short Single file storage for downloaded tiles
+ *
+ * Caching hundreds of thousands of tiles as separate files wastes disk space
+ * and makes looking up, expiring and deleting tiles slow. A tile archive keeps
+ * all tiles in one file instead. Tiles are appended to the file and found
+ * using an index in memory, which is keyed by the relative file name of the
+ * tile (which encodes the source dir, the level and the tile coordinates).
+ *
+ * If a cache limit is set, the least recently used tiles are evicted once the
+ * archive grows beyond it. Pinned tiles, e.g. the base tiles of a map theme,
+ * are never evicted. Space of removed tiles is reclaimed by compact(), which
+ * is started in a worker thread once it makes up more than half of the
+ * archive. Compaction copies the tiles while the archive stays in use, and
+ * the archive is replaced only after the copy was written completely.
+ *
+ * The index is saved next to the archive by flush() and when the archive is
+ * destroyed. If it is missing or outdated, e.g. after a crash, it is rebuilt
+ * from the record headers in the archive.
+ *
+ * This class is thread-safe.
+ */
+class MARBLE_EXPORT TileArchive
+{
+ public:
+    /**
+     * Opens the archive @p fileName, creating it if it does not exist yet.
+     */
+    explicit TileArchive( const QString &fileName );
+    ~TileArchive();
+
+    bool isOpen() const;
+
+    QString fileName() const;
+
+    QString errorString() const;
+
+    /**
+     * Returns the location of the archive used for the tile cache,
+     * which is inside MarbleDirs::localPath().
+     */
+    static QString defaultFileName();
+
+    /**
+     * Returns the archive used for the tile cache, or 0 if the cache
+     * is kept in separate files. The tile cache is stored in an archive
+     * if the file defaultFileName() exists when this method is called first.
+     */
+    static TileArchive *cacheArchive();
+
+    bool contains( const QString &name ) const;
+
+    /**
+     * Returns the time the tile @p name was stored, or an invalid time if
+     * it is not in the archive.
+     */
+    QDateTime lastModified( const QString &name ) const;
+
+    /**
+     * Returns the data of the tile @p name, or an empty byte array if
+     * it is not in the archive.
+     */
+    QByteArray data( const QString &name );
+
+    /**
+     * Stores @p data as the tile @p name, replacing an older version.
+     */
+    bool insert( const QString &name, const QByteArray &data,
+                 const QDateTime &lastModified = QDateTime::currentDateTime(),
+                 bool pinned = false );
+
+    bool remove( const QString &name );
+
+    /**
+     * Removes all tiles which are not pinned.
+     */
+    void clearUnpinned();
+
+    QStringList names() const;
+
+    int count() const;
+
+    /**
+     * Returns the size of the tiles in the archive in bytes, including
+     * the record headers but not the space of removed tiles.
+     */
+    qint64 size() const;
+
+    /**
+     * Sets the size in bytes beyond which least recently used tiles are
+     * evicted. A limit of 0 means no limit, which is the default.
+     */
+    void setCacheLimit( quint64 bytes );
+    quint64 cacheLimit() const;
+
+    /**
+     * Rewrites the archive without the space of removed tiles. The tiles can
+     * be read and stored meanwhile. If compaction fails, the archive is
+     * left unchanged.
+     */
+    bool compact();
+
+    /**
+     * Saves the index.
+     */
+    bool flush();
+
+ private:
+    Q_DISABLE_COPY( TileArchive )
+
+    class CompactJob;
+
+    struct Entry
+    {
+        Entry();
+
+        qint64 recordOffset;
+        qint64 dataOffset;
+        quint32 dataSize;
+        qint64 lastModified;
+        bool pinned;
+        quint64 accessStamp;
+
+        qint64 recordSize() const;
+    };
+
+    bool open();
+    bool loadIndex();
+    bool scanRecords();
+    bool writeIndex();
+    bool appendRecord( const QString &name, const QByteArray &data, qint64 lastModified, bool pinned, Entry &entry );
+    void removeEntry( const QString &name );
+    void touch( const QString &name, Entry &entry );
+    void evict();
+    QString indexFileName() const;
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    QString m_errorString;
+
+    QHash<QString, Entry> m_entries;
+
+    // the names of the tiles which can be evicted, least recently used first
+    QMap<quint64, QString> m_usage;
+    quint64 m_accessCounter;
+
+    qint64 m_liveBytes;
+    qint64 m_deadBytes;
+    quint64 m_cacheLimit;
+
+    // held by compact() for the whole compaction, m_mutex only in between
+    QMutex m_compactionMutex;
+    QThreadPool m_compactionPool;
+    bool m_compactionPending;
+};
+
+}
+
+#endif
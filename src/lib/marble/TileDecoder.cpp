@@ -0,0 +1,175 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "TileDecoder.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include "MarbleDebug.h"
+
+namespace Marble
+{
+
+class TileDecoder::DecodeJob : public QRunnable
+{
+ public:
+    DecodeJob( TileDecoder *decoder, const TileId &tileId, const QByteArray &data );
+
+    virtual void run();
+
+ private:
+    TileDecoder *const m_decoder;
+    const TileId m_tileId;
+    const QByteArray m_data;
+};
+
+TileDecoder::DecodeJob::DecodeJob( TileDecoder *decoder, const TileId &tileId, const QByteArray &data )
+    : m_decoder( decoder ),
+      m_tileId( tileId ),
+      m_data( data )
+{
+}
+
+void TileDecoder::DecodeJob::run()
+{
+    const QImage tileImage = QImage::fromData( m_data );
+    m_decoder->finishJob( m_tileId, tileImage );
+}
+
+TileDecoder::TileDecoder( QObject *parent )
+    : QObject( parent ),
+      m_maximumQueueSize( 256 ),
+      m_activeJobs( 0 ),
+      m_deliveryPending( false )
+{
+    // leave one core to the GUI thread
+    m_threadPool.setMaxThreadCount( qMax( 1, QThread::idealThreadCount() - 1 ) );
+}
+
+TileDecoder::~TileDecoder()
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        m_queue.clear();
+        m_queuedData.clear();
+    }
+
+    m_threadPool.waitForDone();
+}
+
+void TileDecoder::setMaximumQueueSize( int size )
+{
+    QMutexLocker locker( &m_mutex );
+    m_maximumQueueSize = qMax( 1, size );
+}
+
+int TileDecoder::maximumQueueSize() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_maximumQueueSize;
+}
+
+int TileDecoder::pendingCount() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_queue.size() + m_activeJobs;
+}
+
+void TileDecoder::waitForDone()
+{
+    // finished jobs start queued ones, so the pool only runs dry at the end
+    m_threadPool.waitForDone();
+}
+
+void TileDecoder::decode( const TileId &tileId, const QByteArray &data )
+{
+    QMutexLocker locker( &m_mutex );
+
+    if ( m_queuedData.contains( tileId ) ) {
+        // not decoded yet, so decode the newer data only
+        m_queuedData[tileId] = data;
+        return;
+    }
+
+    if ( m_queue.size() >= m_maximumQueueSize ) {
+        // The workers cannot keep up. Rather than dropping downloaded data,
+        // slow the producer down by decoding the tile in its thread.
+        locker.unlock();
+        const QImage tileImage = QImage::fromData( data );
+        locker.relock();
+
+        addDecodedTile( tileId, tileImage );
+        return;
+    }
+
+    m_queue.append( tileId );
+    m_queuedData.insert( tileId, data );
+
+    startJobs();
+}
+
+void TileDecoder::startJobs()
+{
+    // m_mutex is locked
+    while ( m_activeJobs < m_threadPool.maxThreadCount() && !m_queue.isEmpty() ) {
+        const TileId tileId = m_queue.takeFirst();
+        const QByteArray data = m_queuedData.take( tileId );
+
+        ++m_activeJobs;
+        m_threadPool.start( new DecodeJob( this, tileId, data ) );
+    }
+}
+
+void TileDecoder::finishJob( const TileId &tileId, const QImage &tileImage )
+{
+    QMutexLocker locker( &m_mutex );
+
+    --m_activeJobs;
+    addDecodedTile( tileId, tileImage );
+
+    startJobs();
+}
+
+void TileDecoder::addDecodedTile( const TileId &tileId, const QImage &tileImage )
+{
+    // m_mutex is locked
+    if ( tileImage.isNull() ) {
+        mDebug() << Q_FUNC_INFO << "could not decode" << tileId;
+        return;
+    }
+
+    m_decodedTiles.append( qMakePair( tileId, tileImage ) );
+
+    if ( !m_deliveryPending ) {
+        m_deliveryPending = true;
+        QMetaObject::invokeMethod( this, "deliverTiles", Qt::QueuedConnection );
+    }
+}
+
+void TileDecoder::deliverTiles()
+{
+    QList<QPair<TileId, QImage> > decodedTiles;
+
+    {
+        QMutexLocker locker( &m_mutex );
+        decodedTiles.swap( m_decodedTiles );
+        m_deliveryPending = false;
+    }
+
+    for ( int i = 0; i < decodedTiles.size(); ++i ) {
+        emit tileDecoded( decodedTiles[i].first, decodedTiles[i].second );
+    }
+}
+
+}
+
+#include "TileDecoder.moc"
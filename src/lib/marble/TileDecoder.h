@@ -0,0 +1,103 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_TILEDECODER_H
+#define MARBLE_TILEDECODER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QThreadPool>
+
+#include "marble_export.h"
+#include "TileId.h"
+
+namespace Marble
+{
+
+/**
+ * @short Decodes downloaded tile images in worker threads
+ *
+ * Decoding a PNG or JPEG tile takes several milliseconds. Doing so in the
+ * thread receiving the downloads, which is the GUI thread, blocks user input
+ * during bulk downloads. TileDecoder decodes the data in a thread pool and
+ * delivers the results back to its own thread in batches, one event per
+ * batch rather than one per tile.
+ *
+ * Only a few tiles are decoded at the same time. Further tiles wait in a
+ * queue of limited size; if the same tile is queued twice, only the newer
+ * data is decoded. If the queue is full, decode() decodes the tile itself,
+ * which slows the caller down without losing any data.
+ */
+class MARBLE_EXPORT TileDecoder : public QObject
+{
+    Q_OBJECT
+
+ public:
+    explicit TileDecoder( QObject *parent = 0 );
+    ~TileDecoder();
+
+    /**
+     * Sets the maximum number of tiles waiting to be decoded.
+     */
+    void setMaximumQueueSize( int size );
+    int maximumQueueSize() const;
+
+    /**
+     * Returns the number of tiles which are queued or being decoded.
+     */
+    int pendingCount() const;
+
+    /**
+     * Blocks until all queued tiles are decoded. The results are delivered
+     * when control returns to the event loop.
+     */
+    void waitForDone();
+
+ public Q_SLOTS:
+    void decode( const TileId &tileId, const QByteArray &data );
+
+ Q_SIGNALS:
+    /**
+     * Emitted for each successfully decoded tile.
+     */
+    void tileDecoded( const TileId &tileId, const QImage &tileImage );
+
+ private Q_SLOTS:
+    void deliverTiles();
+
+ private:
+    Q_DISABLE_COPY( TileDecoder )
+
+    class DecodeJob;
+
+    void startJobs();
+    void finishJob( const TileId &tileId, const QImage &tileImage );
+    void addDecodedTile( const TileId &tileId, const QImage &tileImage );
+
+    mutable QMutex m_mutex;
+    QThreadPool m_threadPool;
+    int m_maximumQueueSize;
+
+    QList<TileId> m_queue;
+    QHash<TileId, QByteArray> m_queuedData;
+    int m_activeJobs;
+
+    QList<QPair<TileId, QImage> > m_decodedTiles;
+    bool m_deliveryPending;
+};
+
+}
+
+#endif
@@ -24,7 +24,9 @@
 #include <QFileInfo>
 #include <QMetaType>
 #include <QImage>
+#include <QTime>
 
+#include "CacheStatistics.h"
 #include "GeoSceneTextureTile.h"
 #include "GeoSceneTiled.h"
 #include "GeoSceneVectorTile.h"
@@ -33,6 +35,7 @@
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "ParsingRunnerManager.h"
+#include "TileArchive.h"
 #include "TileLoaderHelper.h"
 
 Q_DECLARE_METATYPE( Marble::DownloadUsage )
@@ -41,13 +44,20 @@ namespace Marble
 {
 
 TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const PluginManager *pluginManager) :
-      m_pluginManager( pluginManager )
+      m_pluginManager( pluginManager ),
+      m_statistics( 0 )
 {
     qRegisterMetaType<DownloadUsage>( "DownloadUsage" );
     connect( this, SIGNAL(downloadTile(QUrl,QString,QString,DownloadUsage)),
              downloadManager, SLOT(addJob(QUrl,QString,QString,DownloadUsage)));
+    connect( this, SIGNAL(prefetchTile(QUrl,QString,QString)),
+             downloadManager, SLOT(addPrefetchJob(QUrl,QString,QString)));
+    connect( this, SIGNAL(prefetchCanceled()),
+             downloadManager, SLOT(cancelPrefetchJobs()));
     connect( downloadManager, SIGNAL(downloadComplete(QByteArray,QString)),
              SLOT(updateTile(QByteArray,QString)));
+    connect( &m_decoder, SIGNAL(tileDecoded(TileId,QImage)),
+             SIGNAL(tileCompleted(TileId,QImage)));
 }
 
 // If the tile image file is locally available:
@@ -55,8 +65,6 @@ TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const Plugin
 //     - if expired: create TextureTile, state is set to Expired by default, trigger dl,
 QImage TileLoader::loadTileImage( GeoSceneTextureTile const *textureLayer, TileId const & tileId, DownloadUsage const usage )
 {
-    QString const fileName = tileFileName( textureLayer, tileId );
-
     TileStatus status = tileStatus( textureLayer, tileId );
     if ( status != Missing ) {
         // check if an update should be triggered
@@ -69,13 +77,20 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTile const *textureLayer, TileI
             triggerDownload( textureLayer, tileId, usage );
         }
 
-        QImage const image( fileName );
+        QImage const image = tileImage( textureLayer, tileId );
         if ( !image.isNull() ) {
             // file is there, so create and return a tile object in any case
+            if ( m_statistics ) {
+                m_statistics->addHit( CacheStatistics::TileStorage );
+            }
             return image;
         }
     }
 
+    if ( m_statistics ) {
+        m_statistics->addMiss( CacheStatistics::TileStorage );
+    }
+
     // tile was not locally available => trigger download and look for tiles in other levels
     // for scaling
     QImage replacementTile = scaledLowerLevelTile( textureLayer, tileId );
@@ -108,9 +123,10 @@ GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTile const *textu
         QFile file ( fileName );
         if ( file.exists() ) {
 
-            // File is ready, so parse and return the vector data in any case
+            // File is ready, so parse and return the vector data in any case.
+            // This runs on a worker thread, so the runners are called directly.
             ParsingRunnerManager man( m_pluginManager );
-            GeoDataDocument* document = man.openFile( fileName );
+            GeoDataDocument* document = man.readFile( fileName );
 
             if (document){
                 return document;
@@ -135,6 +151,18 @@ void TileLoader::downloadTile( GeoSceneTiled const *textureLayer, TileId const &
     triggerDownload( textureLayer, tileId, usage );
 }
 
+void TileLoader::queuePrefetch( GeoSceneTiled const *textureLayer, TileId const &tileId )
+{
+    QUrl const sourceUrl = textureLayer->downloadUrl( tileId );
+    QString const destFileName = textureLayer->relativeTileFileName( tileId );
+    emit prefetchTile( sourceUrl, destFileName, downloadId( textureLayer, tileId ) );
+}
+
+void TileLoader::cancelPrefetch()
+{
+    emit prefetchCanceled();
+}
+
 int TileLoader::maximumTileLevel( GeoSceneTiled const & texture )
 {
     // if maximum tile level is configured in the DGML files,
@@ -170,6 +198,7 @@ bool TileLoader::baseTilesAvailable( GeoSceneTiled const & texture )
     const int  levelZeroColumns = texture.levelZeroColumns();
     const int  levelZeroRows    = texture.levelZeroRows();
 
+    const TileArchive *const archive = TileArchive::cacheArchive();
     bool result = true;
 
     // Check whether the tiles from the lowest texture level are available
@@ -178,7 +207,7 @@ bool TileLoader::baseTilesAvailable( GeoSceneTiled const & texture )
         for ( int row = 0; result && row < levelZeroRows; ++row ) {
             const TileId id( 0, 0, column, row );
             const QString tilepath = tileFileName( &texture, id );
-            result &= QFile::exists( tilepath );
+            result &= QFile::exists( tilepath ) || ( archive && archive->contains( texture.relativeTileFileName( id ) ) );
             if (!result) {
                 mDebug() << "Base tile " << texture.relativeTileFileName( id ) << " is missing for source dir " << texture.sourceDir();
             }
@@ -190,13 +219,24 @@ bool TileLoader::baseTilesAvailable( GeoSceneTiled const & texture )
 
 TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTiled const *textureLayer, const TileId &tileId )
 {
-    QString const fileName = tileFileName( textureLayer, tileId );
-    QFileInfo fileInfo( fileName );
-    if ( !fileInfo.exists() ) {
-        return Missing;
+    QDateTime lastModified;
+
+    // downloaded tiles may be stored in an archive rather than in separate files
+    const TileArchive *const archive = TileArchive::cacheArchive();
+    if ( archive ) {
+        lastModified = archive->lastModified( textureLayer->relativeTileFileName( tileId ) );
+    }
+
+    if ( !lastModified.isValid() ) {
+        QString const fileName = tileFileName( textureLayer, tileId );
+        QFileInfo fileInfo( fileName );
+        if ( !fileInfo.exists() ) {
+            return Missing;
+        }
+
+        lastModified = fileInfo.lastModified();
     }
 
-    const QDateTime lastModified = fileInfo.lastModified();
     const int expireSecs = textureLayer->expire();
     const bool isExpired = lastModified.secsTo( QDateTime::currentDateTime() ) >= expireSecs;
     return isExpired ? Expired : Available;
@@ -204,21 +244,40 @@ TileLoader::TileStatus TileLoader::tileStatus( GeoSceneTiled const *textureLayer
 
 void TileLoader::updateTile( QByteArray const & data, QString const & idStr )
 {
-    QStringList const components = idStr.split( ':', QString::SkipEmptyParts );
-    Q_ASSERT( components.size() == 4 );
+    TileId id;
+    if ( !fromDownloadId( idStr, id ) ) {
+        mDebug() << Q_FUNC_INFO << "ignoring download with unknown id" << idStr;
+        return;
+    }
+
+    // tileCompleted() is emitted once the image is decoded
+    m_decoder.decode( id, data );
+}
 
-    QString const sourceDir = components[ 0 ];
-    int const zoomLevel = components[ 1 ].toInt();
-    int const tileX = components[ 2 ].toInt();
-    int const tileY = components[ 3 ].toInt();
+QString TileLoader::downloadId( GeoSceneTiled const *textureLayer, TileId const &tileId )
+{
+    return QString( "%1:%2:%3:%4" ).arg( textureLayer->sourceDir() ).arg( tileId.zoomLevel() ).arg( tileId.x() ).arg( tileId.y() );
+}
 
-    TileId const id = TileId( sourceDir, zoomLevel, tileX, tileY );
+bool TileLoader::fromDownloadId( QString const &downloadId, TileId &tileId )
+{
+    QStringList const components = downloadId.split( ':', QString::SkipEmptyParts );
+    if ( components.size() != 4 ) {
+        return false;
+    }
 
-    QImage const tileImage = QImage::fromData( data );
-    if ( tileImage.isNull() )
-        return;
+    bool zoomLevelOk = false;
+    bool tileXOk = false;
+    bool tileYOk = false;
+    int const zoomLevel = components[ 1 ].toInt( &zoomLevelOk );
+    int const tileX = components[ 2 ].toInt( &tileXOk );
+    int const tileY = components[ 3 ].toInt( &tileYOk );
+    if ( !zoomLevelOk || !tileXOk || !tileYOk ) {
+        return false;
+    }
 
-    emit tileCompleted( id, tileImage );
+    tileId = TileId( components[ 0 ], zoomLevel, tileX, tileY );
+    return true;
 }
 
 QString TileLoader::tileFileName( GeoSceneTiled const * textureLayer, TileId const & tileId )
@@ -228,15 +287,50 @@ QString TileLoader::tileFileName( GeoSceneTiled const * textureLayer, TileId con
     return dirInfo.isAbsolute() ? fileName : MarbleDirs::path( fileName );
 }
 
+void TileLoader::setCacheStatistics( CacheStatistics *statistics )
+{
+    m_statistics = statistics;
+}
+
+QImage TileLoader::tileImage( GeoSceneTiled const *textureLayer, TileId const &tileId ) const
+{
+    QTime timer;
+    timer.start();
+
+    QByteArray data;
+    TileArchive *const archive = TileArchive::cacheArchive();
+    if ( archive ) {
+        data = archive->data( textureLayer->relativeTileFileName( tileId ) );
+    }
+
+    if ( data.isEmpty() ) {
+        QFile file( tileFileName( textureLayer, tileId ) );
+        if ( !file.open( QIODevice::ReadOnly ) ) {
+            return QImage();
+        }
+        data = file.readAll();
+    }
+
+    // read the file before decoding it in order to measure both separately
+    const int readTime = timer.restart();
+    QImage const image = QImage::fromData( data );
+
+    if ( m_statistics ) {
+        m_statistics->addTime( CacheStatistics::TileStorage, CacheStatistics::DiskReadTime, readTime );
+        m_statistics->addTime( CacheStatistics::TileStorage, CacheStatistics::DecodeTime, timer.elapsed() );
+    }
+
+    return image;
+}
+
 void TileLoader::triggerDownload( GeoSceneTiled const *textureLayer, TileId const &id, DownloadUsage const usage )
 {
     QUrl const sourceUrl = textureLayer->downloadUrl( id );
     QString const destFileName = textureLayer->relativeTileFileName( id );
-    QString const idStr = QString( "%1:%2:%3:%4" ).arg( textureLayer->sourceDir() ).arg( id.zoomLevel() ).arg( id.x() ).arg( id.y() );
-    emit downloadTile( sourceUrl, destFileName, idStr, usage );
+    emit downloadTile( sourceUrl, destFileName, downloadId( textureLayer, id ), usage );
 }
 
-QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLayer, TileId const & id )
+QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLayer, TileId const & id ) const
 {
     mDebug() << Q_FUNC_INFO << id;
 
@@ -244,9 +338,8 @@ QImage TileLoader::scaledLowerLevelTile( const GeoSceneTextureTile * textureLaye
         int const deltaLevel = id.zoomLevel() - level;
         TileId const replacementTileId( id.mapThemeIdHash(), level,
                                         id.x() >> deltaLevel, id.y() >> deltaLevel );
-        QString const fileName = tileFileName( textureLayer, replacementTileId );
-        mDebug() << "TileLoader::scaledLowerLevelTile" << "trying" << fileName;
-        QImage toScale = QFile::exists(fileName) ? QImage(fileName) : QImage();
+        mDebug() << "TileLoader::scaledLowerLevelTile" << "trying" << textureLayer->relativeTileFileName( replacementTileId );
+        QImage toScale = tileImage( textureLayer, replacementTileId );
 
         if ( level == 0 && toScale.isNull() ) {
             mDebug() << "No level zero tile installed in map theme dir. Falling back to a transparent image for now.";
@@ -24,6 +24,7 @@
 #include <QString>
 #include <QImage>
 
+#include "TileDecoder.h"
 #include "TileId.h"
 #include "GeoDataContainer.h"
 #include "PluginManager.h"
@@ -35,6 +36,7 @@ class QUrl;
 
 namespace Marble
 {
+class CacheStatistics;
 class HttpDownloadManager;
 class GeoDataDocument;
 class GeoSceneTiled;
@@ -58,6 +60,22 @@ class TileLoader: public QObject
     GeoDataDocument* loadTileVectorData( GeoSceneVectorTile const *textureLayer, TileId const & tileId, DownloadUsage const usage );
     void downloadTile( GeoSceneTiled const *textureLayer, TileId const &, DownloadUsage const );
 
+    /**
+     * Queues a low priority download of a tile which is expected to be needed soon.
+     */
+    void queuePrefetch( GeoSceneTiled const *textureLayer, TileId const & );
+
+    /**
+     * Cancels the downloads queued by queuePrefetch() which have not been started yet.
+     */
+    void cancelPrefetch();
+
+    /**
+     * Sets the statistics which reads from disc and tiles which have to be
+     * downloaded are reported to.
+     */
+    void setCacheStatistics( CacheStatistics *statistics );
+
     static int maximumTileLevel( GeoSceneTiled const & texture );
 
     /**
@@ -74,6 +92,17 @@ class TileLoader: public QObject
       */
     static TileStatus tileStatus( GeoSceneTiled const *textureLayer, const TileId &tileId );
 
+    /**
+      * Returns the id passed to the HttpDownloadManager for downloading the given tile.
+      */
+    static QString downloadId( GeoSceneTiled const *textureLayer, TileId const &tileId );
+
+    /**
+      * Converts an id returned by downloadId() back to the tile id.
+      * Returns false if @p downloadId is not a valid id.
+      */
+    static bool fromDownloadId( QString const &downloadId, TileId &tileId );
+
  public Q_SLOTS:
     void updateTile( QByteArray const & imageData, QString const & tileId );
 
@@ -81,17 +110,28 @@ class TileLoader: public QObject
     void downloadTile( QUrl const & sourceUrl, QString const & destinationFileName,
                        QString const & id, DownloadUsage );
 
+    void prefetchTile( QUrl const & sourceUrl, QString const & destinationFileName,
+                       QString const & id );
+
+    void prefetchCanceled();
+
     void tileCompleted( TileId const & tileId, QImage const & tileImage );
 
     void tileCompleted( TileId const & tileId, GeoDataDocument * document, QString const & format );
 
  private:
     static QString tileFileName( GeoSceneTiled const * textureLayer, TileId const & );
+    QImage tileImage( GeoSceneTiled const * textureLayer, TileId const & ) const;
     void triggerDownload( GeoSceneTiled const *textureLayer, TileId const &, DownloadUsage const );
-    static QImage scaledLowerLevelTile( GeoSceneTextureTile const * textureLayer, TileId const & );
+    QImage scaledLowerLevelTile( GeoSceneTextureTile const * textureLayer, TileId const & ) const;
 
     // For vectorTile parsing
     const PluginManager * m_pluginManager;
+
+    CacheStatistics *m_statistics;
+
+    // Decodes downloaded images outside of the GUI thread
+    TileDecoder m_decoder;
 };
 
 }
@@ -22,6 +22,8 @@
 #include <QRectF>
 #include <QString>
 
+#include "marble_export.h"
+
 namespace Marble
 {
 
@@ -35,7 +37,7 @@ static const qreal s_labelOutlineWidth = 2.5;
  * This class is used by PlacemarkLayout to pass the visible place marks
  * to the PlacemarkPainter.
  */
-class VisiblePlacemark : public QObject
+class MARBLE_EXPORT VisiblePlacemark : public QObject
 {
  Q_OBJECT
 
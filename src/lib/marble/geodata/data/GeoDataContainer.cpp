@@ -159,6 +159,10 @@ bool GeoDataContainer::equals( const GeoDataContainer &other ) const
 
 GeoDataLatLonAltBox GeoDataContainer::latLonAltBox() const
 {
+    if ( !p()->m_dirtyBox ) {
+        return p()->m_latLonAltBox;
+    }
+
     GeoDataLatLonAltBox result;
 
     QVector<GeoDataFeature*>::const_iterator it = p()->m_vector.constBegin();
@@ -191,9 +195,67 @@ GeoDataLatLonAltBox GeoDataContainer::latLonAltBox() const
             }
         }
     }
+
+    p()->m_latLonAltBox = result;
+    p()->m_dirtyBox = false;
+
     return result;
 }
 
+void GeoDataContainer::invalidateLatLonAltBox()
+{
+    // The box is a cache only, so there is no need to detach. The boxes of
+    // all containers above depend on this one.
+    GeoDataContainer *container = this;
+    while ( container ) {
+        container->p()->m_dirtyBox = true;
+        container = dynamic_cast<GeoDataContainer*>( container->parent() );
+    }
+}
+
+void GeoDataContainer::extendLatLonAltBox( const GeoDataFeature *feature )
+{
+    GeoDataLatLonAltBox box;
+    if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+        const GeoDataPlacemark *placemark = static_cast<const GeoDataPlacemark*>( feature );
+        if ( !placemark->isVisible() ) {
+            return;
+        }
+        box = placemark->geometry()->latLonAltBox();
+    } else if ( feature->nodeType() == GeoDataTypes::GeoDataFolderType
+                || feature->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
+        const GeoDataContainer *container = static_cast<const GeoDataContainer*>( feature );
+        if ( container->p()->m_dirtyBox ) {
+            // don't compute the box of a whole document which was just
+            // loaded, maybe nobody asks for it
+            invalidateLatLonAltBox();
+            return;
+        }
+        box = container->p()->m_latLonAltBox;
+    } else {
+        return;
+    }
+
+    if ( box.isEmpty() ) {
+        return;
+    }
+
+    // Extend the boxes which are up to date, the others include the new
+    // feature anyway once they get computed
+    GeoDataContainer *container = this;
+    while ( container ) {
+        GeoDataContainerPrivate *const priv = container->p();
+        if ( !priv->m_dirtyBox ) {
+            if ( priv->m_latLonAltBox.isEmpty() ) {
+                priv->m_latLonAltBox = box;
+            } else {
+                priv->m_latLonAltBox |= box;
+            }
+        }
+        container = dynamic_cast<GeoDataContainer*>( container->parent() );
+    }
+}
+
 QVector<GeoDataFolder*> GeoDataContainer::folderList() const
 {
     QVector<GeoDataFolder*> results;
@@ -273,6 +335,7 @@ void GeoDataContainer::insert( int index, GeoDataFeature *feature )
     detach();
     feature->setParent(this);
     p()->m_vector.insert( index, feature );
+    extendLatLonAltBox( feature );
 }
 
 void GeoDataContainer::append( GeoDataFeature *other )
@@ -280,6 +343,7 @@ void GeoDataContainer::append( GeoDataFeature *other )
     detach();
     other->setParent(this);
     p()->m_vector.append( other );
+    extendLatLonAltBox( other );
 }
 
 
@@ -287,6 +351,7 @@ void GeoDataContainer::remove( int index )
 {
     detach();
     p()->m_vector.remove( index );
+    invalidateLatLonAltBox();
 }
 
 int GeoDataContainer::size() const
@@ -332,6 +397,7 @@ void GeoDataContainer::clear()
     GeoDataContainer::detach();
     qDeleteAll(p()->m_vector);
     p()->m_vector.clear();
+    invalidateLatLonAltBox();
 }
 
 QVector<GeoDataFeature*>::Iterator GeoDataContainer::begin()
@@ -379,6 +445,7 @@ void GeoDataContainer::unpack( QDataStream& stream )
 
     int count;
     stream >> count;
+    p()->m_dirtyBox = true;
 
     for ( int i = 0; i < count; ++i ) {
         int featureId;
@@ -57,12 +57,24 @@ class GEODATA_EXPORT GeoDataContainer : public GeoDataFeature
     /**
      * @brief A convenience function that returns the LatLonAltBox of all
      * placemarks in this container.
+     *
+     * Only visible placemarks are taken into account. The box is kept up to
+     * date when features get added or removed, when placemarks change
+     * their geometry or visibility, and when a geometry below the container
+     * is edited in place, so asking for it is cheap.
+     *
      * @return The GeoDataLatLonAltBox
      *
      * @see GeoDataLatLonAltBox
      */
     GeoDataLatLonAltBox latLonAltBox() const;
 
+    /**
+     * @brief Makes this container and the containers above it compute their
+     * LatLonAltBox anew the next time it is asked for
+     */
+    void invalidateLatLonAltBox();
+
     /**
      * @brief A convenience function that returns all folders in this container.
      * @return A QVector of GeoDataFolder
@@ -162,6 +174,8 @@ class GEODATA_EXPORT GeoDataContainer : public GeoDataFeature
     using GeoDataFeature::equals;
 
  private:
+    void extendLatLonAltBox( const GeoDataFeature *feature );
+
     GeoDataContainerPrivate* p();
     const GeoDataContainerPrivate* p() const;
 };
@@ -13,6 +13,7 @@
 
 #include "GeoDataFeature_p.h"
 
+#include "GeoDataLatLonAltBox.h"
 #include "GeoDataTypes.h"
 
 namespace Marble
@@ -22,6 +23,7 @@ class GeoDataContainerPrivate : public GeoDataFeaturePrivate
 {
   public:
     GeoDataContainerPrivate()
+        : m_dirtyBox( true )
     {
     }
     
@@ -38,6 +40,7 @@ class GeoDataContainerPrivate : public GeoDataFeaturePrivate
         {
             m_vector.append( new GeoDataFeature( *feature ) );
         }
+        m_dirtyBox = true;
         return *this;
     }
 
@@ -59,6 +62,10 @@ class GeoDataContainerPrivate : public GeoDataFeaturePrivate
     }
 
     QVector<GeoDataFeature*> m_vector;
+
+    // the box of the visible placemarks below the container, see latLonAltBox()
+    mutable GeoDataLatLonAltBox m_latLonAltBox;
+    mutable bool m_dirtyBox;
 };
 
 } // namespace Marble
@@ -663,6 +663,11 @@ void GeoDataFeature::setVisible( bool value )
 {
     detach();
     d->m_visible = value;
+
+    // only visible placemarks make up the box of their container
+    if ( GeoDataContainer *container = dynamic_cast<GeoDataContainer*>( parent() ) ) {
+        container->invalidateLatLonAltBox();
+    }
 }
 
 bool GeoDataFeature::isGloballyVisible() const
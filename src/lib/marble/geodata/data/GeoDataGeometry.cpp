@@ -18,6 +18,7 @@
 #include "GeoDataPolygon.h"
 #include "GeoDataLineString.h"
 #include "GeoDataMultiGeometry.h"
+#include "GeoDataContainer.h"
 
 #include "MarbleDebug.h"
 
@@ -119,6 +120,20 @@ const GeoDataLatLonAltBox& GeoDataGeometry::latLonAltBox() const
     return d->m_latLonAltBox;
 }
 
+void GeoDataGeometry::invalidateContainerLatLonAltBox()
+{
+    // Geometries which don't belong to a placemark, like temporary copies,
+    // don't get further than this.
+    GeoDataObject *object = parent();
+    while ( object ) {
+        if ( GeoDataContainer *container = dynamic_cast<GeoDataContainer*>( object ) ) {
+            container->invalidateLatLonAltBox();
+            return;
+        }
+        object = object->parent();
+    }
+}
+
 void GeoDataGeometry::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
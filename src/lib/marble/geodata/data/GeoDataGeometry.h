@@ -79,6 +79,12 @@ class GEODATA_EXPORT GeoDataGeometry : public GeoDataObject
 
     using GeoDataObject::equals;
 
+    /**
+     * @brief Makes the containers above this geometry compute their
+     * LatLonAltBox anew, to be called whenever the box of the geometry changes
+     */
+    void invalidateContainerLatLonAltBox();
+
  protected:
     GeoDataGeometryPrivate *d;
 };
@@ -18,9 +18,72 @@
 #include "Quaternion.h"
 #include "MarbleDebug.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QStack>
+
 
 namespace Marble
 {
+
+// beyond this zoom level a pixel is a few centimeters and nothing gets generalized
+static const int maximumGeneralizationLevel = 20;
+
+// the number of zoom levels whose generalized versions are kept, so zooming
+// back and forth doesn't generalize the line strings again and again
+static const int maximumGeneralizedLevels = 2;
+
+// tessellated versions take a lot of memory, so only the one of the zoom
+// level used last is kept
+static const int maximumTessellatedLevels = 1;
+
+// Mercator maps end at about 85 degrees, where the cosine of the latitude is
+// about 0.08. Nothing closer to the poles is stretched any further.
+static const qreal minimumLatitudeCosine = 0.08;
+
+// the maximum distance of tessellated nodes in pixels, as in AbstractProjection.h
+static const int tessellationPrecision = 10;
+
+// the projections do not add more nodes to a single segment either
+static const int maximumTessellationNodes = 200;
+
+// line strings with more tessellated nodes are tessellated by the projections
+// on the fly instead, to save the memory
+static const int maximumTessellatedSize = 10000;
+
+// The caches of a line string are built lazily by const methods, which may
+// get called from several threads at once (see GeometryLayer). Publishing a
+// cache is guarded by one of a few mutexes shared by all line strings. The
+// caches are built outside of the lock, as building them may need the caches
+// of other line strings.
+static QMutex &cacheMutex( const GeoDataLineStringPrivate *d )
+{
+    static QMutex mutexes[17];
+    return mutexes[( quintptr( d ) / sizeof( void* ) ) % 17];
+}
+
+// Reads a flag which another thread may have cleared after publishing a cache
+static inline bool isSet( QAtomicInt &flag )
+{
+#if QT_VERSION < 0x050000
+    return flag.fetchAndAddAcquire( 0 ) != 0;
+#else
+    return flag.loadAcquire() != 0;
+#endif
+}
+
+// Deletes the versions of the zoom levels farthest from level until there is
+// room for count - 1 of them. Must be called with the cacheMutex locked.
+static void dropFarLevels( QMap<int, GeoDataLineString*> &versions, int level, int count )
+{
+    while ( !versions.isEmpty() && versions.size() >= count ) {
+        const int farthest = level - versions.firstKey() > versions.lastKey() - level ? versions.firstKey()
+                                                                                        : versions.lastKey();
+        delete versions.take( farthest );
+    }
+}
+
 GeoDataLineString::GeoDataLineString( TessellationFlags f )
   : GeoDataGeometry( new GeoDataLineStringPrivate( f ) )
 {
@@ -130,6 +193,193 @@ GeoDataCoordinates GeoDataLineStringPrivate::findDateLine( const GeoDataCoordina
     return findDateLine( previousCoords, interpolatedCoords, recursionCounter );
 }
 
+GeoDataLineString* GeoDataLineStringPrivate::toGeneralized( const GeoDataLineString & q,
+                                                            qreal tolerance ) const
+{
+    const QVector<GeoDataCoordinates> &nodes = m_vector;
+    const int size = nodes.size();
+    const qreal squaredTolerance = tolerance * tolerance;
+
+    QVector<bool> keep( size, false );
+    keep[0] = true;
+    keep[size - 1] = true;
+    int keptNodes = 2;
+
+    // The Mercator projection stretches distances by 1 / cos(latitude),
+    // so the tolerance shrinks towards the poles
+    QVector<qreal> squaredStretch( size );
+    for ( int i = 0; i < size; ++i ) {
+        const qreal stretch = 1.0 / qMax( qreal( cos( nodes[i].latitude() ) ), minimumLatitudeCosine );
+        squaredStretch[i] = stretch * stretch;
+    }
+
+    // Douglas-Peucker on the longitudes and latitudes. Not scaling the
+    // longitudes by the cosine of the latitude overestimates distances,
+    // so nodes are rather kept than dropped. A stack instead of recursion
+    // copes with line strings of millions of nodes.
+    QStack<QPair<int, int> > ranges;
+    ranges.push( qMakePair( 0, size - 1 ) );
+
+    while ( !ranges.isEmpty() ) {
+        const QPair<int, int> range = ranges.pop();
+        const int first = range.first;
+        const int last = range.second;
+
+        const qreal firstLon = nodes[first].longitude();
+        const qreal firstLat = nodes[first].latitude();
+        const qreal dLon = nodes[last].longitude() - firstLon;
+        const qreal dLat = nodes[last].latitude() - firstLat;
+        const qreal squaredLength = dLon * dLon + dLat * dLat;
+
+        qreal maximumDistance = 0.0;
+        int farthest = -1;
+        for ( int i = first + 1; i < last; ++i ) {
+            const qreal lon = nodes[i].longitude() - firstLon;
+            const qreal lat = nodes[i].latitude() - firstLat;
+
+            qreal squaredDistance;
+            if ( squaredLength > 0.0 ) {
+                const qreal cross = dLon * lat - dLat * lon;
+                squaredDistance = cross * cross / squaredLength;
+            }
+            else {
+                // the first and the last node of a ring coincide
+                squaredDistance = lon * lon + lat * lat;
+            }
+            squaredDistance *= squaredStretch[i];
+
+            if ( squaredDistance > maximumDistance ) {
+                maximumDistance = squaredDistance;
+                farthest = i;
+            }
+        }
+
+        if ( farthest >= 0 && maximumDistance > squaredTolerance ) {
+            keep[farthest] = true;
+            ++keptNodes;
+            if ( farthest - first > 1 ) {
+                ranges.push( qMakePair( first, farthest ) );
+            }
+            if ( last - farthest > 1 ) {
+                ranges.push( qMakePair( farthest, last ) );
+            }
+        }
+    }
+
+    // not worth the memory if hardly any node gets dropped
+    if ( keptNodes * 10 > size * 9 ) {
+        return 0;
+    }
+
+    GeoDataLineString *generalized = q.isClosed() ? new GeoDataLinearRing( q.tessellationFlags() )
+                                                  : new GeoDataLineString( q.tessellationFlags() );
+    for ( int i = 0; i < size; ++i ) {
+        if ( keep[i] ) {
+            *generalized << m_vector.at( i );
+        }
+    }
+
+    return generalized;
+}
+
+GeoDataLineString* GeoDataLineStringPrivate::toTessellated( const GeoDataLineString & q, qreal step ) const
+{
+    const int size = m_vector.size();
+    const int segmentCount = q.isClosed() ? size : size - 1;
+    const bool clampToGround = m_tessellationFlags.testFlag( FollowGround );
+    const bool respectLatitudeCircle = m_tessellationFlags.testFlag( RespectLatitudeCircle );
+
+    // Count the nodes first, so no memory gets wasted on line strings which
+    // are not tessellated at all or which would get too many nodes
+    QVector<int> nodeCounts( segmentCount );
+    QVector<qreal> lonDiffs( segmentCount );
+    int tessellatedSize = size;
+    for ( int i = 0; i < segmentCount; ++i ) {
+        const GeoDataCoordinates &previousCoords = m_vector.at( i );
+        const GeoDataCoordinates &currentCoords = m_vector.at( ( i + 1 ) % size );
+
+        qreal distance = 0.0;
+        lonDiffs[i] = 0.0;
+        if ( respectLatitudeCircle && previousCoords.latitude() == currentCoords.latitude() ) {
+            // follow the latitude circle eastwards or westwards, whichever is shorter
+            qreal lonDiff = currentCoords.longitude() - previousCoords.longitude();
+            if ( lonDiff > M_PI ) {
+                lonDiff -= 2 * M_PI;
+            } else if ( lonDiff < -M_PI ) {
+                lonDiff += 2 * M_PI;
+            }
+            lonDiffs[i] = lonDiff;
+            distance = fabs( lonDiff ) * cos( previousCoords.latitude() );
+        } else {
+            distance = distanceSphere( previousCoords, currentCoords );
+        }
+
+        nodeCounts[i] = qMin<int>( distance / step, maximumTessellationNodes );
+        tessellatedSize += nodeCounts[i];
+    }
+
+    if ( tessellatedSize == size || tessellatedSize > maximumTessellatedSize ) {
+        return 0;
+    }
+
+    GeoDataLineString *tessellated = q.isClosed() ? new GeoDataLinearRing( NoTessellation )
+                                                  : new GeoDataLineString( NoTessellation );
+    for ( int i = 0; i < size; ++i ) {
+        const GeoDataCoordinates &previousCoords = m_vector.at( i );
+        if ( clampToGround ) {
+            GeoDataCoordinates clampedCoords( previousCoords );
+            clampedCoords.setAltitude( 0.0 );
+            *tessellated << clampedCoords;
+        } else {
+            *tessellated << previousCoords;
+        }
+
+        if ( i >= segmentCount || nodeCounts.at( i ) == 0 ) {
+            continue;
+        }
+
+        const GeoDataCoordinates &currentCoords = m_vector.at( ( i + 1 ) % size );
+        const bool followLatitudeCircle = respectLatitudeCircle
+                                          && previousCoords.latitude() == currentCoords.latitude();
+        const qreal altDiff = currentCoords.altitude() - previousCoords.altitude();
+        const int tessellatedNodes = nodeCounts.at( i );
+
+        for ( int j = 1; j <= tessellatedNodes; ++j ) {
+            const qreal t = (qreal)(j) / (qreal)( tessellatedNodes + 1 );
+
+            // interpolate the altitude, too
+            const qreal altitude = clampToGround ? 0 : altDiff * t + previousCoords.altitude();
+
+            qreal lon = 0.0;
+            qreal lat = 0.0;
+            if ( followLatitudeCircle ) {
+                lon = GeoDataCoordinates::normalizeLon( lonDiffs.at( i ) * t + previousCoords.longitude() );
+                lat = previousCoords.latitude();
+            }
+            else {
+                // the same normalized linear interpolation ("NLERP") the projections use
+                const Quaternion itpos = Quaternion::nlerp( previousCoords.quaternion(), currentCoords.quaternion(), t );
+                itpos.getSpherical( lon, lat );
+            }
+
+            *tessellated << GeoDataCoordinates( lon, lat, altitude );
+        }
+    }
+
+    return tessellated;
+}
+
+void GeoDataLineStringPrivate::clearDerived() const
+{
+    if ( m_dirtyDerived ) {
+        qDeleteAll( m_generalized );
+        m_generalized.clear();
+        qDeleteAll( m_tessellated );
+        m_tessellated.clear();
+        m_dirtyDerived = false;
+    }
+}
+
 bool GeoDataLineString::isEmpty() const
 {
     return p()->m_vector.isEmpty();
@@ -145,6 +395,8 @@ GeoDataCoordinates& GeoDataLineString::at( int pos )
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    p()->m_dirtyDerived = true;
     return p()->m_vector[ pos ];
 }
 
@@ -158,6 +410,8 @@ GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    p()->m_dirtyDerived = true;
     return p()->m_vector[ pos ];
 }
 
@@ -171,12 +425,15 @@ GeoDataCoordinates& GeoDataLineString::last()
     GeoDataGeometry::detach();
     p()->m_dirtyRange = true;
     p()->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    p()->m_dirtyDerived = true;
     return p()->m_vector.last();
 }
 
 GeoDataCoordinates& GeoDataLineString::first()
 {
     GeoDataGeometry::detach();
+    p()->m_dirtyDerived = true;
     return p()->m_vector.first();
 }
 
@@ -193,6 +450,7 @@ const GeoDataCoordinates& GeoDataLineString::first() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::begin()
 {
     GeoDataGeometry::detach();
+    p()->m_dirtyDerived = true;
     return p()->m_vector.begin();
 }
 
@@ -204,6 +462,7 @@ QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::begin() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::end()
 {
     GeoDataGeometry::detach();
+    p()->m_dirtyDerived = true;
     return p()->m_vector.end();
 }
 
@@ -230,6 +489,8 @@ void GeoDataLineString::insert( int index, const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
     d->m_vector.insert( index, value );
 }
 
@@ -241,6 +502,8 @@ void GeoDataLineString::append ( const GeoDataCoordinates& value )
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
     d->m_vector.append( value );
 }
 
@@ -252,6 +515,8 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& va
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
     d->m_vector.append( value );
     return *this;
 }
@@ -264,6 +529,8 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& val
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
 
     QVector<GeoDataCoordinates>::const_iterator itCoords = value.constBegin();
     QVector<GeoDataCoordinates>::const_iterator itEnd = value.constEnd();
@@ -314,6 +581,8 @@ void GeoDataLineString::clear()
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
 
     d->m_vector.clear();
 }
@@ -343,6 +612,7 @@ void GeoDataLineString::setTessellate( bool tessellate )
         p()->m_tessellationFlags ^= Tessellate;
         p()->m_tessellationFlags ^= RespectLatitudeCircle;
     }
+    p()->m_dirtyDerived = true;
 }
 
 TessellationFlags GeoDataLineString::tessellationFlags() const
@@ -353,6 +623,7 @@ TessellationFlags GeoDataLineString::tessellationFlags() const
 void GeoDataLineString::setTessellationFlags( TessellationFlags f )
 {
     p()->m_tessellationFlags = f;
+    p()->m_dirtyDerived = true;
 }
 
 GeoDataLineString GeoDataLineString::toNormalized() const
@@ -386,16 +657,25 @@ GeoDataLineString GeoDataLineString::toNormalized() const
 
 GeoDataLineString GeoDataLineString::toRangeCorrected() const
 {
+    QMutexLocker locker( &cacheMutex( p() ) );
     if ( p()->m_dirtyRange ) {
-
-        delete p()->m_rangeCorrected;
-
+        locker.unlock();
+        GeoDataLineString *rangeCorrected;
         if( isClosed() ) {
-            p()->m_rangeCorrected = new GeoDataLinearRing( toPoleCorrected() );
+            rangeCorrected = new GeoDataLinearRing( toPoleCorrected() );
+        } else {
+            rangeCorrected = new GeoDataLineString( toPoleCorrected() );
+        }
+        locker.relock();
+
+        if ( p()->m_dirtyRange ) {
+            delete p()->m_rangeCorrected;
+            p()->m_rangeCorrected = rangeCorrected;
+            p()->m_dirtyRange = false;
         } else {
-            p()->m_rangeCorrected = new GeoDataLineString( toPoleCorrected() );
+            // another thread was faster
+            delete rangeCorrected;
         }
-        p()->m_dirtyRange = false;
     }
 
     return *p()->m_rangeCorrected;
@@ -594,14 +874,100 @@ const GeoDataLatLonAltBox& GeoDataLineString::latLonAltBox() const
     // that's why we recreate it only if the m_dirtyBox
     // is TRUE.
     // DO NOT REMOVE THIS CONSTRUCT OR MARBLE WILL BE SLOW.
-    if ( p()->m_dirtyBox ) {
-        p()->m_latLonAltBox = GeoDataLatLonAltBox::fromLineString( *this );
+    // Once computed, the box is returned without locking the shared mutex.
+    if ( !isSet( p()->m_dirtyBox ) ) {
+        return p()->m_latLonAltBox;
+    }
+
+    const GeoDataLatLonAltBox latLonAltBox = GeoDataLatLonAltBox::fromLineString( *this );
+
+    QMutexLocker locker( &cacheMutex( p() ) );
+    if ( isSet( p()->m_dirtyBox ) ) {
+        p()->m_latLonAltBox = latLonAltBox;
+        p()->m_dirtyBox.fetchAndStoreRelease( 0 );
     }
-    p()->m_dirtyBox = false;
 
     return p()->m_latLonAltBox;
 }
 
+GeoDataLineString GeoDataLineString::generalized( int zoomLevel ) const
+{
+    // the projections don't skip any nodes of short line strings either
+    if ( size() <= 50 || zoomLevel > maximumGeneralizationLevel ) {
+        return *this;
+    }
+
+    const int level = qMax( 0, zoomLevel );
+
+    QMutexLocker locker( &cacheMutex( p() ) );
+    p()->clearDerived();
+
+    QMap<int, GeoDataLineString*>::const_iterator it = p()->m_generalized.constFind( level );
+    if ( it == p()->m_generalized.constEnd() ) {
+        locker.unlock();
+        // GeometryLayer uses zoom level z for radii from 64 * 2^z up to
+        // 64 * 2^(z+1) pixels, so allow for one pixel at the latter
+        const qreal tolerance = 1.0 / ( qreal( 64 ) * ( 2 << level ) );
+        GeoDataLineString *generalized = p()->toGeneralized( *this, tolerance );
+        locker.relock();
+
+        it = p()->m_generalized.constFind( level );
+        if ( it == p()->m_generalized.constEnd() ) {
+            dropFarLevels( p()->m_generalized, level, maximumGeneralizedLevels );
+            it = p()->m_generalized.insert( level, generalized );
+        } else {
+            // another thread was faster
+            delete generalized;
+        }
+    }
+
+    return it.value() ? *it.value() : *this;
+}
+
+GeoDataLineString GeoDataLineString::tessellated( int zoomLevel ) const
+{
+    if ( !tessellate() || size() < 2 || zoomLevel > maximumGeneralizationLevel ) {
+        return *this;
+    }
+
+    const int level = qMax( 0, zoomLevel );
+
+    QMutexLocker locker( &cacheMutex( p() ) );
+    p()->clearDerived();
+
+    QMap<int, GeoDataLineString*>::const_iterator it = p()->m_tessellated.constFind( level );
+    if ( it == p()->m_tessellated.constEnd() ) {
+        locker.unlock();
+        // GeometryLayer uses zoom level z for radii from 64 * 2^z up to
+        // 64 * 2^(z+1) pixels, a radian is that many pixels at most
+        const qreal step = tessellationPrecision / ( qreal( 64 ) * ( 2 << level ) );
+        GeoDataLineString *tessellated = p()->toTessellated( *this, step );
+        locker.relock();
+
+        it = p()->m_tessellated.constFind( level );
+        if ( it == p()->m_tessellated.constEnd() ) {
+            dropFarLevels( p()->m_tessellated, level, maximumTessellatedLevels );
+            it = p()->m_tessellated.insert( level, tessellated );
+        } else {
+            // another thread was faster
+            delete tessellated;
+        }
+    }
+
+    return it.value() ? *it.value() : *this;
+}
+
+int GeoDataLineString::generalizationLevel( qreal angularResolution )
+{
+    if ( angularResolution <= 0.0 ) {
+        return maximumGeneralizationLevel + 1;
+    }
+
+    // the angular resolution of a viewport amounts to 4 / radius
+    const qreal radius = 4.0 / angularResolution;
+    return qMax( 0, int( floor( log( radius / 64.0 ) / log( 2.0 ) ) ) );
+}
+
 qreal GeoDataLineString::length( qreal planetRadius, int offset ) const
 {
     if( offset < 0 || offset >= size() ) {
@@ -628,6 +994,8 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
     return d->m_vector.erase( pos );
 }
 
@@ -640,6 +1008,8 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
     d->m_rangeCorrected = 0;
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
     return d->m_vector.erase( begin, end );
 }
 
@@ -649,6 +1019,8 @@ void GeoDataLineString::remove ( int i )
     GeoDataLineStringPrivate* d = p();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
+    invalidateContainerLatLonAltBox();
+    d->m_dirtyDerived = true;
     d->m_vector.remove( i );
 }
 
@@ -681,6 +1053,7 @@ void GeoDataLineString::unpack( QDataStream& stream )
     stream >> tessellationFlags;
 
     p()->m_tessellationFlags = (TessellationFlags)(tessellationFlags);
+    p()->m_dirtyDerived = true;
 
     for(qint32 i = 0; i < size; i++ ) {
         GeoDataCoordinates coord;
@@ -146,6 +146,49 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
 
    virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
+/*!
+    \brief Returns a generalized version of the LineString for a tile zoom level.
+
+    Nodes which don't change the shape of the LineString by more than a pixel
+    at the given zoom level are left out (Douglas-Peucker), also in the
+    Mercator projection, which stretches the map towards the poles. The
+    generalized versions are created on first use. The ones of the two zoom
+    levels closest to the last requested one are kept until the LineString
+    changes. The returned LineString shares its nodes with the kept version,
+    so it stays valid when other threads request other zoom levels.
+    Short LineStrings, high zoom levels and LineStrings which hardly get any
+    simpler return (a shallow copy of) the LineString itself.
+
+    \see generalizationLevel()
+*/
+    GeoDataLineString generalized( int zoomLevel ) const;
+
+/*!
+    \brief Returns a tessellated version of the LineString for a tile zoom level.
+
+    If the LineString is tessellated, the returned LineString holds the
+    nodes which the projections would interpolate along great circles or
+    latitude circles in between its nodes, so that they are not more than a
+    few pixels apart at the given zoom level. The returned LineString itself
+    is not tessellated. The tessellated version is created on first use and
+    kept until the LineString changes or another zoom level is requested.
+    The returned LineString shares its nodes with the kept version.
+    LineStrings which are not tessellated, which need no nodes in between at
+    the given zoom level or which would get too many nodes return (a shallow
+    copy of) the LineString itself.
+
+    \see generalizationLevel()
+*/
+    GeoDataLineString tessellated( int zoomLevel ) const;
+
+/*!
+    \brief Returns the zoom level for generalized() and tessellated() that
+    matches the given angular resolution of a viewport.
+
+    \see ViewportParams::angularResolution()
+*/
+    static int generalizationLevel( qreal angularResolution );
+
 /**
   * @brief Returns the length of LineString across a sphere starting from a coordinate in LineString
   * This method can be used as an approximation for distances along LineStrings.
@@ -11,6 +11,9 @@
 #ifndef MARBLE_GEODATALINESTRINGPRIVATE_H
 #define MARBLE_GEODATALINESTRINGPRIVATE_H
 
+#include <QAtomicInt>
+#include <QMap>
+
 #include "GeoDataGeometry_p.h"
 
 #include "GeoDataTypes.h"
@@ -25,6 +28,7 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         :  m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
            m_dirtyBox( true ),
+           m_dirtyDerived( true ),
            m_tessellationFlags( f )
     {
     }
@@ -32,13 +36,16 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     GeoDataLineStringPrivate()
          : m_rangeCorrected( 0 ),
            m_dirtyRange( true ),
-           m_dirtyBox( true )
+           m_dirtyBox( true ),
+           m_dirtyDerived( true )
     {
     }
 
     ~GeoDataLineStringPrivate()
     {
         delete m_rangeCorrected;
+        qDeleteAll( m_generalized );
+        qDeleteAll( m_tessellated );
     }
 
     GeoDataLineStringPrivate& operator=( const GeoDataLineStringPrivate &other)
@@ -48,6 +55,11 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         m_rangeCorrected = 0;
         m_dirtyRange = true;
         m_dirtyBox = other.m_dirtyBox;
+        qDeleteAll( m_generalized );
+        m_generalized.clear();
+        qDeleteAll( m_tessellated );
+        m_tessellated.clear();
+        m_dirtyDerived = true;
         m_tessellationFlags = other.m_tessellationFlags;
         return *this;
     }
@@ -85,14 +97,27 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
                        const GeoDataCoordinates & currentCoords,
                        int recursionCounter ) const;
 
+    GeoDataLineString* toGeneralized( const GeoDataLineString & q, qreal tolerance ) const;
+
+    GeoDataLineString* toTessellated( const GeoDataLineString & q, qreal step ) const;
+
+    // clears the generalized and tessellated versions if they are outdated
+    void clearDerived() const;
+
     QVector<GeoDataCoordinates> m_vector;
 
     mutable GeoDataLineString*  m_rangeCorrected;
     mutable bool                m_dirtyRange;
 
-    mutable bool                m_dirtyBox; // tells whether there have been changes to the
+    mutable QAtomicInt          m_dirtyBox; // tells whether there have been changes to the
                                             // GeoDataPoints since the LatLonAltBox has 
                                             // been calculated. Saves performance. 
+
+    // generalized and tessellated versions by zoom level, 0 if the line
+    // string itself is used
+    mutable QMap<int, GeoDataLineString*> m_generalized;
+    mutable QMap<int, GeoDataLineString*> m_tessellated;
+    mutable bool                m_dirtyDerived;
     TessellationFlags           m_tessellationFlags;
 };
 
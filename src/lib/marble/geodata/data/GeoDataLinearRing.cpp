@@ -48,6 +48,12 @@ bool GeoDataLinearRing::isClosed() const
     return true;
 }
 
+GeoDataLinearRing GeoDataLinearRing::generalized( int zoomLevel ) const
+{
+    // generalized versions of closed line strings are linear rings as well
+    return GeoDataLinearRing( GeoDataLineString::generalized( zoomLevel ) );
+}
+
 qreal GeoDataLinearRing::length( qreal planetRadius, int offset ) const
 {
     qreal  length = GeoDataLineString::length( planetRadius, offset );
@@ -102,6 +102,13 @@ class GEODATA_EXPORT GeoDataLinearRing : public GeoDataLineString
 */
     virtual bool isClosed() const;
 
+/*!
+    \brief Returns a generalized version of the LinearRing for a tile zoom level.
+
+    \see GeoDataLineString::generalized()
+*/
+    GeoDataLinearRing generalized( int zoomLevel ) const;
+
     
 /*!
     \brief Returns the length of the LinearRing across a sphere.
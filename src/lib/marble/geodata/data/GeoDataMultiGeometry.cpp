@@ -188,6 +188,7 @@ int GeoDataMultiGeometry::childPosition( const GeoDataGeometry *object ) const
 void GeoDataMultiGeometry::append( GeoDataGeometry *other )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     other->setParent( this );
     p()->m_vector.append( other );
 }
@@ -196,6 +197,7 @@ void GeoDataMultiGeometry::append( GeoDataGeometry *other )
 GeoDataMultiGeometry& GeoDataMultiGeometry::operator << ( const GeoDataGeometry& value )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     GeoDataGeometry *g = new GeoDataGeometry( value );
     g->setParent( this );
     p()->m_vector.append( g );
@@ -205,6 +207,7 @@ GeoDataMultiGeometry& GeoDataMultiGeometry::operator << ( const GeoDataGeometry&
 void GeoDataMultiGeometry::clear()
 {
     detach();
+    invalidateContainerLatLonAltBox();
     qDeleteAll(p()->m_vector);
     p()->m_vector.clear();
 }
@@ -228,6 +231,7 @@ void GeoDataMultiGeometry::pack( QDataStream& stream ) const
 void GeoDataMultiGeometry::unpack( QDataStream& stream )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     GeoDataGeometry::unpack( stream );
 
     int size = 0;
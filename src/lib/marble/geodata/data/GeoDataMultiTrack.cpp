@@ -210,6 +210,7 @@ int GeoDataMultiTrack::childPosition( const GeoDataTrack *object ) const
 void GeoDataMultiTrack::append( GeoDataTrack *other )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     other->setParent( this );
     p()->m_vector.append( other );
 }
@@ -218,6 +219,7 @@ void GeoDataMultiTrack::append( GeoDataTrack *other )
 GeoDataMultiTrack& GeoDataMultiTrack::operator << ( const GeoDataTrack& value )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     GeoDataTrack *g = new GeoDataTrack( value );
     g->setParent( this );
     p()->m_vector.append( g );
@@ -227,6 +229,7 @@ GeoDataMultiTrack& GeoDataMultiTrack::operator << ( const GeoDataTrack& value )
 void GeoDataMultiTrack::clear()
 {
     detach();
+    invalidateContainerLatLonAltBox();
     qDeleteAll(p()->m_vector);
     p()->m_vector.clear();
 }
@@ -250,6 +253,7 @@ void GeoDataMultiTrack::pack( QDataStream& stream ) const
 void GeoDataMultiTrack::unpack( QDataStream& stream )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     GeoDataGeometry::unpack( stream );
 
     int size = 0;
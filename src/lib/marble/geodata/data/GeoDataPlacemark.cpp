@@ -19,6 +19,7 @@
 
 #include "GeoDataMultiGeometry.h"
 #include "GeoDataCoordinates.h"
+#include "GeoDataContainer.h"
 
 // Qt
 #include <QDataStream>
@@ -247,6 +248,10 @@ void GeoDataPlacemark::setGeometry( GeoDataGeometry *entry )
     delete p()->m_geometry;
     p()->m_geometry = entry;
     p()->m_geometry->setParent( this );
+
+    if ( GeoDataContainer *container = dynamic_cast<GeoDataContainer*>( parent() ) ) {
+        container->invalidateLatLonAltBox();
+    }
 }
 
 qreal GeoDataPlacemark::area() const
@@ -77,6 +77,7 @@ bool GeoDataPoint::operator!=( const GeoDataPoint &other ) const
 void GeoDataPoint::setCoordinates( const GeoDataCoordinates &coordinates )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     p()->m_coordinates = coordinates;
     p()->m_latLonAltBox = GeoDataLatLonAltBox( p()->m_coordinates );
 }
@@ -125,6 +125,7 @@ const GeoDataLatLonAltBox& GeoDataPolygon::latLonAltBox() const
 GeoDataLinearRing &GeoDataPolygon::outerBoundary()
 {
     detach();
+    invalidateContainerLatLonAltBox();
     return (p()->outer);
 }
 
@@ -136,6 +137,7 @@ const GeoDataLinearRing &GeoDataPolygon::outerBoundary() const
 void GeoDataPolygon::setOuterBoundary( const GeoDataLinearRing& boundary )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     p()->outer = boundary;
 }
 
@@ -178,6 +180,7 @@ void GeoDataPolygon::pack( QDataStream& stream ) const
 void GeoDataPolygon::unpack( QDataStream& stream )
 {
     detach();
+    invalidateContainerLatLonAltBox();
     GeoDataObject::unpack( stream );
 
     p()->outer.unpack( stream );
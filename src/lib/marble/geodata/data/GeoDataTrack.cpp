@@ -204,6 +204,7 @@ GeoDataCoordinates GeoDataTrack::coordinatesAt( int index ) const
 void GeoDataTrack::addPoint( const QDateTime &when, const GeoDataCoordinates &coord )
 {
     detach();
+    invalidateContainerLatLonAltBox();
 
     p()->equalizeWhenSize();
     p()->m_lineStringNeedsUpdate = true;
@@ -221,6 +222,7 @@ void GeoDataTrack::addPoint( const QDateTime &when, const GeoDataCoordinates &co
 void GeoDataTrack::appendCoordinates( const GeoDataCoordinates &coord )
 {
     detach();
+    invalidateContainerLatLonAltBox();
 
     p()->equalizeWhenSize();
     p()->m_lineStringNeedsUpdate = true;
@@ -249,6 +251,7 @@ void GeoDataTrack::appendWhen( const QDateTime &when )
 void GeoDataTrack::clear()
 {
     detach();
+    invalidateContainerLatLonAltBox();
 
     p()->m_when.clear();
     p()->m_coordinates.clear();
@@ -258,6 +261,7 @@ void GeoDataTrack::clear()
 void GeoDataTrack::removeBefore( const QDateTime &when )
 {
     detach();
+    invalidateContainerLatLonAltBox();
 
     Q_ASSERT( p()->m_coordinates.size() == p()->m_when.size() );
     if ( p()->m_when.isEmpty() ) {
@@ -274,6 +278,7 @@ void GeoDataTrack::removeBefore( const QDateTime &when )
 void GeoDataTrack::removeAfter( const QDateTime &when )
 {
     detach();
+    invalidateContainerLatLonAltBox();
 
     Q_ASSERT( p()->m_coordinates.size() == p()->m_when.size() );
     if ( p()->m_when.isEmpty() ) {
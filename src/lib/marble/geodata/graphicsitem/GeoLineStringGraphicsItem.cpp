@@ -12,22 +12,28 @@
 
 #include "GeoDataLineString.h"
 #include "GeoDataLineStyle.h"
+#include "ClipPainter.h"
 #include "GeoPainter.h"
 #include "ViewportParams.h"
 #include "GeoDataStyle.h"
 
+#include <QPainterPath>
+
 namespace Marble
 {
 
 GeoLineStringGraphicsItem::GeoLineStringGraphicsItem( const GeoDataFeature *feature, const GeoDataLineString* lineString )
         : GeoGraphicsItem( feature ),
-          m_lineString( lineString )
+          m_lineString( lineString ),
+          m_prepared( false )
 {
 }
 
 void GeoLineStringGraphicsItem::setLineString( const GeoDataLineString* lineString )
 {
     m_lineString = lineString;
+    m_screenPolygons.clear();
+    m_prepared = false;
 }
 
 const GeoDataLatLonAltBox& GeoLineStringGraphicsItem::latLonAltBox() const
@@ -35,12 +41,124 @@ const GeoDataLatLonAltBox& GeoLineStringGraphicsItem::latLonAltBox() const
     return m_lineString->latLonAltBox();
 }
 
+qreal GeoLineStringGraphicsItem::lineWidth( const ViewportParams *viewport ) const
+{
+    if ( !style() ) {
+        return 0.0;
+    }
+
+    const qreal physicalWidth = float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth();
+    return qMax<qreal>( style()->lineStyle().width(), physicalWidth );
+}
+
+void GeoLineStringGraphicsItem::prepare( const ViewportParams *viewport )
+{
+    m_prepared = true;
+    m_clippedPolygons.clear();
+
+    // Immediately leave this method now if:
+    // - the object is not visible in the viewport or if
+    // - the size of the object is below the resolution of the viewport
+    if ( !viewport->viewLatLonAltBox().intersects( m_lineString->latLonAltBox() ) ||
+         !viewport->resolves( m_lineString->latLonAltBox() ) ) {
+        return;
+    }
+
+    if ( !m_screenPolygons.isValid( viewport ) ) {
+        const int level = GeoDataLineString::generalizationLevel( viewport->angularResolution() );
+        m_screenPolygons.setLineString( viewport, m_lineString->generalized( level ) );
+    }
+
+    // clip like ClipPainter does for the pen
+    const qreal margin = lineWidth( viewport ) / 2.0 + 1.0;
+    const QRectF clipRect = QRectF( 0, 0, viewport->width(), viewport->height() ).adjusted( -margin, -margin, margin, margin );
+    foreach( const QPolygonF &polygon, m_screenPolygons.polygons() ) {
+        ClipPainter::clip( polygon, clipRect, false, m_clippedPolygons );
+    }
+}
+
 void GeoLineStringGraphicsItem::paint( GeoPainter* painter, const ViewportParams* viewport )
 {
-    LabelPositionFlags labelPositionFlags = NoLabel;
+    paintBatch( painter, viewport, QList<GeoGraphicsItem*>() << this );
+}
+
+const char *GeoLineStringGraphicsItem::batchType() const
+{
+    return "GeoLineStringGraphicsItem";
+}
+
+void GeoLineStringGraphicsItem::paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                                            const QList<GeoGraphicsItem*> &items )
+{
+    QList<GeoLineStringGraphicsItem*> visibleItems;
+    foreach( GeoGraphicsItem *item, items ) {
+        GeoLineStringGraphicsItem *lineString = static_cast<GeoLineStringGraphicsItem*>( item );
+        lineString->preparePaint( viewport );
+        if ( !lineString->m_clippedPolygons.isEmpty() ) {
+            visibleItems << lineString;
+        }
+    }
+
+    if ( visibleItems.isEmpty() ) {
+        return;
+    }
 
     painter->save();
 
+    const LabelPositionFlags labelPositionFlags = setupPainter( painter, viewport );
+
+    // the polylines are clipped already
+    const bool screenClip = painter->hasScreenClip();
+    painter->setScreenClip( false );
+
+    // Opaque solid lines look the same when they are stroked as a single path,
+    // which is a lot faster than stroking them one by one
+    const bool mergePaths = painter->pen().style() == Qt::SolidLine
+                            && painter->pen().color().alpha() == 255;
+
+    QPainterPath path;
+    QList<GeoLineStringGraphicsItem*> separateItems;
+    foreach( GeoLineStringGraphicsItem *lineString, visibleItems ) {
+        const bool hasLabel = !lineString->feature()->name().isEmpty()
+                              && !labelPositionFlags.testFlag( NoLabel );
+        if ( mergePaths && !hasLabel ) {
+            foreach( const QPolygonF &polygon, lineString->m_clippedPolygons ) {
+                path.addPolygon( polygon );
+            }
+            lineString->m_clippedPolygons.clear();
+        } else {
+            separateItems << lineString;
+        }
+    }
+
+    if ( !path.isEmpty() ) {
+        painter->save();
+        painter->setBrush( Qt::NoBrush );
+        painter->drawPath( path );
+        painter->restore();
+    }
+
+    foreach( GeoLineStringGraphicsItem *lineString, separateItems ) {
+        painter->drawScreenPolylines( lineString->m_clippedPolygons, lineString->feature()->name(), labelPositionFlags );
+        lineString->m_clippedPolygons.clear();
+    }
+
+    painter->setScreenClip( screenClip );
+    painter->restore();
+}
+
+void GeoLineStringGraphicsItem::preparePaint( const ViewportParams *viewport )
+{
+    if ( !m_prepared ) {
+        prepare( viewport );
+    }
+    m_prepared = false;
+}
+
+LabelPositionFlags GeoLineStringGraphicsItem::setupPainter( GeoPainter *painter, const ViewportParams *viewport ) const
+{
+    LabelPositionFlags labelPositionFlags = NoLabel;
+
     if ( !style() ) {
         painter->setPen( QPen() );
     }
@@ -50,16 +168,8 @@ void GeoLineStringGraphicsItem::paint( GeoPainter* painter, const ViewportParams
         if ( currentPen.color() != style()->lineStyle().paintedColor() )
             currentPen.setColor( style()->lineStyle().paintedColor() );
 
-        if ( currentPen.widthF() != style()->lineStyle().width() ||
-                style()->lineStyle().physicalWidth() != 0.0 ) {
-            if ( float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth() < style()->lineStyle().width() )
-                currentPen.setWidthF( style()->lineStyle().width() );
-            else
-                currentPen.setWidthF( float( viewport->radius() ) / EARTH_RADIUS * style()->lineStyle().physicalWidth() );
-        }
-        else if ( style()->lineStyle().width() != 0.0 ) {
-            currentPen.setWidthF( style()->lineStyle().width() );
-        }
+        if ( currentPen.widthF() != lineWidth( viewport ) )
+            currentPen.setWidthF( lineWidth( viewport ) );
 
         if ( currentPen.capStyle() != style()->lineStyle().capStyle() )
             currentPen.setCapStyle( style()->lineStyle().capStyle() );
@@ -100,9 +210,7 @@ void GeoLineStringGraphicsItem::paint( GeoPainter* painter, const ViewportParams
         }
     }
 
-    painter->drawPolyline( *m_lineString, feature()->name(), labelPositionFlags );
-
-    painter->restore();
+    return labelPositionFlags;
 }
 
 }
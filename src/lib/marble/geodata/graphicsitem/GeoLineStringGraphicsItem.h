@@ -12,6 +12,8 @@
 #define MARBLE_GEOLINESTRINGGRAPHICSITEM_H
 
 #include "GeoGraphicsItem.h"
+#include "MarbleGlobal.h"
+#include "ScreenPolygonCache.h"
 #include "marble_export.h"
 
 namespace Marble
@@ -29,10 +31,27 @@ public:
 
     virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
+    virtual void prepare( const ViewportParams *viewport );
+
     virtual void paint( GeoPainter* painter, const ViewportParams *viewport );
 
+    virtual const char *batchType() const;
+
+    virtual void paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                             const QList<GeoGraphicsItem*> &items );
+
 protected:
     const GeoDataLineString *m_lineString;
+    ScreenPolygonCache m_screenPolygons;
+
+private:
+    qreal lineWidth( const ViewportParams *viewport ) const;
+    void preparePaint( const ViewportParams *viewport );
+    LabelPositionFlags setupPainter( GeoPainter *painter, const ViewportParams *viewport ) const;
+
+    // the screen polylines clipped by prepare() for the next paint()
+    QVector<QPolygonF> m_clippedPolygons;
+    bool m_prepared;
 };
 
 }
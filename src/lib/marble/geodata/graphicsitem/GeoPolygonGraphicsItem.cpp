@@ -11,6 +11,7 @@
 #include "GeoPolygonGraphicsItem.h"
 
 #include "GeoDataLinearRing.h"
+#include "ClipPainter.h"
 #include "GeoDataPolygon.h"
 #include "GeoPainter.h"
 #include "ViewportParams.h"
@@ -22,14 +23,16 @@ namespace Marble
 GeoPolygonGraphicsItem::GeoPolygonGraphicsItem( const GeoDataFeature *feature, const GeoDataPolygon* polygon )
         : GeoGraphicsItem( feature ),
           m_polygon( polygon ),
-          m_ring( 0 )
+          m_ring( 0 ),
+          m_prepared( false )
 {
 }
 
 GeoPolygonGraphicsItem::GeoPolygonGraphicsItem( const GeoDataFeature *feature, const GeoDataLinearRing* ring )
         : GeoGraphicsItem( feature ),
           m_polygon( 0 ),
-          m_ring( ring )
+          m_ring( ring ),
+          m_prepared( false )
 {
 }
 
@@ -44,12 +47,109 @@ const GeoDataLatLonAltBox& GeoPolygonGraphicsItem::latLonAltBox() const
     }
 }
 
+void GeoPolygonGraphicsItem::prepare( const ViewportParams *viewport )
+{
+    m_prepared = true;
+    m_clippedPolygons.clear();
+    m_clippedOutlines.clear();
+
+    const GeoDataLatLonAltBox &box = m_polygon ? m_polygon->outerBoundary().latLonAltBox()
+                                               : latLonAltBox();
+    if ( !viewport->viewLatLonAltBox().intersects( box ) || !viewport->resolves( box ) ) {
+        return;
+    }
+
+    if ( !m_screenPolygons.isValid( viewport ) ) {
+        const int level = GeoDataLineString::generalizationLevel( viewport->angularResolution() );
+        if ( m_polygon ) {
+            GeoDataPolygon polygon( m_polygon->tessellationFlags() );
+            polygon.setOuterBoundary( m_polygon->outerBoundary().generalized( level ) );
+            foreach( const GeoDataLinearRing &innerBoundary, m_polygon->innerBoundaries() ) {
+                polygon.appendInnerBoundary( innerBoundary.generalized( level ) );
+            }
+            m_screenPolygons.setPolygon( viewport, polygon );
+        } else if ( m_ring ) {
+            m_screenPolygons.setLineString( viewport, m_ring->generalized( level ) );
+        }
+    }
+
+    // clip like ClipPainter does for the pen
+    const qreal lineWidth = style() && style()->polyStyle().outline() ? style()->lineStyle().width() : 0.0;
+    const qreal margin = lineWidth / 2.0 + 1.0;
+    const QRectF clipRect = QRectF( 0, 0, viewport->width(), viewport->height() ).adjusted( -margin, -margin, margin, margin );
+    foreach( const QPolygonF &polygon, m_screenPolygons.polygons() ) {
+        ClipPainter::clip( polygon, clipRect, true, m_clippedPolygons );
+    }
+    foreach( const QPolygonF &outline, m_screenPolygons.outlines() ) {
+        ClipPainter::clip( outline, clipRect, false, m_clippedOutlines );
+    }
+}
+
 void GeoPolygonGraphicsItem::paint( GeoPainter* painter, const ViewportParams* viewport )
 {
-    Q_UNUSED( viewport );
+    paintBatch( painter, viewport, QList<GeoGraphicsItem*>() << this );
+}
+
+const char *GeoPolygonGraphicsItem::batchType() const
+{
+    return "GeoPolygonGraphicsItem";
+}
+
+void GeoPolygonGraphicsItem::paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                                         const QList<GeoGraphicsItem*> &items )
+{
+    QList<GeoPolygonGraphicsItem*> visibleItems;
+    foreach( GeoGraphicsItem *item, items ) {
+        GeoPolygonGraphicsItem *polygon = static_cast<GeoPolygonGraphicsItem*>( item );
+        polygon->preparePaint( viewport );
+        if ( !polygon->m_clippedPolygons.isEmpty() || !polygon->m_clippedOutlines.isEmpty() ) {
+            visibleItems << polygon;
+        }
+    }
+
+    if ( visibleItems.isEmpty() ) {
+        return;
+    }
 
     painter->save();
 
+    setupPainter( painter );
+
+    // the polygons are clipped already
+    const bool screenClip = painter->hasScreenClip();
+    painter->setScreenClip( false );
+
+    // Overlapping polygons would change the fill when merged into one path,
+    // so only the painter setup is shared
+    foreach( GeoPolygonGraphicsItem *polygon, visibleItems ) {
+        if ( polygon->m_clippedOutlines.isEmpty() && !polygon->m_screenPolygons.outlines().isEmpty() ) {
+            // the outlines of the holes are off screen, the cut polygons must
+            // not get any outline either
+            const QPen pen = painter->pen();
+            painter->setPen( QPen( Qt::NoPen ) );
+            painter->drawScreenPolygons( polygon->m_clippedPolygons );
+            painter->setPen( pen );
+        } else {
+            painter->drawScreenPolygons( polygon->m_clippedPolygons, polygon->m_clippedOutlines );
+        }
+        polygon->m_clippedPolygons.clear();
+        polygon->m_clippedOutlines.clear();
+    }
+
+    painter->setScreenClip( screenClip );
+    painter->restore();
+}
+
+void GeoPolygonGraphicsItem::preparePaint( const ViewportParams *viewport )
+{
+    if ( !m_prepared ) {
+        prepare( viewport );
+    }
+    m_prepared = false;
+}
+
+void GeoPolygonGraphicsItem::setupPainter( GeoPainter *painter ) const
+{
     if ( !style() ) {
         painter->setPen( QPen() );
     }
@@ -93,14 +193,6 @@ void GeoPolygonGraphicsItem::paint( GeoPainter* painter, const ViewportParams* v
             }
         }
     }
-
-    if ( m_polygon ) {
-        painter->drawPolygon( *m_polygon );
-    } else if ( m_ring ) {
-        painter->drawPolygon( *m_ring );
-    }
-
-    painter->restore();
 }
 
 }
@@ -12,6 +12,7 @@
 #define MARBLE_GEOPOLYGONGRAPHICSITEM_H
 
 #include "GeoGraphicsItem.h"
+#include "ScreenPolygonCache.h"
 #include "marble_export.h"
 
 namespace Marble
@@ -28,11 +29,28 @@ public:
 
     virtual const GeoDataLatLonAltBox& latLonAltBox() const;
 
+    virtual void prepare( const ViewportParams *viewport );
+
     virtual void paint( GeoPainter* painter, const ViewportParams *viewport );
 
+    virtual const char *batchType() const;
+
+    virtual void paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                             const QList<GeoGraphicsItem*> &items );
+
 protected:
     const GeoDataPolygon *const m_polygon;
     const GeoDataLinearRing *const m_ring;
+    ScreenPolygonCache m_screenPolygons;
+
+private:
+    void preparePaint( const ViewportParams *viewport );
+    void setupPainter( GeoPainter *painter ) const;
+
+    // the screen polygons clipped by prepare() for the next paint()
+    QVector<QPolygonF> m_clippedPolygons;
+    QVector<QPolygonF> m_clippedOutlines;
+    bool m_prepared;
 };
 
 }
@@ -28,11 +28,11 @@ void GeoTrackGraphicsItem::setTrack( const GeoDataTrack* track )
     update();
 }
 
-void GeoTrackGraphicsItem::paint( GeoPainter *painter, const ViewportParams *viewport )
+void GeoTrackGraphicsItem::prepare( const ViewportParams *viewport )
 {
     update();
 
-    GeoLineStringGraphicsItem::paint( painter, viewport );
+    GeoLineStringGraphicsItem::prepare( viewport );
 }
 
 void GeoTrackGraphicsItem::update()
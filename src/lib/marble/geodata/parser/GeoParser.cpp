@@ -188,6 +188,14 @@ void GeoParser::parseDocument()
         dumpParentStack( name().toString() + "-discarded", m_nodeStack.size(), true );
     }
 #endif
+
+    if ( stackItem.associatedNode() ) {
+        nodeParsed( stackItem.associatedNode() );
+    }
+}
+
+void GeoParser::nodeParsed( GeoNode* )
+{
 }
 
 void GeoParser::raiseWarning( const QString& warning )
@@ -85,6 +85,13 @@ protected:
 
     virtual GeoDocument* createDocument() const = 0;
 
+    /**
+     * This method is called after @p node and all of its children got parsed.
+     * The default implementation does nothing. It allows parsers to pass on
+     * completed parts of the document while the rest is still being read.
+     */
+    virtual void nodeParsed( GeoNode* node );
+
 protected:
     GeoDocument* m_document;
     GeoDataGenericSourceType m_source;
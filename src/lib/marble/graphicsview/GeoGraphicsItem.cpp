@@ -18,6 +18,8 @@
 #include "MarbleDebug.h"
 
 #include <QColor>
+#include <QHash>
+#include <QPair>
 
 using namespace Marble;
 
@@ -77,6 +79,65 @@ void GeoGraphicsItem::setLatLonAltBox( const GeoDataLatLonAltBox& latLonAltBox )
     p()->m_latLonAltBox = latLonAltBox;
 }
 
+void GeoGraphicsItem::prepare( const ViewportParams *viewport )
+{
+    Q_UNUSED( viewport );
+}
+
+const char *GeoGraphicsItem::batchType() const
+{
+    return 0;
+}
+
+void GeoGraphicsItem::paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                                  const QList<GeoGraphicsItem*> &items )
+{
+    foreach( GeoGraphicsItem *item, items ) {
+        item->paint( painter, viewport );
+    }
+}
+
+void GeoGraphicsItem::paintItems( GeoPainter *painter, const ViewportParams *viewport,
+                                  const QList<GeoGraphicsItem*> &items )
+{
+    typedef QPair<const char*, const GeoDataStyle*> BatchKey;
+
+    int begin = 0;
+    while ( begin < items.size() ) {
+        const qreal zValue = items.at( begin )->zValue();
+        int end = begin + 1;
+        while ( end < items.size() && items.at( end )->zValue() == zValue ) {
+            ++end;
+        }
+
+        QList< QList<GeoGraphicsItem*> > batches;
+        QHash<BatchKey, int> batchIndexes;
+        for ( int i = begin; i < end; ++i ) {
+            GeoGraphicsItem *item = items.at( i );
+            const char *type = item->batchType();
+            if ( !type ) {
+                batches << ( QList<GeoGraphicsItem*>() << item );
+                continue;
+            }
+
+            const BatchKey key( type, item->style() );
+            const QHash<BatchKey, int>::const_iterator index = batchIndexes.constFind( key );
+            if ( index == batchIndexes.constEnd() ) {
+                batchIndexes.insert( key, batches.size() );
+                batches << ( QList<GeoGraphicsItem*>() << item );
+            } else {
+                batches[index.value()] << item;
+            }
+        }
+
+        foreach( const QList<GeoGraphicsItem*> &batch, batches ) {
+            batch.first()->paintBatch( painter, viewport, batch );
+        }
+
+        begin = end;
+    }
+}
+
 void GeoGraphicsItem::setStyle( const GeoDataStyle* style )
 {
     p()->m_style = style;
@@ -15,6 +15,9 @@
 // Marble
 #include "marble_export.h"
 
+// Qt
+#include <QList>
+
 class QString;
 
 namespace Marble
@@ -118,6 +121,15 @@ class MARBLE_EXPORT GeoGraphicsItem
      */
     void setZValue( qreal z );
 
+    /**
+     * Prepares painting the item in the given viewport, e.g. by projecting its geometry.
+     *
+     * GeometryLayer calls this for all items of a frame before painting them, using
+     * several threads at once. Implementations must only change the state of their
+     * own item. The default implementation does nothing.
+     */
+    virtual void prepare( const ViewportParams *viewport );
+
     /**
      * Paints the item using the given GeoPainter.
      *
@@ -126,6 +138,31 @@ class MARBLE_EXPORT GeoGraphicsItem
      */
     virtual void paint( GeoPainter *painter, const ViewportParams *viewport ) = 0;
 
+    /**
+     * Returns a name shared by all items that paintBatch() of this item can paint,
+     * or 0 if the item is painted alone. Items of equal z value, batch type and
+     * style are painted by one call of paintBatch().
+     * The default implementation returns 0.
+     */
+    virtual const char *batchType() const;
+
+    /**
+     * Paints the given items, which all have the batch type and style of this item,
+     * setting up the painter only once. The default implementation paints the items
+     * one by one.
+     */
+    virtual void paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                             const QList<GeoGraphicsItem*> &items );
+
+    /**
+     * Paints @p items, which must be sorted by z value. The items of equal z value
+     * are grouped by batch type and style, and each group is painted by one call of
+     * paintBatch(). The groups are painted in the order of their first items, and
+     * each group keeps the order of its items.
+     */
+    static void paintItems( GeoPainter *painter, const ViewportParams *viewport,
+                            const QList<GeoGraphicsItem*> &items );
+
     void setHighlighted( bool highlight );
 
     bool isHighlighted() const;
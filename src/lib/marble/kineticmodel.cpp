@@ -88,6 +88,27 @@ QPointF KineticModel::position() const
     return d_ptr->position;
 }
 
+// position where the motion started by start() comes to rest
+QPointF KineticModel::restingPosition() const
+{
+    Q_D(const KineticModel);
+
+    QPointF result = d->position;
+    if (!d->ticker.isActive()) {
+        return result;
+    }
+
+    // the velocity decreases linearly
+    if (d->deacceleration.x() > 0) {
+        result.rx() += d->velocity.x() * qAbs(d->velocity.x()) / (2 * d->deacceleration.x());
+    }
+    if (d->deacceleration.y() > 0) {
+        result.ry() += d->velocity.y() * qAbs(d->velocity.y()) / (2 * d->deacceleration.y());
+    }
+
+    return result;
+}
+
 void KineticModel::setPosition(QPointF position)
 {
     setPosition( position.x(), position.y() );
@@ -49,6 +49,7 @@ public:
 
     int duration() const;
     QPointF position() const;
+    QPointF restingPosition() const;
     int updateInterval() const;
 
 public slots:
@@ -16,6 +16,7 @@
 // Marble
 #include "GeoDataDocument.h"
 #include "GeoDataFolder.h"
+#include "GeoDataLatLonAltBox.h"
 #include "GeoDataLineStyle.h"
 #include "GeoDataMultiTrack.h"
 #include "GeoDataObject.h"
@@ -35,6 +36,7 @@
 #include "GeoGraphicsItem.h"
 #include "GeoLineStringGraphicsItem.h"
 #include "GeoPolygonGraphicsItem.h"
+#include "ScreenPolygonCache.h"
 #include "GeoTrackGraphicsItem.h"
 #include "GeoDataPhotoOverlay.h"
 #include "GeoDataScreenOverlay.h"
@@ -50,17 +52,51 @@
 #include <QAbstractItemModel>
 #include <QModelIndex>
 #include <QColor>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
 
 namespace Marble
 {
+
+/**
+ * Prepares items for painting, taking the next item not yet taken by any
+ * other job until all items are prepared.
+ */
+class PrepareItemsJob : public QRunnable
+{
+public:
+    PrepareItemsJob( const QList<GeoGraphicsItem*> *items, QAtomicInt *next, const ViewportParams *viewport )
+        : m_items( items ),
+          m_next( next ),
+          m_viewport( viewport )
+    {
+    }
+
+    virtual void run()
+    {
+        for ( int i = m_next->fetchAndAddRelaxed( 1 ); i < m_items->size(); i = m_next->fetchAndAddRelaxed( 1 ) ) {
+            m_items->at( i )->prepare( m_viewport );
+        }
+    }
+
+private:
+    const QList<GeoGraphicsItem*> *const m_items;
+    QAtomicInt *const m_next;
+    const ViewportParams *const m_viewport;
+};
+
 class GeometryLayerPrivate
 {
 public:
     GeometryLayerPrivate( const QAbstractItemModel *model );
 
-    void createGraphicsItems( const GeoDataObject *object );
-    void createGraphicsItemFromGeometry( const GeoDataGeometry *object, const GeoDataPlacemark *placemark );
-    void createGraphicsItemFromOverlay( const GeoDataOverlay *overlay );
+    void prepareItems( const QList<GeoGraphicsItem*> &items, const ViewportParams *viewport );
+
+    void createGraphicsItems( const GeoDataObject *object, QList<GeoGraphicsItem*> &items );
+    void createGraphicsItemFromGeometry( const GeoDataGeometry *object, const GeoDataPlacemark *placemark, QList<GeoGraphicsItem*> &items );
+    void createGraphicsItemFromOverlay( const GeoDataOverlay *overlay, QList<GeoGraphicsItem*> &items );
     void removeGraphicsItems( const GeoDataFeature *feature );
 
     static int maximumZoomLevel();
@@ -69,6 +105,7 @@ public:
     GeoGraphicsScene m_scene;
     QString m_runtimeTrace;
     QList<ScreenOverlayGraphicsItem*> m_items;
+    QThreadPool m_threadPool;
 
 private:
     static void initializeDefaultValues();
@@ -97,12 +134,33 @@ int GeometryLayerPrivate::maximumZoomLevel()
     return s_maximumZoomLevel;
 }
 
+void GeometryLayerPrivate::prepareItems( const QList<GeoGraphicsItem*> &items, const ViewportParams *viewport )
+{
+    // Below this, starting the threads costs more than it saves
+    const int minimumItemsPerThread = 16;
+    const int threadCount = qMin( m_threadPool.maxThreadCount(), items.size() / minimumItemsPerThread );
+
+    QAtomicInt next( 0 );
+    for ( int i = 1; i < threadCount; ++i ) {
+        m_threadPool.start( new PrepareItemsJob( &items, &next, viewport ) );
+    }
+
+    // the GUI thread does its share, too
+    PrepareItemsJob job( &items, &next, viewport );
+    job.run();
+
+    m_threadPool.waitForDone();
+}
+
 GeometryLayer::GeometryLayer( const QAbstractItemModel *model )
         : d( new GeometryLayerPrivate( model ) )
 {
     const GeoDataObject *object = static_cast<GeoDataObject*>( d->m_model->index( 0, 0, QModelIndex() ).internalPointer() );
-    if ( object && object->parent() )
-        d->createGraphicsItems( object->parent() );
+    if ( object && object->parent() ) {
+        QList<GeoGraphicsItem*> items;
+        d->createGraphicsItems( object->parent(), items );
+        d->m_scene.addItems( items );
+    }
 
     connect( model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
              this, SLOT(resetCacheData()) );
@@ -253,24 +311,36 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
     int maxZoomLevel = qMin<int>( qMax<int>( qLn( viewport->radius() *4 / 256 ) / qLn( 2.0 ), 1), GeometryLayerPrivate::maximumZoomLevel() );
     QList<GeoGraphicsItem*> items = d->m_scene.items( viewport->viewLatLonAltBox(), maxZoomLevel );
 
-    int painted = 0;
+    QList<GeoGraphicsItem*> visibleItems;
     foreach( GeoGraphicsItem* item, items )
     {
         if ( item->latLonAltBox().intersects( viewport->viewLatLonAltBox() ) ) {
-            item->paint( painter, viewport );
-            ++painted;
+            visibleItems << item;
         }
     }
 
+    // Projecting and clipping the items does not need the painter, so do it
+    // for all items in parallel first. Only then paint them in z order.
+    // The view box of the viewport has been computed above, so the threads
+    // only read from the viewport.
+    d->prepareItems( visibleItems, viewport );
+
+    GeoGraphicsItem::paintItems( painter, viewport, visibleItems );
+
     foreach( ScreenOverlayGraphicsItem* item, d->m_items ) {
         item->paintEvent( painter, viewport );
     }
 
     painter->restore();
-    d->m_runtimeTrace = QString( "Geometries: %1 Drawn: %2 Zoom: %3")
+
+    // free the screen polygons of items which have not been painted for a while
+    ScreenPolygonCache::trim();
+
+    d->m_runtimeTrace = QString( "Geometries: %1 Drawn: %2 Zoom: %3 Cache: %4 kB")
                 .arg( items.size() )
-                .arg( painted )
-                .arg( maxZoomLevel );
+                .arg( visibleItems.size() )
+                .arg( maxZoomLevel )
+                .arg( ScreenPolygonCache::cacheSize() );
     return true;
 }
 
@@ -284,13 +354,22 @@ QString GeometryLayer::runtimeTrace() const
     return d->m_runtimeTrace;
 }
 
-void GeometryLayerPrivate::createGraphicsItems( const GeoDataObject *object )
+void GeometryLayerPrivate::createGraphicsItems( const GeoDataObject *object, QList<GeoGraphicsItem*> &items )
 {
+    // Hidden features are not painted, and neither is anything below them.
+    // Changing the visibility updates the feature in the tree model, which
+    // gets the items created then.
+    if ( const GeoDataFeature *feature = dynamic_cast<const GeoDataFeature*>( object ) ) {
+        if ( !feature->isVisible() ) {
+            return;
+        }
+    }
+
     if ( const GeoDataPlacemark *placemark = dynamic_cast<const GeoDataPlacemark*>( object ) )
     {
-        createGraphicsItemFromGeometry( placemark->geometry(), placemark );
+        createGraphicsItemFromGeometry( placemark->geometry(), placemark, items );
     } else if ( const GeoDataOverlay* overlay = dynamic_cast<const GeoDataOverlay*>( object ) ) {
-        createGraphicsItemFromOverlay( overlay );
+        createGraphicsItemFromOverlay( overlay, items );
     }
 
     // parse all child objects of the container
@@ -299,12 +378,12 @@ void GeometryLayerPrivate::createGraphicsItems( const GeoDataObject *object )
         int rowCount = container->size();
         for ( int row = 0; row < rowCount; ++row )
         {
-            createGraphicsItems( container->child( row ) );
+            createGraphicsItems( container->child( row ), items );
         }
     }
 }
 
-void GeometryLayerPrivate::createGraphicsItemFromGeometry( const GeoDataGeometry* object, const GeoDataPlacemark *placemark )
+void GeometryLayerPrivate::createGraphicsItemFromGeometry( const GeoDataGeometry* object, const GeoDataPlacemark *placemark, QList<GeoGraphicsItem*> &items )
 {
     GeoGraphicsItem *item = 0;
     if ( object->nodeType() == GeoDataTypes::GeoDataLineStringType )
@@ -328,7 +407,7 @@ void GeometryLayerPrivate::createGraphicsItemFromGeometry( const GeoDataGeometry
         int rowCount = multigeo->size();
         for ( int row = 0; row < rowCount; ++row )
         {
-            createGraphicsItemFromGeometry( multigeo->child( row ), placemark );
+            createGraphicsItemFromGeometry( multigeo->child( row ), placemark, items );
         }
     }
     else if ( object->nodeType() == GeoDataTypes::GeoDataMultiTrackType  )
@@ -337,7 +416,7 @@ void GeometryLayerPrivate::createGraphicsItemFromGeometry( const GeoDataGeometry
         int rowCount = multitrack->size();
         for ( int row = 0; row < rowCount; ++row )
         {
-            createGraphicsItemFromGeometry( multitrack->child( row ), placemark );
+            createGraphicsItemFromGeometry( multitrack->child( row ), placemark, items );
         }
     }
     else if ( object->nodeType() == GeoDataTypes::GeoDataTrackType )
@@ -351,10 +430,10 @@ void GeometryLayerPrivate::createGraphicsItemFromGeometry( const GeoDataGeometry
     item->setVisible( placemark->isGloballyVisible() );
     item->setZValue( s_defaultZValues[placemark->visualCategory()] );
     item->setMinZoomLevel( s_defaultMinZoomLevels[placemark->visualCategory()] );
-    m_scene.addItem( item );
+    items << item;
 }
 
-void GeometryLayerPrivate::createGraphicsItemFromOverlay( const GeoDataOverlay *overlay )
+void GeometryLayerPrivate::createGraphicsItemFromOverlay( const GeoDataOverlay *overlay, QList<GeoGraphicsItem*> &items )
 {
     GeoGraphicsItem* item = 0;
     if ( overlay->nodeType() == GeoDataTypes::GeoDataPhotoOverlayType ) {
@@ -371,7 +450,7 @@ void GeometryLayerPrivate::createGraphicsItemFromOverlay( const GeoDataOverlay *
     if ( item ) {
         item->setStyle( overlay->style() );
         item->setVisible( overlay->isGloballyVisible() );
-        m_scene.addItem( item );
+        items << item;
     }
 }
 
@@ -401,13 +480,19 @@ void GeometryLayer::addPlacemarks( QModelIndex parent, int first, int last )
 {
     Q_ASSERT( first < d->m_model->rowCount( parent ) );
     Q_ASSERT( last < d->m_model->rowCount( parent ) );
+    QList<GeoGraphicsItem*> items;
     for( int i=first; i<=last; ++i ) {
         QModelIndex index = d->m_model->index( i, 0, parent );
         Q_ASSERT( index.isValid() );
         const GeoDataObject *object = qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) );
         Q_ASSERT( object );
-        d->createGraphicsItems( object );
+        const GeoDataFeature *feature = dynamic_cast<const GeoDataFeature*>( object );
+        if ( feature && !feature->isGloballyVisible() ) {
+            continue;
+        }
+        d->createGraphicsItems( object, items );
     }
+    d->m_scene.addItems( items );
     emit repaintNeeded();
 
 }
@@ -439,8 +524,11 @@ void GeometryLayer::resetCacheData()
     d->m_items.clear();
 
     const GeoDataObject *object = static_cast<GeoDataObject*>( d->m_model->index( 0, 0, QModelIndex() ).internalPointer() );
-    if ( object && object->parent() )
-        d->createGraphicsItems( object->parent() );
+    if ( object && object->parent() ) {
+        QList<GeoGraphicsItem*> items;
+        d->createGraphicsItems( object->parent(), items );
+        d->m_scene.addItems( items );
+    }
     emit repaintNeeded();
 }
 
@@ -480,6 +568,16 @@ void GeometryLayer::handleHighlight( qreal lon, qreal lat, GeoDataCoordinates::U
     GeoDataCoordinates clickedPoint( lon, lat, 0, unit );
     QVector<GeoDataPlacemark*> selectedPlacemarks;
 
+    // Only the placemarks whose items are near the clicked point can be hit.
+    // The scene finds them without looking at the others, and it holds no
+    // hidden placemarks.
+    const GeoDataLatLonBox clickedBox( clickedPoint.latitude(), clickedPoint.latitude(),
+                                       clickedPoint.longitude(), clickedPoint.longitude() );
+    QSet<const GeoDataFeature*> candidates;
+    foreach ( const GeoGraphicsItem *item, d->m_scene.items( clickedBox, GeometryLayerPrivate::maximumZoomLevel() ) ) {
+        candidates.insert( item->feature() );
+    }
+
     for ( int i = 0; i < d->m_model->rowCount(); ++i ) {
         QVariant const data = d->m_model->data ( d->m_model->index ( i, 0 ), MarblePlacemarkModel::ObjectPointerRole );
         GeoDataObject *object = qvariant_cast<GeoDataObject*> ( data );
@@ -487,6 +585,18 @@ void GeometryLayer::handleHighlight( qreal lon, qreal lat, GeoDataCoordinates::U
         if ( object->nodeType() == GeoDataTypes::GeoDataDocumentType ) {
             Q_ASSERT( dynamic_cast<const GeoDataDocument *>( object ) != 0 );
             GeoDataDocument* doc = static_cast<GeoDataDocument*> ( object );
+
+                // Skip hidden documents and those nowhere near the clicked
+                // point without looking at their placemarks. Altitudes don't
+                // matter here.
+                if ( !doc->isVisible() ) {
+                    continue;
+                }
+                const GeoDataLatLonBox box = doc->latLonAltBox();
+                if ( !box.contains( clickedPoint ) ) {
+                    continue;
+                }
+
                 bool isHighlight = false;
 
                 foreach ( const GeoDataStyleMap &styleMap, doc->styleMaps() ) {
@@ -510,6 +620,9 @@ void GeometryLayer::handleHighlight( qreal lon, qreal lat, GeoDataCoordinates::U
                     for ( ; iter != end; ++iter ) {
                         if ( (*iter)->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
                             GeoDataPlacemark *placemark = static_cast<GeoDataPlacemark*>( *iter );
+                            if ( !candidates.contains( placemark ) ) {
+                                continue;
+                            }
                             GeoDataPolygon *polygon = dynamic_cast<GeoDataPolygon*>( placemark->geometry() );
                             GeoDataLineString *lineString = dynamic_cast<GeoDataLineString*>( placemark->geometry() );
                             GeoDataMultiGeometry *multiGeometry = dynamic_cast<GeoDataMultiGeometry*>(placemark->geometry() );
@@ -15,6 +15,8 @@
 #include <qmath.h>
 #include <QTimer>
 #include <QList>
+#include <QMultiMap>
+#include <QMutexLocker>
 #include <QSortFilterProxyModel>
 
 #include "SphericalScanlineTextureMapper.h"
@@ -42,6 +44,10 @@ namespace Marble
 
 const int REPAINT_SCHEDULING_INTERVAL = 1000;
 
+// upper limit of the tiles prefetched for a viewport, which suffices for
+// about twice the size of a full HD screen
+const int maximumPrefetchedTiles = 96;
+
 class TextureLayer::Private
 {
 public:
@@ -60,6 +66,14 @@ public:
 
     void updateGroundOverlays();
 
+    int tileLevel( int radius ) const;
+
+    /**
+     * Returns the ids of the stacked tiles of the given level which are visible
+     * in @p viewport, the ones closest to the center first.
+     */
+    QList<TileId> visibleTileIds( const ViewportParams *viewport, int level ) const;
+
     static bool drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 );
 
 public:
@@ -149,7 +163,10 @@ void TextureLayer::Private::updateTextureLayers()
 
     updateGroundOverlays();
 
+    m_tileLoader.cancelPrefetch();
+    m_tileLoader.decoratorMutex()->lock();
     m_layerDecorator.setTextureLayers( result );
+    m_tileLoader.decoratorMutex()->unlock();
     m_tileLoader.clear();
 
     m_parent->setNeedsUpdate();
@@ -165,6 +182,78 @@ void TextureLayer::Private::updateTile( const TileId &tileId, const QImage &tile
     requestDelayedRepaint();
 }
 
+int TextureLayer::Private::tileLevel( int radius ) const
+{
+    // choose the smaller dimension for selecting the tile level, leading to higher-resolution results
+    const int levelZeroWidth = m_layerDecorator.tileSize().width() * m_layerDecorator.tileColumnCount( 0 );
+    const int levelZeroHight = m_layerDecorator.tileSize().height() * m_layerDecorator.tileRowCount( 0 );
+    const int levelZeroMinDimension = qMin( levelZeroWidth, levelZeroHight );
+
+    // limit to 1 as dirty fix for invalid entry linearLevel
+    const qreal linearLevel = qMax<qreal>( 1.0, radius * 4.0 / levelZeroMinDimension );
+
+    // As our tile resolution doubles with each level we calculate
+    // the tile level from tilesize and the globe radius via log(2)
+    const qreal tileLevelF = qLn( linearLevel ) / qLn( 2.0 ) * 1.00001;  // snap to the sharper tile level a tiny bit earlier
+                                                                         // to work around rounding errors when the radius
+                                                                         // roughly equals the global texture width
+
+    return qMin<int>( m_layerDecorator.maximumTileLevel(), tileLevelF );
+}
+
+QList<TileId> TextureLayer::Private::visibleTileIds( const ViewportParams *viewport, int level ) const
+{
+    const int columns = m_layerDecorator.tileColumnCount( level );
+    const int rows = m_layerDecorator.tileRowCount( level );
+    const bool isMercator = m_layerDecorator.tileProjection() == GeoSceneTiled::Mercator;
+
+    // the latitude at which the Mercator projection is cut off, atan( sinh( pi ) )
+    const qreal maxMercatorLat = 1.4844222297;
+
+    const GeoDataLatLonBox box = viewport->viewLatLonAltBox();
+    const qreal lons[] = { box.west(), box.east(), viewport->centerLongitude() };
+    const qreal lats[] = { box.north(), box.south(), viewport->centerLatitude() };
+
+    int tileX[3];
+    int tileY[3];
+    for ( int i = 0; i < 3; ++i ) {
+        tileX[i] = qBound( 0, int( ( lons[i] + M_PI ) / ( 2 * M_PI ) * columns ), columns - 1 );
+
+        qreal y;
+        if ( isMercator ) {
+            const qreal lat = qBound( -maxMercatorLat, lats[i], maxMercatorLat );
+            y = ( 1.0 - log( tan( lat ) + 1.0 / cos( lat ) ) / M_PI ) / 2.0;
+        } else {
+            y = 0.5 - lats[i] / M_PI;
+        }
+        tileY[i] = qBound( 0, int( y * rows ), rows - 1 );
+    }
+
+    // Order the tiles by their distance to the center tile. Tiles far away from it
+    // are not considered, e.g. all tiles around a pole visible in the viewport.
+    const int maxDelta = 8;
+    QMultiMap<int, TileId> tiles;
+    for ( int y = qMax( tileY[0], tileY[2] - maxDelta ); y <= qMin( tileY[1], tileY[2] + maxDelta ); ++y ) {
+        for ( int deltaX = -maxDelta; deltaX <= maxDelta; ++deltaX ) {
+            // visit each column only once if there are only a few of them
+            if ( deltaX < -( columns / 2 ) || deltaX >= columns - columns / 2 ) {
+                continue;
+            }
+
+            const int x = ( ( tileX[2] + deltaX ) % columns + columns ) % columns;
+
+            // the box crosses the date line if west is right of east
+            const bool inBox = tileX[0] <= tileX[1] ? ( x >= tileX[0] && x <= tileX[1] )
+                                                    : ( x >= tileX[0] || x <= tileX[1] );
+            if ( inBox ) {
+                tiles.insert( qAbs( deltaX ) + qAbs( y - tileY[2] ), TileId( 0, level, x, y ) );
+            }
+        }
+    }
+
+    return tiles.values();
+}
+
 bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 )
 {
     return o1->drawOrder() < o2->drawOrder();
@@ -217,6 +306,10 @@ void TextureLayer::Private::resetGroundOverlaysCache()
 
 void TextureLayer::Private::updateGroundOverlays()
 {
+    // the prefetching thread must not read the ground overlays meanwhile
+    m_tileLoader.cancelPrefetch();
+    QMutexLocker locker( m_tileLoader.decoratorMutex() );
+
     if ( !m_texcolorizer ) {
         m_layerDecorator.updateGroundOverlays( m_groundOverlayCache );
     }
@@ -303,24 +396,10 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
          d->m_centerCoordinates.latitude() != viewport->centerLatitude() ) {
         d->m_centerCoordinates.setLongitude( viewport->centerLongitude() );
         d->m_centerCoordinates.setLatitude( viewport->centerLatitude() );
-        d->m_texmapper->setRepaintNeeded();
+        d->m_texmapper->setCenterChanged();
     }
 
-    // choose the smaller dimension for selecting the tile level, leading to higher-resolution results
-    const int levelZeroWidth = d->m_layerDecorator.tileSize().width() * d->m_layerDecorator.tileColumnCount( 0 );
-    const int levelZeroHight = d->m_layerDecorator.tileSize().height() * d->m_layerDecorator.tileRowCount( 0 );
-    const int levelZeroMinDimension = qMin( levelZeroWidth, levelZeroHight );
-
-    // limit to 1 as dirty fix for invalid entry linearLevel
-    const qreal linearLevel = qMax<qreal>( 1.0, viewport->radius() * 4.0 / levelZeroMinDimension );
-
-    // As our tile resolution doubles with each level we calculate
-    // the tile level from tilesize and the globe radius via log(2)
-    const qreal tileLevelF = qLn( linearLevel ) / qLn( 2.0 ) * 1.00001;  // snap to the sharper tile level a tiny bit earlier
-                                                                         // to work around rounding errors when the radius
-                                                                         // roughly equals the global texture width
-
-    const int tileLevel = qMin<int>( d->m_layerDecorator.maximumTileLevel(), tileLevelF );
+    const int tileLevel = d->tileLevel( viewport->radius() );
 
     if ( tileLevel != d->m_tileZoomLevel ) {
         d->m_tileZoomLevel = tileLevel;
@@ -329,8 +408,14 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
 
     const QRect dirtyRect = QRect( QPoint( 0, 0), viewport->size() );
     d->m_texmapper->mapTexture( painter, viewport, d->m_tileZoomLevel, dirtyRect, d->m_texcolorizer );
+    if ( d->m_tileLoader.parentTilesUsed() ) {
+        // some tiles were drawn from lower levels while being loaded, so draw them again
+        d->m_texmapper->setRepaintNeeded();
+        emit repaintNeeded();
+    }
     d->m_renderState.addChild( d->m_tileLoader.renderState() );
     d->m_runtimeTrace = QString("Texture Cache: %1 ").arg(d->m_tileLoader.tileCount());
+    d->m_runtimeTrace += d->m_texmapper->runtimeTrace();
     return true;
 }
 
@@ -356,21 +441,30 @@ void TextureLayer::setShowSunShading( bool show )
                  this,       SLOT(reset()) );
     }
 
+    d->m_tileLoader.cancelPrefetch();
+    d->m_tileLoader.decoratorMutex()->lock();
     d->m_layerDecorator.setShowSunShading( show );
+    d->m_tileLoader.decoratorMutex()->unlock();
 
     reset();
 }
 
 void TextureLayer::setShowCityLights( bool show )
 {
+    d->m_tileLoader.cancelPrefetch();
+    d->m_tileLoader.decoratorMutex()->lock();
     d->m_layerDecorator.setShowCityLights( show );
+    d->m_tileLoader.decoratorMutex()->unlock();
 
     reset();
 }
 
 void TextureLayer::setShowTileId( bool show )
 {
+    d->m_tileLoader.cancelPrefetch();
+    d->m_tileLoader.decoratorMutex()->lock();
     d->m_layerDecorator.setShowTileId( show );
+    d->m_tileLoader.decoratorMutex()->unlock();
 
     reset();
 }
@@ -425,6 +519,16 @@ void TextureLayer::setVolatileCacheLimit( quint64 kilobytes )
     d->m_tileLoader.setVolatileCacheLimit( kilobytes );
 }
 
+void TextureLayer::setDecodedTileCacheLimit( quint64 kilobytes )
+{
+    d->m_layerDecorator.setDecodedTileCacheLimit( kilobytes );
+}
+
+void TextureLayer::setVolatileCacheEncoding( TileCacheEncoding encoding )
+{
+    d->m_tileLoader.setVolatileCacheEncoding( encoding );
+}
+
 void TextureLayer::reset()
 {
     mDebug() << Q_FUNC_INFO;
@@ -448,6 +552,48 @@ void TextureLayer::downloadStackedTile( const TileId &stackedTileId )
     d->m_layerDecorator.downloadStackedTile( stackedTileId, DownloadBulk );
 }
 
+void TextureLayer::prefetchTiles( const ViewportParams *viewport )
+{
+    if ( d->m_textures.isEmpty() || d->m_layerDecorator.textureLayersSize() == 0 ) {
+        return;
+    }
+
+    // The SunLocator is moved on the GUI thread without any lock, and every
+    // move drops the shaded tiles anyway.
+    if ( d->m_layerDecorator.showSunShading() || d->m_layerDecorator.showCityLights() ) {
+        return;
+    }
+
+    // replace the downloads of the previous prediction
+    d->m_loader.cancelPrefetch();
+
+    const int level = d->tileLevel( viewport->radius() );
+    QList<TileId> availableTiles;
+
+    foreach ( const TileId &stackedTileId, d->visibleTileIds( viewport, level ).mid( 0, maximumPrefetchedTiles ) ) {
+        if ( d->m_layerDecorator.prefetchStackedTile( stackedTileId ) ) {
+            availableTiles << stackedTileId;
+        }
+    }
+
+    mDebug() << Q_FUNC_INFO << "level" << level << "available on disk:" << availableTiles.size();
+
+    d->m_tileLoader.prefetchTiles( availableTiles );
+}
+
+void TextureLayer::setCacheStatistics( CacheStatistics *statistics )
+{
+    d->m_loader.setCacheStatistics( statistics );
+    d->m_layerDecorator.setCacheStatistics( statistics );
+    d->m_tileLoader.setCacheStatistics( statistics );
+}
+
+void TextureLayer::cancelPrefetch()
+{
+    d->m_loader.cancelPrefetch();
+    d->m_tileLoader.cancelPrefetch();
+}
+
 void TextureLayer::setMapTheme( const QVector<const GeoSceneTextureTile *> &textures, const GeoSceneGroup *textureLayerSettings, const QString &seaFile, const QString &landFile )
 {
     delete d->m_texcolorizer;
@@ -498,6 +644,16 @@ qint64 TextureLayer::volatileCacheLimit() const
     return d->m_tileLoader.volatileCacheLimit();
 }
 
+quint64 TextureLayer::decodedTileCacheLimit() const
+{
+    return d->m_layerDecorator.decodedTileCacheLimit();
+}
+
+TileCacheEncoding TextureLayer::volatileCacheEncoding() const
+{
+    return d->m_tileLoader.volatileCacheEncoding();
+}
+
 int TextureLayer::preferredRadiusCeil( int radius ) const
 {
     const int tileWidth = d->m_layerDecorator.tileSize().width();
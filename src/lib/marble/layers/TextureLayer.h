@@ -27,6 +27,7 @@ class QRect;
 namespace Marble
 {
 
+class CacheStatistics;
 class GeoPainter;
 class GeoDataDocument;
 class GeoSceneGroup;
@@ -46,6 +47,11 @@ class MARBLE_EXPORT TextureLayer : public QObject, public LayerInterface
 
     ~TextureLayer();
 
+    /**
+     * Sets the statistics which the tile caches of this layer report to.
+     */
+    void setCacheStatistics( CacheStatistics *statistics );
+
     QStringList renderPosition() const;
 
     void addSeaDocument( const GeoDataDocument *seaDocument );
@@ -70,6 +76,10 @@ class MARBLE_EXPORT TextureLayer : public QObject, public LayerInterface
 
     qint64 volatileCacheLimit() const;
 
+    quint64 decodedTileCacheLimit() const;
+
+    TileCacheEncoding volatileCacheEncoding() const;
+
     int preferredRadiusCeil( int radius ) const;
     int preferredRadiusFloor( int radius ) const;
 
@@ -102,12 +112,31 @@ public Q_SLOTS:
 
     void setVolatileCacheLimit( quint64 kilobytes );
 
+    void setDecodedTileCacheLimit( quint64 kilobytes );
+
+    void setVolatileCacheEncoding( TileCacheEncoding encoding );
+
     void reset();
 
     void reload();
 
     void downloadStackedTile( const TileId &stackedTileId );
 
+    /**
+     * @brief Prepares the tiles visible in @p viewport, which is where the map
+     *        is expected to be shown soon.
+     *
+     * Tiles which are missing on disk are queued for low priority downloads,
+     * the others are loaded into the tile cache in a background thread.
+     * Replaces the prefetched tiles of the previous call which are still pending.
+     */
+    void prefetchTiles( const ViewportParams *viewport );
+
+    /**
+     * @brief Cancels the pending downloads and loads of prefetchTiles().
+     */
+    void cancelPrefetch();
+
  Q_SIGNALS:
     void tileLevelChanged( int );
     void repaintNeeded();
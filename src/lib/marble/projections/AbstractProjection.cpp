@@ -21,6 +21,7 @@
 // Marble
 #include "GeoDataLineString.h"
 #include "GeoDataLinearRing.h"
+#include "MarbleGlobal.h"
 #include "ViewportParams.h"
 
 using namespace Marble;
@@ -46,6 +47,15 @@ AbstractProjectionPrivate::AbstractProjectionPrivate( AbstractProjection * paren
 {
 }
 
+int AbstractProjectionPrivate::tessellationLevel( const ViewportParams *viewport )
+{
+    const int level = GeoDataLineString::generalizationLevel( viewport->angularResolution() );
+
+    // small screens get a coarser tessellation, see tessellateLineSegment()
+    bool const smallScreen = MarbleGlobal::getInstance()->profiles() & MarbleGlobal::SmallScreen;
+    return smallScreen ? qMax( 0, level - 1 ) : level;
+}
+
 qreal AbstractProjection::maxValidLat() const
 {
     return +90.0 * DEG2RAD;
@@ -16,6 +16,7 @@ namespace Marble
 {
 
 class AbstractProjection;
+class ViewportParams;
 
 class AbstractProjectionPrivate
 {
@@ -24,6 +25,11 @@ class AbstractProjectionPrivate
 
     virtual ~AbstractProjectionPrivate() { };
 
+    /**
+     * The zoom level of the tessellation line strings cache for @p viewport.
+     * @see GeoDataLineString::tessellated()
+     */
+    static int tessellationLevel( const ViewportParams *viewport );
 
     qreal  m_maxLat;
     qreal  m_minLat;
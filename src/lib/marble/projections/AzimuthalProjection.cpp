@@ -325,6 +325,16 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
 {
     Q_Q( const AzimuthalProjection );
 
+    if ( lineString.tessellate() ) {
+        // Interpolating the nodes is costly, so use the tessellated nodes the
+        // line string keeps for this zoom level. Line strings which would get
+        // too many nodes at this level are tessellated on the fly below.
+        const GeoDataLineString tessellated = lineString.tessellated( tessellationLevel( viewport ) );
+        if ( tessellated.size() > lineString.size() ) {
+            return lineStringToPolygon( tessellated, viewport, polygons );
+        }
+    }
+
     const TessellationFlags f = lineString.tessellationFlags();
 
     qreal x = 0;
@@ -265,6 +265,16 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
                                               const ViewportParams *viewport,
                                               QVector<QPolygonF *> &polygons ) const
 {
+    if ( lineString.tessellate() ) {
+        // Interpolating the nodes is costly, so use the tessellated nodes the
+        // line string keeps for this zoom level. Line strings which would get
+        // too many nodes at this level are tessellated on the fly below.
+        const GeoDataLineString tessellated = lineString.tessellated( tessellationLevel( viewport ) );
+        if ( tessellated.size() > lineString.size() ) {
+            return lineStringToPolygon( tessellated, viewport, polygons );
+        }
+    }
+
     const TessellationFlags f = lineString.tessellationFlags();
 
     qreal x = 0;
@@ -29,18 +29,28 @@
 namespace Marble
 {
 
+// the field of view is 110 degrees
+static const qreal tanHalfFieldOfView = qTan( 0.5 * 110 * DEG2RAD );
+
 class VerticalPerspectiveProjectionPrivate : public AzimuthalProjectionPrivate
 {
   public:
     explicit VerticalPerspectiveProjectionPrivate( VerticalPerspectiveProjection * parent );
 
-    void calculateConstants(qreal radius) const;
+    /**
+     * The constants for a radius of the viewport. They are computed for each
+     * call instead of being cached, as GeometryLayer projects from several
+     * threads at once and the projection is shared by all viewports.
+     */
+    struct Constants
+    {
+        explicit Constants( qreal radius );
 
-    mutable qreal m_P; ///< Distance of the point of perspective in earth diameters
-    mutable qreal m_previousRadius;
-    mutable qreal m_altitudeToPixel;
-    mutable qreal m_perspectiveRadius;
-    mutable qreal m_pPfactor;
+        qreal P; ///< Distance of the point of perspective in earth diameters
+        qreal altitudeToPixel;
+        qreal perspectiveRadius;
+        qreal pPfactor;
+    };
 
     Q_DECLARE_PUBLIC( VerticalPerspectiveProjection )
 };
@@ -65,12 +75,15 @@ VerticalPerspectiveProjection::~VerticalPerspectiveProjection()
 
 
 VerticalPerspectiveProjectionPrivate::VerticalPerspectiveProjectionPrivate( VerticalPerspectiveProjection * parent )
-        : AzimuthalProjectionPrivate( parent ),
-          m_P(1),
-          m_previousRadius(1),
-          m_altitudeToPixel(1),
-          m_perspectiveRadius(1),
-          m_pPfactor(1)
+        : AzimuthalProjectionPrivate( parent )
+{
+}
+
+VerticalPerspectiveProjectionPrivate::Constants::Constants( qreal radius )
+    : P( 1.5 + 3 * 1000 * 0.4 / radius / tanHalfFieldOfView ),
+      altitudeToPixel( radius / (EARTH_RADIUS * qSqrt((P-1)/(P+1))) ),
+      perspectiveRadius( radius / qSqrt((P-1)/(P+1)) ),
+      pPfactor( (P+1)/(perspectiveRadius*perspectiveRadius*(P-1)) )
 {
 }
 
@@ -90,16 +103,6 @@ QIcon VerticalPerspectiveProjection::icon() const
     return QIcon(":/icons/map-globe.png");
 }
 
-void VerticalPerspectiveProjectionPrivate::calculateConstants(qreal radius) const
-{
-    if (radius == m_previousRadius)  return;
-    m_previousRadius = radius;
-    m_P = 1.5 + 3 * 1000 * 0.4 / radius / qTan(0.5 * 110 * DEG2RAD);
-    m_altitudeToPixel = radius / (EARTH_RADIUS * qSqrt((m_P-1)/(m_P+1)));
-    m_perspectiveRadius = radius / qSqrt((m_P-1)/(m_P+1));
-    m_pPfactor = (m_P+1)/(m_perspectiveRadius*m_perspectiveRadius*(m_P-1));
-}
-
 qreal VerticalPerspectiveProjection::clippingRadius() const
 {
     return 1;
@@ -109,9 +112,8 @@ bool VerticalPerspectiveProjection::screenCoordinates( const GeoDataCoordinates
                                              const ViewportParams *viewport,
                                              qreal &x, qreal &y, bool &globeHidesPoint ) const
 {
-    Q_D(const VerticalPerspectiveProjection);
-    d->calculateConstants(viewport->radius());
-    const qreal P =  d->m_P;
+    const VerticalPerspectiveProjectionPrivate::Constants constants( viewport->radius() );
+    const qreal P = constants.P;
     const qreal deltaLambda = coordinates.longitude() - viewport->centerLongitude();
     const qreal phi = coordinates.latitude();
     const qreal phi1 = viewport->centerLatitude();
@@ -132,7 +134,7 @@ bool VerticalPerspectiveProjection::screenCoordinates( const GeoDataCoordinates
     y = ( qCos( phi1 ) * qSin( phi ) - qSin( phi1 ) * qCos( phi ) * qCos( deltaLambda ) ) * k;
 
     // Transform to screen coordinates
-    qreal pixelAltitude = (coordinates.altitude() + EARTH_RADIUS) * d->m_altitudeToPixel;
+    qreal pixelAltitude = (coordinates.altitude() + EARTH_RADIUS) * constants.altitudeToPixel;
     x *= pixelAltitude;
     y *= pixelAltitude;
 
@@ -187,9 +189,8 @@ bool VerticalPerspectiveProjection::geoCoordinates( const int x, const int y,
                                           qreal& lon, qreal& lat,
                                           GeoDataCoordinates::Unit unit ) const
 {
-    Q_D(const VerticalPerspectiveProjection);
-    d->calculateConstants(viewport->radius());
-    const qreal P = d->m_P;
+    const VerticalPerspectiveProjectionPrivate::Constants constants( viewport->radius() );
+    const qreal P = constants.P;
     const qreal rx = ( - viewport->width()  / 2 + x );
     const qreal ry = (   viewport->height() / 2 - y );
     const qreal p2 = rx*rx + ry*ry;
@@ -200,12 +201,12 @@ bool VerticalPerspectiveProjection::geoCoordinates( const int x, const int y,
         return true;
     }
 
-    const qreal pP = p2*d->m_pPfactor;
+    const qreal pP = p2*constants.pPfactor;
 
     if ( pP > 1) return false;
 
     const qreal p = qSqrt(p2);
-    const qreal fract = d->m_perspectiveRadius*(P-1)/p;
+    const qreal fract = constants.perspectiveRadius*(P-1)/p;
     const qreal c = qAsin((P-qSqrt(1-pP))/(fract+1/fract));
     const qreal sinc = qSin(c);
 
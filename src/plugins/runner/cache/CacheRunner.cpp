@@ -12,6 +12,7 @@
 #include "GeoDataDocument.h"
 #include "GeoDataExtendedData.h"
 #include "GeoDataPlacemark.h"
+#include "PlacemarkCacheFile.h"
 
 #include <QFile>
 
@@ -38,6 +39,12 @@ void CacheRunner::parseFile( const QString &fileName, DocumentRole role = Unknow
         return;
     }
 
+    if ( PlacemarkCacheFile::isCacheFile( fileName ) ) {
+        parseCacheFile( fileName, role );
+        return;
+    }
+
+    // the old format, written by kml2cache before the memory mapped one
     file.open( QIODevice::ReadOnly );
     QDataStream in( &file );
 
@@ -111,6 +118,24 @@ void CacheRunner::parseFile( const QString &fileName, DocumentRole role = Unknow
     emit parsingFinished( document );
 }
 
+void CacheRunner::parseCacheFile( const QString &fileName, DocumentRole role )
+{
+    const PlacemarkCacheFile cache( fileName );
+    if ( !cache.isOpen() ) {
+        emit parsingFinished( 0, cache.errorString() );
+        return;
+    }
+
+    GeoDataDocument *document = new GeoDataDocument();
+    document->setDocumentRole( role );
+    for ( int i = 0; i < cache.size(); ++i ) {
+        document->append( cache.placemark( i ) );
+    }
+    document->setFileName( fileName );
+
+    emit parsingFinished( document );
+}
+
 }
 
 #include "CacheRunner.moc"
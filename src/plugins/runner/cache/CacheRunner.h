@@ -23,6 +23,8 @@ public:
     ~CacheRunner();
     virtual void parseFile( const QString &fileName, DocumentRole role );
 
+private:
+    void parseCacheFile( const QString &fileName, DocumentRole role );
 };
 
 }
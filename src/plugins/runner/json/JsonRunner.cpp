@@ -14,6 +14,7 @@
 #include "GeoDataDocument.h"
 #include "MarbleDebug.h"
 
+#include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
 
@@ -59,6 +60,25 @@ void JsonRunner::parseFile( const QString &fileName, DocumentRole role = Unknown
     emit parsingFinished( document );
 }
 
+void JsonRunner::parseData( const QByteArray &data, const QString &fileName, DocumentRole role )
+{
+    QBuffer buffer;
+    buffer.setData( data );
+    buffer.open( QIODevice::ReadOnly );
+
+    JsonParser parser;
+    if ( !parser.read( &buffer ) ) {
+        emit parsingFinished( 0, "Could not parse GeoJSON" );
+        return;
+    }
+
+    GeoDataDocument* document = parser.releaseDocument();
+    document->setDocumentRole( role );
+    document->setFileName( fileName );
+
+    emit parsingFinished( document );
+}
+
 }
 
 #include "JsonRunner.moc"
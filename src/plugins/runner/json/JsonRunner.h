@@ -23,6 +23,7 @@ public:
     explicit JsonRunner(QObject *parent = 0);
     ~JsonRunner();
     virtual void parseFile( const QString &fileName, DocumentRole role );
+    virtual void parseData( const QByteArray &data, const QString &fileName, DocumentRole role );
 };
 
 }
@@ -18,6 +18,7 @@
 #include "KmzHandler.h"
 #endif
 
+#include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
 
@@ -83,6 +84,33 @@ void KmlRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     emit parsingFinished( doc );
 }
 
+void KmlRunner::parseData( const QByteArray &data, const QString &fileName, DocumentRole role )
+{
+    // KMZ archives are unpacked from files only
+    if ( QFileInfo( fileName ).suffix().toLower() == "kmz" ) {
+        ParsingRunner::parseData( data, fileName, role );
+        return;
+    }
+
+    QBuffer buffer;
+    buffer.setData( data );
+    buffer.open( QIODevice::ReadOnly );
+
+    KmlParser parser;
+    if ( !parser.read( &buffer ) ) {
+        emit parsingFinished( 0, parser.errorString() );
+        return;
+    }
+    GeoDocument* document = parser.releaseDocument();
+    Q_ASSERT( document );
+    KmlDocument* doc = static_cast<KmlDocument*>( document );
+    doc->setDocumentRole( role );
+    doc->setFileName( fileName );
+    doc->setBaseUri( fileName );
+
+    emit parsingFinished( doc );
+}
+
 }
 
 #include "KmlRunner.moc"
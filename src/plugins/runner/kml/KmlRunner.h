@@ -22,6 +22,7 @@ public:
     explicit KmlRunner(QObject *parent = 0);
     ~KmlRunner();
     virtual void parseFile( const QString &fileName, DocumentRole role );
+    virtual void parseData( const QByteArray &data, const QString &fileName, DocumentRole role );
 };
 
 }
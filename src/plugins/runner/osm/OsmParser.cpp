@@ -12,14 +12,20 @@
 
 #include "OsmParser.h"
 #include "OsmElementDictionary.h"
+#include "GeoDataCoordinates.h"
 #include "GeoDataDocument.h"
 
+#include <QtAlgorithms>
+
+#include <cmath>
+
 namespace Marble {
 
 const QColor OsmParser::backgroundColor( 0xF1, 0xEE, 0xE8 );
 
 OsmParser::OsmParser()
-    : GeoParser( 0 )
+    : GeoParser( 0 ),
+      m_nodesSorted( true )
 {
     // All these tags can be found updated at
     // http://wiki.openstreetmap.org/wiki/Map_Features#Landuse
@@ -58,17 +64,44 @@ OsmParser::OsmParser()
 OsmParser::~OsmParser()
 {
     qDeleteAll( m_dummyPlacemarks );
-    qDeleteAll( m_nodes );
 }
 
-void OsmParser::setNode( quint64 id, GeoDataPoint *point )
+void OsmParser::setNode( quint64 id, qreal lon, qreal lat )
 {
-    m_nodes[id] = point;
+    const Node node = { id, qint32( floor( lon * 1e7 + 0.5 ) ), qint32( floor( lat * 1e7 + 0.5 ) ) };
+
+    // the nodes of OSM files are usually sorted by id
+    if ( !m_nodes.isEmpty() && id <= m_nodes.last().id ) {
+        m_nodesSorted = false;
+    }
+    m_nodes.append( node );
 }
 
-GeoDataPoint *OsmParser::node( quint64 id )
+bool OsmParser::node( quint64 id, GeoDataCoordinates &coordinates )
 {
-    return m_nodes.value( id );
+    if ( !m_nodesSorted ) {
+        // a node given twice is replaced by the later one
+        qStableSort( m_nodes.begin(), m_nodes.end(), lessThan );
+        m_nodesSorted = true;
+    }
+
+    const Node key = { id, 0, 0 };
+    QVector<Node>::const_iterator it = qUpperBound( m_nodes.constBegin(), m_nodes.constEnd(), key, lessThan );
+    if ( it == m_nodes.constBegin() || ( it - 1 )->id != id ) {
+        return false;
+    }
+
+    --it;
+    coordinates = GeoDataCoordinates( it->lon * 1e-7, it->lat * 1e-7, 0, GeoDataCoordinates::Degree );
+    return true;
+}
+
+GeoDataPoint *OsmParser::nodePoint( qreal lon, qreal lat )
+{
+    m_nodePoint.setCoordinates( GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree ) );
+    m_nodePoint.setParent( 0 );
+
+    return &m_nodePoint;
 }
 
 void OsmParser::setWay( quint64 id, GeoDataLineString *way )
@@ -91,6 +124,11 @@ GeoDataPolygon *OsmParser::polygon( quint64 id )
     return m_polygons.value( id );
 }
 
+bool OsmParser::lessThan( const Node &node1, const Node &node2 )
+{
+    return node1.id < node2.id;
+}
+
 bool OsmParser::tagNeedArea( const QString &keyValue ) const
 {
     return m_areaTags.contains( keyValue );
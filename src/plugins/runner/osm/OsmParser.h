@@ -14,17 +14,19 @@
 #define OSMPARSER_H
 
 #include "GeoParser.h"
+#include "GeoDataPoint.h"
 
 #include <QColor>
 #include <QList>
 #include <QMap>
 #include <QSet>
+#include <QVector>
 
 namespace Marble {
 
+class GeoDataCoordinates;
 class GeoDataLineString;
 class GeoDataPlacemark;
-class GeoDataPoint;
 class GeoDataPolygon;
 
 class OsmParser : public GeoParser
@@ -33,8 +35,25 @@ public:
     OsmParser();
     virtual ~OsmParser();
 
-    void setNode( quint64 id, GeoDataPoint *point );
-    GeoDataPoint *node( quint64 id );
+    /**
+     * Stores the coordinates of node @p id, given in degrees. Only the
+     * coordinates are kept, in a flat array sorted by id, as most nodes
+     * are only needed to build ways.
+     */
+    void setNode( quint64 id, qreal lon, qreal lat );
+
+    /**
+     * Sets @p coordinates to those of node @p id. Returns false if the node
+     * is unknown.
+     */
+    bool node( quint64 id, GeoDataCoordinates &coordinates );
+
+    /**
+     * Returns a point at the given coordinates, in degrees, to which the
+     * tags of a node are applied. The same point is returned for every
+     * node; tags which create a placemark copy it.
+     */
+    GeoDataPoint *nodePoint( qreal lon, qreal lat );
 
     void setWay( quint64 id, GeoDataLineString *way );
     GeoDataLineString *way( quint64 id );
@@ -53,7 +72,19 @@ private:
 
     virtual GeoDocument* createDocument() const;
 
-    QMap<quint64, GeoDataPoint *> m_nodes;
+    // a node in units of 1e-7 degrees, the precision of OSM data
+    struct Node
+    {
+        quint64 id;
+        qint32 lon;
+        qint32 lat;
+    };
+
+    static bool lessThan( const Node &node1, const Node &node2 );
+
+    QVector<Node> m_nodes;
+    bool m_nodesSorted;
+    GeoDataPoint m_nodePoint;
     QMap<quint64, GeoDataPolygon *> m_polygons;
     QMap<quint64, GeoDataLineString *> m_ways;
     QSet<QString> m_areaTags;
@@ -12,6 +12,11 @@
 #include "GeoDataDocument.h"
 #include "OsmParser.h"
 
+#ifdef MARBLE_HAVE_PROTOBUF
+#include "OsmPbfParser.h"
+#endif
+
+#include <QBuffer>
 #include <QFile>
 
 namespace Marble
@@ -38,9 +43,40 @@ void OsmRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     // Open file in right mode
     file.open( QIODevice::ReadOnly );
 
+    parse( &file, fileName, role );
+    file.close();
+}
+
+void OsmRunner::parseData( const QByteArray &data, const QString &fileName, DocumentRole role )
+{
+    QBuffer buffer;
+    buffer.setData( data );
+    buffer.open( QIODevice::ReadOnly );
+
+    parse( &buffer, fileName, role );
+}
+
+void OsmRunner::parse( QIODevice *device, const QString &fileName, DocumentRole role )
+{
+#ifdef MARBLE_HAVE_PROTOBUF
+    if ( OsmPbfParser::isPbf( device ) ) {
+        OsmPbfParser parser;
+        if ( !parser.read( device ) ) {
+            emit parsingFinished( 0, parser.errorString() );
+            return;
+        }
+        GeoDataDocument* doc = parser.releaseDocument();
+        doc->setDocumentRole( role );
+        doc->setFileName( fileName );
+
+        emit parsingFinished( doc );
+        return;
+    }
+#endif
+
     OsmParser parser;
 
-    if ( !parser.read( &file ) ) {
+    if ( !parser.read( device ) ) {
         emit parsingFinished( 0, parser.errorString() );
         return;
     }
@@ -50,7 +86,6 @@ void OsmRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     doc->setDocumentRole( role );
     doc->setFileName( fileName );
 
-    file.close();
     emit parsingFinished( doc );
 }
 
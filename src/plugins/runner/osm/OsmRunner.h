@@ -12,6 +12,8 @@
 
 #include "ParsingRunner.h"
 
+class QIODevice;
+
 namespace Marble
 {
 
@@ -22,6 +24,10 @@ public:
     explicit OsmRunner(QObject *parent = 0);
     ~OsmRunner();
     virtual void parseFile( const QString &fileName, DocumentRole role );
+    virtual void parseData( const QByteArray &data, const QString &fileName, DocumentRole role );
+
+private:
+    void parse( QIODevice *device, const QString &fileName, DocumentRole role );
 };
 
 }
@@ -16,8 +16,13 @@
 #include "GeoTagHandler.h"
 #include "marble_export.h"
 
+class QString;
+
 namespace Marble
 {
+class GeoDataPolygon;
+class OsmParser;
+
 namespace osm
 {
 
@@ -25,6 +30,13 @@ class OsmMemberTagHandler : public GeoTagHandler
 {
 public:
     virtual GeoNode* parse( GeoParser& ) const;
+
+    /**
+     * Adds the member @p id of type @p type ("way" or "relation") with the
+     * role @p role to the boundaries of the relation's @p polygon.
+     */
+    static void handleMember( OsmParser &parser, GeoDataPolygon *polygon,
+                              const QString &type, const QString &role, quint64 id );
 };
 
 }
@@ -15,7 +15,6 @@
 
 #include "GeoDataCoordinates.h"
 #include "GeoDataLineString.h"
-#include "GeoDataPoint.h"
 
 namespace Marble
 {
@@ -40,8 +39,9 @@ GeoNode* OsmNdTagHandler::parse( GeoParser &geoParser ) const
         GeoDataLineString *s = parentItem.nodeAs<GeoDataLineString>();
         Q_ASSERT( s );
         quint64 id = parser.attribute( "ref" ).toULongLong();
-        if ( GeoDataPoint *p = parser.node( id ) ) {
-            s->append( GeoDataCoordinates( p->coordinates().longitude(), p->coordinates().latitude() ) );
+        GeoDataCoordinates coordinates;
+        if ( parser.node( id, coordinates ) ) {
+            s->append( coordinates );
         }
 
         return 0;
@@ -36,9 +36,8 @@ GeoNode* OsmNodeTagHandler::parse( GeoParser &geoParser ) const
     qreal lon = parser.attribute( "lon" ).toDouble();
     qreal lat = parser.attribute( "lat" ).toDouble();
 
-    GeoDataPoint *point = new GeoDataPoint( lon, lat, 0, GeoDataCoordinates::Degree );
-    parser.setNode( parser.attribute( "id" ).toULongLong(), point );
-    return point;
+    parser.setNode( parser.attribute( "id" ).toULongLong(), lon, lat );
+    return parser.nodePoint( lon, lat );
 }
 
 }
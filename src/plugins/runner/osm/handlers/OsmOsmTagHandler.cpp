@@ -35,7 +35,13 @@ GeoNode* OsmOsmTagHandler::parse( GeoParser& parser ) const
     // Osm Node http://wiki.openstreetmap.org/wiki/Data_Primitives#Node
 
     GeoDataDocument* doc = geoDataDoc( parser );
+    addStyles( doc );
 
+    return doc;
+}
+
+void OsmOsmTagHandler::addStyles( GeoDataDocument *doc )
+{
     GeoDataPolyStyle backgroundPolyStyle;
     backgroundPolyStyle.setFill( true );
     backgroundPolyStyle.setOutline( false );
@@ -44,8 +50,6 @@ GeoNode* OsmOsmTagHandler::parse( GeoParser& parser ) const
     backgroundStyle.setPolyStyle( backgroundPolyStyle );
     backgroundStyle.setId( "background" );
     doc->addStyle( backgroundStyle );
-
-    return doc;
 }
 
 }
@@ -16,6 +16,8 @@
 
 namespace Marble
 {
+class GeoDataDocument;
+
 namespace osm
 {
 
@@ -23,6 +25,9 @@ class OsmOsmTagHandler : public GeoTagHandler
 {
 public:
     virtual GeoNode* parse( GeoParser& ) const;
+
+    /** Adds the styles shared by all placemarks of an OSM file to @p doc */
+    static void addStyles( GeoDataDocument *doc );
 };
 
 }
@@ -43,13 +43,24 @@ GeoNode* OsmTagTagHandler::parse( GeoParser &geoParser ) const
     QString key = parser.attribute( "k" );
     QString value = parser.attribute( "v" );
 
-    if ( tagBlackList.contains( key ) )
-        return 0;
-
     GeoDataGeometry * geometry = parentItem.nodeAs<GeoDataGeometry>();
     if ( !geometry )
         return 0;
 
+    const Element element = parentItem.represents( osmTag_node ) ? NodeElement
+                          : parentItem.represents( osmTag_way ) ? WayElement
+                          : parentItem.represents( osmTag_relation ) ? RelationElement : OtherElement;
+    handleTag( parser, doc, geometry, element, key, value );
+
+    return 0;
+}
+
+void OsmTagTagHandler::handleTag( OsmParser &parser, GeoDataDocument *doc, GeoDataGeometry *geometry,
+                                  Element element, const QString &key, const QString &value )
+{
+    if ( tagBlackList.contains( key ) )
+        return;
+
     GeoDataGeometry *placemarkGeometry = geometry;
     
     //If node geometry is part of multigeometry -> go up to placemark geometry.
@@ -62,17 +73,17 @@ GeoNode* OsmTagTagHandler::parse( GeoParser &geoParser ) const
     {
         if ( !placemark )
         {
-            if ( parentItem.represents( osmTag_node ) )
+            if ( element == NodeElement )
                 placemark = createPOI( doc, geometry );
             else
-                return 0;
+                return;
         }
         placemark->setName( value );
-        return 0;
+        return;
     }
 
     // Ways or relations can represent closed areas such as buildings
-    if ( parentItem.represents( osmTag_way ) || parentItem.represents( osmTag_relation ) )
+    if ( element == WayElement || element == RelationElement )
     {
         Q_ASSERT( placemark );
 
@@ -96,7 +107,7 @@ GeoNode* OsmTagTagHandler::parse( GeoParser &geoParser ) const
             placemark->setVisible( true );
         }
     }
-    else if ( parentItem.represents( osmTag_node ) ) //POI
+    else if ( element == NodeElement ) //POI
     {
         GeoDataFeature::GeoDataVisualCategory poiCategory = GeoDataFeature::OsmVisualCategory( key + '=' + value );
 
@@ -152,8 +163,6 @@ GeoNode* OsmTagTagHandler::parse( GeoParser &geoParser ) const
             }
         }
     }
-
-    return 0;
 }
 
 GeoDataPlacemark* OsmTagTagHandler::createPOI( GeoDataDocument* doc, GeoDataGeometry* geometry )
@@ -12,11 +12,15 @@
 #define MARBLE_OSMTAGTAGHANDLER_H
 
 #include "GeoTagHandler.h"
+
+class QString;
+
 namespace Marble
 {
 class GeoDataGeometry;
 class GeoDataPlacemark;
 class GeoDataDocument;
+class OsmParser;
 
 namespace osm
 {
@@ -24,8 +28,23 @@ namespace osm
 class OsmTagTagHandler : public GeoTagHandler
 {
 public:
+    /** The kinds of OSM elements which have tags */
+    enum Element {
+        OtherElement,
+        NodeElement,
+        WayElement,
+        RelationElement
+    };
+
     virtual GeoNode* parse( GeoParser& ) const;
 
+    /**
+     * Applies the tag @p key = @p value of an element of kind @p element to
+     * its @p geometry, creating or changing placemarks in @p doc.
+     */
+    static void handleTag( OsmParser &parser, GeoDataDocument *doc, GeoDataGeometry *geometry,
+                           Element element, const QString &key, const QString &value );
+
 private:
     static GeoDataPlacemark *createPOI( GeoDataDocument *doc, GeoDataGeometry *geometry );
 };
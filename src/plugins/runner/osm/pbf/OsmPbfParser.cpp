@@ -0,0 +1,501 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "OsmPbfParser.h"
+
+#include "OsmElementDictionary.h"
+#include "OsmMemberTagHandler.h"
+#include "OsmOsmTagHandler.h"
+#include "OsmTagTagHandler.h"
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+
+#include "fileformat.pb.h"
+#include "osmformat.pb.h"
+
+#include <QIODevice>
+#include <QPair>
+#include <QRunnable>
+#include <QVector>
+#include <QtEndian>
+
+#include <zlib.h>
+
+namespace Marble
+{
+
+namespace
+{
+
+// limits given by the specification of the format
+const int maxBlobHeaderSize = 64 * 1024;
+const int maxBlobSize = 32 * 1024 * 1024;
+
+bool decodeBlob( const QByteArray &data, QByteArray &result, QString &errorString )
+{
+    OSMPBF::Blob blob;
+    if ( !blob.ParseFromArray( data.constData(), data.size() ) ) {
+        errorString = "Unable to parse blob";
+        return false;
+    }
+
+    if ( blob.has_raw() ) {
+        result = QByteArray( blob.raw().data(), blob.raw().size() );
+        return true;
+    }
+
+    if ( blob.has_zlib_data() ) {
+        if ( blob.raw_size() < 0 || blob.raw_size() > maxBlobSize ) {
+            errorString = QString( "Invalid blob size %1" ).arg( blob.raw_size() );
+            return false;
+        }
+
+        result.resize( blob.raw_size() );
+        z_stream stream;
+        stream.next_in = (Bytef*) blob.zlib_data().data();
+        stream.avail_in = blob.zlib_data().size();
+        stream.next_out = (Bytef*) result.data();
+        stream.avail_out = result.size();
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        if ( inflateInit( &stream ) != Z_OK ) {
+            errorString = "Unable to initialize zlib";
+            return false;
+        }
+
+        const int status = inflate( &stream, Z_FINISH );
+        inflateEnd( &stream );
+        if ( status != Z_STREAM_END || stream.total_out != uLong( result.size() ) ) {
+            errorString = "Unable to inflate blob";
+            return false;
+        }
+
+        return true;
+    }
+
+    if ( blob.has_lzma_data() ) {
+        errorString = "LZMA compressed blobs are not supported";
+    } else {
+        errorString = "Blob contains no data";
+    }
+
+    return false;
+}
+
+}
+
+/**
+ * A primitive block decoded into plain values. Tags and roles are indices
+ * into the string table of the block.
+ */
+struct OsmPbfParser::Block
+{
+    struct Node
+    {
+        quint64 id;
+        qreal lon;
+        qreal lat;
+        int firstTag;
+        int tagCount;
+    };
+
+    struct Way
+    {
+        quint64 id;
+        int firstRef;
+        int refCount;
+        int firstTag;
+        int tagCount;
+    };
+
+    struct Member
+    {
+        OSMPBF::Relation::MemberType type;
+        quint64 id;
+        int role;
+    };
+
+    struct Relation
+    {
+        quint64 id;
+        int firstMember;
+        int memberCount;
+        int firstTag;
+        int tagCount;
+    };
+
+    void decode( const OSMPBF::PrimitiveBlock &block );
+
+    QVector<QString> strings;
+    QVector<QPair<int, int> > tags;
+    QVector<quint64> refs;
+    QVector<Member> members;
+
+    QVector<Node> nodes;
+    QVector<Way> ways;
+    QVector<Relation> relations;
+
+    QString errorString;
+};
+
+void OsmPbfParser::Block::decode( const OSMPBF::PrimitiveBlock &block )
+{
+    const OSMPBF::StringTable &stringTable = block.stringtable();
+    strings.reserve( stringTable.s_size() );
+    for ( int i = 0; i < stringTable.s_size(); ++i ) {
+        strings << QString::fromUtf8( stringTable.s( i ).data(), stringTable.s( i ).size() );
+    }
+
+    // coordinates are given in units of granularity nanodegrees
+    const qint64 granularity = block.granularity();
+    const qint64 latOffset = block.lat_offset();
+    const qint64 lonOffset = block.lon_offset();
+
+    for ( int i = 0; i < block.primitivegroup_size(); ++i ) {
+        const OSMPBF::PrimitiveGroup &group = block.primitivegroup( i );
+
+        for ( int j = 0; j < group.nodes_size(); ++j ) {
+            const OSMPBF::Node &input = group.nodes( j );
+            Node node;
+            node.id = input.id();
+            node.lon = 1e-9 * ( lonOffset + granularity * input.lon() );
+            node.lat = 1e-9 * ( latOffset + granularity * input.lat() );
+            node.firstTag = tags.size();
+            for ( int k = 0; k < qMin( input.keys_size(), input.vals_size() ); ++k ) {
+                tags << qMakePair<int, int>( input.keys( k ), input.vals( k ) );
+            }
+            node.tagCount = tags.size() - node.firstTag;
+            nodes << node;
+        }
+
+        if ( group.has_dense() ) {
+            // ids and coordinates are delta coded, the tags of all nodes
+            // are stored in one array, each node's tags terminated by 0
+            const OSMPBF::DenseNodes &dense = group.dense();
+            const int count = qMin( dense.id_size(), qMin( dense.lat_size(), dense.lon_size() ) );
+            qint64 id = 0;
+            qint64 lat = 0;
+            qint64 lon = 0;
+            int keyValue = 0;
+            nodes.reserve( nodes.size() + count );
+            for ( int j = 0; j < count; ++j ) {
+                id += dense.id( j );
+                lat += dense.lat( j );
+                lon += dense.lon( j );
+
+                Node node;
+                node.id = id;
+                node.lon = 1e-9 * ( lonOffset + granularity * lon );
+                node.lat = 1e-9 * ( latOffset + granularity * lat );
+                node.firstTag = tags.size();
+                while ( keyValue + 1 < dense.keys_vals_size() && dense.keys_vals( keyValue ) != 0 ) {
+                    tags << qMakePair( dense.keys_vals( keyValue ), dense.keys_vals( keyValue + 1 ) );
+                    keyValue += 2;
+                }
+                ++keyValue;
+                node.tagCount = tags.size() - node.firstTag;
+                nodes << node;
+            }
+        }
+
+        for ( int j = 0; j < group.ways_size(); ++j ) {
+            const OSMPBF::Way &input = group.ways( j );
+            Way way;
+            way.id = input.id();
+            way.firstRef = refs.size();
+            qint64 ref = 0;
+            for ( int k = 0; k < input.refs_size(); ++k ) {
+                ref += input.refs( k );
+                refs << ref;
+            }
+            way.refCount = refs.size() - way.firstRef;
+            way.firstTag = tags.size();
+            for ( int k = 0; k < qMin( input.keys_size(), input.vals_size() ); ++k ) {
+                tags << qMakePair<int, int>( input.keys( k ), input.vals( k ) );
+            }
+            way.tagCount = tags.size() - way.firstTag;
+            ways << way;
+        }
+
+        for ( int j = 0; j < group.relations_size(); ++j ) {
+            const OSMPBF::Relation &input = group.relations( j );
+            Relation relation;
+            relation.id = input.id();
+            relation.firstMember = members.size();
+            const int memberCount = qMin( input.memids_size(), qMin( input.types_size(), input.roles_sid_size() ) );
+            qint64 id = 0;
+            for ( int k = 0; k < memberCount; ++k ) {
+                id += input.memids( k );
+                Member member;
+                member.type = input.types( k );
+                member.id = id;
+                member.role = input.roles_sid( k );
+                members << member;
+            }
+            relation.memberCount = members.size() - relation.firstMember;
+            relation.firstTag = tags.size();
+            for ( int k = 0; k < qMin( input.keys_size(), input.vals_size() ); ++k ) {
+                tags << qMakePair<int, int>( input.keys( k ), input.vals( k ) );
+            }
+            relation.tagCount = tags.size() - relation.firstTag;
+            relations << relation;
+        }
+    }
+}
+
+/**
+ * Decompresses and decodes one blob of OSMData.
+ */
+class OsmPbfParser::DecodeJob : public QRunnable
+{
+public:
+    DecodeJob( const QByteArray &blob, Block *block )
+        : m_blob( blob ),
+          m_block( block )
+    {
+    }
+
+    virtual void run()
+    {
+        QByteArray data;
+        if ( !decodeBlob( m_blob, data, m_block->errorString ) ) {
+            return;
+        }
+
+        OSMPBF::PrimitiveBlock primitiveBlock;
+        if ( !primitiveBlock.ParseFromArray( data.constData(), data.size() ) ) {
+            m_block->errorString = "Unable to parse primitive block";
+            return;
+        }
+
+        m_block->decode( primitiveBlock );
+    }
+
+private:
+    const QByteArray m_blob;
+    Block *const m_block;
+};
+
+OsmPbfParser::OsmPbfParser()
+    : m_document( 0 )
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+}
+
+OsmPbfParser::~OsmPbfParser()
+{
+    m_threadPool.waitForDone();
+    delete m_document;
+}
+
+bool OsmPbfParser::isPbf( QIODevice *device )
+{
+    // the size of the first blob header, followed by its type field
+    const QByteArray start = device->peek( 15 );
+    return start.size() == 15 && start.at( 4 ) == 0x0a && start.at( 5 ) == 9 && start.mid( 6 ) == "OSMHeader";
+}
+
+bool OsmPbfParser::read( QIODevice *device )
+{
+    Q_ASSERT( !m_document );
+
+    QByteArray type;
+    QByteArray blob;
+    if ( !readBlob( device, type, blob ) ) {
+        return false;
+    }
+
+    if ( type != "OSMHeader" ) {
+        m_errorString = QString( "Expected an OSMHeader blob, found %1" ).arg( QString( type ) );
+        return false;
+    }
+
+    if ( !readHeader( blob ) ) {
+        return false;
+    }
+
+    m_document = new GeoDataDocument;
+    osm::OsmOsmTagHandler::addStyles( m_document );
+
+    const int window = 2 * qMax( 1, m_threadPool.maxThreadCount() );
+    while ( !device->atEnd() ) {
+        QVector<Block> blocks( window );
+        int count = 0;
+        while ( count < window && !device->atEnd() ) {
+            if ( !readBlob( device, type, blob ) ) {
+                m_threadPool.waitForDone();
+                return false;
+            }
+
+            // blobs of unknown types are to be skipped
+            if ( type == "OSMData" ) {
+                m_threadPool.start( new DecodeJob( blob, &blocks[count] ) );
+                ++count;
+            }
+        }
+
+        m_threadPool.waitForDone();
+
+        for ( int i = 0; i < count; ++i ) {
+            if ( !blocks.at( i ).errorString.isEmpty() ) {
+                m_errorString = blocks.at( i ).errorString;
+                return false;
+            }
+
+            addBlock( blocks.at( i ) );
+        }
+    }
+
+    return true;
+}
+
+GeoDataDocument *OsmPbfParser::releaseDocument()
+{
+    GeoDataDocument *const document = m_document;
+    m_document = 0;
+
+    return document;
+}
+
+QString OsmPbfParser::errorString() const
+{
+    return m_errorString;
+}
+
+bool OsmPbfParser::readBlob( QIODevice *device, QByteArray &type, QByteArray &blob )
+{
+    // each blob is preceded by its header and the size of the header
+    const QByteArray size = device->read( 4 );
+    if ( size.size() != 4 ) {
+        m_errorString = "Unexpected end of file";
+        return false;
+    }
+
+    const qint32 headerSize = qFromBigEndian<qint32>( reinterpret_cast<const uchar*>( size.constData() ) );
+    if ( headerSize < 0 || headerSize > maxBlobHeaderSize ) {
+        m_errorString = QString( "Invalid blob header size %1" ).arg( headerSize );
+        return false;
+    }
+
+    const QByteArray headerData = device->read( headerSize );
+    OSMPBF::BlobHeader header;
+    if ( headerData.size() != headerSize || !header.ParseFromArray( headerData.constData(), headerData.size() ) ) {
+        m_errorString = "Unable to parse blob header";
+        return false;
+    }
+
+    if ( header.datasize() < 0 || header.datasize() > maxBlobSize ) {
+        m_errorString = QString( "Invalid blob size %1" ).arg( header.datasize() );
+        return false;
+    }
+
+    type = QByteArray( header.type().data(), header.type().size() );
+    blob = device->read( header.datasize() );
+    if ( blob.size() != header.datasize() ) {
+        m_errorString = "Unexpected end of file";
+        return false;
+    }
+
+    return true;
+}
+
+bool OsmPbfParser::readHeader( const QByteArray &blob )
+{
+    QByteArray data;
+    if ( !decodeBlob( blob, data, m_errorString ) ) {
+        return false;
+    }
+
+    OSMPBF::HeaderBlock header;
+    if ( !header.ParseFromArray( data.constData(), data.size() ) ) {
+        m_errorString = "Unable to parse header block";
+        return false;
+    }
+
+    for ( int i = 0; i < header.required_features_size(); ++i ) {
+        const std::string &feature = header.required_features( i );
+        if ( feature != "OsmSchema-V0.6" && feature != "DenseNodes" ) {
+            m_errorString = QString( "Unsupported feature %1" ).arg( QString::fromUtf8( feature.data(), feature.size() ) );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void OsmPbfParser::addBlock( const Block &block )
+{
+    // The same is done by the handlers of the .osm elements, where nd and
+    // member elements precede the tag elements.
+
+    foreach ( const Block::Node &node, block.nodes ) {
+        m_parser.setNode( node.id, node.lon, node.lat );
+        if ( node.tagCount > 0 ) {
+            addTags( block, node.firstTag, node.tagCount, m_parser.nodePoint( node.lon, node.lat ), osm::OsmTagTagHandler::NodeElement );
+        }
+    }
+
+    foreach ( const Block::Way &way, block.ways ) {
+        GeoDataLineString *polyline = new GeoDataLineString;
+        GeoDataPlacemark *placemark = new GeoDataPlacemark;
+        placemark->setGeometry( polyline );
+        placemark->setVisible( false );
+        m_document->append( placemark );
+        m_parser.setWay( way.id, polyline );
+
+        GeoDataCoordinates coordinates;
+        for ( int i = way.firstRef; i < way.firstRef + way.refCount; ++i ) {
+            if ( m_parser.node( block.refs.at( i ), coordinates ) ) {
+                polyline->append( coordinates );
+            }
+        }
+
+        addTags( block, way.firstTag, way.tagCount, polyline, osm::OsmTagTagHandler::WayElement );
+    }
+
+    foreach ( const Block::Relation &relation, block.relations ) {
+        GeoDataPolygon *polygon = new GeoDataPolygon;
+        GeoDataPlacemark *placemark = new GeoDataPlacemark;
+        placemark->setGeometry( polygon );
+        placemark->setVisible( false );
+        m_document->append( placemark );
+        m_parser.setPolygon( relation.id, polygon );
+
+        static const QString nodeType = "node";
+        static const QString wayType = "way";
+        static const QString relationType = "relation";
+        for ( int i = relation.firstMember; i < relation.firstMember + relation.memberCount; ++i ) {
+            const Block::Member &member = block.members.at( i );
+            const QString &type = member.type == OSMPBF::Relation::WAY ? wayType
+                                : member.type == OSMPBF::Relation::RELATION ? relationType : nodeType;
+            osm::OsmMemberTagHandler::handleMember( m_parser, polygon, type, block.strings.value( member.role ), member.id );
+        }
+
+        addTags( block, relation.firstTag, relation.tagCount, polygon, osm::OsmTagTagHandler::RelationElement );
+    }
+}
+
+void OsmPbfParser::addTags( const Block &block, int first, int count, GeoDataGeometry *geometry,
+                            osm::OsmTagTagHandler::Element element )
+{
+    for ( int i = first; i < first + count; ++i ) {
+        const QPair<int, int> &tag = block.tags.at( i );
+        osm::OsmTagTagHandler::handleTag( m_parser, m_document, geometry, element,
+                                          block.strings.value( tag.first ), block.strings.value( tag.second ) );
+    }
+}
+
+}
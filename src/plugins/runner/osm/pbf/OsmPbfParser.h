@@ -0,0 +1,81 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#ifndef MARBLE_OSMPBFPARSER_H
+#define MARBLE_OSMPBFPARSER_H
+
+#include "OsmParser.h"
+#include "OsmTagTagHandler.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QThreadPool>
+
+class QIODevice;
+
+namespace Marble
+{
+
+class GeoDataDocument;
+class GeoDataGeometry;
+
+/**
+ * @short Reads OpenStreetMap data in the PBF format
+ *
+ * A PBF file is a sequence of blobs, each holding a compressed block of
+ * nodes, ways or relations. The blobs are decompressed and decoded in a
+ * thread pool, a few at a time, which takes most of the time. The decoded
+ * blocks are then added to the document in file order, since ways refer to
+ * the nodes and relations to the ways before them.
+ *
+ * The document has the same structure as the one created by OsmParser from
+ * .osm files, as the same tag handling is used.
+ */
+class OsmPbfParser
+{
+public:
+    OsmPbfParser();
+    ~OsmPbfParser();
+
+    /**
+     * Returns whether the data of @p device starts with the header of a PBF
+     * file. Nothing is read from @p device.
+     */
+    static bool isPbf( QIODevice *device );
+
+    bool read( QIODevice *device );
+
+    /** Returns the document read, the caller takes ownership */
+    GeoDataDocument *releaseDocument();
+
+    QString errorString() const;
+
+private:
+    Q_DISABLE_COPY( OsmPbfParser )
+
+    struct Block;
+    class DecodeJob;
+
+    bool readBlob( QIODevice *device, QByteArray &type, QByteArray &blob );
+    bool readHeader( const QByteArray &blob );
+    void addBlock( const Block &block );
+    void addTags( const Block &block, int first, int count, GeoDataGeometry *geometry,
+                  osm::OsmTagTagHandler::Element element );
+
+    // keeps the nodes, ways and relations for resolving references
+    OsmParser m_parser;
+    GeoDataDocument *m_document;
+    QString m_errorString;
+    QThreadPool m_threadPool;
+};
+
+}
+
+#endif
@@ -0,0 +1,317 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include <QBuffer>
+#include <QFile>
+#include <QtTest>
+
+#include "OsmParser.h"
+#ifdef MARBLE_HAVE_PROTOBUF
+#include "OsmPbfParser.h"
+#endif
+
+#include "GeoDataDocument.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTypes.h"
+#include "MarbleDebug.h"
+
+using namespace Marble;
+
+class TestOsmParser : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void unsortedNodesTest();
+    void duplicateNodesTest();
+    void nodeCoordinatesTest_data();
+    void nodeCoordinatesTest();
+    void nodePointTest();
+    void osmFixtureTest();
+    void pbfFixtureTest();
+
+private:
+    static GeoDataDocument *readOsm( const QString &fileName );
+    static void compareCoordinates( const GeoDataCoordinates &coordinates, const GeoDataCoordinates &expected );
+    static void compareLineStrings( const GeoDataLineString &lineString, const GeoDataLineString &expected );
+};
+
+void TestOsmParser::initTestCase()
+{
+    MarbleDebug::setEnabled( true );
+}
+
+GeoDataDocument *TestOsmParser::readOsm( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return 0;
+    }
+
+    OsmParser parser;
+    if ( !parser.read( &file ) ) {
+        return 0;
+    }
+
+    return static_cast<GeoDataDocument*>( parser.releaseDocument() );
+}
+
+void TestOsmParser::compareCoordinates( const GeoDataCoordinates &coordinates, const GeoDataCoordinates &expected )
+{
+    // OSM data has a precision of 1e-7 degrees
+    QVERIFY( qAbs( coordinates.longitude( GeoDataCoordinates::Degree ) - expected.longitude( GeoDataCoordinates::Degree ) ) < 1e-7 );
+    QVERIFY( qAbs( coordinates.latitude( GeoDataCoordinates::Degree ) - expected.latitude( GeoDataCoordinates::Degree ) ) < 1e-7 );
+}
+
+void TestOsmParser::compareLineStrings( const GeoDataLineString &lineString, const GeoDataLineString &expected )
+{
+    QCOMPARE( lineString.size(), expected.size() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        compareCoordinates( lineString.at( i ), expected.at( i ) );
+    }
+}
+
+void TestOsmParser::unsortedNodesTest()
+{
+    OsmParser parser;
+    parser.setNode( 5, 5.0, 50.0 );
+    parser.setNode( 2, 2.0, 20.0 );
+    parser.setNode( 9, 9.0, 90.0 );
+    parser.setNode( 1, 1.0, 10.0 );
+
+    GeoDataCoordinates coordinates;
+    QVERIFY( parser.node( 1, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 1.0, 10.0, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( parser.node( 2, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 2.0, 20.0, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( parser.node( 5, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 5.0, 50.0, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( parser.node( 9, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 9.0, 90.0, 0, GeoDataCoordinates::Degree ) );
+
+    // ids before, between and after the known ones
+    QVERIFY( !parser.node( 0, coordinates ) );
+    QVERIFY( !parser.node( 3, coordinates ) );
+    QVERIFY( !parser.node( 10, coordinates ) );
+
+    // nodes added after a lookup are found as well
+    parser.setNode( 4, 4.0, 40.0 );
+    QVERIFY( parser.node( 4, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 4.0, 40.0, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( parser.node( 9, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 9.0, 90.0, 0, GeoDataCoordinates::Degree ) );
+}
+
+void TestOsmParser::duplicateNodesTest()
+{
+    OsmParser parser;
+    parser.setNode( 1, 1.0, 10.0 );
+    parser.setNode( 3, 3.0, 30.0 );
+    parser.setNode( 3, -3.0, -30.0 );
+    parser.setNode( 2, 2.0, 20.0 );
+    parser.setNode( 1, -1.0, -10.0 );
+    parser.setNode( 3, 33.0, 33.0 );
+
+    // the node given last wins
+    GeoDataCoordinates coordinates;
+    QVERIFY( parser.node( 1, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( -1.0, -10.0, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( parser.node( 2, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 2.0, 20.0, 0, GeoDataCoordinates::Degree ) );
+    QVERIFY( parser.node( 3, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( 33.0, 33.0, 0, GeoDataCoordinates::Degree ) );
+}
+
+void TestOsmParser::nodeCoordinatesTest_data()
+{
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+
+    QTest::newRow( "positive" ) << qreal( 13.3777 ) << qreal( 52.5163 );
+    QTest::newRow( "negative" ) << qreal( -0.1276 ) << qreal( -33.8688 );
+    QTest::newRow( "small negative" ) << qreal( -0.0000001 ) << qreal( -0.0000001 );
+    QTest::newRow( "west" ) << qreal( -180 ) << qreal( -90 );
+    QTest::newRow( "east" ) << qreal( 180 ) << qreal( 90 );
+    QTest::newRow( "precision" ) << qreal( -179.9999999 ) << qreal( 89.9999999 );
+}
+
+void TestOsmParser::nodeCoordinatesTest()
+{
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+
+    OsmParser parser;
+    parser.setNode( 1, lon, lat );
+
+    GeoDataCoordinates coordinates;
+    QVERIFY( parser.node( 1, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree ) );
+}
+
+void TestOsmParser::nodePointTest()
+{
+    QByteArray data( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                     "<osm version=\"0.6\">"
+                     " <node id=\"1\" lat=\"-33.8688\" lon=\"151.2093\">"
+                     "  <tag k=\"amenity\" v=\"cafe\"/>"
+                     "  <tag k=\"tourism\" v=\"hotel\"/>"
+                     "  <tag k=\"tourism\" v=\"museum\"/>"
+                     " </node>"
+                     " <node id=\"2\" lat=\"10\" lon=\"-180\"/>"
+                     " <node id=\"3\" lat=\"20\" lon=\"180\">"
+                     "  <tag k=\"amenity\" v=\"cafe\"/>"
+                     " </node>"
+                     "</osm>" );
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+
+    OsmParser parser;
+    QVERIFY( parser.read( &buffer ) );
+    GeoDataDocument *document = static_cast<GeoDataDocument*>( parser.releaseDocument() );
+    QVERIFY( document != 0 );
+
+    // every POI tag of the first node makes a placemark of its own
+    const QVector<GeoDataPlacemark*> placemarks = document->placemarkList();
+    QCOMPARE( placemarks.size(), 4 );
+    QCOMPARE( placemarks.at( 0 )->visualCategory(), GeoDataFeature::FoodCafe );
+    QCOMPARE( placemarks.at( 1 )->visualCategory(), GeoDataFeature::AccomodationHotel );
+    QCOMPARE( placemarks.at( 2 )->visualCategory(), GeoDataFeature::TouristMuseum );
+    QCOMPARE( placemarks.at( 3 )->visualCategory(), GeoDataFeature::FoodCafe );
+
+    // the point shared by all nodes is copied, so the placemarks keep the
+    // coordinates of their node once it is reused
+    const GeoDataPoint *point = parser.nodePoint( 0, 0 );
+    QVERIFY( point->parent() == 0 );
+    foreach ( const GeoDataPlacemark *placemark, placemarks ) {
+        QVERIFY( placemark->geometry() != point );
+    }
+    for ( int i = 0; i < 3; ++i ) {
+        compareCoordinates( placemarks.at( i )->coordinate(), GeoDataCoordinates( 151.2093, -33.8688, 0, GeoDataCoordinates::Degree ) );
+    }
+    compareCoordinates( placemarks.at( 3 )->coordinate(), GeoDataCoordinates( 180, 20, 0, GeoDataCoordinates::Degree ) );
+
+    // the coordinates of all nodes are kept for ways
+    GeoDataCoordinates coordinates;
+    QVERIFY( parser.node( 2, coordinates ) );
+    compareCoordinates( coordinates, GeoDataCoordinates( -180, 10, 0, GeoDataCoordinates::Degree ) );
+
+    delete document;
+}
+
+void TestOsmParser::osmFixtureTest()
+{
+    GeoDataDocument *document = readOsm( QString( TESTSRCDIR ) + "/data/fixture.osm" );
+    QVERIFY( document != 0 );
+
+    const QVector<GeoDataPlacemark*> placemarks = document->placemarkList();
+    QCOMPARE( placemarks.size(), 9 );
+
+    // nodes with POI tags, the second POI tag of a node makes a copy
+    QCOMPARE( placemarks.at( 0 )->name(), QString( "Museum" ) );
+    QCOMPARE( placemarks.at( 0 )->visualCategory(), GeoDataFeature::TouristMuseum );
+    QCOMPARE( placemarks.at( 1 )->name(), QString::fromUtf8( "Caf\xc3\xa9" ) );
+    QCOMPARE( placemarks.at( 1 )->visualCategory(), GeoDataFeature::FoodCafe );
+    QCOMPARE( placemarks.at( 2 )->name(), QString::fromUtf8( "Caf\xc3\xa9" ) );
+    QCOMPARE( placemarks.at( 2 )->visualCategory(), GeoDataFeature::AccomodationHotel );
+    for ( int i = 0; i < 3; ++i ) {
+        QCOMPARE( placemarks.at( i )->geometry()->nodeType(), GeoDataTypes::GeoDataPointType );
+        QVERIFY( placemarks.at( i )->isVisible() );
+    }
+    compareCoordinates( placemarks.at( 1 )->coordinate(), GeoDataCoordinates( -0.1276, 51.5072, 0, GeoDataCoordinates::Degree ) );
+
+    // a road, and a building turned into a polygon
+    QCOMPARE( placemarks.at( 3 )->name(), QString( "Unter den Linden" ) );
+    QCOMPARE( placemarks.at( 3 )->visualCategory(), GeoDataFeature::HighwayPrimary );
+    QCOMPARE( placemarks.at( 3 )->geometry()->nodeType(), GeoDataTypes::GeoDataLineStringType );
+    QCOMPARE( placemarks.at( 4 )->visualCategory(), GeoDataFeature::Building );
+    QCOMPARE( placemarks.at( 4 )->geometry()->nodeType(), GeoDataTypes::GeoDataPolygonType );
+
+    // the ways of the relation, which are hidden
+    for ( int i = 5; i < 8; ++i ) {
+        QCOMPARE( placemarks.at( i )->geometry()->nodeType(), GeoDataTypes::GeoDataLineStringType );
+        QVERIFY( !placemarks.at( i )->isVisible() );
+    }
+
+    // the relation, whose outer ways are joined at their shared node
+    QCOMPARE( placemarks.at( 8 )->name(), QString( "Wald" ) );
+    QCOMPARE( placemarks.at( 8 )->visualCategory(), GeoDataFeature::NaturalWood );
+    QCOMPARE( placemarks.at( 8 )->geometry()->nodeType(), GeoDataTypes::GeoDataPolygonType );
+    const GeoDataPolygon *polygon = static_cast<const GeoDataPolygon*>( placemarks.at( 8 )->geometry() );
+    QCOMPARE( polygon->outerBoundary().size(), 5 );
+    QCOMPARE( polygon->innerBoundaries().size(), 1 );
+    QCOMPARE( polygon->innerBoundaries().first().size(), 5 );
+    compareCoordinates( polygon->outerBoundary().at( 3 ), GeoDataCoordinates( 13.38, 52.515, 0, GeoDataCoordinates::Degree ) );
+
+    delete document;
+}
+
+void TestOsmParser::pbfFixtureTest()
+{
+#ifdef MARBLE_HAVE_PROTOBUF
+    GeoDataDocument *expected = readOsm( QString( TESTSRCDIR ) + "/data/fixture.osm" );
+    QVERIFY( expected != 0 );
+
+    // the same data, with dense nodes, a plain node, ways and a relation
+    QFile file( QString( TESTSRCDIR ) + "/data/fixture.osm.pbf" );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QVERIFY( OsmPbfParser::isPbf( &file ) );
+    OsmPbfParser parser;
+    QVERIFY( parser.read( &file ) );
+    GeoDataDocument *document = parser.releaseDocument();
+    QVERIFY( document != 0 );
+
+    const QVector<GeoDataPlacemark*> placemarks = document->placemarkList();
+    const QVector<GeoDataPlacemark*> expectedPlacemarks = expected->placemarkList();
+    QCOMPARE( placemarks.size(), expectedPlacemarks.size() );
+
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        const GeoDataPlacemark *placemark = placemarks.at( i );
+        const GeoDataPlacemark *expectedPlacemark = expectedPlacemarks.at( i );
+        QCOMPARE( placemark->name(), expectedPlacemark->name() );
+        QCOMPARE( placemark->visualCategory(), expectedPlacemark->visualCategory() );
+        QCOMPARE( placemark->isVisible(), expectedPlacemark->isVisible() );
+
+        const GeoDataGeometry *geometry = placemark->geometry();
+        const GeoDataGeometry *expectedGeometry = expectedPlacemark->geometry();
+        QCOMPARE( geometry->nodeType(), expectedGeometry->nodeType() );
+
+        if ( geometry->nodeType() == GeoDataTypes::GeoDataPointType ) {
+            compareCoordinates( placemark->coordinate(), expectedPlacemark->coordinate() );
+        } else if ( geometry->nodeType() == GeoDataTypes::GeoDataLineStringType ) {
+            compareLineStrings( *static_cast<const GeoDataLineString*>( geometry ),
+                                *static_cast<const GeoDataLineString*>( expectedGeometry ) );
+        } else if ( geometry->nodeType() == GeoDataTypes::GeoDataPolygonType ) {
+            const GeoDataPolygon *polygon = static_cast<const GeoDataPolygon*>( geometry );
+            const GeoDataPolygon *expectedPolygon = static_cast<const GeoDataPolygon*>( expectedGeometry );
+            compareLineStrings( polygon->outerBoundary(), expectedPolygon->outerBoundary() );
+            QCOMPARE( polygon->innerBoundaries().size(), expectedPolygon->innerBoundaries().size() );
+            for ( int j = 0; j < polygon->innerBoundaries().size(); ++j ) {
+                compareLineStrings( polygon->innerBoundaries().at( j ), expectedPolygon->innerBoundaries().at( j ) );
+            }
+        }
+    }
+
+    delete document;
+    delete expected;
+#else
+#if QT_VERSION < 0x050000
+    QSKIP( "Built without support for .osm.pbf files", SkipSingle );
+#else
+    QSKIP( "Built without support for .osm.pbf files" );
+#endif
+#endif
+}
+
+QTEST_MAIN( TestOsmParser )
+
+#include "TestOsmParser.moc"
@@ -0,0 +1,122 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "CacheStatistics.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class CacheStatisticsTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testHitRatio();
+    void testEvictions();
+    void testHistogram();
+    void testClear();
+    void testRuntimeTrace();
+};
+
+void CacheStatisticsTest::testHitRatio()
+{
+    CacheStatistics statistics;
+    QCOMPARE( statistics.hitRatio( CacheStatistics::VolatileTileCache ), 0.0 );
+
+    statistics.addHit( CacheStatistics::VolatileTileCache );
+    statistics.addHit( CacheStatistics::VolatileTileCache );
+    statistics.addHit( CacheStatistics::VolatileTileCache );
+    statistics.addMiss( CacheStatistics::VolatileTileCache );
+    statistics.addMiss( CacheStatistics::TileStorage );
+
+    QCOMPARE( statistics.hits( CacheStatistics::VolatileTileCache ), quint64( 3 ) );
+    QCOMPARE( statistics.misses( CacheStatistics::VolatileTileCache ), quint64( 1 ) );
+    QCOMPARE( statistics.hitRatio( CacheStatistics::VolatileTileCache ), 0.75 );
+
+    QCOMPARE( statistics.hits( CacheStatistics::TileStorage ), quint64( 0 ) );
+    QCOMPARE( statistics.misses( CacheStatistics::TileStorage ), quint64( 1 ) );
+    QCOMPARE( statistics.hitRatio( CacheStatistics::TileStorage ), 0.0 );
+}
+
+void CacheStatisticsTest::testEvictions()
+{
+    CacheStatistics statistics;
+
+    statistics.addEvictions( CacheStatistics::DecodedTileCache );
+    statistics.addEvictions( CacheStatistics::DecodedTileCache, 4 );
+    statistics.addEvictions( CacheStatistics::DecodedTileCache, 0 );
+    statistics.addEvictions( CacheStatistics::DecodedTileCache, -2 );
+    QCOMPARE( statistics.evictions( CacheStatistics::DecodedTileCache ), quint64( 5 ) );
+
+    statistics.setByteCount( CacheStatistics::DecodedTileCache, 1024 );
+    statistics.setByteCount( CacheStatistics::DecodedTileCache, 4096 );
+    QCOMPARE( statistics.byteCount( CacheStatistics::DecodedTileCache ), qint64( 4096 ) );
+}
+
+void CacheStatisticsTest::testHistogram()
+{
+    CacheStatistics statistics;
+    QCOMPARE( statistics.averageTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency ), 0.0 );
+
+    statistics.addTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency, 0 );
+    statistics.addTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency, 1 );
+    statistics.addTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency, 3 );
+    statistics.addTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency, 100000 );
+
+    const QVector<quint64> histogram = statistics.histogram( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency );
+    QCOMPARE( histogram.size(), int( CacheStatistics::bucketCount ) );
+    QCOMPARE( histogram[0], quint64( 1 ) ); // below 1 ms
+    QCOMPARE( histogram[1], quint64( 1 ) ); // below 2 ms
+    QCOMPARE( histogram[2], quint64( 1 ) ); // below 4 ms
+    QCOMPARE( histogram.last(), quint64( 1 ) );
+
+    QCOMPARE( statistics.timeCount( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency ), quint64( 4 ) );
+    QCOMPARE( statistics.timeCount( CacheStatistics::TileStorage, CacheStatistics::DecodeTime ), quint64( 0 ) );
+    QCOMPARE( statistics.averageTime( CacheStatistics::TileStorage, CacheStatistics::DownloadLatency ), 25001.0 );
+
+    QCOMPARE( CacheStatistics::bucketLimit( 0 ), 1 );
+    QCOMPARE( CacheStatistics::bucketLimit( 10 ), 1024 );
+    QCOMPARE( CacheStatistics::bucketLimit( CacheStatistics::bucketCount - 1 ), -1 );
+}
+
+void CacheStatisticsTest::testClear()
+{
+    CacheStatistics statistics;
+    statistics.addHit( CacheStatistics::ElevationTileCache );
+    statistics.addEvictions( CacheStatistics::ElevationTileCache );
+    statistics.addTime( CacheStatistics::ElevationTileCache, CacheStatistics::DecodeTime, 5 );
+    statistics.setByteCount( CacheStatistics::ElevationTileCache, 100 );
+
+    statistics.clear();
+
+    QCOMPARE( statistics.hits( CacheStatistics::ElevationTileCache ), quint64( 0 ) );
+    QCOMPARE( statistics.evictions( CacheStatistics::ElevationTileCache ), quint64( 0 ) );
+    QCOMPARE( statistics.timeCount( CacheStatistics::ElevationTileCache, CacheStatistics::DecodeTime ), quint64( 0 ) );
+    QCOMPARE( statistics.byteCount( CacheStatistics::ElevationTileCache ), qint64( 100 ) );
+}
+
+void CacheStatisticsTest::testRuntimeTrace()
+{
+    CacheStatistics statistics;
+    statistics.addHit( CacheStatistics::VolatileTileCache );
+    statistics.addTime( CacheStatistics::VolatileTileCache, CacheStatistics::DecodeTime, 4 );
+
+    const QStringList trace = statistics.runtimeTrace();
+    QCOMPARE( trace.size(), int( CacheStatistics::levelCount ) );
+    QVERIFY( trace.first().startsWith( CacheStatistics::levelName( CacheStatistics::VolatileTileCache ) ) );
+    QVERIFY( trace.first().contains( "decode 4.0 ms" ) );
+}
+
+}
+
+QTEST_MAIN( Marble::CacheStatisticsTest )
+
+#include "CacheStatisticsTest.moc"
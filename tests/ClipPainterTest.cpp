@@ -0,0 +1,106 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "ClipPainter.h"
+
+#include <QImage>
+#include <QPolygonF>
+#include <QRectF>
+#include <QTest>
+
+namespace Marble
+{
+
+class ClipPainterTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void insideTest();
+    void outsideTest();
+    void crossingTest();
+    void degenerateTest();
+    void labelNodesTest();
+};
+
+void ClipPainterTest::insideTest()
+{
+    const QRectF rect( 0, 0, 100, 100 );
+    const QPolygonF square = QPolygonF() << QPointF( 10, 10 ) << QPointF( 90, 10 )
+                                         << QPointF( 90, 90 ) << QPointF( 10, 90 );
+
+    QVector<QPolygonF> clipped;
+    ClipPainter::clip( square, rect, true, clipped );
+    QCOMPARE( clipped.size(), 1 );
+    QCOMPARE( clipped.first(), square );
+}
+
+void ClipPainterTest::outsideTest()
+{
+    const QRectF rect( 0, 0, 100, 100 );
+    const QPolygonF line = QPolygonF() << QPointF( 20, -50 ) << QPointF( 80, -50 );
+
+    QVector<QPolygonF> clipped;
+    ClipPainter::clip( line, rect, false, clipped );
+    QVERIFY( clipped.isEmpty() );
+}
+
+void ClipPainterTest::crossingTest()
+{
+    const QRectF rect( 0, 0, 100, 100 );
+    const QPolygonF line = QPolygonF() << QPointF( -50, 50 ) << QPointF( 50, 50 ) << QPointF( 150, 50 );
+
+    QVector<QPolygonF> clipped;
+    ClipPainter::clip( line, rect, false, clipped );
+    QCOMPARE( clipped.size(), 1 );
+    foreach ( const QPointF &point, clipped.first() ) {
+        QVERIFY( rect.adjusted( -0.001, -0.001, 0.001, 0.001 ).contains( point ) );
+    }
+    QCOMPARE( clipped.first().first(), QPointF( 0, 50 ) );
+    QCOMPARE( clipped.first().last(), QPointF( 100, 50 ) );
+}
+
+void ClipPainterTest::degenerateTest()
+{
+    const QRectF rect( 0, 0, 100, 100 );
+
+    // a single node is not drawn as a polyline, two nodes are not drawn as a polygon
+    QVector<QPolygonF> clipped;
+    ClipPainter::clip( QPolygonF() << QPointF( 50, 50 ), rect, false, clipped );
+    QVERIFY( clipped.isEmpty() );
+
+    ClipPainter::clip( QPolygonF() << QPointF( 50, 50 ) << QPointF( 60, 60 ), rect, true, clipped );
+    QVERIFY( clipped.isEmpty() );
+}
+
+void ClipPainterTest::labelNodesTest()
+{
+    QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+    ClipPainter painter( &image, true );
+
+    const QPolygonF line = QPolygonF() << QPointF( -50, 50 ) << QPointF( 50, 50 ) << QPointF( 150, 50 );
+
+    QVector<QPointF> labelNodes;
+    painter.drawPolyline( line, labelNodes, LineCenter );
+    QCOMPARE( labelNodes, QVector<QPointF>() << QPointF( 50, 50 ) );
+
+    // the start node is clipped off, the label moves to the label area margin
+    labelNodes.clear();
+    painter.drawPolyline( line, labelNodes, LineStart );
+    QCOMPARE( labelNodes, QVector<QPointF>() << QPointF( 10, 50 ) );
+
+    painter.end();
+}
+
+}
+
+QTEST_MAIN( Marble::ClipPainterTest )
+
+#include "ClipPainterTest.moc"
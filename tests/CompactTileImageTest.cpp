@@ -0,0 +1,151 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "CompactTileImage.h"
+#include "TestUtils.h"
+
+Q_DECLARE_METATYPE( Marble::TileCacheEncoding )
+
+namespace Marble
+{
+
+class CompactTileImageTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testNull();
+    void testLossless_data();
+    void testLossless();
+    void testRgb565();
+    void testPalettized();
+    void testTransparent();
+
+ private:
+    static QImage gradientImage();
+    static QImage fewColorsImage();
+};
+
+QImage CompactTileImageTest::gradientImage()
+{
+    QImage image( 256, 256, QImage::Format_ARGB32_Premultiplied );
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 0; x < image.width(); ++x ) {
+            image.setPixel( x, y, qRgb( x, y, ( x + y ) / 2 ) );
+        }
+    }
+
+    return image;
+}
+
+QImage CompactTileImageTest::fewColorsImage()
+{
+    QImage image( 256, 256, QImage::Format_ARGB32_Premultiplied );
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 0; x < image.width(); ++x ) {
+            image.setPixel( x, y, qRgb( ( x / 32 ) * 30, ( y / 32 ) * 30, 200 ) );
+        }
+    }
+
+    return image;
+}
+
+void CompactTileImageTest::testNull()
+{
+    const CompactTileImage empty;
+    QVERIFY( empty.isNull() );
+    QVERIFY( empty.toImage().isNull() );
+
+    const CompactTileImage null( QImage(), CompressedTiles );
+    QVERIFY( null.isNull() );
+}
+
+void CompactTileImageTest::testLossless_data()
+{
+    QTest::addColumn<QImage>( "image" );
+    QTest::addColumn<TileCacheEncoding>( "encoding" );
+
+    addRow() << gradientImage() << UncompressedTiles;
+    addRow() << gradientImage() << CompressedTiles;
+    addRow() << fewColorsImage() << PalettizedTiles;
+    addRow() << gradientImage().convertToFormat( QImage::Format_Indexed8 ) << CompressedTiles;
+    addRow() << gradientImage().convertToFormat( QImage::Format_RGB32 ) << CompressedTiles;
+}
+
+void CompactTileImageTest::testLossless()
+{
+    QFETCH( QImage, image );
+    QFETCH( TileCacheEncoding, encoding );
+
+    const CompactTileImage compactImage( image, encoding );
+    QVERIFY( !compactImage.isNull() );
+    QCOMPARE( compactImage.encoding(), encoding );
+
+    const QImage result = compactImage.toImage();
+    QCOMPARE( result.format(), image.format() );
+    QCOMPARE( result, image );
+}
+
+void CompactTileImageTest::testRgb565()
+{
+    const QImage image = gradientImage();
+    const CompactTileImage compactImage( image, Rgb565Tiles );
+    QCOMPARE( compactImage.encoding(), Rgb565Tiles );
+    QCOMPARE( compactImage.byteCount(), image.byteCount() / 2 );
+
+    const QImage result = compactImage.toImage();
+    QCOMPARE( result.format(), image.format() );
+    QCOMPARE( result.size(), image.size() );
+
+    for ( int y = 0; y < image.height(); y += 7 ) {
+        for ( int x = 0; x < image.width(); x += 7 ) {
+            const QRgb expected = image.pixel( x, y );
+            const QRgb actual = result.pixel( x, y );
+            QVERIFY( qAbs( qRed( actual ) - qRed( expected ) ) <= 8 );
+            QVERIFY( qAbs( qGreen( actual ) - qGreen( expected ) ) <= 4 );
+            QVERIFY( qAbs( qBlue( actual ) - qBlue( expected ) ) <= 8 );
+            QCOMPARE( qAlpha( actual ), 255 );
+        }
+    }
+}
+
+void CompactTileImageTest::testPalettized()
+{
+    const QImage image = fewColorsImage();
+    const CompactTileImage compactImage( image, PalettizedTiles );
+    QCOMPARE( compactImage.encoding(), PalettizedTiles );
+    QVERIFY( compactImage.byteCount() <= image.byteCount() / 4 + 256 * 4 );
+
+    // too many colors for a palette
+    const QImage gradient = gradientImage();
+    const CompactTileImage compressed( gradient, PalettizedTiles );
+    QCOMPARE( compressed.encoding(), CompressedTiles );
+    QCOMPARE( compressed.toImage(), gradient );
+}
+
+void CompactTileImageTest::testTransparent()
+{
+    QImage image = fewColorsImage();
+    image.setPixel( 3, 5, qRgba( 0, 0, 0, 0 ) );
+
+    const CompactTileImage rgb565( image, Rgb565Tiles );
+    QCOMPARE( rgb565.encoding(), CompressedTiles );
+    QCOMPARE( rgb565.toImage(), image );
+
+    const CompactTileImage palettized( image, PalettizedTiles );
+    QCOMPARE( palettized.encoding(), CompressedTiles );
+    QCOMPARE( palettized.toImage(), image );
+}
+
+}
+
+QTEST_MAIN( Marble::CompactTileImageTest )
+
+#include "CompactTileImageTest.moc"
@@ -0,0 +1,135 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "DecodedTileCache.h"
+#include "TestUtils.h"
+
+namespace Marble
+{
+
+class DecodedTileCacheTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testDisabled();
+    void testFind();
+    void testReplacement();
+    void testRemove();
+    void testUnsupportedFormat();
+
+ private:
+    static QImage tileImage( int seed );
+};
+
+QImage DecodedTileCacheTest::tileImage( int seed )
+{
+    QImage image( 256, 256, QImage::Format_ARGB32_Premultiplied );
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 0; x < image.width(); ++x ) {
+            image.setPixel( x, y, qRgb( seed, x, y ) );
+        }
+    }
+
+    return image;
+}
+
+void DecodedTileCacheTest::testDisabled()
+{
+    DecodedTileCache cache;
+    QVERIFY( !cache.isEnabled() );
+
+    cache.insert( TileId( 0, 1, 0, 0 ), "earth", tileImage( 1 ) );
+    QCOMPARE( cache.count(), 0 );
+    QVERIFY( cache.find( TileId( 0, 1, 0, 0 ), "earth" ).isNull() );
+}
+
+void DecodedTileCacheTest::testFind()
+{
+    DecodedTileCache cache;
+    cache.setMaximumSize( 4 * 256 * 256 * 4 );
+    QVERIFY( cache.isEnabled() );
+
+    const QImage image = tileImage( 7 );
+    cache.insert( TileId( 0, 3, 1, 2 ), "earth clouds", image );
+    QCOMPARE( cache.count(), 1 );
+
+    const QImage found = cache.find( TileId( 0, 3, 1, 2 ), "earth clouds" );
+    QCOMPARE( found.format(), image.format() );
+    QCOMPARE( found, image );
+
+    // other tile, or same tile created differently
+    QVERIFY( cache.find( TileId( 0, 3, 2, 1 ), "earth clouds" ).isNull() );
+    QVERIFY( cache.find( TileId( 0, 3, 1, 2 ), "earth sun" ).isNull() );
+
+    // tile updated in place
+    cache.insert( TileId( 0, 3, 1, 2 ), "earth sun", tileImage( 8 ) );
+    QCOMPARE( cache.count(), 1 );
+    QCOMPARE( cache.find( TileId( 0, 3, 1, 2 ), "earth sun" ), tileImage( 8 ) );
+}
+
+void DecodedTileCacheTest::testReplacement()
+{
+    DecodedTileCache cache;
+    cache.setMaximumSize( 3 * 256 * 256 * 4 );
+
+    for ( int i = 0; i < 5; ++i ) {
+        cache.insert( TileId( 0, 4, i, 0 ), "earth", tileImage( i ) );
+    }
+
+    // the tiles inserted first were replaced
+    QCOMPARE( cache.count(), 3 );
+    QVERIFY( cache.find( TileId( 0, 4, 0, 0 ), "earth" ).isNull() );
+    QVERIFY( cache.find( TileId( 0, 4, 1, 0 ), "earth" ).isNull() );
+    for ( int i = 2; i < 5; ++i ) {
+        QCOMPARE( cache.find( TileId( 0, 4, i, 0 ), "earth" ), tileImage( i ) );
+    }
+
+    // a tile size which doesn't fit in the cache disables caching
+    cache.insert( TileId( 0, 0, 0, 0 ), "earth", QImage( 2048, 2048, QImage::Format_RGB32 ) );
+    QCOMPARE( cache.count(), 0 );
+}
+
+void DecodedTileCacheTest::testRemove()
+{
+    DecodedTileCache cache;
+    cache.setMaximumSize( 2 * 256 * 256 * 4 );
+
+    cache.insert( TileId( 0, 1, 0, 0 ), "earth", tileImage( 1 ) );
+    cache.insert( TileId( 0, 1, 1, 0 ), "earth", tileImage( 2 ) );
+    QCOMPARE( cache.count(), 2 );
+
+    cache.remove( TileId( 0, 1, 0, 0 ) );
+    QCOMPARE( cache.count(), 1 );
+    QVERIFY( cache.find( TileId( 0, 1, 0, 0 ), "earth" ).isNull() );
+    QCOMPARE( cache.find( TileId( 0, 1, 1, 0 ), "earth" ), tileImage( 2 ) );
+
+    cache.clear();
+    QCOMPARE( cache.count(), 0 );
+    QVERIFY( cache.find( TileId( 0, 1, 1, 0 ), "earth" ).isNull() );
+}
+
+void DecodedTileCacheTest::testUnsupportedFormat()
+{
+    DecodedTileCache cache;
+    cache.setMaximumSize( 1024 * 1024 );
+
+    QImage indexed( 256, 256, QImage::Format_Indexed8 );
+    indexed.fill( 0 );
+    cache.insert( TileId( 0, 1, 0, 0 ), "earth", indexed );
+
+    QCOMPARE( cache.count(), 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::DecodedTileCacheTest )
+
+#include "DecodedTileCacheTest.moc"
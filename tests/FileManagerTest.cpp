@@ -0,0 +1,156 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "FileManager.h"
+
+#include "GeoDataTreeModel.h"
+#include "PluginManager.h"
+
+#include <QDir>
+#include <QModelIndex>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QTextStream>
+
+namespace Marble
+{
+
+/// Counts the rows inserted below the top level of a tree model until a file is added
+class InsertionRecorder : public QObject
+{
+    Q_OBJECT
+
+ public:
+    InsertionRecorder() : m_rowsBeforeFileAdded( 0 ), m_fileAdded( false ) {}
+
+    int m_rowsBeforeFileAdded;
+    bool m_fileAdded;
+
+ public slots:
+    void recordRowsInserted( const QModelIndex &parent, int first, int last )
+    {
+        if ( parent.isValid() && !m_fileAdded ) {
+            m_rowsBeforeFileAdded += last - first + 1;
+        }
+    }
+
+    void recordFileAdded()
+    {
+        m_fileAdded = true;
+    }
+};
+
+class FileManagerTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+
+    void streamingTest();
+    void cancelTest();
+
+ private:
+    static void waitFor( const QSignalSpy &spy );
+
+    static const int placemarkCount = 20000;
+    QTemporaryFile m_file;
+};
+
+void FileManagerTest::waitFor( const QSignalSpy &spy )
+{
+    for ( int i = 0; i < 300 && spy.isEmpty(); ++i ) {
+        QTest::qWait( 100 );
+    }
+}
+
+void FileManagerTest::initTestCase()
+{
+    m_file.setFileTemplate( QDir::tempPath() + "/FileManagerTest-XXXXXX.kml" );
+    QVERIFY( m_file.open() );
+
+    QTextStream stream( &m_file );
+    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           << "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n";
+    for ( int i = 0; i < placemarkCount; ++i ) {
+        stream << "<Placemark><name>" << i << "</name><Point><coordinates>"
+               << ( i % 360 ) - 180 << ',' << ( i % 170 ) - 85
+               << "</coordinates></Point></Placemark>\n";
+    }
+    stream << "</Document>\n</kml>\n";
+    stream.flush();
+    m_file.close();
+}
+
+void FileManagerTest::streamingTest()
+{
+    PluginManager pluginManager;
+    GeoDataTreeModel treeModel;
+    FileManager manager( &treeModel, &pluginManager );
+
+    QSignalSpy fileAdded( &manager, SIGNAL(fileAdded(QString)) );
+    QSignalSpy loadingProgress( &manager, SIGNAL(loadingProgress(QString,int)) );
+
+    // the preview document is added at the top level, the batches of placemarks below it
+    InsertionRecorder recorder;
+    connect( &treeModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             &recorder, SLOT(recordRowsInserted(QModelIndex,int,int)) );
+    connect( &manager, SIGNAL(fileAdded(QString)), &recorder, SLOT(recordFileAdded()) );
+
+    manager.addFile( m_file.fileName(), m_file.fileName(), 0, UserDocument );
+    QCOMPARE( manager.pendingFiles(), 1 );
+
+    waitFor( fileAdded );
+    QCOMPARE( fileAdded.count(), 1 );
+    QCOMPARE( manager.pendingFiles(), 0 );
+
+    // the placemarks were shown in batches before the file was loaded
+    QVERIFY( recorder.m_fileAdded );
+    QVERIFY( recorder.m_rowsBeforeFileAdded > 0 );
+    QVERIFY( !loadingProgress.isEmpty() );
+    QCOMPARE( loadingProgress.first().at( 0 ).toString(), m_file.fileName() );
+    foreach ( const QList<QVariant> &arguments, loadingProgress ) {
+        QVERIFY( arguments.at( 1 ).toInt() >= 0 );
+        QVERIFY( arguments.at( 1 ).toInt() <= 100 );
+    }
+
+    // which were replaced by the document
+    GeoDataDocument *document = manager.at( m_file.fileName() );
+    QVERIFY( document != 0 );
+    QCOMPARE( treeModel.rootDocument()->size(), 1 );
+    QCOMPARE( treeModel.rootDocument()->child( 0 ), static_cast<GeoDataFeature*>( document ) );
+    QCOMPARE( document->placemarkList().size(), int( placemarkCount ) );
+}
+
+void FileManagerTest::cancelTest()
+{
+    PluginManager pluginManager;
+    GeoDataTreeModel treeModel;
+    FileManager manager( &treeModel, &pluginManager );
+
+    QSignalSpy fileAdded( &manager, SIGNAL(fileAdded(QString)) );
+
+    manager.addFile( m_file.fileName(), m_file.fileName(), 0, UserDocument );
+    manager.removeFile( m_file.fileName() );
+    QCOMPARE( manager.pendingFiles(), 0 );
+    QCOMPARE( treeModel.rootDocument()->size(), 0 );
+
+    QTest::qWait( 500 );
+    QVERIFY( fileAdded.isEmpty() );
+    QCOMPARE( treeModel.rootDocument()->size(), 0 );
+    QVERIFY( manager.at( m_file.fileName() ) == 0 );
+}
+
+}
+
+QTEST_MAIN( Marble::FileManagerTest )
+
+#include "FileManagerTest.moc"
@@ -0,0 +1,127 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoGraphicsItem.h"
+
+#include "GeoDataStyle.h"
+
+#include <QStringList>
+#include <QTest>
+
+namespace Marble
+{
+
+class TestItem : public GeoGraphicsItem
+{
+ public:
+    TestItem( const QString &name, qreal zValue, const char *type, const GeoDataStyle *style, QStringList *log )
+        : GeoGraphicsItem( 0 ),
+          m_name( name ),
+          m_type( type ),
+          m_log( log )
+    {
+        setZValue( zValue );
+        setStyle( style );
+    }
+
+    virtual const char *batchType() const
+    {
+        return m_type;
+    }
+
+    virtual void paint( GeoPainter *painter, const ViewportParams *viewport )
+    {
+        Q_UNUSED( painter );
+        Q_UNUSED( viewport );
+        *m_log << m_name;
+    }
+
+    virtual void paintBatch( GeoPainter *painter, const ViewportParams *viewport,
+                             const QList<GeoGraphicsItem*> &items )
+    {
+        Q_UNUSED( painter );
+        Q_UNUSED( viewport );
+        QStringList names;
+        foreach( const GeoGraphicsItem *item, items ) {
+            names << static_cast<const TestItem*>( item )->m_name;
+        }
+        *m_log << names.join( " " );
+    }
+
+ private:
+    const QString m_name;
+    const char *const m_type;
+    QStringList *const m_log;
+};
+
+class GeoGraphicsItemTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void paintItems();
+    void paintItemsAlone();
+};
+
+void GeoGraphicsItemTest::paintItems()
+{
+    const char *lines = "lines";
+    const char *polygons = "polygons";
+    const GeoDataStyle road;
+    const GeoDataStyle river;
+    QStringList log;
+
+    QList<GeoGraphicsItem*> items;
+    items << new TestItem( "a", 1, lines, &road, &log )
+          << new TestItem( "b", 1, lines, &river, &log )
+          << new TestItem( "c", 1, lines, &road, &log )
+          << new TestItem( "d", 1, polygons, &road, &log )
+          << new TestItem( "e", 1, lines, &river, &log )
+          << new TestItem( "f", 2, lines, &road, &log )
+          << new TestItem( "g", 2, lines, &road, &log )
+          << new TestItem( "h", 3, lines, &road, &log );
+
+    GeoGraphicsItem::paintItems( 0, 0, items );
+
+    // the batches of equal z value are painted in the order of their first
+    // items, and items of other z values are never batched together
+    QStringList expected;
+    expected << "a c" << "b e" << "d" << "f g" << "h";
+    QCOMPARE( log, expected );
+
+    qDeleteAll( items );
+}
+
+void GeoGraphicsItemTest::paintItemsAlone()
+{
+    const GeoDataStyle style;
+    QStringList log;
+
+    QList<GeoGraphicsItem*> items;
+    items << new TestItem( "a", 1, 0, &style, &log )
+          << new TestItem( "b", 1, 0, &style, &log )
+          << new TestItem( "c", 1, "lines", &style, &log )
+          << new TestItem( "d", 1, 0, &style, &log );
+
+    GeoGraphicsItem::paintItems( 0, 0, items );
+
+    // items without batch type are painted alone and keep their place
+    QStringList expected;
+    expected << "a" << "b" << "c" << "d";
+    QCOMPARE( log, expected );
+
+    qDeleteAll( items );
+}
+
+}
+
+QTEST_MAIN( Marble::GeoGraphicsItemTest )
+
+#include "GeoGraphicsItemTest.moc"
@@ -0,0 +1,331 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoGraphicsRTree.h"
+
+#include "GeoDataLatLonAltBox.h"
+#include "GeoGraphicsItem.h"
+#include "TileCoordsPyramid.h"
+#include "TileId.h"
+
+#include <QMap>
+#include <QRect>
+#include <QSet>
+#include <QTest>
+
+namespace Marble
+{
+
+class TestItem : public GeoGraphicsItem
+{
+ public:
+    TestItem( qreal west, qreal south, qreal east, qreal north ) :
+        GeoGraphicsItem( 0 )
+    {
+        setLatLonAltBox( GeoDataLatLonAltBox( GeoDataLatLonBox( north, south, east, west ), 0, 0 ) );
+    }
+
+    virtual void paint( GeoPainter *painter, const ViewportParams *viewport )
+    {
+        Q_UNUSED( painter );
+        Q_UNUSED( viewport );
+    }
+};
+
+/**
+ * The tile buckets GeoGraphicsScene used before the R-tree, for comparison.
+ */
+class TileBuckets
+{
+ public:
+    void addItem( GeoGraphicsItem *item )
+    {
+        int zoomLevel;
+        qreal north, south, east, west;
+        item->latLonAltBox().boundaries( north, south, east, west );
+        for ( zoomLevel = item->minZoomLevel(); zoomLevel >= 0; zoomLevel-- ) {
+            if ( TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel ) ==
+                 TileId::fromCoordinates( GeoDataCoordinates( east, south, 0 ), zoomLevel ) )
+                break;
+        }
+
+        const TileId key = TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel );
+        m_items[key].append( item );
+    }
+
+    QList<GeoGraphicsItem *> items( const GeoDataLatLonBox &box, int zoomLevel ) const
+    {
+        QList<GeoGraphicsItem *> result;
+        qreal north, south, east, west;
+        box.boundaries( north, south, east, west );
+
+        QRect rect;
+        TileId key = TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), zoomLevel );
+        rect.setLeft( key.x() );
+        rect.setTop( key.y() );
+        key = TileId::fromCoordinates( GeoDataCoordinates( east, south, 0 ), zoomLevel );
+        rect.setRight( key.x() );
+        rect.setBottom( key.y() );
+
+        TileCoordsPyramid pyramid( 0, zoomLevel );
+        pyramid.setBottomLevelCoords( rect );
+        for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
+            int x1, y1, x2, y2;
+            pyramid.coords( level ).getCoords( &x1, &y1, &x2, &y2 );
+            for ( int x = x1; x <= x2; ++x ) {
+                for ( int y = y1; y <= y2; ++y ) {
+                    foreach ( GeoGraphicsItem *item, m_items.value( TileId( 0, level, x, y ) ) ) {
+                        if ( item->minZoomLevel() <= zoomLevel && item->visible() ) {
+                            result << item;
+                        }
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+ private:
+    QMap<TileId, QList<GeoGraphicsItem *> > m_items;
+};
+
+class GeoGraphicsRTreeTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void cleanup();
+
+    void emptyTest();
+    void queryTest_data();
+    void queryTest();
+    void zOrderTest();
+    void dateLineTest();
+    void zoomLevelTest();
+    void removeTest();
+
+    void benchmarkRTree();
+    void benchmarkTileBuckets();
+
+ private:
+    void createRandomItems( int count, qreal maximumSize );
+    QSet<GeoGraphicsItem *> bruteForce( const GeoDataLatLonBox &box, int zoomLevel ) const;
+
+    QList<GeoGraphicsItem *> m_items;
+};
+
+void GeoGraphicsRTreeTest::cleanup()
+{
+    qDeleteAll( m_items );
+    m_items.clear();
+}
+
+void GeoGraphicsRTreeTest::createRandomItems( int count, qreal maximumSize )
+{
+    qsrand( 42 );
+    for ( int i = 0; i < count; ++i ) {
+        // stay clear of the date line and the poles
+        const qreal west = -3.0 + ( 6.0 - maximumSize ) * qrand() / RAND_MAX;
+        const qreal south = -1.4 + ( 2.8 - maximumSize ) * qrand() / RAND_MAX;
+        const qreal width = maximumSize * qrand() / RAND_MAX;
+        const qreal height = maximumSize * qrand() / RAND_MAX;
+        TestItem *item = new TestItem( west, south, west + width, south + height );
+        item->setMinZoomLevel( qrand() % 10 );
+        item->setZValue( qrand() % 5 );
+        m_items << item;
+    }
+}
+
+QSet<GeoGraphicsItem *> GeoGraphicsRTreeTest::bruteForce( const GeoDataLatLonBox &box, int zoomLevel ) const
+{
+    QSet<GeoGraphicsItem *> result;
+    foreach ( GeoGraphicsItem *item, m_items ) {
+        if ( item->minZoomLevel() <= zoomLevel && item->latLonAltBox().intersects( box ) ) {
+            result << item;
+        }
+    }
+
+    return result;
+}
+
+void GeoGraphicsRTreeTest::emptyTest()
+{
+    GeoGraphicsRTree tree;
+    QVERIFY( tree.isEmpty() );
+    QVERIFY( tree.items( GeoDataLatLonBox( 1.0, -1.0, 1.0, -1.0 ), 20 ).isEmpty() );
+
+    tree.load( QList<GeoGraphicsItem *>() );
+    QVERIFY( tree.isEmpty() );
+}
+
+void GeoGraphicsRTreeTest::queryTest_data()
+{
+    QTest::addColumn<bool>( "bulkLoad" );
+
+    QTest::newRow( "insert" ) << false;
+    QTest::newRow( "load" ) << true;
+}
+
+void GeoGraphicsRTreeTest::queryTest()
+{
+    QFETCH( bool, bulkLoad );
+
+    createRandomItems( 2000, 0.2 );
+
+    GeoGraphicsRTree tree;
+    if ( bulkLoad ) {
+        tree.load( m_items );
+    } else {
+        foreach ( GeoGraphicsItem *item, m_items ) {
+            tree.insert( item );
+        }
+    }
+    QCOMPARE( tree.size(), m_items.size() );
+
+    for ( int i = 0; i < 50; ++i ) {
+        const qreal west = -3.0 + 5.0 * qrand() / RAND_MAX;
+        const qreal south = -1.4 + 2.0 * qrand() / RAND_MAX;
+        const GeoDataLatLonBox box( south + 0.5, south, west + 1.0, west );
+        const int zoomLevel = qrand() % 10;
+
+        const QList<GeoGraphicsItem *> items = tree.items( box, zoomLevel );
+        QCOMPARE( items.size(), items.toSet().size() );
+        QCOMPARE( items.toSet(), bruteForce( box, zoomLevel ) );
+    }
+}
+
+void GeoGraphicsRTreeTest::zOrderTest()
+{
+    createRandomItems( 500, 0.2 );
+
+    GeoGraphicsRTree tree;
+    foreach ( GeoGraphicsItem *item, m_items ) {
+        tree.insert( item );
+    }
+
+    const QList<GeoGraphicsItem *> items = tree.items( GeoDataLatLonBox( M_PI / 2, -M_PI / 2, M_PI, -M_PI ), 20 );
+    QCOMPARE( items.size(), m_items.size() );
+    for ( int i = 1; i < items.size(); ++i ) {
+        QVERIFY( items.at( i - 1 )->zValue() <= items.at( i )->zValue() );
+        if ( items.at( i - 1 )->zValue() == items.at( i )->zValue() ) {
+            // equal z values keep the order of insertion
+            QVERIFY( m_items.indexOf( items.at( i - 1 ) ) < m_items.indexOf( items.at( i ) ) );
+        }
+    }
+}
+
+void GeoGraphicsRTreeTest::dateLineTest()
+{
+    TestItem *crossing = new TestItem( 3.0, 0.0, -3.0, 0.1 );
+    TestItem *west = new TestItem( -3.1, 0.0, -3.05, 0.1 );
+    TestItem *east = new TestItem( 3.05, 0.0, 3.1, 0.1 );
+    m_items << crossing << west << east;
+
+    GeoGraphicsRTree tree;
+    tree.load( m_items );
+
+    QList<GeoGraphicsItem *> items = tree.items( GeoDataLatLonBox( 0.2, -0.2, -3.0, -3.12 ), 20 );
+    QCOMPARE( items.toSet(), QSet<GeoGraphicsItem *>() << crossing << west );
+
+    items = tree.items( GeoDataLatLonBox( 0.2, -0.2, 3.12, 3.0 ), 20 );
+    QCOMPARE( items.toSet(), QSet<GeoGraphicsItem *>() << crossing << east );
+
+    // a box crossing the date line itself finds each item once
+    items = tree.items( GeoDataLatLonBox( 0.2, -0.2, -3.0, 3.0 ), 20 );
+    QCOMPARE( items.size(), 3 );
+    QCOMPARE( items.toSet(), m_items.toSet() );
+
+    QVERIFY( tree.remove( crossing ) );
+    items = tree.items( GeoDataLatLonBox( 0.2, -0.2, -3.0, 3.0 ), 20 );
+    QCOMPARE( items.toSet(), QSet<GeoGraphicsItem *>() << west << east );
+}
+
+void GeoGraphicsRTreeTest::zoomLevelTest()
+{
+    TestItem *coarse = new TestItem( 0.0, 0.0, 0.1, 0.1 );
+    TestItem *detailed = new TestItem( 0.0, 0.0, 0.1, 0.1 );
+    detailed->setMinZoomLevel( 10 );
+    TestItem *hidden = new TestItem( 0.0, 0.0, 0.1, 0.1 );
+    hidden->setVisible( false );
+    m_items << coarse << detailed << hidden;
+
+    GeoGraphicsRTree tree;
+    tree.load( m_items );
+
+    const GeoDataLatLonBox box( 1.0, -1.0, 1.0, -1.0 );
+    QCOMPARE( tree.items( box, 5 ), QList<GeoGraphicsItem *>() << coarse );
+    QCOMPARE( tree.items( box, 10 ).toSet(), QSet<GeoGraphicsItem *>() << coarse << detailed );
+}
+
+void GeoGraphicsRTreeTest::removeTest()
+{
+    createRandomItems( 1000, 0.5 );
+
+    GeoGraphicsRTree tree;
+    tree.load( m_items );
+
+    // remove every other item, the tree has to dissolve and reinsert nodes
+    QList<GeoGraphicsItem *> removed;
+    for ( int i = 0; i < m_items.size(); i += 2 ) {
+        QVERIFY( tree.remove( m_items.at( i ) ) );
+        removed << m_items.at( i );
+    }
+    QVERIFY( !tree.remove( removed.first() ) );
+    QCOMPARE( tree.size(), m_items.size() - removed.size() );
+
+    foreach ( GeoGraphicsItem *item, removed ) {
+        m_items.removeOne( item );
+    }
+    qDeleteAll( removed );
+
+    const GeoDataLatLonBox box( M_PI / 2, -M_PI / 2, M_PI, -M_PI );
+    QCOMPARE( tree.items( box, 20 ).toSet(), bruteForce( box, 20 ) );
+
+    foreach ( GeoGraphicsItem *item, m_items ) {
+        QVERIFY( tree.remove( item ) );
+    }
+    QVERIFY( tree.isEmpty() );
+    QVERIFY( tree.items( box, 20 ).isEmpty() );
+}
+
+void GeoGraphicsRTreeTest::benchmarkRTree()
+{
+    createRandomItems( 100000, 0.01 );
+
+    GeoGraphicsRTree tree;
+    tree.load( m_items );
+
+    const GeoDataLatLonBox box( 0.3, 0.1, 0.4, 0.0 );
+    QBENCHMARK {
+        tree.items( box, 8 );
+    }
+}
+
+void GeoGraphicsRTreeTest::benchmarkTileBuckets()
+{
+    createRandomItems( 100000, 0.01 );
+
+    TileBuckets buckets;
+    foreach ( GeoGraphicsItem *item, m_items ) {
+        buckets.addItem( item );
+    }
+
+    const GeoDataLatLonBox box( 0.3, 0.1, 0.4, 0.0 );
+    QBENCHMARK {
+        buckets.items( box, 8 );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::GeoGraphicsRTreeTest )
+
+#include "GeoGraphicsRTreeTest.moc"
@@ -21,6 +21,8 @@
 #include "routing/RouteRequest.h"
 #include "TestUtils.h"
 
+#include <QFile>
+#include <QFileInfo>
 #include <QSignalSpy>
 #include <QMetaType>
 #include <QThreadPool>
@@ -61,6 +63,12 @@ private slots:
     void testAsyncParsing_data();
     void testAsyncParsing();
 
+    void testReadFile_data();
+    void testReadFile();
+
+    void testReadData_data();
+    void testReadData();
+
 public:
     PluginManager m_pluginManager;
     int m_time;
@@ -368,6 +376,69 @@ void MarbleRunnerManagerTest::testAsyncParsing()
     QThreadPool::globalInstance()->waitForDone();
 }
 
+void MarbleRunnerManagerTest::testReadFile_data()
+{
+    testSyncParsing_data();
+}
+
+void MarbleRunnerManagerTest::testReadFile()
+{
+    const ParsingRunnerManager runnerManager( &m_pluginManager );
+
+    QSignalSpy finishSpy( &runnerManager, SIGNAL(parsingFinished()) );
+    QSignalSpy resultSpy( &runnerManager, SIGNAL(parsingFinished(GeoDataDocument*,QString)) );
+
+    QFETCH( QString, fileName );
+    QFETCH( int, resultCount );
+
+    GeoDataDocument* file = runnerManager.readFile( fileName );
+
+    // parsed right away, without signals
+    QCOMPARE( file != 0, resultCount > 0 );
+    QCOMPARE( resultSpy.count(), 0 );
+    QCOMPARE( finishSpy.count(), 0 );
+
+    delete file;
+}
+
+void MarbleRunnerManagerTest::testReadData_data()
+{
+    QTest::addColumn<QString>( "fileName" );
+    QTest::addColumn<int>( "resultCount" );
+    QTest::addColumn<bool>( "inMemory" );
+
+    addNamedRow("kml") << QString( MARBLE_SRC_DIR ).append( "/examples/kml/NewYork.kml") << 1 << true;
+    addNamedRow("osm") << QString( MARBLE_SRC_DIR ).append( "/examples/osm/map.osm") << 1 << true;
+    // parsed from a temporary file
+    addNamedRow("gpx") << QString( MARBLE_SRC_DIR ).append( "/examples/gpx/mjolby.gpx") << 1 << false;
+
+    addNamedRow("svg") << MarbleDirs::path( "flags/flag_tv.svg" ) << 0 << false;
+}
+
+void MarbleRunnerManagerTest::testReadData()
+{
+    const ParsingRunnerManager runnerManager( &m_pluginManager );
+
+    QFETCH( QString, fileName );
+    QFETCH( int, resultCount );
+    QFETCH( bool, inMemory );
+
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    const QByteArray data = file.readAll();
+
+    // only the name is used to pick the runners
+    const QString name = "tile." + QFileInfo( fileName ).suffix();
+    GeoDataDocument* document = runnerManager.readData( data, name );
+
+    QCOMPARE( document != 0, resultCount > 0 );
+    if ( inMemory ) {
+        QCOMPARE( document->fileName(), name );
+    }
+
+    delete document;
+}
+
 }
 
 QTEST_MAIN( Marble::MarbleRunnerManagerTest )
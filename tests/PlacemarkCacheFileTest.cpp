@@ -0,0 +1,189 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "PlacemarkCacheFile.h"
+
+#include "GeoDataData.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataPlacemark.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QTemporaryFile>
+#include <QTest>
+
+namespace Marble
+{
+
+class PlacemarkCacheFileTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void roundTripTest();
+    void sharedStringsTest();
+    void corruptFileTest();
+    void oldFormatTest();
+
+    void benchmarkRead();
+
+ private:
+    QString fileName() const;
+
+    QVector<GeoDataPlacemark*> m_placemarks;
+    QTemporaryFile m_file;
+};
+
+void PlacemarkCacheFileTest::initTestCase()
+{
+    qsrand( 42 );
+    const QString roles[] = { "PPL", "PPLA", "PPLC", "H" };
+    for ( int i = 0; i < 10000; ++i ) {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( QString( "Place %1" ).arg( i ) );
+        placemark->setCoordinate( 360.0 * qrand() / RAND_MAX - 180, 170.0 * qrand() / RAND_MAX - 85,
+                                  i % 100, GeoDataCoordinates::Degree );
+        placemark->setRole( roles[i % 4] );
+        if ( i % 10 == 0 ) {
+            placemark->setDescription( QString::fromUtf8( "Beschreibung \xc3\xa4\xc3\xb6\xc3\xbc %1" ).arg( i ) );
+        }
+        placemark->setCountryCode( QString( "C%1" ).arg( i % 50 ) );
+        placemark->setState( i % 3 == 0 ? QString( "State" ) : QString() );
+        placemark->setArea( i * 0.5 );
+        placemark->setPopulation( qint64( i ) * 1000 );
+        placemark->extendedData().addValue( GeoDataData( "gmt", i % 24 - 12 ) );
+        placemark->extendedData().addValue( GeoDataData( "dst", i % 2 ) );
+        m_placemarks << placemark;
+    }
+
+    m_file.setFileTemplate( QDir::tempPath() + "/PlacemarkCacheFileTest-XXXXXX.cache" );
+    QVERIFY( m_file.open() );
+    m_file.close();
+
+    QVector<const GeoDataPlacemark*> placemarks;
+    foreach ( const GeoDataPlacemark *placemark, m_placemarks ) {
+        placemarks << placemark;
+    }
+    QVERIFY( PlacemarkCacheFile::write( fileName(), placemarks ) );
+}
+
+void PlacemarkCacheFileTest::cleanupTestCase()
+{
+    qDeleteAll( m_placemarks );
+}
+
+QString PlacemarkCacheFileTest::fileName() const
+{
+    return m_file.fileName();
+}
+
+void PlacemarkCacheFileTest::roundTripTest()
+{
+    QVERIFY( PlacemarkCacheFile::isCacheFile( fileName() ) );
+
+    const PlacemarkCacheFile cache( fileName() );
+    QVERIFY( cache.isOpen() );
+    QCOMPARE( cache.size(), m_placemarks.size() );
+
+    for ( int i = 0; i < cache.size(); ++i ) {
+        GeoDataPlacemark *placemark = cache.placemark( i );
+        QVERIFY( placemark != 0 );
+        const GeoDataPlacemark *original = m_placemarks.at( i );
+
+        QCOMPARE( placemark->name(), original->name() );
+        QCOMPARE( placemark->coordinate().longitude(), original->coordinate().longitude() );
+        QCOMPARE( placemark->coordinate().latitude(), original->coordinate().latitude() );
+        QCOMPARE( placemark->coordinate().altitude(), original->coordinate().altitude() );
+        QCOMPARE( placemark->role(), original->role() );
+        QCOMPARE( placemark->description(), original->description() );
+        QCOMPARE( placemark->countryCode(), original->countryCode() );
+        QCOMPARE( placemark->state(), original->state() );
+        QCOMPARE( placemark->area(), original->area() );
+        QCOMPARE( placemark->population(), original->population() );
+        QCOMPARE( placemark->extendedData().value( "gmt" ).value().toInt(),
+                  original->extendedData().value( "gmt" ).value().toInt() );
+        QCOMPARE( placemark->extendedData().value( "dst" ).value().toInt(),
+                  original->extendedData().value( "dst" ).value().toInt() );
+        delete placemark;
+    }
+
+    QVERIFY( cache.placemark( -1 ) == 0 );
+    QVERIFY( cache.placemark( cache.size() ) == 0 );
+}
+
+void PlacemarkCacheFileTest::sharedStringsTest()
+{
+    const PlacemarkCacheFile cache( fileName() );
+
+    // equal strings are decoded once and shared by the placemarks
+    GeoDataPlacemark *first = 0;
+    for ( int i = 0; i < cache.size(); ++i ) {
+        GeoDataPlacemark *placemark = cache.placemark( i );
+        if ( placemark->role() != "PPLC" ) {
+            delete placemark;
+        } else if ( !first ) {
+            first = placemark;
+        } else {
+            QCOMPARE( placemark->role().constData(), first->role().constData() );
+            delete placemark;
+            break;
+        }
+    }
+    QVERIFY( first != 0 );
+    delete first;
+}
+
+void PlacemarkCacheFileTest::corruptFileTest()
+{
+    QFile original( fileName() );
+    QVERIFY( original.open( QIODevice::ReadOnly ) );
+    const QByteArray data = original.readAll();
+
+    QTemporaryFile truncated( QDir::tempPath() + "/PlacemarkCacheFileTest-XXXXXX.cache" );
+    QVERIFY( truncated.open() );
+    truncated.write( data.left( data.size() / 2 ) );
+    truncated.close();
+
+    const PlacemarkCacheFile cache( truncated.fileName() );
+    QVERIFY( !cache.isOpen() );
+    QVERIFY( !cache.errorString().isEmpty() );
+    QCOMPARE( cache.size(), 0 );
+    QVERIFY( cache.placemark( 0 ) == 0 );
+}
+
+void PlacemarkCacheFileTest::oldFormatTest()
+{
+    QTemporaryFile file( QDir::tempPath() + "/PlacemarkCacheFileTest-XXXXXX.cache" );
+    QVERIFY( file.open() );
+    QDataStream out( &file );
+    out << quint32( 0x31415926 ) << qint32( 015 );
+    file.close();
+
+    QVERIFY( !PlacemarkCacheFile::isCacheFile( file.fileName() ) );
+    QVERIFY( !PlacemarkCacheFile( file.fileName() ).isOpen() );
+}
+
+void PlacemarkCacheFileTest::benchmarkRead()
+{
+    QBENCHMARK {
+        const PlacemarkCacheFile cache( fileName() );
+        for ( int i = 0; i < cache.size(); ++i ) {
+            delete cache.placemark( i );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkCacheFileTest )
+
+#include "PlacemarkCacheFileTest.moc"
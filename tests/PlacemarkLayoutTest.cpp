@@ -0,0 +1,162 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "PlacemarkLayout.h"
+
+#include "GeoDataPlacemark.h"
+#include "MarbleClock.h"
+#include "MarblePlacemarkModel.h"
+#include "ViewportParams.h"
+#include "VisiblePlacemark.h"
+
+#include <QItemSelectionModel>
+#include <QTest>
+
+#include <cmath>
+
+namespace Marble
+{
+
+class PlacemarkLayoutTest : public QObject
+{
+    Q_OBJECT
+
+ public:
+    PlacemarkLayoutTest();
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void overlapTest_data();
+    void overlapTest();
+    void selectionTest();
+
+    void benchmarkLayout_data();
+    void benchmarkLayout();
+
+ private:
+    QVector<GeoDataPlacemark*> m_placemarks;
+    MarblePlacemarkModel m_model;
+    QItemSelectionModel m_selectionModel;
+    MarbleClock m_clock;
+};
+
+PlacemarkLayoutTest::PlacemarkLayoutTest() :
+    m_selectionModel( &m_model )
+{
+}
+
+void PlacemarkLayoutTest::initTestCase()
+{
+    // 100000 cities all over the world, few of them popular enough to be
+    // shown when zoomed out
+    qsrand( 42 );
+    for ( int i = 0; i < 100000; ++i ) {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( QString( "City %1" ).arg( i ) );
+        const qreal lon = 360.0 * qrand() / RAND_MAX - 180.0;
+        const qreal lat = 160.0 * qrand() / RAND_MAX - 80.0;
+        placemark->setCoordinate( GeoDataCoordinates( lon, lat, 0.0, GeoDataCoordinates::Degree ) );
+        placemark->setVisualCategory( i < 1000 ? GeoDataFeature::LargeCity : GeoDataFeature::SmallCity );
+        placemark->setZoomLevel( 1 + 2 * int( log10( i + 1.0 ) ) );
+        placemark->setPopularity( 100000 - i );
+        m_placemarks << placemark;
+    }
+
+    m_model.setPlacemarkContainer( &m_placemarks );
+    m_model.addPlacemarks( 0, m_placemarks.size() );
+}
+
+void PlacemarkLayoutTest::cleanupTestCase()
+{
+    qDeleteAll( m_placemarks );
+    m_placemarks.clear();
+}
+
+void PlacemarkLayoutTest::overlapTest_data()
+{
+    QTest::addColumn<int>( "radius" );
+
+    QTest::newRow( "zoomed out" ) << 200;
+    QTest::newRow( "zoomed in" ) << 5000;
+}
+
+void PlacemarkLayoutTest::overlapTest()
+{
+    QFETCH( int, radius );
+
+    PlacemarkLayout layout( &m_model, &m_selectionModel, &m_clock );
+    layout.setShowCities( true );
+    layout.resetCacheData();
+
+    const ViewportParams viewport( Spherical, 0.0, 0.0, radius, QSize( 800, 600 ) );
+    const QVector<VisiblePlacemark*> placemarks = layout.generateLayout( &viewport );
+    QVERIFY( !placemarks.isEmpty() );
+
+    // labels are not placed on top of each other
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        for ( int j = i + 1; j < placemarks.size(); ++j ) {
+            QVERIFY( !placemarks.at( i )->labelRect().intersects( placemarks.at( j )->labelRect() ) );
+        }
+    }
+}
+
+void PlacemarkLayoutTest::selectionTest()
+{
+    PlacemarkLayout layout( &m_model, &m_selectionModel, &m_clock );
+    layout.setShowCities( true );
+    layout.resetCacheData();
+
+    // a city too small to be shown otherwise
+    const int row = m_placemarks.size() - 1;
+    const GeoDataPlacemark *selected = m_placemarks.at( row );
+    const ViewportParams viewport( Spherical, selected->coordinate().longitude(), selected->coordinate().latitude(),
+                                   200, QSize( 800, 600 ) );
+
+    m_selectionModel.select( m_model.index( row ), QItemSelectionModel::ClearAndSelect );
+    const QVector<VisiblePlacemark*> placemarks = layout.generateLayout( &viewport );
+    m_selectionModel.clear();
+
+    // selected placemarks are laid out first, and only once
+    QVERIFY( !placemarks.isEmpty() );
+    QCOMPARE( placemarks.first()->placemark(), selected );
+    QVERIFY( placemarks.first()->selected() );
+    for ( int i = 1; i < placemarks.size(); ++i ) {
+        QVERIFY( placemarks.at( i )->placemark() != selected );
+        QVERIFY( !placemarks.at( i )->selected() );
+    }
+}
+
+void PlacemarkLayoutTest::benchmarkLayout_data()
+{
+    overlapTest_data();
+}
+
+void PlacemarkLayoutTest::benchmarkLayout()
+{
+    QFETCH( int, radius );
+
+    PlacemarkLayout layout( &m_model, &m_selectionModel, &m_clock );
+    layout.setShowCities( true );
+    layout.resetCacheData();
+
+    const ViewportParams viewport( Spherical, 0.0, 0.0, radius, QSize( 800, 600 ) );
+    layout.generateLayout( &viewport );
+
+    QBENCHMARK {
+        layout.generateLayout( &viewport );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkLayoutTest )
+
+#include "PlacemarkLayoutTest.moc"
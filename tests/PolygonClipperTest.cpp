@@ -0,0 +1,247 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "PolygonClipper.h"
+#include "SectorClipper.h"
+
+#include <QPainterPath>
+#include <QTest>
+
+#include <cmath>
+
+namespace Marble
+{
+
+class PolygonClipperTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void insideTest();
+    void coveringTest();
+    void areaTest();
+    void polylineTest();
+    void hugeCoordinatesTest();
+    void bufferReuseTest();
+
+    void benchmarkPolygon_data();
+    void benchmarkPolygon();
+    void benchmarkPolyline_data();
+    void benchmarkPolyline();
+
+ private:
+    static QPolygonF star( const QPointF &center, qreal radius, int nodes );
+    static qreal area( const QPolygonF &polygon );
+};
+
+QPolygonF PolygonClipperTest::star( const QPointF &center, qreal radius, int nodes )
+{
+    // a simple polygon with a ragged boundary, similar to a coastline
+    QPolygonF result;
+    for ( int i = 0; i < nodes; ++i ) {
+        const qreal angle = 2 * M_PI * i / nodes;
+        const qreal distance = radius * ( 0.5 + 0.5 * qrand() / RAND_MAX );
+        result << center + QPointF( distance * cos( angle ), distance * sin( angle ) );
+    }
+
+    return result;
+}
+
+qreal PolygonClipperTest::area( const QPolygonF &polygon )
+{
+    qreal result = 0;
+    for ( int i = 0; i < polygon.size(); ++i ) {
+        const QPointF &a = polygon.at( i );
+        const QPointF &b = polygon.at( ( i + 1 ) % polygon.size() );
+        result += a.x() * b.y() - b.x() * a.y();
+    }
+
+    return qAbs( result ) / 2;
+}
+
+void PolygonClipperTest::insideTest()
+{
+    PolygonClipper clipper( QRectF( 0, 0, 100, 100 ) );
+    const QPolygonF square = QPolygonF() << QPointF( 10, 10 ) << QPointF( 90, 10 )
+                                         << QPointF( 90, 90 ) << QPointF( 10, 90 );
+
+    // no copies of polygons inside the rectangle
+    QCOMPARE( &clipper.clipPolygon( square ), &square );
+
+    QCOMPARE( clipper.clipPolyline( square ), 1 );
+    QCOMPARE( clipper.piece( 0 ), square.constData() );
+    QCOMPARE( clipper.pieceSize( 0 ), square.size() );
+}
+
+void PolygonClipperTest::coveringTest()
+{
+    // a polygon around the whole rectangle is clipped to the rectangle
+    PolygonClipper clipper( QRectF( 0, 0, 100, 100 ) );
+    const QPolygonF square = QPolygonF() << QPointF( -1000, -1000 ) << QPointF( 1000, -1000 )
+                                         << QPointF( 1000, 1000 ) << QPointF( -1000, 1000 );
+
+    const QPolygonF clipped = clipper.clipPolygon( square );
+    QCOMPARE( clipped.size(), 4 );
+    QCOMPARE( area( clipped ), 10000.0 );
+
+    // its boundary does not cross the rectangle
+    QCOMPARE( clipper.clipPolyline( square ), 0 );
+}
+
+void PolygonClipperTest::areaTest()
+{
+    qsrand( 42 );
+    const QRectF rect( 0, 0, 800, 600 );
+    QPainterPath rectPath;
+    rectPath.addRect( rect );
+
+    PolygonClipper clipper( rect );
+    for ( int i = 0; i < 50; ++i ) {
+        const QPointF center( 1600.0 * qrand() / RAND_MAX - 400, 1200.0 * qrand() / RAND_MAX - 300 );
+        const QPolygonF polygon = star( center, 200 + 800.0 * qrand() / RAND_MAX, 500 );
+
+        QPainterPath path;
+        path.addPolygon( polygon );
+        qreal expected = 0;
+        foreach ( const QPolygonF &piece, path.intersected( rectPath ).toFillPolygons() ) {
+            expected += area( piece );
+        }
+
+        const QPolygonF clipped = clipper.clipPolygon( polygon );
+        foreach ( const QPointF &point, clipped ) {
+            QVERIFY( rect.adjusted( -1e-6, -1e-6, 1e-6, 1e-6 ).contains( point ) );
+        }
+        QVERIFY( qAbs( area( clipped ) - expected ) <= 1e-3 * expected + 1e-6 );
+    }
+}
+
+void PolygonClipperTest::polylineTest()
+{
+    PolygonClipper clipper( QRectF( 0, 0, 100, 100 ) );
+
+    // in and out three times, the middle piece crosses the rectangle
+    // from outside to outside
+    const QPolygonF polyline = QPolygonF() << QPointF( 50, 50 ) << QPointF( 150, 50 )
+                                           << QPointF( 150, 150 ) << QPointF( 50, 150 )
+                                           << QPointF( 50, -50 ) << QPointF( -50, -50 )
+                                           << QPointF( -50, 20 ) << QPointF( 20, 20 );
+
+    QCOMPARE( clipper.clipPolyline( polyline ), 3 );
+
+    QCOMPARE( clipper.pieceSize( 0 ), 2 );
+    QCOMPARE( clipper.piece( 0 )[0], QPointF( 50, 50 ) );
+    QCOMPARE( clipper.piece( 0 )[1], QPointF( 100, 50 ) );
+
+    QCOMPARE( clipper.pieceSize( 1 ), 2 );
+    QCOMPARE( clipper.piece( 1 )[0], QPointF( 50, 100 ) );
+    QCOMPARE( clipper.piece( 1 )[1], QPointF( 50, 0 ) );
+
+    QCOMPARE( clipper.pieceSize( 2 ), 2 );
+    QCOMPARE( clipper.piece( 2 )[0], QPointF( 0, 20 ) );
+    QCOMPARE( clipper.piece( 2 )[1], QPointF( 20, 20 ) );
+
+    QVector<QPolygonF> pieces;
+    clipper.clipPolyline( polyline, pieces );
+    QCOMPARE( pieces.size(), 3 );
+    QCOMPARE( pieces.at( 1 ), QPolygonF() << QPointF( 50, 100 ) << QPointF( 50, 0 ) );
+}
+
+void PolygonClipperTest::hugeCoordinatesTest()
+{
+    // nodes far off the screen, as at high zoom levels
+    PolygonClipper clipper( QRectF( 0, 0, 800, 600 ) );
+    const QPolygonF polyline = QPolygonF() << QPointF( -1e12, 300 ) << QPointF( 1e12, 300 );
+
+    QCOMPARE( clipper.clipPolyline( polyline ), 1 );
+    QCOMPARE( clipper.pieceSize( 0 ), 2 );
+    QCOMPARE( clipper.piece( 0 )[0], QPointF( 0, 300 ) );
+    QCOMPARE( clipper.piece( 0 )[1], QPointF( 800, 300 ) );
+
+    const QPolygonF triangle = QPolygonF() << QPointF( -1e12, -1e12 ) << QPointF( 1e12, -1e12 )
+                                           << QPointF( 0, 1e12 );
+    const QPolygonF clipped = clipper.clipPolygon( triangle );
+    QVERIFY( qAbs( area( clipped ) - 800 * 600 ) < 1.0 );
+}
+
+void PolygonClipperTest::bufferReuseTest()
+{
+    qsrand( 42 );
+    PolygonClipper clipper( QRectF( 0, 0, 800, 600 ) );
+    const QPolygonF polygon = star( QPointF( 0, 0 ), 1000, 1000 );
+
+    const QPointF *const buffer = clipper.clipPolygon( polygon ).constData();
+    for ( int i = 0; i < 10; ++i ) {
+        QCOMPARE( clipper.clipPolygon( polygon ).constData(), buffer );
+    }
+}
+
+void PolygonClipperTest::benchmarkPolygon_data()
+{
+    QTest::addColumn<bool>( "sectors" );
+
+    QTest::newRow( "PolygonClipper" ) << false;
+    QTest::newRow( "SectorClipper" ) << true;
+}
+
+void PolygonClipperTest::benchmarkPolygon()
+{
+    QFETCH( bool, sectors );
+
+    // a large coastline at a high zoom level, mostly off the screen
+    qsrand( 42 );
+    const QRectF rect( -2, -2, 804, 604 );
+    const QPolygonF polygon = star( QPointF( 400, 300 ), 20000, 50000 );
+
+    if ( sectors ) {
+        SectorClipper clipper( rect );
+        QBENCHMARK {
+            QVector<QPolygonF> clipped;
+            clipper.clipPolyObject( polygon, clipped, true );
+        }
+    } else {
+        PolygonClipper clipper( rect );
+        QBENCHMARK {
+            clipper.clipPolygon( polygon );
+        }
+    }
+}
+
+void PolygonClipperTest::benchmarkPolyline_data()
+{
+    benchmarkPolygon_data();
+}
+
+void PolygonClipperTest::benchmarkPolyline()
+{
+    QFETCH( bool, sectors );
+
+    qsrand( 42 );
+    const QRectF rect( -2, -2, 804, 604 );
+    const QPolygonF polyline = star( QPointF( 400, 300 ), 2000, 50000 );
+
+    if ( sectors ) {
+        SectorClipper clipper( rect );
+        QBENCHMARK {
+            QVector<QPolygonF> clipped;
+            clipper.clipPolyObject( polyline, clipped, false );
+        }
+    } else {
+        PolygonClipper clipper( rect );
+        QBENCHMARK {
+            clipper.clipPolyline( polyline );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PolygonClipperTest )
+
+#include "PolygonClipperTest.moc"
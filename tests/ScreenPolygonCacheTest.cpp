@@ -0,0 +1,187 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "ScreenPolygonCache.h"
+
+#include "GeoDataLineString.h"
+#include "ViewportParams.h"
+
+#include <QTest>
+
+Q_DECLARE_METATYPE( Marble::Projection )
+
+namespace Marble
+{
+
+class ScreenPolygonCacheTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void validTest();
+    void panTest_data();
+    void panTest();
+    void repeatTest();
+    void trimTest();
+
+ private:
+    static GeoDataLineString lineString( qreal lon, qreal lat );
+    static void compare( const QVector<QPolygonF> &actual, const QVector<QPolygonF> &expected );
+};
+
+GeoDataLineString ScreenPolygonCacheTest::lineString( qreal lon, qreal lat )
+{
+    GeoDataLineString result;
+    for ( int i = 0; i < 10; ++i ) {
+        result << GeoDataCoordinates( lon + i, lat + ( i % 3 ), 0, GeoDataCoordinates::Degree );
+    }
+
+    return result;
+}
+
+void ScreenPolygonCacheTest::compare( const QVector<QPolygonF> &actual, const QVector<QPolygonF> &expected )
+{
+    QCOMPARE( actual.size(), expected.size() );
+    for ( int i = 0; i < actual.size(); ++i ) {
+        QCOMPARE( actual[i].size(), expected[i].size() );
+        for ( int j = 0; j < actual[i].size(); ++j ) {
+            QVERIFY( qAbs( actual[i][j].x() - expected[i][j].x() ) < 1e-6 );
+            QVERIFY( qAbs( actual[i][j].y() - expected[i][j].y() ) < 1e-6 );
+        }
+    }
+}
+
+void ScreenPolygonCacheTest::validTest()
+{
+    ViewportParams viewport( Spherical, 0, 0, 500, QSize( 800, 600 ) );
+    const GeoDataLineString line = lineString( 10.0, 20.0 );
+
+    ScreenPolygonCache cache;
+    QVERIFY( !cache.isValid( &viewport ) );
+
+    cache.setLineString( &viewport, line );
+    QVERIFY( cache.isValid( &viewport ) );
+    QVERIFY( !cache.polygons().isEmpty() );
+
+    QVector<QPolygonF> expected;
+    ScreenPolygonCache::project( &viewport, line, expected );
+    compare( cache.polygons(), expected );
+
+    viewport.setRadius( 600 );
+    QVERIFY( !cache.isValid( &viewport ) );
+    viewport.setRadius( 500 );
+    QVERIFY( cache.isValid( &viewport ) );
+
+    viewport.setSize( QSize( 1024, 768 ) );
+    QVERIFY( !cache.isValid( &viewport ) );
+    viewport.setSize( QSize( 800, 600 ) );
+
+    viewport.setProjection( Mercator );
+    QVERIFY( !cache.isValid( &viewport ) );
+    viewport.setProjection( Spherical );
+
+    cache.clear();
+    QVERIFY( !cache.isValid( &viewport ) );
+    QVERIFY( cache.polygons().isEmpty() );
+}
+
+void ScreenPolygonCacheTest::panTest_data()
+{
+    QTest::addColumn<Projection>( "projection" );
+    QTest::addColumn<bool>( "translated" );
+
+    QTest::newRow( "Equirectangular" ) << Equirectangular << true;
+    QTest::newRow( "Mercator" ) << Mercator << true;
+    QTest::newRow( "Spherical" ) << Spherical << false;
+}
+
+void ScreenPolygonCacheTest::panTest()
+{
+    QFETCH( Projection, projection );
+    QFETCH( bool, translated );
+
+    ViewportParams viewport( projection, 0, 0, 2000, QSize( 800, 600 ) );
+    const GeoDataLineString line = lineString( 0.0, 0.0 );
+
+    ScreenPolygonCache cache;
+    cache.setLineString( &viewport, line );
+
+    viewport.centerOn( 3.0 * DEG2RAD, -2.0 * DEG2RAD );
+    QCOMPARE( cache.isValid( &viewport ), translated );
+
+    if ( translated ) {
+        QVector<QPolygonF> expected;
+        ScreenPolygonCache::project( &viewport, line, expected );
+        compare( cache.polygons(), expected );
+
+        // panning back ends up where it started
+        viewport.centerOn( 0.0, 0.0 );
+        QVERIFY( cache.isValid( &viewport ) );
+        expected.clear();
+        ScreenPolygonCache::project( &viewport, line, expected );
+        compare( cache.polygons(), expected );
+    }
+}
+
+void ScreenPolygonCacheTest::repeatTest()
+{
+    // the whole map fits into the viewport, so it gets repeated horizontally
+    ViewportParams viewport( Equirectangular, 0, 0, 100, QSize( 800, 600 ) );
+    const GeoDataLineString line = lineString( 0.0, 0.0 );
+
+    ScreenPolygonCache cache;
+    cache.setLineString( &viewport, line );
+    QVERIFY( cache.polygons().size() > 1 );
+
+    viewport.centerOn( 30.0 * DEG2RAD, 0.0 );
+    QVERIFY( !cache.isValid( &viewport ) );
+}
+
+void ScreenPolygonCacheTest::trimTest()
+{
+    const quint64 limit = ScreenPolygonCache::cacheLimit();
+    ViewportParams viewport( Equirectangular, 0, 0, 20000, QSize( 800, 600 ) );
+
+    // the nodes are far enough apart to not get skipped
+    GeoDataLineString line;
+    for ( int i = 0; i < 1000; ++i ) {
+        line << GeoDataCoordinates( 0.01 * i, 0.005 * ( i % 2 ), 0, GeoDataCoordinates::Degree );
+    }
+
+    ScreenPolygonCache first;
+    first.setLineString( &viewport, line );
+    ScreenPolygonCache second;
+    second.setLineString( &viewport, line );
+    QVERIFY( ScreenPolygonCache::cacheSize() > 0 );
+
+    ScreenPolygonCache::trim();
+    QVERIFY( first.isValid( &viewport ) );
+    QVERIFY( second.isValid( &viewport ) );
+
+    // the least recently used cache goes first
+    QVERIFY( first.isValid( &viewport ) );
+    ScreenPolygonCache::setCacheLimit( ScreenPolygonCache::cacheSize() - 1 );
+    ScreenPolygonCache::trim();
+    QVERIFY( first.isValid( &viewport ) );
+    QVERIFY( !second.isValid( &viewport ) );
+
+    ScreenPolygonCache::setCacheLimit( 0 );
+    ScreenPolygonCache::trim();
+    QVERIFY( !first.isValid( &viewport ) );
+    QCOMPARE( ScreenPolygonCache::cacheSize(), quint64( 0 ) );
+
+    ScreenPolygonCache::setCacheLimit( limit );
+}
+
+}
+
+QTEST_MAIN( Marble::ScreenPolygonCacheTest )
+
+#include "ScreenPolygonCacheTest.moc"
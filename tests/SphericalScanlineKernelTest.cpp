@@ -0,0 +1,115 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "SphericalScanlineKernel.h"
+#include "MarbleGlobal.h"
+#include "Quaternion.h"
+#include "TestUtils.h"
+
+#include <QVector>
+
+Q_DECLARE_METATYPE( Marble::SphericalScanlineKernel::InstructionSet )
+
+namespace Marble
+{
+
+class SphericalScanlineKernelTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testLonLat_data();
+    void testLonLat();
+};
+
+void SphericalScanlineKernelTest::testLonLat_data()
+{
+    QTest::addColumn<SphericalScanlineKernel::InstructionSet>( "instructionSet" );
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+
+    const SphericalScanlineKernel::InstructionSet instructionSets[] = {
+        SphericalScanlineKernel::Scalar,
+        SphericalScanlineKernel::Sse2,
+        SphericalScanlineKernel::Avx2
+    };
+
+    for ( int i = 0; i < 3; ++i ) {
+        const SphericalScanlineKernel::InstructionSet instructionSet = instructionSets[i];
+        if ( instructionSet > SphericalScanlineKernel::bestInstructionSet() ) {
+            continue;
+        }
+
+        addRow() << instructionSet << qreal(0.0) << qreal(0.0);
+        addRow() << instructionSet << qreal(180.0) << qreal(0.0);
+        addRow() << instructionSet << qreal(-90.0) << qreal(45.0);
+        addRow() << instructionSet << qreal(13.4) << qreal(52.5);
+        addRow() << instructionSet << qreal(-122.3) << qreal(-37.8);
+        addRow() << instructionSet << qreal(45.0) << qreal(89.0);
+        addRow() << instructionSet << qreal(-170.0) << qreal(-89.0);
+    }
+}
+
+void SphericalScanlineKernelTest::testLonLat()
+{
+    QFETCH( SphericalScanlineKernel::InstructionSet, instructionSet );
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+
+    const Quaternion planetAxis = Quaternion::fromEuler( -lat * DEG2RAD, lon * DEG2RAD, 0.0 );
+    matrix planetAxisMatrix;
+    planetAxis.toMatrix( planetAxisMatrix );
+
+    const SphericalScanlineKernel kernel( planetAxisMatrix, instructionSet );
+    QCOMPARE( kernel.instructionSet(), instructionSet );
+
+    // an odd number of pixels also exercises the scalar tail of the vectorized paths,
+    // the outermost pixels are slightly outside the globe disk
+    const int count = 203;
+    QVector<qreal> qx( count );
+    QVector<qreal> kernelLon( count );
+    QVector<qreal> kernelLat( count );
+    for ( int i = 0; i < count; ++i ) {
+        qx[i] = ( i - count / 2 ) / 100.0;
+    }
+
+    for ( int row = -100; row <= 100; ++row ) {
+        const qreal qy = row / 100.0;
+        const qreal qr = 1.0 - qy * qy;
+        kernel.lonLat( qy, qx.constData(), count, kernelLon.data(), kernelLat.data() );
+
+        for ( int i = 0; i < count; ++i ) {
+            const qreal qr2z = qr - qx[i] * qx[i];
+            const qreal qz = ( qr2z > 0.0 ) ? sqrt( qr2z ) : 0.0;
+
+            Quaternion qpos( 0.0, qx[i], qy, qz );
+            qpos.rotateAroundAxis( planetAxisMatrix );
+
+            qreal expectedLon;
+            qreal expectedLat;
+            qpos.getSpherical( expectedLon, expectedLat );
+
+            // longitudes of +180 and -180 degree are equivalent
+            qreal lonError = fabs( kernelLon[i] - expectedLon );
+            if ( lonError > M_PI ) {
+                lonError = fabs( lonError - 2 * M_PI );
+            }
+
+            QVERIFY( lonError <= SphericalScanlineKernel::maximumError() );
+            QFUZZYCOMPARE( kernelLat[i], expectedLat, SphericalScanlineKernel::maximumError() );
+        }
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::SphericalScanlineKernelTest )
+
+#include "SphericalScanlineKernelTest.moc"
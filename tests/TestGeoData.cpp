@@ -16,6 +16,8 @@
 #include "GeoDataPlacemark.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPoint.h"
 #include "GeoDataTypes.h"
 #include "GeoDataStyle.h"
 #include "GeoDataIconStyle.h"
@@ -31,6 +33,7 @@ class TestGeoData : public QObject
  private slots:
     void nodeTypeTest();
     void parentingTest();
+    void latLonAltBoxTest();
 };
 
 /// test the nodeType function through various construction tests
@@ -134,6 +137,75 @@ void TestGeoData::parentingTest()
 
 }
 
+void TestGeoData::latLonAltBoxTest()
+{
+    GeoDataDocument document;
+    GeoDataPlacemark *first = new GeoDataPlacemark;
+    first->setCoordinate( GeoDataCoordinates( 10.0, 20.0, 0.0, GeoDataCoordinates::Degree ) );
+    document.append( first );
+
+    GeoDataFolder *folder = new GeoDataFolder;
+    GeoDataPlacemark *second = new GeoDataPlacemark;
+    second->setCoordinate( GeoDataCoordinates( 30.0, 40.0, 0.0, GeoDataCoordinates::Degree ) );
+    folder->append( second );
+    document.append( folder );
+
+    GeoDataLatLonAltBox box = document.latLonAltBox();
+    QVERIFY( qAbs( box.west( GeoDataCoordinates::Degree ) - 10.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.east( GeoDataCoordinates::Degree ) - 30.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.south( GeoDataCoordinates::Degree ) - 20.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.north( GeoDataCoordinates::Degree ) - 40.0 ) < 1e-9 );
+
+    /// features added below extend the boxes above
+    GeoDataPlacemark *third = new GeoDataPlacemark;
+    third->setCoordinate( GeoDataCoordinates( 50.0, -10.0, 0.0, GeoDataCoordinates::Degree ) );
+    folder->append( third );
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.east( GeoDataCoordinates::Degree ) - 50.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.south( GeoDataCoordinates::Degree ) + 10.0 ) < 1e-9 );
+    QVERIFY( qAbs( folder->latLonAltBox().west( GeoDataCoordinates::Degree ) - 30.0 ) < 1e-9 );
+
+    /// hidden placemarks do not count
+    third->setVisible( false );
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.east( GeoDataCoordinates::Degree ) - 30.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.south( GeoDataCoordinates::Degree ) - 20.0 ) < 1e-9 );
+
+    /// neither do removed ones
+    folder->remove( 0 );
+    delete second;
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.east( GeoDataCoordinates::Degree ) - 10.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.north( GeoDataCoordinates::Degree ) - 20.0 ) < 1e-9 );
+
+    /// a placemark which moves takes the box along
+    first->setCoordinate( GeoDataCoordinates( -5.0, 15.0, 0.0, GeoDataCoordinates::Degree ) );
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.west( GeoDataCoordinates::Degree ) + 5.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.north( GeoDataCoordinates::Degree ) - 15.0 ) < 1e-9 );
+
+    /// so does a geometry edited in place
+    GeoDataLineString *track = new GeoDataLineString;
+    track->append( GeoDataCoordinates( 0.0, 0.0, 0.0, GeoDataCoordinates::Degree ) );
+    GeoDataPlacemark *fourth = new GeoDataPlacemark;
+    fourth->setGeometry( track );
+    folder->append( fourth );
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.north( GeoDataCoordinates::Degree ) - 15.0 ) < 1e-9 );
+    track->append( GeoDataCoordinates( 60.0, 70.0, 0.0, GeoDataCoordinates::Degree ) );
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.east( GeoDataCoordinates::Degree ) - 60.0 ) < 1e-9 );
+    QVERIFY( qAbs( box.north( GeoDataCoordinates::Degree ) - 70.0 ) < 1e-9 );
+
+    /// and a point moved in place
+    GeoDataPoint *point = static_cast<GeoDataPoint*>( first->geometry() );
+    point->setCoordinates( GeoDataCoordinates( -20.0, 15.0, 0.0, GeoDataCoordinates::Degree ) );
+    box = document.latLonAltBox();
+    QVERIFY( qAbs( box.west( GeoDataCoordinates::Degree ) + 20.0 ) < 1e-9 );
+}
+
+}
+
 QTEST_MAIN( Marble::TestGeoData )
 
 #include "TestGeoData.moc"
@@ -0,0 +1,206 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoDataLineString.h"
+#include "GeoDataLinearRing.h"
+
+#include <QObject>
+#include <QRunnable>
+#include <QTest>
+#include <QThreadPool>
+
+using namespace Marble;
+
+
+class TestGeoDataGeneralization : public QObject
+{
+    Q_OBJECT
+private slots:
+    void levelTest();
+    void shortLineStringTest();
+    void straightLineTest();
+    void zigzagTest();
+    void ringTest();
+    void polarTest();
+    void invalidateTest();
+    void levelCacheTest();
+    void concurrentTest();
+};
+
+/**
+ * Reads the lazily built caches of a copy of a line string, which shares
+ * them with the original.
+ */
+class ReadCachesJob : public QRunnable
+{
+public:
+    explicit ReadCachesJob( const GeoDataLineString &lineString ) :
+        m_lineString( lineString ),
+        m_size( 0 )
+    {
+        setAutoDelete( false );
+    }
+
+    virtual void run()
+    {
+        for ( int level = 0; level < 10; ++level ) {
+            m_lineString.latLonAltBox();
+            m_size += m_lineString.generalized( level ).size();
+        }
+    }
+
+    const GeoDataLineString m_lineString;
+    int m_size;
+};
+
+void TestGeoDataGeneralization::levelTest()
+{
+    // the angular resolution of a viewport is 4 / radius
+    QCOMPARE( GeoDataLineString::generalizationLevel( 4.0 / 64 ), 0 );
+    QCOMPARE( GeoDataLineString::generalizationLevel( 4.0 / 100 ), 0 );
+    QCOMPARE( GeoDataLineString::generalizationLevel( 4.0 / 128 ), 1 );
+    QCOMPARE( GeoDataLineString::generalizationLevel( 4.0 / 4096 ), 6 );
+    QCOMPARE( GeoDataLineString::generalizationLevel( 1.0 ), 0 );
+}
+
+void TestGeoDataGeneralization::shortLineStringTest()
+{
+    GeoDataLineString lineString;
+    for ( int i = 0; i < 10; ++i ) {
+        lineString << GeoDataCoordinates( 0.001 * i, 0.0 );
+    }
+
+    QCOMPARE( lineString.generalized( 0 ).constBegin(), lineString.constBegin() );
+}
+
+void TestGeoDataGeneralization::straightLineTest()
+{
+    GeoDataLineString lineString;
+    for ( int i = 0; i < 100; ++i ) {
+        lineString << GeoDataCoordinates( 0.001 * i, 0.0 );
+    }
+
+    const GeoDataLineString generalized = lineString.generalized( 0 );
+    QCOMPARE( generalized.size(), 2 );
+    QCOMPARE( generalized.first(), GeoDataCoordinates( 0.0, 0.0 ) );
+    QCOMPARE( generalized.last(), GeoDataCoordinates( 0.001 * 99, 0.0 ) );
+    QVERIFY( !generalized.isClosed() );
+
+    // cached
+    QCOMPARE( lineString.generalized( 0 ).constBegin(), generalized.constBegin() );
+
+    // nothing is generalized beyond the last level
+    QCOMPARE( lineString.generalized( 25 ).constBegin(), lineString.constBegin() );
+}
+
+void TestGeoDataGeneralization::zigzagTest()
+{
+    // at level 0 a pixel amounts to 1/128 radian
+    GeoDataLineString lineString;
+    for ( int i = 0; i < 100; ++i ) {
+        lineString << GeoDataCoordinates( 0.1 * i, ( i % 2 ) ? 0.05 : -0.05 );
+    }
+
+    QCOMPARE( lineString.generalized( 0 ).constBegin(), lineString.constBegin() );
+}
+
+void TestGeoDataGeneralization::ringTest()
+{
+    GeoDataLinearRing ring;
+    for ( int i = 0; i < 360; ++i ) {
+        ring << GeoDataCoordinates( 10 + 5 * cos( i * DEG2RAD ), 20 + 5 * sin( i * DEG2RAD ), 0,
+                                    GeoDataCoordinates::Degree );
+    }
+
+    const GeoDataLinearRing generalized = ring.generalized( 0 );
+    QVERIFY( generalized.isClosed() );
+    QVERIFY( generalized.size() < ring.size() );
+    QVERIFY( generalized.size() >= 3 );
+
+    // a finer level keeps more nodes
+    QVERIFY( ring.generalized( 4 ).size() >= generalized.size() );
+}
+
+void TestGeoDataGeneralization::polarTest()
+{
+    // a zigzag within a pixel at level 0, unless Mercator stretches it
+    // by 1 / cos(latitude), which is almost 6 at 80 degrees
+    GeoDataLineString equatorial;
+    GeoDataLineString polar;
+    for ( int i = 0; i < 100; ++i ) {
+        const qreal offset = ( i % 2 ) ? 0.003 : -0.003;
+        equatorial << GeoDataCoordinates( 0.01 * i, offset );
+        polar << GeoDataCoordinates( 0.01 * i, 80 * DEG2RAD + offset );
+    }
+
+    QCOMPARE( equatorial.generalized( 0 ).size(), 2 );
+    QCOMPARE( polar.generalized( 0 ).size(), polar.size() );
+}
+
+void TestGeoDataGeneralization::invalidateTest()
+{
+    GeoDataLineString lineString;
+    for ( int i = 0; i < 100; ++i ) {
+        lineString << GeoDataCoordinates( 0.001 * i, 0.0 );
+    }
+    QCOMPARE( lineString.generalized( 0 ).size(), 2 );
+
+    lineString << GeoDataCoordinates( 0.1, 0.5 );
+    QCOMPARE( lineString.generalized( 0 ).size(), 3 );
+    QCOMPARE( lineString.generalized( 0 ).last(), GeoDataCoordinates( 0.1, 0.5 ) );
+}
+
+void TestGeoDataGeneralization::levelCacheTest()
+{
+    GeoDataLineString lineString;
+    for ( int i = 0; i < 1000; ++i ) {
+        lineString << GeoDataCoordinates( 0.001 * i, 0.0001 * sin( 0.1 * i ) );
+    }
+
+    const GeoDataLineString level0 = lineString.generalized( 0 );
+    const GeoDataLineString level1 = lineString.generalized( 1 );
+    QCOMPARE( lineString.generalized( 0 ).constBegin(), level0.constBegin() );
+
+    // only the versions of the two levels closest to the last one are kept,
+    // the ones handed out before stay valid
+    lineString.generalized( 2 );
+    QCOMPARE( lineString.generalized( 1 ).constBegin(), level1.constBegin() );
+    QVERIFY( lineString.generalized( 0 ).constBegin() != level0.constBegin() );
+    QCOMPARE( level0.size(), lineString.generalized( 0 ).size() );
+    QCOMPARE( level0.first(), lineString.first() );
+}
+
+void TestGeoDataGeneralization::concurrentTest()
+{
+    GeoDataLineString lineString;
+    for ( int i = 0; i < 10000; ++i ) {
+        lineString << GeoDataCoordinates( 0.0001 * i, 0.01 * sin( 0.01 * i ) );
+    }
+
+    QList<ReadCachesJob *> jobs;
+    for ( int i = 0; i < 16; ++i ) {
+        jobs << new ReadCachesJob( lineString );
+        QThreadPool::globalInstance()->start( jobs.last() );
+    }
+    QThreadPool::globalInstance()->waitForDone();
+
+    int expected = 0;
+    for ( int level = 0; level < 10; ++level ) {
+        expected += lineString.generalized( level ).size();
+    }
+    foreach ( const ReadCachesJob *job, jobs ) {
+        QCOMPARE( job->m_size, expected );
+    }
+
+    qDeleteAll( jobs );
+}
+
+QTEST_MAIN( TestGeoDataGeneralization )
+#include "TestGeoDataGeneralization.moc"
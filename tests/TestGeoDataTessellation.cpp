@@ -0,0 +1,152 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "GeoDataLineString.h"
+#include "GeoDataLinearRing.h"
+#include "MarbleMath.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace Marble;
+
+
+class TestGeoDataTessellation : public QObject
+{
+    Q_OBJECT
+private slots:
+    void notTessellatedTest();
+    void greatCircleTest();
+    void latitudeCircleTest();
+    void followGroundTest();
+    void ringTest();
+    void invalidateTest();
+    void limitTest();
+};
+
+void TestGeoDataTessellation::notTessellatedTest()
+{
+    GeoDataLineString lineString;
+    lineString << GeoDataCoordinates( 0.0, 0.0 ) << GeoDataCoordinates( 1.0, 0.5 );
+    QCOMPARE( lineString.tessellated( 0 ).constBegin(), lineString.constBegin() );
+
+    // nodes close enough to each other need no tessellation
+    GeoDataLineString shortLineString( Tessellate );
+    shortLineString << GeoDataCoordinates( 0.0, 0.0 ) << GeoDataCoordinates( 0.01, 0.01 );
+    QCOMPARE( shortLineString.tessellated( 0 ).constBegin(), shortLineString.constBegin() );
+}
+
+void TestGeoDataTessellation::greatCircleTest()
+{
+    GeoDataLineString lineString( Tessellate );
+    lineString << GeoDataCoordinates( 0.0, 0.2 ) << GeoDataCoordinates( 1.0, 0.8 );
+    const qreal distance = distanceSphere( lineString.first(), lineString.last() );
+
+    const GeoDataLineString tessellated = lineString.tessellated( 0 );
+    QVERIFY( !tessellated.tessellate() );
+    QVERIFY( !tessellated.isClosed() );
+    QCOMPARE( tessellated.first(), lineString.first() );
+    QCOMPARE( tessellated.last(), lineString.last() );
+
+    // at level 0 a pixel amounts to 1/128 radian, nodes are 10 pixels apart at most
+    QVERIFY( tessellated.size() > 2 );
+    qreal length = 0.0;
+    for ( int i = 1; i < tessellated.size(); ++i ) {
+        const qreal step = distanceSphere( tessellated.at( i - 1 ), tessellated.at( i ) );
+        QVERIFY( step <= 10.0 / 128 );
+        length += step;
+    }
+    // the nodes are on the great circle
+    QVERIFY( qAbs( length - distance ) < 1e-6 );
+
+    // cached
+    QCOMPARE( lineString.tessellated( 0 ).constBegin(), tessellated.constBegin() );
+
+    // a higher level gets more nodes
+    QVERIFY( lineString.tessellated( 2 ).size() > tessellated.size() );
+
+    // only the level used last is kept, the versions handed out stay valid
+    QVERIFY( lineString.tessellated( 0 ).constBegin() != tessellated.constBegin() );
+    QCOMPARE( tessellated.last(), lineString.last() );
+}
+
+void TestGeoDataTessellation::latitudeCircleTest()
+{
+    // crossing the date line the short way
+    GeoDataLineString lineString;
+    lineString.setTessellate( true );
+    lineString << GeoDataCoordinates( 170.0, 60.0, 0.0, GeoDataCoordinates::Degree )
+               << GeoDataCoordinates( -170.0, 60.0, 0.0, GeoDataCoordinates::Degree );
+
+    const GeoDataLineString tessellated = lineString.tessellated( 3 );
+    QVERIFY( tessellated.size() > 2 );
+    for ( int i = 0; i < tessellated.size(); ++i ) {
+        QCOMPARE( tessellated.at( i ).latitude(), lineString.first().latitude() );
+        QVERIFY( qAbs( tessellated.at( i ).longitude( GeoDataCoordinates::Degree ) ) >= 170.0 - 1e-9 );
+    }
+}
+
+void TestGeoDataTessellation::followGroundTest()
+{
+    GeoDataLineString lineString( Tessellate | FollowGround );
+    lineString << GeoDataCoordinates( 0.0, 0.0, 1000.0 ) << GeoDataCoordinates( 1.0, 0.0, 2000.0 );
+
+    const GeoDataLineString tessellated = lineString.tessellated( 0 );
+    QVERIFY( tessellated.size() > 2 );
+    for ( int i = 0; i < tessellated.size(); ++i ) {
+        QCOMPARE( tessellated.at( i ).altitude(), 0.0 );
+    }
+}
+
+void TestGeoDataTessellation::ringTest()
+{
+    GeoDataLinearRing ring( Tessellate );
+    ring << GeoDataCoordinates( 0.0, 0.0 ) << GeoDataCoordinates( 1.0, 0.0 )
+         << GeoDataCoordinates( 1.0, 1.0 );
+
+    // the segment from the last node back to the first one is tessellated, too
+    const GeoDataLineString tessellated = ring.tessellated( 0 );
+    QVERIFY( tessellated.isClosed() );
+    QVERIFY( !( tessellated.last() == ring.last() ) );
+    QVERIFY( distanceSphere( tessellated.last(), ring.first() ) <= 10.0 / 128 );
+}
+
+void TestGeoDataTessellation::invalidateTest()
+{
+    GeoDataLineString lineString( Tessellate );
+    lineString << GeoDataCoordinates( 0.0, 0.0 ) << GeoDataCoordinates( 1.0, 0.0 );
+    const int size = lineString.tessellated( 0 ).size();
+
+    lineString << GeoDataCoordinates( 1.0, 1.0 );
+    QVERIFY( lineString.tessellated( 0 ).size() > size );
+
+    lineString.setTessellationFlags( NoTessellation );
+    QCOMPARE( lineString.tessellated( 0 ).constBegin(), lineString.constBegin() );
+}
+
+void TestGeoDataTessellation::limitTest()
+{
+    // too many nodes, the projections tessellate on the fly
+    GeoDataLineString lineString( Tessellate );
+    for ( int i = 0; i < 100; ++i ) {
+        lineString << GeoDataCoordinates( 0.05 * i, ( i % 2 ) ? 0.5 : -0.5 );
+    }
+    QVERIFY( lineString.tessellated( 0 ).constBegin() != lineString.constBegin() );
+    QCOMPARE( lineString.tessellated( 15 ).constBegin(), lineString.constBegin() );
+
+    // nothing is cached beyond the last level
+    GeoDataLineString shortLineString( Tessellate );
+    shortLineString << GeoDataCoordinates( 0.0, 0.0 ) << GeoDataCoordinates( 0.1, 0.0 );
+    QCOMPARE( shortLineString.tessellated( 25 ).constBegin(), shortLineString.constBegin() );
+}
+
+QTEST_MAIN( TestGeoDataTessellation )
+
+#include "TestGeoDataTessellation.moc"
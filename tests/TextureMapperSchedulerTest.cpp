@@ -0,0 +1,101 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "TextureMapperScheduler.h"
+#include "TestUtils.h"
+
+#include <QVector>
+
+namespace Marble
+{
+
+class CountingJob : public TextureMapperScheduler::Job
+{
+ public:
+    CountingJob( QVector<int> *renderCount, int *deleteCount )
+        : m_renderCount( renderCount ),
+          m_deleteCount( deleteCount )
+    {
+    }
+
+    ~CountingJob()
+    {
+        ++*m_deleteCount;
+    }
+
+    virtual void renderLines( int yTop, int yBottom )
+    {
+        // bands are disjoint, so no synchronization is needed
+        for ( int y = yTop; y < yBottom; ++y ) {
+            ++(*m_renderCount)[y];
+        }
+    }
+
+ private:
+    QVector<int> *const m_renderCount;
+    int *const m_deleteCount;
+};
+
+class TextureMapperSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void testRun_data();
+    void testRun();
+};
+
+void TextureMapperSchedulerTest::testRun_data()
+{
+    QTest::addColumn<int>( "yTop" );
+    QTest::addColumn<int>( "yBottom" );
+
+    addRow() << 0 << 0;
+    addRow() << 0 << 1;
+    addRow() << 3 << 17;
+    addRow() << 0 << 1080;
+    addRow() << 250 << 773;
+}
+
+void TextureMapperSchedulerTest::testRun()
+{
+    QFETCH( int, yTop );
+    QFETCH( int, yBottom );
+
+    QVector<int> renderCount( 2 * yBottom, 0 );
+    int deleteCount = 0;
+
+    TextureMapperScheduler scheduler;
+    // two jobs for different parts of the frame, as used when the map is translated
+    scheduler.schedule( new CountingJob( &renderCount, &deleteCount ), yTop, yBottom );
+    scheduler.schedule( new CountingJob( &renderCount, &deleteCount ), yBottom, 2 * yBottom );
+    scheduler.run();
+
+    QCOMPARE( deleteCount, 2 );
+
+    for ( int y = 0; y < renderCount.size(); ++y ) {
+        const int expected = ( y < yTop ) ? 0 : 1;
+        QCOMPARE( renderCount[y], expected );
+    }
+
+    QVERIFY( scheduler.utilization() >= 0.0 );
+    QVERIFY( scheduler.utilization() <= 1.0 );
+    QVERIFY( scheduler.stolenBandCount() >= 0 );
+
+    // nothing scheduled, nothing to do
+    scheduler.run();
+    QCOMPARE( deleteCount, 2 );
+}
+
+}
+
+QTEST_MAIN( Marble::TextureMapperSchedulerTest )
+
+#include "TextureMapperSchedulerTest.moc"
@@ -0,0 +1,222 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "TileArchive.h"
+#include "TestUtils.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+namespace Marble
+{
+
+class TileArchiveTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void testInsert();
+    void testReplace();
+    void testEviction();
+    void testReopen();
+    void testRebuildIndex();
+    void testCompact();
+    void testInterruptedCompaction();
+
+ private:
+    static QByteArray tileData( int seed );
+    static QString tileName( int x );
+
+    QString m_fileName;
+};
+
+QByteArray TileArchiveTest::tileData( int seed )
+{
+    return QByteArray( 1000, char( seed ) );
+}
+
+QString TileArchiveTest::tileName( int x )
+{
+    return QString( "maps/earth/test/5/3/%1.png" ).arg( x );
+}
+
+void TileArchiveTest::init()
+{
+    m_fileName = QDir::tempPath() + "/marble-tilearchivetest.archive";
+    cleanup();
+}
+
+void TileArchiveTest::cleanup()
+{
+    QFile::remove( m_fileName );
+    QFile::remove( m_fileName + ".index" );
+    QFile::remove( m_fileName + ".old" );
+    QFile::remove( m_fileName + ".compact" );
+}
+
+void TileArchiveTest::testInsert()
+{
+    TileArchive archive( m_fileName );
+    QVERIFY( archive.isOpen() );
+    QCOMPARE( archive.count(), 0 );
+
+    const QDateTime lastModified = QDateTime::currentDateTime().addDays( -3 );
+    QVERIFY( archive.insert( tileName( 1 ), tileData( 1 ), lastModified ) );
+
+    QVERIFY( archive.contains( tileName( 1 ) ) );
+    QVERIFY( !archive.contains( tileName( 2 ) ) );
+    QCOMPARE( archive.count(), 1 );
+    QCOMPARE( archive.data( tileName( 1 ) ), tileData( 1 ) );
+    QCOMPARE( archive.lastModified( tileName( 1 ) ).toMSecsSinceEpoch(), lastModified.toMSecsSinceEpoch() );
+
+    QVERIFY( archive.data( tileName( 2 ) ).isEmpty() );
+    QVERIFY( !archive.lastModified( tileName( 2 ) ).isValid() );
+}
+
+void TileArchiveTest::testReplace()
+{
+    TileArchive archive( m_fileName );
+
+    QVERIFY( archive.insert( tileName( 1 ), tileData( 1 ) ) );
+    const qint64 size = archive.size();
+    QVERIFY( archive.insert( tileName( 1 ), tileData( 2 ) ) );
+
+    QCOMPARE( archive.count(), 1 );
+    QCOMPARE( archive.size(), size );
+    QCOMPARE( archive.data( tileName( 1 ) ), tileData( 2 ) );
+
+    QVERIFY( archive.remove( tileName( 1 ) ) );
+    QVERIFY( !archive.contains( tileName( 1 ) ) );
+    QCOMPARE( archive.size(), qint64( 0 ) );
+}
+
+void TileArchiveTest::testEviction()
+{
+    TileArchive archive( m_fileName );
+
+    QVERIFY( archive.insert( tileName( 0 ), tileData( 0 ), QDateTime::currentDateTime(), true ) );
+    for ( int i = 1; i <= 4; ++i ) {
+        QVERIFY( archive.insert( tileName( i ), tileData( i ) ) );
+    }
+
+    // using tile 1 makes tile 2 the least recently used one
+    QVERIFY( !archive.data( tileName( 1 ) ).isEmpty() );
+
+    archive.setCacheLimit( archive.size() - 1 );
+    QCOMPARE( archive.count(), 4 );
+    QVERIFY( !archive.contains( tileName( 2 ) ) );
+
+    // pinned tiles are kept in any case
+    archive.setCacheLimit( 1 );
+    QCOMPARE( archive.count(), 1 );
+    QVERIFY( archive.contains( tileName( 0 ) ) );
+
+    archive.setCacheLimit( 0 );
+    QVERIFY( archive.insert( tileName( 5 ), tileData( 5 ) ) );
+    archive.clearUnpinned();
+    QCOMPARE( archive.names(), QStringList() << tileName( 0 ) );
+}
+
+void TileArchiveTest::testReopen()
+{
+    {
+        TileArchive archive( m_fileName );
+        for ( int i = 0; i < 10; ++i ) {
+            QVERIFY( archive.insert( tileName( i ), tileData( i ) ) );
+        }
+        QVERIFY( archive.remove( tileName( 3 ) ) );
+    }
+
+    QVERIFY( QFile::exists( m_fileName + ".index" ) );
+
+    TileArchive archive( m_fileName );
+    QVERIFY( archive.isOpen() );
+    QCOMPARE( archive.count(), 9 );
+    QVERIFY( !archive.contains( tileName( 3 ) ) );
+    for ( int i = 0; i < 10; ++i ) {
+        if ( i != 3 ) {
+            QCOMPARE( archive.data( tileName( i ) ), tileData( i ) );
+        }
+    }
+}
+
+void TileArchiveTest::testRebuildIndex()
+{
+    {
+        TileArchive archive( m_fileName );
+        for ( int i = 0; i < 10; ++i ) {
+            QVERIFY( archive.insert( tileName( i ), tileData( i ) ) );
+        }
+        QVERIFY( archive.insert( tileName( 5 ), tileData( 50 ) ) );
+        QVERIFY( archive.remove( tileName( 3 ) ) );
+    }
+
+    // as after a crash
+    QVERIFY( QFile::remove( m_fileName + ".index" ) );
+
+    TileArchive archive( m_fileName );
+    QVERIFY( archive.isOpen() );
+    QCOMPARE( archive.count(), 9 );
+    QVERIFY( !archive.contains( tileName( 3 ) ) );
+    QCOMPARE( archive.data( tileName( 5 ) ), tileData( 50 ) );
+    QCOMPARE( archive.data( tileName( 9 ) ), tileData( 9 ) );
+}
+
+void TileArchiveTest::testCompact()
+{
+    TileArchive archive( m_fileName );
+    for ( int i = 0; i < 10; ++i ) {
+        QVERIFY( archive.insert( tileName( i ), tileData( i ) ) );
+    }
+    for ( int i = 0; i < 5; ++i ) {
+        QVERIFY( archive.remove( tileName( i ) ) );
+    }
+
+    const qint64 fileSize = QFileInfo( m_fileName ).size();
+    QVERIFY( archive.compact() );
+    QVERIFY( QFileInfo( m_fileName ).size() < fileSize );
+
+    QCOMPARE( archive.count(), 5 );
+    for ( int i = 5; i < 10; ++i ) {
+        QCOMPARE( archive.data( tileName( i ) ), tileData( i ) );
+    }
+
+    QVERIFY( archive.insert( tileName( 10 ), tileData( 10 ) ) );
+    QCOMPARE( archive.data( tileName( 10 ) ), tileData( 10 ) );
+}
+
+void TileArchiveTest::testInterruptedCompaction()
+{
+    {
+        TileArchive archive( m_fileName );
+        for ( int i = 0; i < 10; ++i ) {
+            QVERIFY( archive.insert( tileName( i ), tileData( i ) ) );
+        }
+    }
+
+    // as after a crash while the compacted archive replaces the old one
+    QVERIFY( QFile::rename( m_fileName, m_fileName + ".old" ) );
+
+    TileArchive archive( m_fileName );
+    QVERIFY( archive.isOpen() );
+    QCOMPARE( archive.count(), 10 );
+    QCOMPARE( archive.data( tileName( 7 ) ), tileData( 7 ) );
+    QVERIFY( !QFile::exists( m_fileName + ".old" ) );
+}
+
+}
+
+QTEST_MAIN( Marble::TileArchiveTest )
+
+#include "TileArchiveTest.moc"
@@ -0,0 +1,133 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+#include "TileDecoder.h"
+#include "TestUtils.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QThread>
+
+namespace Marble
+{
+
+class TileDecoderTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void init();
+
+    void testDecode();
+    void testInvalidData();
+    void testQueueLimit();
+
+ public slots:
+    void collectTile( const TileId &tileId, const QImage &tileImage );
+
+ private:
+    static QByteArray encodedImage( const QSize &size );
+
+    QList<TileId> m_tileIds;
+    QList<QImage> m_tileImages;
+};
+
+void TileDecoderTest::init()
+{
+    m_tileIds.clear();
+    m_tileImages.clear();
+}
+
+void TileDecoderTest::collectTile( const TileId &tileId, const QImage &tileImage )
+{
+    m_tileIds << tileId;
+    m_tileImages << tileImage;
+}
+
+QByteArray TileDecoderTest::encodedImage( const QSize &size )
+{
+    QImage image( size, QImage::Format_RGB32 );
+    image.fill( qRgb( 10, 20, 30 ) );
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    image.save( &buffer, "PNG" );
+
+    return data;
+}
+
+void TileDecoderTest::testDecode()
+{
+    TileDecoder decoder;
+    connect( &decoder, SIGNAL(tileDecoded(TileId,QImage)), SLOT(collectTile(TileId,QImage)) );
+
+    const int tileCount = 20;
+    for ( int i = 0; i < tileCount; ++i ) {
+        decoder.decode( TileId( 0, 3, i, 2 ), encodedImage( QSize( 16 + i, 16 ) ) );
+    }
+
+    decoder.waitForDone();
+    QCOMPARE( decoder.pendingCount(), 0 );
+
+    // results are delivered through the event loop
+    QCOMPARE( m_tileIds.size(), 0 );
+    QCoreApplication::processEvents();
+    QCOMPARE( m_tileIds.size(), tileCount );
+
+    for ( int i = 0; i < tileCount; ++i ) {
+        const int x = m_tileIds[i].x();
+        QCOMPARE( m_tileIds[i], TileId( 0, 3, x, 2 ) );
+        QCOMPARE( m_tileImages[i].size(), QSize( 16 + x, 16 ) );
+        QCOMPARE( m_tileImages[i].pixel( 0, 0 ), qRgb( 10, 20, 30 ) );
+    }
+}
+
+void TileDecoderTest::testInvalidData()
+{
+    TileDecoder decoder;
+    connect( &decoder, SIGNAL(tileDecoded(TileId,QImage)), SLOT(collectTile(TileId,QImage)) );
+
+    decoder.decode( TileId( 0, 1, 0, 0 ), QByteArray( "no image" ) );
+    decoder.waitForDone();
+    QCoreApplication::processEvents();
+
+    QCOMPARE( m_tileIds.size(), 0 );
+}
+
+void TileDecoderTest::testQueueLimit()
+{
+    TileDecoder decoder;
+    decoder.setMaximumQueueSize( 2 );
+    QCOMPARE( decoder.maximumQueueSize(), 2 );
+
+    connect( &decoder, SIGNAL(tileDecoded(TileId,QImage)), SLOT(collectTile(TileId,QImage)) );
+
+    const int tileCount = 100;
+    for ( int i = 0; i < tileCount; ++i ) {
+        decoder.decode( TileId( 0, 6, i, 0 ), encodedImage( QSize( 64, 64 ) ) );
+        QVERIFY( decoder.pendingCount() <= 2 + QThread::idealThreadCount() );
+    }
+
+    decoder.waitForDone();
+    QCoreApplication::processEvents();
+
+    // no tile is dropped when the queue is full
+    QCOMPARE( m_tileIds.size(), tileCount );
+    for ( int i = 0; i < tileCount; ++i ) {
+        QVERIFY( m_tileIds.contains( TileId( 0, 6, i, 0 ) ) );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::TileDecoderTest )
+
+#include "TileDecoderTest.moc"
@@ -17,12 +17,15 @@
 #include <GeoDataDocument.h>
 #include <GeoDataFolder.h>
 #include <GeoDataPlacemark.h>
+#include <GeoDataData.h>
 #include <GeoDataExtendedData.h>
 #include <GeoWriter.h>
+#include <PlacemarkCacheFile.h>
 
 #include <QApplication>
 #include <QDebug>
 #include <QFile>
+#include <QScopedPointer>
 #include <iostream>
 
 using namespace std;
@@ -63,7 +66,18 @@ void savePlacemarks( QDataStream &out, const GeoDataContainer *container, Marble
     }
 }
 
-void saveFile( const QString& filename, GeoDataDocument* document )
+void collectPlacemarks( const GeoDataContainer *container, QVector<const GeoDataPlacemark*> &placemarks )
+{
+    foreach ( const GeoDataPlacemark *placemark, container->placemarkList() ) {
+        placemarks << placemark;
+    }
+
+    foreach ( const GeoDataFolder *folder, container->folderList() ) {
+        collectPlacemarks( folder, placemarks );
+    }
+}
+
+void saveLegacyFile( const QString& filename, GeoDataDocument* document )
 {
     QFile file( filename );
     if ( !file.open( QIODevice::WriteOnly ) ) {
@@ -82,30 +96,124 @@ void saveFile( const QString& filename, GeoDataDocument* document )
     savePlacemarks( out, document, new MarbleClock );
 }
 
-int main(int argc, char** argv)
+bool isLegacyFile( const QString& filename )
 {
-    QApplication app(argc,argv);
+    QFile file( filename );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+    QDataStream in( &file );
+    quint32 magic;
+    in >> magic;
+    return magic == MarbleMagicNumber;
+}
+
+// Reads the old format without the cache runner, so that no plugins and no
+// display are needed when converting the caches while building
+GeoDataDocument* loadLegacyFile( const QString& filename )
+{
+    QFile file( filename );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        qDebug() << Q_FUNC_INFO << "Can't open" << filename << "for reading";
+        return 0;
+    }
+    QDataStream in( &file );
+
+    quint32 magic;
+    qint32 version;
+    in >> magic >> version;
+    if ( magic != MarbleMagicNumber || version < 015 ) {
+        qDebug() << Q_FUNC_INFO << "Unsupported cache file" << filename;
+        return 0;
+    }
+
+    in.setVersion( QDataStream::Qt_4_2 );
+
+    GeoDataDocument* document = new GeoDataDocument;
+    double lon, lat, alt, area;
+    QString name, role, description, countryCode, state;
+    qint64 population;
+    qint16 gmt;
+    qint8 dst;
+    while ( !in.atEnd() ) {
+        in >> name >> lon >> lat >> alt >> role >> description >> countryCode >> state
+           >> area >> population >> gmt >> dst;
+
+        GeoDataPlacemark* placemark = new GeoDataPlacemark( name );
+        placemark->setCoordinate( lon, lat, alt );
+        placemark->setRole( role );
+        placemark->setDescription( description );
+        placemark->setCountryCode( countryCode );
+        placemark->setState( state );
+        placemark->setArea( area );
+        placemark->setPopulation( population );
+        placemark->extendedData().addValue( GeoDataData( "gmt", int( gmt ) ) );
+        placemark->extendedData().addValue( GeoDataData( "dst", int( dst ) ) );
+        document->append( placemark );
+    }
 
+    return document;
+}
+
+bool saveFile( const QString& filename, GeoDataDocument* document )
+{
+    QVector<const GeoDataPlacemark*> placemarks;
+    collectPlacemarks( document, placemarks );
+
+    QString error;
+    if ( !PlacemarkCacheFile::write( filename, placemarks, &error ) ) {
+        qDebug() << Q_FUNC_INFO << "Can't write" << filename << error;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
     QString inputFilename;
-    int inputIndex = app.arguments().indexOf( "-i" );
-    if ( inputIndex > 0 && inputIndex + 1 < argc ) {
-        inputFilename = app.arguments().at( inputIndex + 1 );
-    } else {
-        qDebug( " Syntax: kml2cache -i sourcefile [-o cache-targetfile]" );
+    for ( int i = 1; i + 1 < argc; ++i ) {
+        if ( QString( argv[i] ) == "-i" ) {
+            inputFilename = QString::fromLocal8Bit( argv[i + 1] );
+        }
+    }
+
+    // Old cache files are converted without plugins, which allows to run
+    // without a display
+    const bool legacyInput = isLegacyFile( inputFilename );
+    QScopedPointer<QCoreApplication> app( legacyInput ? new QCoreApplication( argc, argv )
+                                                      : new QApplication( argc, argv ) );
+
+    if ( inputFilename.isEmpty() ) {
+        qDebug( " Syntax: kml2cache -i sourcefile [-o cache-targetfile] [-legacy]" );
+        qDebug( " The source may be a .cache file of the old format to convert it." );
+        qDebug( " -legacy writes the old format, which older versions of Marble can read." );
         return 1;
     }
 
     QString outputFilename = "output.cache";
-    int outputIndex = app.arguments().indexOf("-o");
+    int outputIndex = app->arguments().indexOf("-o");
     if ( outputIndex > 0 && outputIndex + 1 < argc )
-        outputFilename = app.arguments().at( outputIndex + 1 );
-
-    ParsingRunnerManager* manager = new ParsingRunnerManager( new PluginManager );
-    GeoDataDocument* document = manager->openFile( inputFilename );
-    if (!document) {
-        qDebug() << "Could not parse input file. No error message available unfortunately";
-        return 2;
+        outputFilename = app->arguments().at( outputIndex + 1 );
+
+    GeoDataDocument* document = 0;
+    if ( legacyInput ) {
+        document = loadLegacyFile( inputFilename );
+        if ( !document ) {
+            return 2;
+        }
+    } else {
+        ParsingRunnerManager* manager = new ParsingRunnerManager( new PluginManager );
+        QString error;
+        document = manager->readFile( inputFilename, UserDocument, &error );
+        if (!document) {
+            qDebug() << "Could not parse input file." << error;
+            return 2;
+        }
     }
 
-    saveFile( outputFilename, document );
+    if ( app->arguments().contains( "-legacy" ) ) {
+        saveLegacyFile( outputFilename, document );
+    } else if ( !saveFile( outputFilename, document ) ) {
+        return 3;
+    }
 }
@@ -0,0 +1,98 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+// Copyright 2014      The Marble Developers <marble-devel@kde.org>
+//
+
+// A tool to move the texture tiles of a tile cache directory into a tile archive.
+// Once the archive exists in the default location, Marble stores new tiles in it.
+
+#include <ArchiveStoragePolicy.h>
+#include <MarbleDirs.h>
+#include <TileArchive.h>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+
+using namespace Marble;
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc,argv);
+
+    QStringList arguments = app.arguments();
+    arguments.removeFirst();
+
+    const bool removeFiles = arguments.removeAll( "-r" ) > 0;
+    if ( arguments.size() > 2 || arguments.contains( "-h" ) || arguments.contains( "--help" ) ) {
+        qDebug( " Syntax: tilearchive [-r] [cache-directory [archive-file]]" );
+        qDebug( "   Moves the texture tiles of cache-directory (default: the Marble tile cache)" );
+        qDebug( "   into archive-file (default: the location Marble uses the archive from)." );
+        qDebug( "   -r: remove the tile files after storing them in the archive" );
+        return 1;
+    }
+
+    const QString cacheDirectory = arguments.size() > 0 ? arguments.at( 0 ) : MarbleDirs::localPath();
+    const QString archiveFileName = arguments.size() > 1 ? arguments.at( 1 ) : TileArchive::defaultFileName();
+
+    TileArchive archive( archiveFileName );
+    if ( !archive.isOpen() ) {
+        qDebug() << "Could not open" << archiveFileName << archive.errorString();
+        return 2;
+    }
+
+    const QDir cacheDir( cacheDirectory );
+    int count = 0;
+    int errors = 0;
+
+    QDirIterator it( cacheDir.filePath( "maps" ), QDir::Files | QDir::NoSymLinks, QDirIterator::Subdirectories );
+    while ( it.hasNext() ) {
+        it.next();
+
+        // tiles are stored with their names relative to the cache directory,
+        // e.g. maps/earth/openstreetmap/3/4/2.png
+        const QString name = cacheDir.relativeFilePath( it.filePath() );
+        if ( !ArchiveStoragePolicy::isArchived( name ) ) {
+            continue;
+        }
+
+        QFile file( it.filePath() );
+        if ( !file.open( QIODevice::ReadOnly ) ) {
+            qDebug() << "Could not read" << it.filePath() << file.errorString();
+            ++errors;
+            continue;
+        }
+
+        const QByteArray data = file.readAll();
+        file.close();
+
+        if ( !archive.insert( name, data, it.fileInfo().lastModified(), ArchiveStoragePolicy::isBaseTile( name ) ) ) {
+            qDebug() << "Could not store" << name << archive.errorString();
+            ++errors;
+            continue;
+        }
+
+        if ( removeFiles ) {
+            file.remove();
+        }
+
+        ++count;
+    }
+
+    if ( !archive.flush() ) {
+        qDebug() << "Could not save the index of" << archiveFileName << archive.errorString();
+        ++errors;
+    }
+
+    qDebug() << "Stored" << count << "tiles in" << archiveFileName << "(" << archive.size() << "bytes)";
+
+    return errors == 0 ? 0 : 3;
+}